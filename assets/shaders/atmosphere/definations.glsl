@@ -3,17 +3,18 @@
 #define MAX 1e6
 #define rad 1.0
 
-#define TRANSMITTANCE_TEXTURE_WIDTH  256
-#define TRANSMITTANCE_TEXTURE_HEIGHT  64
-#define SCATTERING_TEXTURE_R_SIZE  32
-#define SCATTERING_TEXTURE_MU_SIZE  128
-#define SCATTERING_TEXTURE_MU_S_SIZE  32
-#define SCATTERING_TEXTURE_NU_SIZE  8
-#define SCATTERING_TEXTURE_WIDTH  SCATTERING_TEXTURE_NU_SIZE * SCATTERING_TEXTURE_MU_S_SIZE
+// lut extents, specialized from AtmosphereLutSize by the atmosphere pass. the defaults are the high quality ones
+layout(constant_id = 0) const int TRANSMITTANCE_TEXTURE_WIDTH = 256;
+layout(constant_id = 1) const int TRANSMITTANCE_TEXTURE_HEIGHT = 64;
+layout(constant_id = 2) const int SCATTERING_TEXTURE_R_SIZE = 32;
+layout(constant_id = 3) const int SCATTERING_TEXTURE_MU_SIZE = 128;
+layout(constant_id = 4) const int SCATTERING_TEXTURE_MU_S_SIZE = 32;
+layout(constant_id = 5) const int SCATTERING_TEXTURE_NU_SIZE = 8;
+layout(constant_id = 6) const int IRRADIANCE_TEXTURE_WIDTH = 64;
+layout(constant_id = 7) const int IRRADIANCE_TEXTURE_HEIGHT = 16;
+#define SCATTERING_TEXTURE_WIDTH  (SCATTERING_TEXTURE_NU_SIZE * SCATTERING_TEXTURE_MU_S_SIZE)
 #define SCATTERING_TEXTURE_HEIGHT  SCATTERING_TEXTURE_MU_SIZE
 #define SCATTERING_TEXTURE_DEPTH  SCATTERING_TEXTURE_R_SIZE
-#define IRRADIANCE_TEXTURE_WIDTH  64
-#define IRRADIANCE_TEXTURE_HEIGHT  16
 
 struct DensityProfileLayer {
     float width;
@@ -1,37 +1,50 @@
 #include "definations.glsl"
 
+// filled from Horizon::AtmosphereParameters, shared by the lut kernels and the sky pass. std140, see
+// Atmosphere::ParametersUb
+layout(set = 1, binding = 0) uniform AtmosphereUb {
+    float bottom_radius;
+    float top_radius;
+    float mie_g;
+    float sun_angular_radius;
+    vec3 solar_irradiance;
+    float mu_s_min;
+    vec3 rayleigh_scattering;
+    vec3 mie_scattering;
+    vec3 mie_extinction;
+    vec3 absorption_extinction;
+    vec3 ground_albedo;
+    // rayleigh, mie and absorption density, two layers each. width, exp_term, exp_scale and linear_term, then
+    // constant_term in x
+    vec4 density_layers[12];
+} atmosphere_ub;
+
+DensityProfileLayer GetDensityProfileLayer(int layer)
+{
+    vec4 terms = atmosphere_ub.density_layers[2 * layer];
+    return DensityProfileLayer(terms.x, terms.y, terms.z, terms.w, atmosphere_ub.density_layers[2 * layer + 1].x);
+}
+
 AtmosphereParameters GetAtmosphereParameters()
 {
     AtmosphereParameters atmosphere;
-    atmosphere.bottom_radius = 6360.0f;
-    atmosphere.top_radius = 6460.0f;
-    // TODO: light is not a part of sky model
-    atmosphere.solar_irradiance = vec3(1.0f);
-    atmosphere.sun_angular_radius = 0.004675f;
-
-    float rayleigh_scale_height = 8.0f;
-    float mie_scale_height = 1.2f;
-
-    // Raleigh scattering
-    atmosphere.rayleigh_density.layers[0] = DensityProfileLayer(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-    atmosphere.rayleigh_density.layers[1] = DensityProfileLayer(0.0f, 1.0f, -1.0f / rayleigh_scale_height, 0.0f, 0.0f);
-    atmosphere.rayleigh_scattering = vec3(0.005802f, 0.013558f, 0.033100f); // 1/km
-
-    // Mie scattering
-    atmosphere.mie_density.layers[0] = DensityProfileLayer(0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
-    atmosphere.mie_density.layers[1] = DensityProfileLayer(0.0f, 1.0f, -1.0f / mie_scale_height, 0.0f, 0.0f);
-    atmosphere.mie_scattering = vec3(0.003996f, 0.003996f, 0.003996f); // 1/km
-    atmosphere.mie_extinction = vec3(0.004440f, 0.004440f, 0.004440f); // 1/km
-    atmosphere.mie_g = 0.8;
-
-    // Ozone absorption
-    atmosphere.absorption_density.layers[0] = DensityProfileLayer(25.0f, 0.0f, 0.0f, 1.0f / 15.0f, -2.0f / 3.0f);
-    atmosphere.absorption_density.layers[1] = DensityProfileLayer(0.0f, 0.0f, 0.0f, -1.0f / 15.0f, 8.0f / 3.0f);
-    atmosphere.absorption_extinction = vec3(0.000650f, 0.001881f, 0.000085f); // 1/km
-    atmosphere.ground_albedo = vec3(0.0, 0.0, 0.0);
-
-    const float max_sun_zenith_angle = 120.0 / 180.0 * PI;
-    atmosphere.mu_s_min = cos(max_sun_zenith_angle);
+    atmosphere.bottom_radius = atmosphere_ub.bottom_radius;
+    atmosphere.top_radius = atmosphere_ub.top_radius;
+    atmosphere.mie_g = atmosphere_ub.mie_g;
+    atmosphere.sun_angular_radius = atmosphere_ub.sun_angular_radius;
+    atmosphere.solar_irradiance = atmosphere_ub.solar_irradiance;
+    atmosphere.rayleigh_scattering = atmosphere_ub.rayleigh_scattering;
+    atmosphere.mie_scattering = atmosphere_ub.mie_scattering;
+    atmosphere.mie_extinction = atmosphere_ub.mie_extinction;
+    atmosphere.absorption_extinction = atmosphere_ub.absorption_extinction;
+    atmosphere.rayleigh_density.layers[0] = GetDensityProfileLayer(0);
+    atmosphere.rayleigh_density.layers[1] = GetDensityProfileLayer(1);
+    atmosphere.mie_density.layers[0] = GetDensityProfileLayer(2);
+    atmosphere.mie_density.layers[1] = GetDensityProfileLayer(3);
+    atmosphere.absorption_density.layers[0] = GetDensityProfileLayer(4);
+    atmosphere.absorption_density.layers[1] = GetDensityProfileLayer(5);
+    atmosphere.mu_s_min = atmosphere_ub.mu_s_min;
+    atmosphere.ground_albedo = atmosphere_ub.ground_albedo;
     return atmosphere;
 }
 
@@ -387,7 +400,8 @@ the transmittance texture:
 DimensionlessSpectrum ComputeTransmittanceToTopAtmosphereBoundaryTexture(
     AtmosphereParameters atmosphere, vec2 frag_coord)
 {
-    const vec2 TRANSMITTANCE_TEXTURE_SIZE =
+    // not const, float conversions of specialization constants are no constant expressions
+    vec2 TRANSMITTANCE_TEXTURE_SIZE =
         vec2(TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT);
     Length r;
     Number mu;
@@ -845,7 +859,7 @@ void GetRMuMuSNuFromScatteringTextureFragCoord(
     out Length r, out Number mu, out Number mu_s, out Number nu,
     out bool ray_r_mu_intersects_ground)
 {
-    const vec4 SCATTERING_TEXTURE_SIZE = vec4(
+    vec4 SCATTERING_TEXTURE_SIZE = vec4(
         SCATTERING_TEXTURE_NU_SIZE - 1,
         SCATTERING_TEXTURE_MU_S_SIZE,
         SCATTERING_TEXTURE_MU_SIZE,
@@ -1488,8 +1502,8 @@ void GetRMuSFromIrradianceTextureUv(AtmosphereParameters atmosphere,
 the ground irradiance texture, for the direct irradiance:
 */
 
-const vec2 IRRADIANCE_TEXTURE_SIZE =
-    vec2(IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT);
+#define IRRADIANCE_TEXTURE_SIZE \
+    vec2(IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT)
 
 IrradianceSpectrum ComputeDirectIrradianceTexture(
     AtmosphereParameters atmosphere,
@@ -22,6 +22,8 @@ layout(set = 0, binding = 4) uniform sampler2D scene_depth;
 void main() {
     AtmosphereParameters atmosphere = GetAtmosphereParameters();
 	vec2 frag_coord = gl_FragCoord.xy / vec2(scattering_ub.resolution);
+	// resolution is the rendered part of the targets, which keep their full size
+	vec2 texture_coord = gl_FragCoord.xy / vec2(textureSize(scene_depth, 0));
     vec3 x_clip = vec3(frag_coord * vec2(2.0, -2.0) - vec2(1.0, -1.0), 0.5); 
     vec4 _x_world = scattering_ub.inv_view_projection_matrix * vec4(x_clip, 1.0); 
 	vec3 x_world = _x_world.xyz / _x_world.w;
@@ -45,7 +47,7 @@ void main() {
 	float t = raySphereIntersect(scattering_ub.camera_position, view_dir, earth_pos, earth_radius);
 	
 	// don't calculate atmosphere before scene depth;
-	x_clip.z = texture(scene_depth, frag_coord).r;
+	x_clip.z = texture(scene_depth, texture_coord).r;
 	if (x_clip.z > 0.0f)
 	{
 		vec4 DepthBufferWorldPos = scattering_ub.inv_view_projection_matrix * vec4(x_clip,1.0);
@@ -76,5 +78,5 @@ void main() {
 	transmittance = vec3(0.0);
 	// Compute in scattering and apply transmittance on background
 	vec3 luminance = (SunIlluminanceToSkyLuminanceTransfer + SunIlluminanceToGroundLuminanceTransfer) + SunLuminance * SunTransmittance;
-	out_color = texture(geometry_color, frag_coord) + vec4(luminance, 1.0 - dot(transmittance, vec3(0.33, 0.33, 0.34)));
+	out_color = texture(geometry_color, texture_coord) + vec4(luminance, 1.0 - dot(transmittance, vec3(0.33, 0.33, 0.34)));
 }
\ No newline at end of file
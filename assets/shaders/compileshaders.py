@@ -1,5 +1,9 @@
+# compiles into spirv/ by hand, what the shaders build target does on every build. the runtime compiles the glsl
+# itself when it is built with shaderc and caches the result under assets/cache, the spirv/ files are what it loads
+# without shaderc or when a source fails to compile. exits non zero when any shader fails, ci runs it to check them
 import sys
 import os
+import subprocess
 
 
 path, _ = os.path.split(os.path.abspath(sys.argv[0]))
@@ -7,28 +11,24 @@ path, _ = os.path.split(os.path.abspath(sys.argv[0]))
 def glslc(shaderPath):
     input = os.path.join(path, shaderPath)
     output = os.path.join(os.path.join(path, "spirv"), shaderPath) + ".spv"
-    cmd="glslc"+ " " + input + " -o " + output
-    os.system(cmd)
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+    return subprocess.call(["glslc", input, "-o", output]) == 0
 
 def main():
+    # every .vert, .frag and .comp like the glob of the shaders target
+    failed = []
+    for root, dirs, files in os.walk(path):
+        dirs[:] = sorted(d for d in dirs if d not in ("spirv", "cache"))
+        for name in sorted(files):
+            if os.path.splitext(name)[1] in (".vert", ".frag", ".comp"):
+                shaderPath = os.path.relpath(os.path.join(root, name), path).replace(os.sep, "/")
+                if not glslc(shaderPath):
+                    failed.append(shaderPath)
 
-    glslc("postprocess.frag")
-    glslc("geometry.vert")
-    glslc("geometry.frag")
-    glslc("present.frag")
-    glslc("simplevs.vert")
-    glslc("shading.frag")
-
-    # atmosphere
-    glslc("atmosphere/transmittance_lut.comp")
-    glslc("atmosphere/direct_irradiance_lut.comp")
-    glslc("atmosphere/single_scattering_lut.comp")
-    glslc("atmosphere/scattering_density.comp")
-    glslc("atmosphere/indirect_irradiance_lut.comp")
-    glslc("atmosphere/multi_scattering_lut.comp")
-    glslc("atmosphere/scatter.vert")
-    glslc("atmosphere/scatter.frag")
+    for shaderPath in failed:
+        print("failed to compile " + shaderPath)
+    return 1 if failed else 0
 
 
 if __name__ == '__main__':
-    main()
+    sys.exit(main())
@@ -19,15 +19,15 @@ layout(set = 0, binding = 0) uniform SceneUb {
 
 // set 1: material
 
-// push constant
+// set 2: instance transforms, gl_InstanceIndex already includes the draw's first instance
 
-layout(push_constant) uniform MeshUb {
-    mat4 model;
-} mesh_ub;
+layout(set = 2, binding = 0) readonly buffer InstanceBuffer {
+    mat4 model[];
+} instance_buffer;
 
 
 void main() {
-    mat4 model = mesh_ub.model;
+    mat4 model = instance_buffer.model[gl_InstanceIndex];
     world_pos = (model * vec4(in_position, 1.0)).xyz;
     world_normal = (model * vec4(in_normal, 0.0)).xyz;
     frag_tex_coord = in_tex_coord;
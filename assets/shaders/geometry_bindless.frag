@@ -0,0 +1,72 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec3 world_pos;
+layout(location = 1) in vec3 world_normal;
+layout(location = 2) in vec2 frag_tex_coord;
+
+layout(location = 0) out vec4 position_depth;
+layout(location = 1) out vec4 normal_roughness;
+layout(location = 2) out vec4 albedo_metallic;
+
+// set 0: scene
+layout(set = 0, binding = 0) uniform SceneUb {
+    mat4 view, proj;
+    vec2 near_far;
+} scene_ub;
+
+// set 1: material table, see MaterialTable.h
+
+const uint MATERIAL_HAS_BASE_COLOR = 1u;
+const uint MATERIAL_HAS_NORMAL = 2u;
+const uint MATERIAL_HAS_METALLIC_ROUGHNESS = 4u;
+
+struct MaterialParams {
+    uint base_color_texture;
+    uint normal_texture;
+    uint metallic_roughness_texture;
+    uint flags;
+};
+
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer {
+    MaterialParams materials[];
+} material_buffer;
+
+// partially bound, only slots referenced by a material are written
+layout(set = 1, binding = 1) uniform sampler2D textures[];
+
+// set 2: mesh
+
+// the vertex stage owns the dequantization in front of it, see RenderQueue.h
+layout(push_constant) uniform DrawParams {
+    layout(offset = 32) uint material_index;
+} draw_params;
+
+// -------------------------------------------------------
+
+
+float ToLinearDepth(float _depth)
+{
+    float near_plane = scene_ub.near_far.x;
+    float far_plane = scene_ub.near_far.y;
+	float z = _depth * 2.0f - 1.0f; 
+	return (2.0f * near_plane * far_plane) / (far_plane + near_plane - z * (far_plane - near_plane));	
+}
+
+
+void main() {
+    // the index is pushed per draw, so every texture index below is dynamically uniform
+    MaterialParams material = material_buffer.materials[draw_params.material_index];
+    bool has_base_color = (material.flags & MATERIAL_HAS_BASE_COLOR) != 0u;
+    bool has_normal = (material.flags & MATERIAL_HAS_NORMAL) != 0u;
+    bool has_metallic_roughness = (material.flags & MATERIAL_HAS_METALLIC_ROUGHNESS) != 0u;
+
+    vec3 albedo = has_base_color ? texture(textures[material.base_color_texture], frag_tex_coord).xyz : vec3(1.0);
+    vec3 normal = has_normal ? texture(textures[material.normal_texture], frag_tex_coord).xyz : vec3(0.0);
+    vec2 metallic_roughness = has_metallic_roughness ?
+        texture(textures[material.metallic_roughness_texture], frag_tex_coord).xy : vec2(0.0, 1.0);
+
+    position_depth = vec4(world_pos, ToLinearDepth(gl_FragCoord.z));
+    normal_roughness = vec4(normalize(world_normal), metallic_roughness.y);
+    albedo_metallic = vec4(albedo, metallic_roughness.x);
+}
@@ -0,0 +1,48 @@
+#version 450
+
+// CompressedVertex, see Vertex.h
+layout(location = 0) in vec4 in_position;  // unorm16, relative to the primitive aabb
+layout(location = 1) in vec2 in_normal;    // octahedral, snorm16
+layout(location = 2) in vec2 in_tex_coord; // f16
+
+layout(location = 0) out vec3 world_pos;
+layout(location = 1) out vec3 world_normal;
+layout(location = 2) out vec2 frag_tex_coord;
+
+// set 0: scene
+
+layout(set = 0, binding = 0) uniform SceneUb {
+    mat4 view, proj;
+    vec2 near_far;
+} scene_ub;
+
+// set 1: material
+
+// set 2: instance transforms, gl_InstanceIndex already includes the draw's first instance
+
+layout(set = 2, binding = 0) readonly buffer InstanceBuffer {
+    mat4 model[];
+} instance_buffer;
+
+// per draw aabb of the primitive
+
+layout(push_constant) uniform VertexDequantization {
+    vec4 position_scale;
+    vec4 position_offset;
+} dequantization;
+
+vec3 OctDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main() {
+    mat4 model = instance_buffer.model[gl_InstanceIndex];
+    vec3 position = in_position.xyz * dequantization.position_scale.xyz + dequantization.position_offset.xyz;
+    world_pos = (model * vec4(position, 1.0)).xyz;
+    world_normal = (model * vec4(OctDecode(in_normal), 0.0)).xyz;
+    frag_tex_coord = in_tex_coord;
+    gl_Position = scene_ub.proj * scene_ub.view * model * vec4(position, 1.0);
+}
@@ -4,6 +4,11 @@ layout(location = 0) out vec4 out_color;
 
 layout(set = 0, binding = 0) uniform sampler2D color_texture;
 
+// the scene covers the top left input_scale of color_texture
+layout(push_constant) uniform PostProcessConstants {
+	vec2 input_scale;
+} constants;
+
 float sRGB(float x)
 {
 	if (x <= 0.00031308)
@@ -33,7 +38,10 @@ vec3 GammaCorrection(vec3 x){
 }
 
 void main() {
-	vec2 frag_coord = gl_FragCoord.xy / vec2(1920.0,1080.0);
+	vec2 texture_size = vec2(textureSize(color_texture, 0));
+	// stay half a texel inside the rendered part so filtering never reads past it
+	vec2 max_coord = constants.input_scale - 0.5 / texture_size;
+	vec2 frag_coord = min(gl_FragCoord.xy / texture_size * constants.input_scale, max_coord);
 	vec4 rgbA = texture(color_texture, frag_coord);
 	rgbA /= rgbA.aaaa;	// Normalise according to sample count when path tracing
 	vec3 white_point = vec3(1.08241, 0.96756, 0.95003);
@@ -1,6 +1,8 @@
 #version 450
 
-#define MAX_LIGHT_COUNT 512
+// specialized to Scene::MAX_LIGHT_COUNT. the lights are the last member of their block, so the size does not move
+// any offset
+layout(constant_id = 0) const int MAX_LIGHT_COUNT = 1024;
 #define PI 3.14159265359
 #define eps 1e-6
 
@@ -140,7 +142,7 @@ vec3 radiance(LightParams light, vec3 N, vec3 V, vec3 world_pos, vec3 albedo, fl
 
 void main() {
 
-    vec2 frag_coord = gl_FragCoord.xy/vec2(1920.0f,1080.0f);
+    vec2 frag_coord = gl_FragCoord.xy / vec2(textureSize(position_depth, 0));
     vec4 position_depth_color = texture(position_depth, frag_coord);
     vec4 albedo_metallic_color = texture(albedo_metallic, frag_coord);
     vec4 normal_roughness_color = texture(normal_roughness, frag_coord);
@@ -0,0 +1,70 @@
+// loads a gltf file with serial and with thread pool image decoding and reports the best time of each.
+// usage: image_decode_benchmark [model.gltf|model.glb] [runs]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include <runtime/core/path/Path.h>
+#include <runtime/core/thread/ThreadPool.h>
+#include <runtime/scene/model/GlbFile.h>
+#include <runtime/scene/model/ImageDecoder.h>
+
+using namespace Horizon;
+
+// parse the file and decode every image, returns the wall time in ms or a negative value on failure
+static f64 LoadOnce(const std::string &path, bool parallel, u64 &decoded_pixels) noexcept {
+    auto start = std::chrono::steady_clock::now();
+    tinygltf::TinyGLTF context;
+    tinygltf::Model model;
+    std::string error, warning;
+    bool is_binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".glb") == 0;
+    std::unique_ptr<GlbFile> glb_file = nullptr;
+    bool loaded = false;
+    {
+        ImageDecoder decoder(parallel);
+        if (is_binary) {
+            glb_file = std::make_unique<GlbFile>(path);
+            loaded = glb_file->Load(context, model, error, warning, &decoder);
+        } else {
+            decoder.Install(context);
+            loaded = context.LoadASCIIFromFile(&model, &error, &warning, path);
+        }
+        decoder.CollectAll(model);
+    }
+    if (!loaded) {
+        std::printf("failed to load %s: %s\n", path.c_str(), error.c_str());
+        return -1.0;
+    }
+    decoded_pixels = 0;
+    for (const tinygltf::Image &image : model.images) {
+        decoded_pixels += image.image.empty() ? 0 : static_cast<u64>(image.width) * image.height;
+    }
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    std::string path = argc > 1 ? argv[1] : Path::GetModelPath("FlightHelmet/glTF/FlightHelmet.gltf");
+    u32 runs = argc > 2 ? static_cast<u32>(std::max(std::atoi(argv[2]), 1)) : 5;
+
+    std::printf("%s, %u runs, %u pool workers\n", path.c_str(), runs, ThreadPool::GetInstance().GetWorkerCount());
+    f64 best[2] = {0.0, 0.0};
+    for (u32 mode = 0; mode < 2; mode++) {
+        bool parallel = mode == 1;
+        u64 pixels = 0;
+        for (u32 run = 0; run < runs; run++) {
+            f64 ms = LoadOnce(path, parallel, pixels);
+            if (ms < 0.0) {
+                return 1;
+            }
+            best[mode] = run == 0 ? ms : std::min(best[mode], ms);
+        }
+        std::printf("%-8s %9.1f ms  %7.1f mpixel/s\n", parallel ? "parallel" : "serial", best[mode],
+                    static_cast<f64>(pixels) / (best[mode] * 1000.0));
+    }
+    std::printf("speedup  %9.2fx\n", best[0] / best[1]);
+    return 0;
+}
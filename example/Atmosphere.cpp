@@ -1,27 +1,59 @@
 #include "Atmosphere.h"
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 
 using namespace Horizon;
 
-App::App(u32 _width, u32 _height) noexcept : m_width(_width), mHeight(_height) {}
+App::App(u32 _width, u32 _height, PresentMode present_mode, f32 max_frame_rate) noexcept
+    : m_width(_width), mHeight(_height), m_present_mode(present_mode), m_max_frame_rate(max_frame_rate) {}
 
 void App::Run() noexcept {
 
     m_window = std::make_shared<Window>("horizon", m_width, mHeight);
     m_renderer = std::make_unique<Renderer>(m_window->getWidth(), m_window->getHeight(), m_window);
     m_input_manager = std::make_unique<InputManager>(m_window, m_renderer->GetMainCamera());
+    m_renderer->SetPresentMode(m_present_mode);
+
+    // fifo blocks once the swap chain is full, pacing it to the refresh rate keeps frames from queueing up ahead
+    f32 max_frame_rate = m_max_frame_rate;
+    if (max_frame_rate == 0.0f && m_present_mode == PresentMode::PRESENT_MODE_FIFO) {
+        max_frame_rate = static_cast<f32>(m_window->GetRefreshRate());
+    }
+    m_frame_pacer.SetMaxFrameRate(max_frame_rate);
+    LOG_INFO("frame rate limit: {}", max_frame_rate > 0.0f ? std::to_string(max_frame_rate) : "none");
 
     while (m_window->ShouldClose() == 0) {
+        m_frame_pacer.BeginFrame();
         m_input_manager->ProcessInput();
         m_renderer->Update();
         m_renderer->Render();
+        if (m_frame_pacer.EndFrame()) {
+            const FramePacingStats &stats = m_frame_pacer.GetStats();
+            LOG_DEBUG("present interval: {:.2f} ms mean, {:.2f} ms jitter, {:.2f} ms max, {:.2f} ms frame work",
+                      stats.mean_interval, stats.jitter, stats.max_interval, stats.predicted_work);
+        }
     }
     m_renderer->Wait();
 }
 
+// --present fifo|mailbox|immediate, --fps <max frame rate>
 int main(int argc, char *argv[]) {
+    PresentMode present_mode = PresentMode::PRESENT_MODE_FIFO;
+    f32 max_frame_rate = 0.0f;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--present") == 0) {
+            if (std::strcmp(argv[i + 1], "mailbox") == 0) {
+                present_mode = PresentMode::PRESENT_MODE_MAILBOX;
+            } else if (std::strcmp(argv[i + 1], "immediate") == 0) {
+                present_mode = PresentMode::PRESENT_MODE_IMMEDIATE;
+            }
+        } else if (std::strcmp(argv[i], "--fps") == 0) {
+            max_frame_rate = static_cast<f32>(std::atof(argv[i + 1]));
+        }
+    }
 
-    std::unique_ptr<App> app = std::make_unique<App>(1920, 1080);
+    std::unique_ptr<App> app = std::make_unique<App>(1920, 1080, present_mode, max_frame_rate);
     app->Run();
 
     return 0;
@@ -2,6 +2,8 @@
 
 #include <memory>
 
+#include <runtime/core/time/FramePacer.h>
+
 #include <runtime/function/input/InputManager.h>
 #include <runtime/function/rhi/RenderContext.h>
 #include <runtime/function/window/Window.h>
@@ -9,7 +11,9 @@
 
 class App {
   public:
-    App(Horizon::u32 _width, Horizon::u32 _height) noexcept;
+    // max_frame_rate 0 paces fifo to the monitor's refresh rate and leaves the other modes unlimited
+    App(Horizon::u32 _width, Horizon::u32 _height, Horizon::PresentMode present_mode,
+        Horizon::f32 max_frame_rate) noexcept;
     ~App() noexcept = default;
     App(const App &) = delete;
     App(App &&) = delete;
@@ -21,6 +25,9 @@ class App {
   private:
     Horizon::u32 m_width;
     Horizon::u32 mHeight;
+    Horizon::PresentMode m_present_mode;
+    Horizon::f32 m_max_frame_rate;
+    Horizon::FramePacer m_frame_pacer;
     std::shared_ptr<Horizon::Window> m_window = nullptr;
     std::unique_ptr<Horizon::Renderer> m_renderer = nullptr;
     std::unique_ptr<Horizon::InputManager> m_input_manager;
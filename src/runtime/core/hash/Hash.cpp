@@ -0,0 +1,60 @@
+#include "Hash.h"
+
+#include <cstring>
+
+namespace Horizon::Hash {
+
+static constexpr u64 MURMUR_M = 0xc6a4a7935bd1e995ull;
+static constexpr i32 MURMUR_R = 47;
+
+u64 Hash64(const void *data, u64 size, u64 seed) noexcept {
+    const u8 *bytes = static_cast<const u8 *>(data);
+    u64 h = seed ^ (size * MURMUR_M);
+
+    u64 block_count = size / 8;
+    for (u64 i = 0; i < block_count; i++) {
+        u64 k;
+        std::memcpy(&k, bytes + i * 8, sizeof(u64));
+        k *= MURMUR_M;
+        k ^= k >> MURMUR_R;
+        k *= MURMUR_M;
+        h ^= k;
+        h *= MURMUR_M;
+    }
+
+    const u8 *tail = bytes + block_count * 8;
+    switch (size & 7) {
+    case 7:
+        h ^= u64(tail[6]) << 48;
+        [[fallthrough]];
+    case 6:
+        h ^= u64(tail[5]) << 40;
+        [[fallthrough]];
+    case 5:
+        h ^= u64(tail[4]) << 32;
+        [[fallthrough]];
+    case 4:
+        h ^= u64(tail[3]) << 24;
+        [[fallthrough]];
+    case 3:
+        h ^= u64(tail[2]) << 16;
+        [[fallthrough]];
+    case 2:
+        h ^= u64(tail[1]) << 8;
+        [[fallthrough]];
+    case 1:
+        h ^= u64(tail[0]);
+        h *= MURMUR_M;
+    }
+
+    h ^= h >> MURMUR_R;
+    h *= MURMUR_M;
+    h ^= h >> MURMUR_R;
+    return h;
+}
+
+u64 Hash64(const std::string &string, u64 seed) noexcept { return Hash64(string.data(), string.size(), seed); }
+
+u64 Combine(u64 seed, u64 value) noexcept { return Hash64(&value, sizeof(u64), seed); }
+
+} // namespace Horizon::Hash
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+#include <runtime/core/math/Math.h>
+
+// non cryptographic hashing for cache keys
+namespace Horizon::Hash {
+
+// MurmurHash64A over a byte range
+u64 Hash64(const void *data, u64 size, u64 seed = 0) noexcept;
+
+u64 Hash64(const std::string &string, u64 seed = 0) noexcept;
+
+// fold a value into a running hash
+u64 Combine(u64 seed, u64 value) noexcept;
+
+} // namespace Horizon::Hash
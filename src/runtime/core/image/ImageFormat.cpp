@@ -0,0 +1,201 @@
+#include "ImageFormat.h"
+#include "Mipmap.h"
+
+#include <cstring>
+
+namespace Horizon::ImageFormat {
+
+u32 GetBlockSize(VkFormat format) noexcept {
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return 4;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return 8;
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+bool IsBlockCompressed(VkFormat format) noexcept {
+    return GetBlockSize(format) != 0 && GetUnormFormat(format) != VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+u64 GetLevelSize(VkFormat format, u32 width, u32 height) noexcept {
+    if (!IsBlockCompressed(format)) {
+        return static_cast<u64>(width) * height * GetBlockSize(format);
+    }
+    return static_cast<u64>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+u64 GetChainSize(VkFormat format, u32 width, u32 height, u32 level_count) noexcept {
+    u64 size = 0;
+    for (u32 level = 0; level < level_count; level++) {
+        size += GetLevelSize(format, Mipmap::GetLevelExtent(width, level), Mipmap::GetLevelExtent(height, level));
+    }
+    return size;
+}
+
+VkFormat GetUnormFormat(VkFormat format) noexcept {
+    switch (format) {
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+        return VK_FORMAT_BC3_UNORM_BLOCK;
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+    default:
+        return format;
+    }
+}
+
+bool CanDecode(VkFormat format) noexcept {
+    switch (GetUnormFormat(format)) {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static u16 ReadU16(const u8 *data) noexcept { return static_cast<u16>(data[0] | (data[1] << 8)); }
+
+static void Unpack565(u16 color, u8 *rgb) noexcept {
+    u32 r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    rgb[0] = static_cast<u8>((r << 3) | (r >> 2));
+    rgb[1] = static_cast<u8>((g << 2) | (g >> 4));
+    rgb[2] = static_cast<u8>((b << 3) | (b >> 2));
+}
+
+// 16 rgba texels of a color block, bc1 switches to three colors and transparent black when c0 <= c1
+static void DecodeColorBlock(const u8 *block, bool allow_punch_through, u8 texels[16][4]) noexcept {
+    u16 c0 = ReadU16(block), c1 = ReadU16(block + 2);
+    u8 palette[4][4] = {};
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for (u32 c = 0; c < 3; c++) {
+        if (c0 > c1 || !allow_punch_through) {
+            palette[2][c] = static_cast<u8>((2 * palette[0][c] + palette[1][c]) / 3);
+            palette[3][c] = static_cast<u8>((palette[0][c] + 2 * palette[1][c]) / 3);
+        } else {
+            palette[2][c] = static_cast<u8>((palette[0][c] + palette[1][c]) / 2);
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = c0 > c1 || !allow_punch_through ? 255 : 0;
+
+    u32 indices;
+    std::memcpy(&indices, block + 4, sizeof(u32));
+    for (u32 t = 0; t < 16; t++) {
+        std::memcpy(texels[t], palette[(indices >> (2 * t)) & 3], 4);
+    }
+}
+
+// 16 values of a bc4 style block, also the alpha of bc3 and both channels of bc5
+static void DecodeChannelBlock(const u8 *block, u8 values[16]) noexcept {
+    u32 a0 = block[0], a1 = block[1];
+    u8 palette[8] = {static_cast<u8>(a0), static_cast<u8>(a1)};
+    if (a0 > a1) {
+        for (u32 i = 2; i < 8; i++) {
+            palette[i] = static_cast<u8>(((8 - i) * a0 + (i - 1) * a1) / 7);
+        }
+    } else {
+        for (u32 i = 2; i < 6; i++) {
+            palette[i] = static_cast<u8>(((6 - i) * a0 + (i - 1) * a1) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    u64 indices = 0;
+    std::memcpy(&indices, block + 2, 6);
+    for (u32 t = 0; t < 16; t++) {
+        values[t] = palette[(indices >> (3 * t)) & 7];
+    }
+}
+
+bool DecodeRgba8(VkFormat format, const u8 *data, u32 width, u32 height, u8 *rgba) noexcept {
+    format = GetUnormFormat(format);
+    if (!CanDecode(format)) {
+        return false;
+    }
+    if (format == VK_FORMAT_R8G8B8A8_UNORM) {
+        std::memcpy(rgba, data, GetLevelSize(format, width, height));
+        return true;
+    }
+
+    u32 block_size = GetBlockSize(format);
+    u32 blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+    for (u32 by = 0; by < blocks_y; by++) {
+        for (u32 bx = 0; bx < blocks_x; bx++) {
+            const u8 *block = data + (static_cast<u64>(by) * blocks_x + bx) * block_size;
+            u8 texels[16][4];
+            u8 values[16];
+            switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+                DecodeColorBlock(block, true, texels);
+                for (u32 t = 0; t < 16; t++) {
+                    texels[t][3] = 255;
+                }
+                break;
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+                DecodeColorBlock(block, true, texels);
+                break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+                DecodeColorBlock(block + 8, false, texels);
+                DecodeChannelBlock(block, values);
+                for (u32 t = 0; t < 16; t++) {
+                    texels[t][3] = values[t];
+                }
+                break;
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                DecodeChannelBlock(block, values);
+                for (u32 t = 0; t < 16; t++) {
+                    texels[t][0] = values[t];
+                    texels[t][1] = texels[t][2] = 0;
+                    texels[t][3] = 255;
+                }
+                break;
+            default:
+                DecodeChannelBlock(block, values);
+                for (u32 t = 0; t < 16; t++) {
+                    texels[t][0] = values[t];
+                }
+                DecodeChannelBlock(block + 8, values);
+                for (u32 t = 0; t < 16; t++) {
+                    texels[t][1] = values[t];
+                    texels[t][2] = 0;
+                    texels[t][3] = 255;
+                }
+                break;
+            }
+            // blocks on the right and bottom edge hang over the image
+            for (u32 y = 0; y < 4 && by * 4 + y < height; y++) {
+                for (u32 x = 0; x < 4 && bx * 4 + x < width; x++) {
+                    std::memcpy(rgba + ((static_cast<u64>(by) * 4 + y) * width + bx * 4 + x) * 4, texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace Horizon::ImageFormat
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <runtime/core/math/Math.h>
+
+// texel layout of the formats textures are loaded in: rgba8 and the bc block formats
+namespace Horizon::ImageFormat {
+
+// bytes of one 4x4 block, or of one texel for rgba8. 0 for formats the loader does not handle
+u32 GetBlockSize(VkFormat format) noexcept;
+
+bool IsBlockCompressed(VkFormat format) noexcept;
+
+u64 GetLevelSize(VkFormat format, u32 width, u32 height) noexcept;
+
+// bytes of the first level_count levels stored back to back largest first
+u64 GetChainSize(VkFormat format, u32 width, u32 height, u32 level_count) noexcept;
+
+// srgb formats are sampled through the unorm format with the same bits, shaders expect the raw values like with the
+// rgba8 path
+VkFormat GetUnormFormat(VkFormat format) noexcept;
+
+// cpu fallback for devices that cannot sample a block format, bc7 has no decoder
+bool CanDecode(VkFormat format) noexcept;
+
+// expands one level to tightly packed rgba8, single channel formats fill the missing channels like a sampler would
+bool DecodeRgba8(VkFormat format, const u8 *data, u32 width, u32 height, u8 *rgba) noexcept;
+
+} // namespace Horizon::ImageFormat
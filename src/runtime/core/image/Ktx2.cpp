@@ -0,0 +1,114 @@
+#include "Ktx2.h"
+#include "ImageFormat.h"
+#include "Mipmap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Horizon::Ktx2 {
+
+static constexpr u8 IDENTIFIER[12] = {0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n'};
+
+static constexpr u32 SUPERCOMPRESSION_NONE = 0;
+static constexpr u32 SUPERCOMPRESSION_BASIS_LZ = 1;
+
+// file layout up to the level index
+struct Header {
+    u8 identifier[12];
+    u32 vk_format;
+    u32 type_size;
+    u32 pixel_width;
+    u32 pixel_height;
+    u32 pixel_depth;
+    u32 layer_count;
+    u32 face_count;
+    u32 level_count;
+    u32 supercompression_scheme;
+    u32 dfd_byte_offset;
+    u32 dfd_byte_length;
+    u32 kvd_byte_offset;
+    u32 kvd_byte_length;
+    u64 sgd_byte_offset;
+    u64 sgd_byte_length;
+};
+static_assert(sizeof(Header) == 80);
+
+struct LevelIndex {
+    u64 byte_offset;
+    u64 byte_length;
+    u64 uncompressed_byte_length;
+};
+
+bool IsKtx2(const u8 *data, u64 size) noexcept {
+    return size >= sizeof(IDENTIFIER) && std::memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) == 0;
+}
+
+bool Parse(const u8 *data, u64 size, Image &image, std::string &error) noexcept {
+    if (!IsKtx2(data, size) || size < sizeof(Header)) {
+        error = "not a ktx2 file";
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    // universal payloads carry no vulkan format and need a basis transcoder, which is left out on purpose. the caller
+    // falls back to the plain source of the texture, ktx2 files have to be written with a vk block format instead
+    if (header.vk_format == VK_FORMAT_UNDEFINED || header.supercompression_scheme == SUPERCOMPRESSION_BASIS_LZ) {
+        error = "basis universal payloads are not supported without a transcoder";
+        return false;
+    }
+    if (header.supercompression_scheme != SUPERCOMPRESSION_NONE) {
+        error = "supercompression scheme " + std::to_string(header.supercompression_scheme) + " is not supported";
+        return false;
+    }
+    VkFormat format = static_cast<VkFormat>(header.vk_format);
+    if (ImageFormat::GetBlockSize(format) == 0) {
+        error = "vk format " + std::to_string(header.vk_format) + " is not supported";
+        return false;
+    }
+    if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1 || header.layer_count > 1 ||
+        header.face_count != 1) {
+        error = "only single 2d images are supported";
+        return false;
+    }
+
+    u32 level_count = std::max(header.level_count, 1u);
+    if (level_count > Mipmap::GetLevelCount(header.pixel_width, header.pixel_height) ||
+        sizeof(Header) + sizeof(LevelIndex) * level_count > size) {
+        error = "broken level index";
+        return false;
+    }
+    image.format = format;
+    image.width = header.pixel_width;
+    image.height = header.pixel_height;
+    image.levels.resize(level_count);
+    for (u32 level = 0; level < level_count; level++) {
+        LevelIndex index;
+        std::memcpy(&index, data + sizeof(Header) + sizeof(LevelIndex) * level, sizeof(LevelIndex));
+        u64 level_size = ImageFormat::GetLevelSize(format, Mipmap::GetLevelExtent(image.width, level),
+                                                   Mipmap::GetLevelExtent(image.height, level));
+        if (index.byte_offset > size || index.byte_length > size - index.byte_offset ||
+            index.byte_length < level_size) {
+            error = "level " + std::to_string(level) + " is out of bounds";
+            return false;
+        }
+        image.levels[level] = {data + index.byte_offset, level_size};
+    }
+    return true;
+}
+
+std::vector<u8> PackLevels(const Image &image) noexcept {
+    u64 size = 0;
+    for (const Level &level : image.levels) {
+        size += level.size;
+    }
+    std::vector<u8> ret(size);
+    u8 *dst = ret.data();
+    for (const Level &level : image.levels) {
+        std::memcpy(dst, level.data, level.size);
+        dst += level.size;
+    }
+    return ret;
+}
+
+} // namespace Horizon::Ktx2
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <runtime/core/math/Math.h>
+
+// reader for ktx2 containers holding a single 2d image, levels are referenced in place
+namespace Horizon::Ktx2 {
+
+struct Level {
+    const u8 *data = nullptr;
+    u64 size = 0;
+};
+
+struct Image {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    u32 width = 0;
+    u32 height = 0;
+    // largest first, a container that asks for generated mips has one level
+    std::vector<Level> levels;
+};
+
+bool IsKtx2(const u8 *data, u64 size) noexcept;
+
+// false with a reason for anything the texture upload cannot take as is: supercompression, basis universal payloads,
+// arrays, cube maps, 3d images and formats outside ImageFormat. there is no basis transcoder in the tree, so etc1s and
+// uastc files are rejected rather than transcoded and only ktx2 that already holds a vk block format loads
+bool Parse(const u8 *data, u64 size, Image &image, std::string &error) noexcept;
+
+// levels copied back to back largest first, files store them the other way round
+std::vector<u8> PackLevels(const Image &image) noexcept;
+
+} // namespace Horizon::Ktx2
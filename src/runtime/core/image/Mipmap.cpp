@@ -0,0 +1,106 @@
+#include "Mipmap.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Horizon::Mipmap {
+
+static constexpr u32 SRGB_ENCODE_STEPS = 4096;
+
+struct SrgbTables {
+    std::array<f32, 256> decode;
+    std::array<u8, SRGB_ENCODE_STEPS> encode;
+
+    SrgbTables() noexcept {
+        for (u32 i = 0; i < 256; i++) {
+            f32 c = i / 255.0f;
+            decode[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (u32 i = 0; i < SRGB_ENCODE_STEPS; i++) {
+            f32 l = i / static_cast<f32>(SRGB_ENCODE_STEPS - 1);
+            f32 c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            encode[i] = static_cast<u8>(c * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const SrgbTables &GetSrgbTables() noexcept {
+    static const SrgbTables tables;
+    return tables;
+}
+
+u32 GetLevelCount(u32 width, u32 height) noexcept {
+    u32 extent = std::max(width, height);
+    u32 count = 1;
+    while (extent > 1) {
+        extent >>= 1;
+        count++;
+    }
+    return count;
+}
+
+u32 GetLevelExtent(u32 extent, u32 level) noexcept { return std::max(extent >> level, 1u); }
+
+u64 GetChainSize(u32 width, u32 height, u32 level_count) noexcept {
+    u64 size = 0;
+    for (u32 level = 0; level < level_count; level++) {
+        size += static_cast<u64>(GetLevelExtent(width, level)) * GetLevelExtent(height, level) * 4;
+    }
+    return size;
+}
+
+// source texels [begin, end) of a destination texel along one axis
+static void GetFootprint(u32 dst, u32 dst_extent, u32 src_extent, u32 &begin, u32 &end) noexcept {
+    begin = std::min(dst * 2, src_extent - 1);
+    end = dst + 1 == dst_extent ? src_extent : std::min(dst * 2 + 2, src_extent);
+}
+
+static void DownsampleLevel(const u8 *src, u32 src_width, u32 src_height, u8 *dst, u32 dst_width, u32 dst_height,
+                            bool srgb) noexcept {
+    const SrgbTables &tables = GetSrgbTables();
+    for (u32 y = 0; y < dst_height; y++) {
+        u32 y0, y1;
+        GetFootprint(y, dst_height, src_height, y0, y1);
+        for (u32 x = 0; x < dst_width; x++) {
+            u32 x0, x1;
+            GetFootprint(x, dst_width, src_width, x0, x1);
+            f32 sum[4] = {};
+            for (u32 sy = y0; sy < y1; sy++) {
+                const u8 *row = src + (static_cast<u64>(sy) * src_width + x0) * 4;
+                for (u32 sx = x0; sx < x1; sx++, row += 4) {
+                    for (u32 c = 0; c < 3; c++) {
+                        sum[c] += srgb ? tables.decode[row[c]] : row[c] / 255.0f;
+                    }
+                    sum[3] += row[3] / 255.0f;
+                }
+            }
+            f32 weight = 1.0f / static_cast<f32>((x1 - x0) * (y1 - y0));
+            u8 *texel = dst + (static_cast<u64>(y) * dst_width + x) * 4;
+            for (u32 c = 0; c < 4; c++) {
+                f32 value = std::min(sum[c] * weight, 1.0f);
+                texel[c] = srgb && c < 3 ? tables.encode[static_cast<u32>(value * (SRGB_ENCODE_STEPS - 1) + 0.5f)]
+                                         : static_cast<u8>(value * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+std::vector<u8> GenerateRgba8(const u8 *pixels, u32 width, u32 height, bool srgb) noexcept {
+    u32 level_count = GetLevelCount(width, height);
+    std::vector<u8> chain(GetChainSize(width, height, level_count));
+    std::memcpy(chain.data(), pixels, static_cast<u64>(width) * height * 4);
+
+    u8 *src = chain.data();
+    for (u32 level = 1; level < level_count; level++) {
+        u32 src_width = GetLevelExtent(width, level - 1), src_height = GetLevelExtent(height, level - 1);
+        u8 *dst = src + static_cast<u64>(src_width) * src_height * 4;
+        DownsampleLevel(src, src_width, src_height, dst, GetLevelExtent(width, level), GetLevelExtent(height, level),
+                        srgb);
+        src = dst;
+    }
+    return chain;
+}
+
+} // namespace Horizon::Mipmap
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+
+// cpu mip chains of tightly packed rgba8 images, levels are stored back to back largest first down to 1x1
+namespace Horizon::Mipmap {
+
+u32 GetLevelCount(u32 width, u32 height) noexcept;
+
+// extent of a level along one axis, never below 1
+u32 GetLevelExtent(u32 extent, u32 level) noexcept;
+
+// bytes of the first level_count levels
+u64 GetChainSize(u32 width, u32 height, u32 level_count) noexcept;
+
+// box filters the base level down to 1x1, the result starts with a copy of the base level. an odd extent folds the
+// last three source texels into one. srgb color channels are averaged in linear space, alpha always is linear
+std::vector<u8> GenerateRgba8(const u8 *pixels, u32 width, u32 height, bool srgb) noexcept;
+
+} // namespace Horizon::Mipmap
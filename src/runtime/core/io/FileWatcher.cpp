@@ -0,0 +1,25 @@
+#include "FileWatcher.h"
+
+namespace Horizon {
+
+static std::filesystem::file_time_type GetWriteTime(const std::string &path) noexcept {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
+
+void FileWatcher::Watch(const std::string &path) noexcept { m_files.emplace(path, GetWriteTime(path)); }
+
+std::vector<std::string> FileWatcher::Poll() noexcept {
+    std::vector<std::string> changed;
+    for (auto &[path, time] : m_files) {
+        std::filesystem::file_time_type current = GetWriteTime(path);
+        if (current != time) {
+            time = current;
+            changed.push_back(path);
+        }
+    }
+    return changed;
+}
+
+} // namespace Horizon
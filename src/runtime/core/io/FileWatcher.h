@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Horizon {
+
+// polls the modification times of a set of files, no os notification is involved
+class FileWatcher {
+  public:
+    // the current modification time of path is the baseline, watching a path again keeps the first one.
+    // a missing file counts as changed once it appears
+    void Watch(const std::string &path) noexcept;
+
+    // the watched files whose modification time moved since they were watched or last returned
+    std::vector<std::string> Poll() noexcept;
+
+  private:
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_files;
+};
+
+} // namespace Horizon
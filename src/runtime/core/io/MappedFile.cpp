@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) noexcept {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("failed to open {}", path);
+        return;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        LOG_ERROR("failed to map {}, empty file", path);
+        CloseHandle(file);
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        LOG_ERROR("failed to map {}", path);
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const u8 *>(data);
+    m_size = static_cast<u64>(size.QuadPart);
+}
+
+void MappedFile::Release() noexcept {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+        m_data = nullptr;
+        m_mapping = nullptr;
+        m_file = nullptr;
+        m_size = 0;
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) noexcept {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("failed to open {}", path);
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        LOG_ERROR("failed to map {}, empty file", path);
+        close(fd);
+        return;
+    }
+    void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file referenced
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("failed to map {}", path);
+        return;
+    }
+    m_data = static_cast<const u8 *>(data);
+    m_size = static_cast<u64>(st.st_size);
+}
+
+void MappedFile::Release() noexcept {
+    if (m_data) {
+        munmap(const_cast<u8 *>(m_data), static_cast<size_t>(m_size));
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() noexcept { Release(); }
+
+bool MappedFile::IsValid() const noexcept { return m_data != nullptr; }
+
+const u8 *MappedFile::GetData() const noexcept { return m_data; }
+
+u64 MappedFile::GetSize() const noexcept { return m_size; }
+
+} // namespace Horizon
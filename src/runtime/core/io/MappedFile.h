@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// read only memory mapping of a whole file, pages are faulted in on first access and shared with the page cache
+class MappedFile {
+  public:
+    MappedFile(const std::string &path) noexcept;
+    ~MappedFile() noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+
+    bool IsValid() const noexcept;
+    const u8 *GetData() const noexcept;
+    u64 GetSize() const noexcept;
+
+    // unmap early, every pointer into the mapping becomes invalid
+    void Release() noexcept;
+
+  private:
+    const u8 *m_data = nullptr;
+    u64 m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+} // namespace Horizon
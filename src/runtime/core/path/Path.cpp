@@ -13,7 +13,11 @@ std::string GetModelPath(const std::string &_path) noexcept { return GetAssetsPa
 std::string GetShaderPath(const std::string &_path) noexcept {
     return GetAssetsPath().append("/shaders/spirv/").append(_path);
 }
+std::string GetShaderSourcePath(const std::string &_path) noexcept {
+    return GetAssetsPath().append("/shaders/").append(_path);
+}
 std::string GetTexturePath(const std::string &_path) noexcept {
     return GetAssetsPath().append("/textures/").append(_path);
 }
+std::string GetCachePath(const std::string &_path) noexcept { return GetAssetsPath().append("/cache/").append(_path); }
 } // namespace Horizon::Path
\ No newline at end of file
@@ -10,4 +10,8 @@ static std::string GetAssetsPath() noexcept;
 std::string GetModelPath(const std::string &_path) noexcept;
 std::string GetTexturePath(const std::string &_path) noexcept;
 std::string GetShaderPath(const std::string &_path) noexcept;
+// the glsl sources the spirv is compiled from
+std::string GetShaderSourcePath(const std::string &_path) noexcept;
+// generated files, safe to delete
+std::string GetCachePath(const std::string &_path) noexcept;
 } // namespace Horizon::Path
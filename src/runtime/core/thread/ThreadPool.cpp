@@ -0,0 +1,97 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace Horizon {
+
+ThreadPool::ThreadPool() noexcept {
+    u32 worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    for (u32 i = 0; i < worker_count; i++) {
+        m_workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for (auto &worker : m_workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) noexcept {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::ParallelFor(u32 count, u32 min_chunk_size, const std::function<void(u32, u32)> &func) noexcept {
+    if (count == 0) {
+        return;
+    }
+    u32 max_chunks = GetWorkerCount() + 1;
+    u32 chunk_count = std::min(max_chunks, (count + std::max(min_chunk_size, 1u) - 1) / std::max(min_chunk_size, 1u));
+    if (chunk_count <= 1) {
+        func(0, count);
+        return;
+    }
+
+    u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+    std::atomic<u32> remaining{chunk_count - 1};
+    for (u32 chunk = 1; chunk < chunk_count; chunk++) {
+        u32 begin = chunk * chunk_size;
+        u32 end = std::min(begin + chunk_size, count);
+        Submit([&func, &remaining, begin, end]() {
+            if (begin < end) {
+                func(begin, end);
+            }
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    func(0, std::min(chunk_size, count));
+
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (!RunPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+u32 ThreadPool::GetWorkerCount() const noexcept { return static_cast<u32>(m_workers.size()); }
+
+bool ThreadPool::RunPendingTask() noexcept {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_tasks.empty()) {
+            return false;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop() noexcept {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            if (m_stop && m_tasks.empty()) {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace Horizon
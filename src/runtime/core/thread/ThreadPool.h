@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+#include <runtime/core/singleton/public_singleton.h>
+
+namespace Horizon {
+
+// fixed size worker pool shared by the engine
+class ThreadPool : public PublicSingleton<ThreadPool> {
+  public:
+    ThreadPool() noexcept;
+    ~ThreadPool() noexcept override;
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+    void Submit(std::function<void()> task) noexcept;
+
+    // split [0, count) into chunks of at least min_chunk_size and run func(begin, end) on each.
+    // the calling thread works on queued tasks while waiting, so nested calls from workers cannot deadlock.
+    void ParallelFor(u32 count, u32 min_chunk_size, const std::function<void(u32, u32)> &func) noexcept;
+
+    u32 GetWorkerCount() const noexcept;
+
+    // run one queued task on the calling thread, false if the queue is empty
+    bool RunPendingTask() noexcept;
+
+  private:
+    void WorkerLoop() noexcept;
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+};
+
+} // namespace Horizon
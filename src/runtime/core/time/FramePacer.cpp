@@ -0,0 +1,89 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace Horizon {
+
+FramePacer::FramePacer(f32 max_frame_rate) noexcept { SetMaxFrameRate(max_frame_rate); }
+
+void FramePacer::SetMaxFrameRate(f32 max_frame_rate) noexcept {
+    m_max_frame_rate = std::max(max_frame_rate, 0.0f);
+    m_period = m_max_frame_rate > 0.0f ? std::chrono::duration_cast<Clock::duration>(
+                                             std::chrono::duration<f64>(1.0 / m_max_frame_rate))
+                                       : Clock::duration::zero();
+    // the next frame starts a new schedule
+    m_deadline = Clock::time_point{};
+}
+
+f32 FramePacer::GetMaxFrameRate() const noexcept { return m_max_frame_rate; }
+
+void FramePacer::BeginFrame() noexcept {
+    if (m_period != Clock::duration::zero()) {
+        Clock::time_point now = Clock::now();
+        // first frame or too late to catch up, schedule from now instead of rushing the frames behind
+        if (m_deadline == Clock::time_point{} || m_deadline + m_period < now) {
+            m_deadline = now;
+        } else {
+            m_deadline += m_period;
+        }
+        auto lead = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<f64, std::milli>(m_predicted_work + SAFETY_MARGIN));
+        WaitUntil(m_deadline - lead);
+    }
+    m_frame_start = Clock::now();
+}
+
+bool FramePacer::EndFrame() noexcept {
+    Clock::time_point now = Clock::now();
+    f64 work = ToMs(now - m_frame_start);
+    m_predicted_work = std::max(work, m_predicted_work * 0.95 + work * 0.05);
+    // the frame cannot present before it is done
+    if (m_period != Clock::duration::zero() && now > m_deadline) {
+        m_deadline = now;
+    }
+
+    if (!m_has_present) {
+        m_has_present = true;
+        m_last_present = now;
+        return false;
+    }
+    f64 interval = ToMs(now - m_last_present);
+    m_last_present = now;
+    m_interval_count++;
+    m_interval_sum += interval;
+    m_interval_square_sum += interval * interval;
+    m_interval_max = std::max(m_interval_max, interval);
+    if (m_interval_count < STATS_WINDOW) {
+        return false;
+    }
+
+    m_stats.frames = m_interval_count;
+    m_stats.mean_interval = m_interval_sum / m_interval_count;
+    f64 variance = m_interval_square_sum / m_interval_count - m_stats.mean_interval * m_stats.mean_interval;
+    m_stats.jitter = std::sqrt(std::max(variance, 0.0));
+    m_stats.max_interval = m_interval_max;
+    m_stats.predicted_work = m_predicted_work;
+    m_interval_count = 0;
+    m_interval_sum = m_interval_square_sum = m_interval_max = 0.0;
+    return true;
+}
+
+const FramePacingStats &FramePacer::GetStats() const noexcept { return m_stats; }
+
+void FramePacer::WaitUntil(Clock::time_point time) noexcept {
+    f64 remaining = ToMs(time - Clock::now());
+    if (remaining > SPIN_THRESHOLD) {
+        std::this_thread::sleep_for(std::chrono::duration<f64, std::milli>(remaining - SPIN_THRESHOLD));
+    }
+    while (Clock::now() < time) {
+        std::this_thread::yield();
+    }
+}
+
+f64 FramePacer::ToMs(Clock::duration duration) noexcept {
+    return std::chrono::duration<f64, std::milli>(duration).count();
+}
+
+} // namespace Horizon
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+struct FramePacingStats {
+    u32 frames = 0;
+    // present to present intervals in ms
+    f64 mean_interval = 0.0;
+    f64 jitter = 0.0; // standard deviation
+    f64 max_interval = 0.0;
+    // start of a frame to its present returning, what the pacer schedules ahead of the deadline
+    f64 predicted_work = 0.0;
+};
+
+// caps the frame rate and starts each frame as late as it can still present on time. a frame's deadline is one
+// period after the last one, the pacer waits until the deadline minus the predicted cpu and gpu time of a frame, so
+// input is sampled and commands are recorded just before they are needed instead of a frame ahead. the wait sleeps
+// until shortly before the wake up time and spins the rest, os sleeps overshoot by up to a scheduler tick
+class FramePacer {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // the part of a wait left to spinning
+    static constexpr f64 SPIN_THRESHOLD = 2.0;
+    // slack added to the predicted frame time
+    static constexpr f64 SAFETY_MARGIN = 0.5;
+    // present intervals per stats window
+    static constexpr u32 STATS_WINDOW = 240;
+
+    // 0 does not limit, frames then only report their present intervals
+    FramePacer(f32 max_frame_rate = 0.0f) noexcept;
+    ~FramePacer() noexcept = default;
+
+    void SetMaxFrameRate(f32 max_frame_rate) noexcept;
+    f32 GetMaxFrameRate() const noexcept;
+
+    // blocks until the next frame should start, call before sampling input
+    void BeginFrame() noexcept;
+    // call once the frame was presented, true when a stats window completed
+    bool EndFrame() noexcept;
+
+    // the last completed stats window
+    const FramePacingStats &GetStats() const noexcept;
+
+  private:
+    static void WaitUntil(Clock::time_point time) noexcept;
+    static f64 ToMs(Clock::duration duration) noexcept;
+
+  private:
+    f32 m_max_frame_rate = 0.0f;
+    Clock::duration m_period{};
+    Clock::time_point m_deadline{};
+    Clock::time_point m_frame_start{};
+    Clock::time_point m_last_present{};
+    bool m_has_present = false;
+    // decays slowly and follows spikes at once, a late frame costs more latency than an early one
+    f64 m_predicted_work = 0.0;
+
+    // running sums of the current window
+    u32 m_interval_count = 0;
+    f64 m_interval_sum = 0.0;
+    f64 m_interval_square_sum = 0.0;
+    f64 m_interval_max = 0.0;
+    FramePacingStats m_stats;
+};
+
+} // namespace Horizon
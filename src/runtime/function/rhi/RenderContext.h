@@ -5,10 +5,55 @@
 
 namespace Horizon {
 
+enum class VertexFormat {
+    // f32 position, normal and uv, 32 bytes
+    VERTEX_FORMAT_FULL,
+    // unorm16 position relative to the primitive aabb, octahedral snorm16 normal, f16 uv, 16 bytes
+    VERTEX_FORMAT_COMPRESSED
+};
+
+enum class PresentMode {
+    // waits for vertical blank, never tears, always available
+    PRESENT_MODE_FIFO,
+    // waits for vertical blank but replaces the queued image, never tears and never blocks the renderer
+    PRESENT_MODE_MAILBOX,
+    // presents at once and may tear
+    PRESENT_MODE_IMMEDIATE
+};
+
+enum class AtmosphereQuality {
+    // half the lut extents of high, an eighth of the scattering lut
+    ATMOSPHERE_QUALITY_LOW,
+    ATMOSPHERE_QUALITY_HIGH
+};
+
 struct RenderContext {
     u32 width;
     u32 height;
     u32 swap_chain_image_count = 3;
+    // falls back to fifo when the surface does not support it
+    PresentMode present_mode = PresentMode::PRESENT_MODE_FIFO;
+    // layout of model vertex buffers and the geometry pass vertex input
+    VertexFormat vertex_format = VertexFormat::VERTEX_FORMAT_FULL;
+    // device memory streamed model textures may take, their coarse tails stay resident beyond it
+    u64 texture_budget = 512ull * 1024 * 1024;
+    // geometry draws read every material from one descriptor set through a pushed index, needs descriptor indexing
+    // and falls back to a descriptor set per material without it
+    bool bindless_materials = true;
+    // the geometry, light and sky passes render into the top left render_scale of their targets, which keep the
+    // output size, and the post process pass upscales to the swap chain. with dynamic resolution the scale follows
+    // the measured gpu frame time, between min_render_scale and 1
+    f32 render_scale = 1.0f;
+    bool dynamic_resolution = true;
+    f32 target_frame_time = 1000.0f / 60.0f;
+    f32 min_render_scale = 0.5f;
+    // gpu time in ms a frame spends on an atmosphere lut recompute, see Atmosphere::RequestRecompute
+    f32 atmosphere_step_budget = 1.0f;
+    // lut extents of the atmosphere pass, see AtmosphereLutSize
+    AtmosphereQuality atmosphere_quality = AtmosphereQuality::ATMOSPHERE_QUALITY_HIGH;
+    // rebuilds the pipelines whose glsl sources change on disk between frames, see PipelineManager::Update. does
+    // nothing without shaderc
+    bool shader_hot_reload = true;
 };
 
 enum class DescriptorType {
@@ -341,6 +386,8 @@ inline VkImageUsageFlags ToVkImageUsage(u32 usage) {
     if ((usage & TextureUsage::TEXTURE_USAGE_RW) != 0u) {
         flags |= VK_IMAGE_USAGE_STORAGE_BIT;
         flags |= VK_IMAGE_USAGE_SAMPLED_BIT;
+        // read back and filled from the cpu, see Texture::ReadTexels
+        flags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     }
     if (flags == 0) {
         LOG_ERROR("invalid image usage: ", usage);
@@ -24,17 +24,26 @@ CommandBuffer::~CommandBuffer() {
 
 VkCommandBuffer CommandBuffer::Get(u32 i) const noexcept { return m_command_buffers[i]; }
 
-void CommandBuffer::submit(std::shared_ptr<SwapChain> swap_chain) {
+bool CommandBuffer::submit(std::shared_ptr<SwapChain> swap_chain) {
     vkWaitForFences(m_device->Get(), 1, &m_in_flight_fences[m_current_frame], VK_TRUE, UINT64_MAX);
 
     uint32_t imageIndex;
-    vkAcquireNextImageKHR(m_device->Get(), swap_chain->Get(), UINT64_MAX, m_image_available_semaphores[m_current_frame],
-                          VK_NULL_HANDLE, &imageIndex);
+    VkResult acquire_result =
+        vkAcquireNextImageKHR(m_device->Get(), swap_chain->Get(), UINT64_MAX,
+                              m_image_available_semaphores[m_current_frame], VK_NULL_HANDLE, &imageIndex);
+    // nothing was signaled, the fence stays signaled for the next attempt
+    if (acquire_result == VK_ERROR_OUT_OF_DATE_KHR) {
+        return false;
+    }
+    if (acquire_result != VK_SUBOPTIMAL_KHR) {
+        CHECK_VK_RESULT(acquire_result);
+    }
 
     if (m_images_in_flight[imageIndex] != VK_NULL_HANDLE) {
         vkWaitForFences(m_device->Get(), 1, &m_images_in_flight[imageIndex], VK_TRUE, UINT64_MAX);
     }
     m_images_in_flight[imageIndex] = m_in_flight_fences[m_current_frame];
+    m_last_image_index = imageIndex;
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -68,12 +77,21 @@ void CommandBuffer::submit(std::shared_ptr<SwapChain> swap_chain) {
 
     presentInfo.pImageIndices = &imageIndex;
 
-    vkQueuePresentKHR(m_device->getPresnetQueue(), &presentInfo);
+    VkResult present_result = vkQueuePresentKHR(m_device->getPresnetQueue(), &presentInfo);
 
     m_current_frame = (m_current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
     vkQueueWaitIdle(m_device->getGraphicQueue());
+
+    if (present_result == VK_ERROR_OUT_OF_DATE_KHR || present_result == VK_SUBOPTIMAL_KHR ||
+        acquire_result == VK_SUBOPTIMAL_KHR) {
+        return false;
+    }
+    CHECK_VK_RESULT(present_result);
+    return true;
 }
 
+u32 CommandBuffer::GetLastImageIndex() const noexcept { return m_last_image_index; }
+
 VkCommandPool CommandBuffer::getCommandpool() const noexcept { return m_command_pool; }
 
 void CommandBuffer::createCommandPool() {
@@ -126,8 +144,11 @@ void CommandBuffer::beginRenderPass(u32 index, std::shared_ptr<Pipeline> pipelin
     renderPassInfo.clearValueCount = static_cast<u32>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
     auto viewport = _pipeline->getViewport();
+    VkRect2D scissor = renderPassInfo.renderArea;
     vkCmdBeginRenderPass(m_command_buffers[index], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // both are dynamic, so neither a resize nor a render scale change rebuilds the pipeline
     vkCmdSetViewport(m_command_buffers[index], 0, 1, &viewport);
+    vkCmdSetScissor(m_command_buffers[index], 0, 1, &scissor);
 }
 
 void CommandBuffer::endRenderPass(u32 index) const noexcept { vkCmdEndRenderPass(m_command_buffers[index]); }
@@ -211,6 +232,22 @@ void CommandBuffer::endCommandRecording(u32 i) { CHECK_VK_RESULT(vkEndCommandBuf
 
 void CommandBuffer::Dispatch(u32 i, std::shared_ptr<Pipeline> pipeline,
                              const std::vector<std::shared_ptr<DescriptorSet>> _descriptor_sets) noexcept {
+    Dispatch(m_command_buffers[i], pipeline, _descriptor_sets);
+}
+
+void CommandBuffer::Dispatch(VkCommandBuffer command_buffer, std::shared_ptr<Pipeline> pipeline,
+                             const std::vector<std::shared_ptr<DescriptorSet>> &_descriptor_sets) noexcept {
+    if (pipeline->GetType() != PipelineType::COMPUTE) {
+        LOG_ERROR("incorrect pipeline type");
+        return;
+    }
+    std::shared_ptr<ComputePipeline> _pipeline = std::static_pointer_cast<ComputePipeline>(pipeline);
+    DispatchBase(command_buffer, pipeline, _descriptor_sets, 0, _pipeline->GroupCountY(), 0, _pipeline->GroupCountZ());
+}
+
+void CommandBuffer::DispatchBase(VkCommandBuffer command_buffer, std::shared_ptr<Pipeline> pipeline,
+                                 const std::vector<std::shared_ptr<DescriptorSet>> &_descriptor_sets, u32 base_y,
+                                 u32 group_count_y, u32 base_z, u32 group_count_z) noexcept {
     if (pipeline->GetType() != PipelineType::COMPUTE) {
         LOG_ERROR("incorrect pipeline type");
         return;
@@ -218,7 +255,7 @@ void CommandBuffer::Dispatch(u32 i, std::shared_ptr<Pipeline> pipeline,
 
     if (pipeline->hasPushConstants()) {
         for (auto &pc : pipeline->m_push_constants->ranges) {
-            vkCmdPushConstants(m_command_buffers[i], pipeline->GetLayout(), ToVkShaderStageFlags(pc.stages), pc.offset,
+            vkCmdPushConstants(command_buffer, pipeline->GetLayout(), ToVkShaderStageFlags(pc.stages), pc.offset,
                                pc.size, pc.value);
         }
     }
@@ -229,10 +266,14 @@ void CommandBuffer::Dispatch(u32 i, std::shared_ptr<Pipeline> pipeline,
         for (u32 i = 0; i < _descriptor_sets.size(); i++) {
             descriptor_sets[i] = _descriptor_sets[i]->Get();
         }
-        vkCmdBindDescriptorSets(m_command_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->GetLayout(), 0,
+        vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->GetLayout(), 0,
                                 descriptor_sets.size(), descriptor_sets.data(), 0, 0);
     }
-    vkCmdBindPipeline(m_command_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->Get());
-    vkCmdDispatch(m_command_buffers[i], _pipeline->GroupCountX(), _pipeline->GroupCountY(), _pipeline->GroupCountZ());
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline->Get());
+    if (base_y == 0 && base_z == 0) {
+        vkCmdDispatch(command_buffer, _pipeline->GroupCountX(), group_count_y, group_count_z);
+    } else {
+        vkCmdDispatchBase(command_buffer, 0, base_y, base_z, _pipeline->GroupCountX(), group_count_y, group_count_z);
+    }
 }
-} // namespace Horizon
\ No newline at end of file
+} // namespace Horizon
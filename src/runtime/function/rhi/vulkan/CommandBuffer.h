@@ -16,7 +16,10 @@ class CommandBuffer {
     CommandBuffer(RenderContext &render_context, std::shared_ptr<Device> device);
     ~CommandBuffer();
     VkCommandBuffer Get(u32 i) const noexcept;
-    void submit(std::shared_ptr<SwapChain> swap_chain);
+    // false when the swap chain no longer matches the surface and has to be recreated
+    bool submit(std::shared_ptr<SwapChain> swap_chain);
+    // command buffer of the swap chain image the last submit rendered
+    u32 GetLastImageIndex() const noexcept;
     VkCommandPool getCommandpool() const noexcept;
     void beginRenderPass(u32 index, std::shared_ptr<Pipeline> pipeline, bool is_present = false) const noexcept;
     void endRenderPass(u32 index) const noexcept;
@@ -28,6 +31,14 @@ class CommandBuffer {
     void endCommandRecording(u32 index);
     void Dispatch(u32 i, std::shared_ptr<Pipeline> pipeline,
                   const std::vector<std::shared_ptr<DescriptorSet>> _descriptor_sets) noexcept;
+    // records into a command buffer outside the per image ones, e.g. from beginSingleTimeCommands
+    void Dispatch(VkCommandBuffer command_buffer, std::shared_ptr<Pipeline> pipeline,
+                  const std::vector<std::shared_ptr<DescriptorSet>> &descriptor_sets) noexcept;
+    // every group along x of group_count_y rows from base_y in group_count_z slices from base_z, the shaders see the
+    // global invocation ids of the whole dispatch. a base other than 0 needs a pipeline created with dispatch_base
+    void DispatchBase(VkCommandBuffer command_buffer, std::shared_ptr<Pipeline> pipeline,
+                      const std::vector<std::shared_ptr<DescriptorSet>> &descriptor_sets, u32 base_y, u32 group_count_y,
+                      u32 base_z, u32 group_count_z) noexcept;
 
   private:
     void createCommandPool();
@@ -52,6 +63,7 @@ class CommandBuffer {
     std::vector<VkFence> m_images_in_flight;
     const int MAX_FRAMES_IN_FLIGHT = 2;
     u32 m_current_frame = 0;
+    u32 m_last_image_index = 0;
 };
 
 } // namespace Horizon
\ No newline at end of file
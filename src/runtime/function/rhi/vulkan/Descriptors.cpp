@@ -22,14 +22,26 @@ DescriptorSet::~DescriptorSet() {
 void DescriptorSet::CreateDescriptorSetLayout() {
 
     std::vector<VkDescriptorSetLayoutBinding> bindings(mDescriptorSetInfo->bindingCount);
+    std::vector<VkDescriptorBindingFlags> binding_flags(mDescriptorSetInfo->bindingCount, 0);
+    bool partially_bound = false;
     for (u32 binding = 0; binding < mDescriptorSetInfo->bindingCount; binding++) {
         bindings[binding].binding = binding;
         bindings[binding].descriptorType = ToVkDescriptorType(mDescriptorSetInfo->types[binding]);
-        bindings[binding].descriptorCount = 1;
+        bindings[binding].descriptorCount = mDescriptorSetInfo->counts[binding];
         bindings[binding].stageFlags = ToVkShaderStageFlags(mDescriptorSetInfo->stageFlags[binding]);
+        if (mDescriptorSetInfo->counts[binding] > 1) {
+            binding_flags[binding] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+            partially_bound = true;
+        }
     }
+    VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+    binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    binding_flags_info.bindingCount = static_cast<u32>(binding_flags.size());
+    binding_flags_info.pBindingFlags = binding_flags.data();
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = partially_bound ? &binding_flags_info : nullptr;
     layoutInfo.bindingCount = bindings.size();
     layoutInfo.pBindings = bindings.data();
 
@@ -39,30 +51,45 @@ void DescriptorSet::CreateDescriptorSetLayout() {
 void DescriptorSet::UpdateDescriptorSet(const DescriptorSetUpdateDesc &desc) {
     AllocateDescriptorSet();
     // update descriptor set
-    std::vector<VkWriteDescriptorSet> descriptorWrites(mDescriptorSetInfo->bindingCount);
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    descriptorWrites.reserve(mDescriptorSetInfo->bindingCount);
     for (u32 binding = 0; binding < mDescriptorSetInfo->bindingCount; binding++) {
-        descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[binding].pNext = nullptr;
-        descriptorWrites[binding].dstSet = mSet;
-        descriptorWrites[binding].dstBinding = binding;
-        descriptorWrites[binding].dstArrayElement = 0;
-        descriptorWrites[binding].descriptorCount = 1;
-        descriptorWrites[binding].descriptorType = ToVkDescriptorType(mDescriptorSetInfo->types[binding]);
-
-        switch (descriptorWrites[binding].descriptorType) {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.pNext = nullptr;
+        write.dstSet = mSet;
+        write.dstBinding = binding;
+        write.dstArrayElement = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = ToVkDescriptorType(mDescriptorSetInfo->types[binding]);
+
+        auto image_array = desc.imageArrayMap.find(binding);
+        if (image_array != desc.imageArrayMap.end()) {
+            // partially bound, nothing to write for an empty array
+            if (image_array->second.empty()) {
+                continue;
+            }
+            write.descriptorCount = static_cast<u32>(image_array->second.size());
+            write.pImageInfo = image_array->second.data();
+            descriptorWrites.push_back(write);
+            continue;
+        }
+
+        switch (write.descriptorType) {
         case VK_DESCRIPTOR_TYPE_SAMPLER:
         case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
         case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
         case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-            descriptorWrites[binding].pImageInfo = &desc.descriptorMap.at(binding).get()->imageDescriptorInfo;
+            write.pImageInfo = &desc.descriptorMap.at(binding).get()->imageDescriptorInfo;
             break;
         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            descriptorWrites[binding].pBufferInfo = &desc.descriptorMap.at(binding).get()->bufferDescriptrInfo;
+            write.pBufferInfo = &desc.descriptorMap.at(binding).get()->bufferDescriptrInfo;
             break;
         default:
             break;
         }
+        descriptorWrites.push_back(write);
     }
     vkUpdateDescriptorSets(m_device->Get(), descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
 }
@@ -91,7 +118,8 @@ void DescriptorSet::CreateDescriptorPool() {
     std::unordered_map<VkDescriptorType, u32> descriptorTypeMap;
 
     for (u32 binding = 0; binding < mDescriptorSetInfo->bindingCount; binding++) {
-        descriptorTypeMap[ToVkDescriptorType(mDescriptorSetInfo->types[binding])]++;
+        VkDescriptorType type = ToVkDescriptorType(mDescriptorSetInfo->types[binding]);
+        descriptorTypeMap[type] += mDescriptorSetInfo->counts[binding];
     }
 
     std::vector<VkDescriptorPoolSize> poolSizes(descriptorTypeMap.size());
@@ -113,14 +141,21 @@ void DescriptorSet::CreateDescriptorPool() {
     CHECK_VK_RESULT(vkCreateDescriptorPool(m_device->Get(), &poolInfo, nullptr, &mDescriptorPool));
 }
 
-void DescriptorSetInfo::AddBinding(DescriptorType type, u32 stage) {
+void DescriptorSetInfo::AddBinding(DescriptorType type, u32 stage) { AddBindingArray(type, stage, 1); }
+
+void DescriptorSetInfo::AddBindingArray(DescriptorType type, u32 stage, u32 count) {
     bindingCount++;
     types.push_back(type);
     stageFlags.push_back(stage);
+    counts.push_back(count);
 }
 
 void DescriptorSetUpdateDesc::BindResource(u32 binding, std::shared_ptr<DescriptorBase> buffer) {
     descriptorMap[binding] = buffer;
 }
 
+void DescriptorSetUpdateDesc::BindImageArray(u32 binding, std::vector<VkDescriptorImageInfo> images) {
+    imageArrayMap[binding] = std::move(images);
+}
+
 } // namespace Horizon
\ No newline at end of file
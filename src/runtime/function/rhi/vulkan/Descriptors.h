@@ -14,14 +14,20 @@ struct DescriptorSetUpdateDesc {
     // sampler/Ub/sbo
   public:
     void BindResource(u32 binding, std::shared_ptr<DescriptorBase> buffer);
+    // the first images.size() elements of an array binding, the rest stays unwritten
+    void BindImageArray(u32 binding, std::vector<VkDescriptorImageInfo> images);
     std::unordered_map<u32, std::shared_ptr<DescriptorBase>> descriptorMap;
+    std::unordered_map<u32, std::vector<VkDescriptorImageInfo>> imageArrayMap;
 };
 
 struct DescriptorSetInfo {
     u32 bindingCount = 0;
     std::vector<DescriptorType> types{};
     std::vector<u32> stageFlags{};
+    std::vector<u32> counts{};
     void AddBinding(DescriptorType type, u32 stage);
+    // partially bound array of up to count descriptors, needs Device::SupportsDescriptorIndexing
+    void AddBindingArray(DescriptorType type, u32 stage, u32 count);
 };
 
 struct DescriptorSetLayouts {
@@ -1,5 +1,6 @@
 #include "Device.h"
 
+#include <cstring>
 #include <set>
 #include <vector>
 
@@ -21,7 +22,10 @@ Device::Device(std::shared_ptr<Instance> instance, std::shared_ptr<Surface> surf
     createDevice(m_instance->getValidationLayer());
 }
 
-Device::~Device() { vkDestroyDevice(m_device, nullptr); }
+Device::~Device() {
+    m_sampler_cache.reset();
+    vkDestroyDevice(m_device, nullptr);
+}
 
 VkPhysicalDevice Device::getPhysicalDevice() const noexcept { return m_physical_devices[m_physical_device_index]; }
 
@@ -83,21 +87,59 @@ void Device::createDevice(const ValidationLayer &validation_layers) {
                                                                       nullptr, 0, queue_family, 1, &queue_priority});
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(m_physical_devices[m_physical_device_index], &supportedFeatures);
+
+    // optional, gpu driven draws fall back to cpu submission without them
     VkPhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    m_multi_draw_indirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+    m_draw_indirect_first_instance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+    // optional, bc textures are decoded on the cpu without it
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    m_texture_compression_bc = supportedFeatures.textureCompressionBC == VK_TRUE;
+
+    // optional, materials keep a descriptor set each without it
+    std::vector<const char *> device_extensions = m_device_extensions;
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing{};
+    descriptor_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    if (checkDeviceExtensionSupport(m_physical_devices[m_physical_device_index],
+                                    VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+        VkPhysicalDeviceDescriptorIndexingFeatures supported_descriptor_indexing{};
+        supported_descriptor_indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported_descriptor_indexing;
+        vkGetPhysicalDeviceFeatures2(m_physical_devices[m_physical_device_index], &features2);
+        m_descriptor_indexing = supported_descriptor_indexing.runtimeDescriptorArray == VK_TRUE &&
+                                supported_descriptor_indexing.descriptorBindingPartiallyBound == VK_TRUE &&
+                                supportedFeatures.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+    }
+    if (m_descriptor_indexing) {
+        descriptor_indexing.runtimeDescriptorArray = VK_TRUE;
+        descriptor_indexing.descriptorBindingPartiallyBound = VK_TRUE;
+        // the material index is pushed per draw, so texture indices are dynamically uniform
+        deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        device_extensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+    }
 
     VkDeviceCreateInfo device_create_info{};
     device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     device_create_info.pQueueCreateInfos = device_queue_create_info.data();
     device_create_info.queueCreateInfoCount = static_cast<u32>(device_queue_create_info.size());
     device_create_info.pEnabledFeatures = &deviceFeatures;
-    device_create_info.enabledExtensionCount = static_cast<u32>(m_device_extensions.size());
-    device_create_info.ppEnabledExtensionNames = m_device_extensions.data();
+    device_create_info.enabledExtensionCount = static_cast<u32>(device_extensions.size());
+    device_create_info.ppEnabledExtensionNames = device_extensions.data();
+    device_create_info.pNext = m_descriptor_indexing ? &descriptor_indexing : nullptr;
 
     CHECK_VK_RESULT(
         vkCreateDevice(m_physical_devices[m_physical_device_index], &device_create_info, nullptr, &m_device));
 
     vkGetDeviceQueue(m_device, m_queue_family_indices.getGraphics(), 0, &m_graphics_queue);
     vkGetDeviceQueue(m_device, m_queue_family_indices.getPresent(), 0, &m_present_queue);
+
+    m_sampler_cache = std::make_unique<SamplerCache>(m_device);
 }
 
 bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
@@ -116,6 +158,31 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
     return required_extensions.empty();
 }
 
+bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extension) {
+    u32 extension_count;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+
+    std::vector<VkExtensionProperties> available_extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
+
+    for (const auto &available_extension : available_extensions) {
+        if (std::strcmp(available_extension.extensionName, extension) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Device::SupportsMultiDrawIndirect() const noexcept { return m_multi_draw_indirect; }
+
+bool Device::SupportsDrawIndirectFirstInstance() const noexcept { return m_draw_indirect_first_instance; }
+
+bool Device::SupportsTextureCompressionBC() const noexcept { return m_texture_compression_bc; }
+
+bool Device::SupportsDescriptorIndexing() const noexcept { return m_descriptor_indexing; }
+
+SamplerCache &Device::GetSamplerCache() const noexcept { return *m_sampler_cache; }
+
 QueueFamilyIndices Device::getQueueFamilyIndices() const noexcept { return m_queue_family_indices; }
 
 } // namespace Horizon
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "Instance.h"
 #include "QueueFamilyIndices.h"
+#include "SamplerCache.h"
 #include "Surface.h"
 #include "ValidationLayer.h"
 #include <runtime/function/rhi/RenderContext.h>
@@ -19,6 +20,13 @@ class Device {
     VkQueue getGraphicQueue() const noexcept;
     VkQueue getPresnetQueue() const noexcept;
     QueueFamilyIndices getQueueFamilyIndices() const noexcept;
+    bool SupportsMultiDrawIndirect() const noexcept;
+    bool SupportsDrawIndirectFirstInstance() const noexcept;
+    bool SupportsTextureCompressionBC() const noexcept;
+    // runtime sized, partially bound sampled image arrays through VK_EXT_descriptor_indexing
+    bool SupportsDescriptorIndexing() const noexcept;
+    // samplers shared by every texture and framebuffer of the device
+    SamplerCache &GetSamplerCache() const noexcept;
 
   private:
     bool isDeviceSuitable(VkPhysicalDevice device);
@@ -30,6 +38,7 @@ class Device {
     void createDevice(const ValidationLayer &validation_layers);
 
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool checkDeviceExtensionSupport(VkPhysicalDevice device, const char *extension);
 
   private:
     u32 device_count;
@@ -38,6 +47,11 @@ class Device {
     VkDevice m_device{};
     VkQueue m_graphics_queue, m_present_queue;
     QueueFamilyIndices m_queue_family_indices;
+    bool m_multi_draw_indirect = false;
+    bool m_draw_indirect_first_instance = false;
+    bool m_texture_compression_bc = false;
+    bool m_descriptor_indexing = false;
+    std::unique_ptr<SamplerCache> m_sampler_cache = nullptr;
     std::shared_ptr<Instance> m_instance = nullptr;
     std::shared_ptr<Surface> m_surface = nullptr;
     const std::vector<const char *> m_device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -18,17 +18,7 @@ Framebuffer::Framebuffer(std::shared_ptr<Device> device,
     }
 }
 
-Framebuffer::~Framebuffer() {
-    vkDestroySampler(m_device->Get(), m_sampler, nullptr);
-    for (auto &attachment : m_frame_buffer_attachments) {
-        vkDestroyImage(m_device->Get(), attachment.m_image, nullptr);
-        vkDestroyImageView(m_device->Get(), attachment.m_image_view, nullptr);
-        vkFreeMemory(m_device->Get(), attachment.m_image_memory, nullptr);
-    }
-    for (auto &framebuffer : m_framebuffer) {
-        vkDestroyFramebuffer(m_device->Get(), framebuffer, nullptr);
-    }
-}
+Framebuffer::~Framebuffer() { destroyFrameBuffer(); }
 
 VkFramebuffer Framebuffer::Get() const noexcept { return m_framebuffer[0]; }
 
@@ -77,6 +67,20 @@ std::vector<VkClearValue> Framebuffer::getClearValues() {
     return clearValues;
 }
 
+void Framebuffer::Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain) noexcept {
+    destroyFrameBuffer();
+    for (auto &create_info : m_attachment_create_info) {
+        create_info.width = width;
+        create_info.height = height;
+    }
+    createAttachmentsResources(m_attachment_create_info);
+    if (swap_chain) {
+        createFrameBuffer(width, height, m_render_context.swap_chain_image_count, swap_chain);
+    } else {
+        createFrameBuffer(width, height, 1);
+    }
+}
+
 void Framebuffer::createFrameBuffer(u32 width, u32 height, u32 imag_count, std::shared_ptr<SwapChain> swap_chain) {
     m_framebuffer.resize(imag_count);
     for (u32 i = 0; i < imag_count; i++) {
@@ -102,24 +106,26 @@ void Framebuffer::createFrameBuffer(u32 width, u32 height, u32 imag_count, std::
 }
 
 void Framebuffer::createAttachmentsResources(const std::vector<AttachmentCreateInfo> &attachment_create_info) {
+    m_attachment_create_info = attachment_create_info;
     for (auto &create_info : attachment_create_info) {
         m_frame_buffer_attachments.emplace_back(m_device, create_info);
     }
 
-    VkSamplerCreateInfo sampler{};
-    sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    sampler.magFilter = VK_FILTER_LINEAR;
-    sampler.minFilter = VK_FILTER_LINEAR;
-    sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    sampler.mipLodBias = 0.0f;
-    sampler.maxAnisotropy = 1.0f;
-    sampler.minLod = 0.0f;
-    sampler.maxLod = 1.0f;
-    sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-    CHECK_VK_RESULT(vkCreateSampler(m_device->Get(), &sampler, nullptr, &m_sampler));
+    // linear clamp like the default texture sampler, attachments have a single level
+    m_sampler = m_device->GetSamplerCache().Get(SamplerDesc{});
+}
+
+void Framebuffer::destroyFrameBuffer() noexcept {
+    for (auto &attachment : m_frame_buffer_attachments) {
+        vkDestroyImage(m_device->Get(), attachment.m_image, nullptr);
+        vkDestroyImageView(m_device->Get(), attachment.m_image_view, nullptr);
+        vkFreeMemory(m_device->Get(), attachment.m_image_memory, nullptr);
+    }
+    m_frame_buffer_attachments.clear();
+    for (auto &framebuffer : m_framebuffer) {
+        vkDestroyFramebuffer(m_device->Get(), framebuffer, nullptr);
+    }
+    m_framebuffer.clear();
 }
 
 } // namespace Horizon
\ No newline at end of file
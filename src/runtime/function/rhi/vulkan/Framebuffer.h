@@ -21,10 +21,13 @@ class Framebuffer {
     std::vector<VkImage> getPresentImages();
     u32 getColorAttachmentCount();
     std::vector<VkClearValue> getClearValues();
+    // recreates the attachments and framebuffers at the new size, the render pass stays
+    void Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain = nullptr) noexcept;
 
   private:
     void createFrameBuffer(u32 width, u32 height, u32 imag_count, std::shared_ptr<SwapChain> swap_chain = nullptr);
     void createAttachmentsResources(const std::vector<AttachmentCreateInfo> &attachment_create_info);
+    void destroyFrameBuffer() noexcept;
 
   private:
     RenderContext &m_render_context;
@@ -32,8 +35,9 @@ class Framebuffer {
     std::shared_ptr<Device> m_device = nullptr;
     std::shared_ptr<RenderPass> m_render_pass;
     std::vector<VkFramebuffer> m_framebuffer;
-    // Shared sampler used for all color attachments
+    // Shared sampler used for all color attachments, owned by the sampler cache
     VkSampler m_sampler;
     std::vector<Attachment> m_frame_buffer_attachments;
+    std::vector<AttachmentCreateInfo> m_attachment_create_info;
 };
 } // namespace Horizon
@@ -0,0 +1,80 @@
+#include "GpuTimer.h"
+
+#include <vector>
+
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+GpuTimer::GpuTimer(std::shared_ptr<Device> device, u32 command_buffer_count) noexcept
+    : m_device(device), m_command_buffer_count(command_buffer_count) {
+    u32 family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->getPhysicalDevice(), &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->getPhysicalDevice(), &family_count, families.data());
+    u32 valid_bits = families[m_device->getQueueFamilyIndices().getGraphics()].timestampValidBits;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->getPhysicalDevice(), &properties);
+    m_timestamp_period = properties.limits.timestampPeriod;
+
+    if (valid_bits == 0 || m_timestamp_period <= 0.0) {
+        LOG_INFO("graphics queue has no timestamps, gpu timing disabled");
+        return;
+    }
+    m_timestamp_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo query_pool_create_info{};
+    query_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    query_pool_create_info.queryCount = 2 * m_command_buffer_count;
+    CHECK_VK_RESULT(vkCreateQueryPool(m_device->Get(), &query_pool_create_info, nullptr, &m_query_pool));
+}
+
+GpuTimer::~GpuTimer() noexcept {
+    if (m_query_pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_device->Get(), m_query_pool, nullptr);
+    }
+}
+
+bool GpuTimer::IsSupported() const noexcept { return m_query_pool != VK_NULL_HANDLE; }
+
+void GpuTimer::Begin(u32 index, std::shared_ptr<CommandBuffer> command_buffer) noexcept {
+    Begin(index, command_buffer->Get(index));
+}
+
+void GpuTimer::End(u32 index, std::shared_ptr<CommandBuffer> command_buffer) noexcept {
+    End(index, command_buffer->Get(index));
+}
+
+void GpuTimer::Begin(u32 index, VkCommandBuffer command_buffer) noexcept {
+    if (!IsSupported()) {
+        return;
+    }
+    vkCmdResetQueryPool(command_buffer, m_query_pool, 2 * index, 2);
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_query_pool, 2 * index);
+}
+
+void GpuTimer::End(u32 index, VkCommandBuffer command_buffer) noexcept {
+    if (!IsSupported()) {
+        return;
+    }
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_query_pool, 2 * index + 1);
+}
+
+bool GpuTimer::GetElapsedTime(u32 index, f64 &ms) const noexcept {
+    if (!IsSupported() || index >= m_command_buffer_count) {
+        return false;
+    }
+    u64 timestamps[2];
+    VkResult result = vkGetQueryPoolResults(m_device->Get(), m_query_pool, 2 * index, 2, sizeof(timestamps),
+                                            timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return false;
+    }
+    u64 ticks = (timestamps[1] - timestamps[0]) & m_timestamp_mask;
+    ms = static_cast<f64>(ticks) * m_timestamp_period / 1e6;
+    return true;
+}
+
+} // namespace Horizon
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include <vulkan/vulkan.hpp>
+
+#include "CommandBuffer.h"
+#include "Device.h"
+
+namespace Horizon {
+
+// a begin and an end timestamp per command buffer. the queries of a command buffer are reset when it is recorded
+// again and read back after it executed
+class GpuTimer {
+  public:
+    GpuTimer(std::shared_ptr<Device> device, u32 command_buffer_count) noexcept;
+    ~GpuTimer() noexcept;
+
+    // false if the graphics queue does not write timestamps, Begin and End record nothing then
+    bool IsSupported() const noexcept;
+
+    // has to be recorded outside a render pass
+    void Begin(u32 index, std::shared_ptr<CommandBuffer> command_buffer) noexcept;
+    void End(u32 index, std::shared_ptr<CommandBuffer> command_buffer) noexcept;
+    // the same for a command buffer outside the per image ones, index picks the timer
+    void Begin(u32 index, VkCommandBuffer command_buffer) noexcept;
+    void End(u32 index, VkCommandBuffer command_buffer) noexcept;
+
+    // gpu time between Begin and End of a command buffer, false while its results are not available
+    bool GetElapsedTime(u32 index, f64 &ms) const noexcept;
+
+  private:
+    std::shared_ptr<Device> m_device = nullptr;
+    VkQueryPool m_query_pool = VK_NULL_HANDLE;
+    u32 m_command_buffer_count = 0;
+    // nanoseconds per tick
+    f64 m_timestamp_period = 0.0;
+    u64 m_timestamp_mask = 0;
+};
+
+} // namespace Horizon
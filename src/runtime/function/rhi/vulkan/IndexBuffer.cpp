@@ -4,8 +4,12 @@
 namespace Horizon {
 IndexBuffer::IndexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
                          const std::vector<Index> &indices)
+    : IndexBuffer(device, command_buffer, indices.data(), indices.size()) {}
+
+IndexBuffer::IndexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                         const Index *indices, u64 indices_count)
     : m_device(device) {
-    m_indices_count = indices.size();
+    m_indices_count = indices_count;
     VkDeviceSize buffer_size = sizeof(Index) * m_indices_count;
 
     // create stage buffer
@@ -18,7 +22,7 @@ IndexBuffer::IndexBuffer(std::shared_ptr<Device> device, std::shared_ptr<Command
     // upload cpu data
     void *data;
     vkMapMemory(m_device->Get(), stagingBufferMemory, 0, buffer_size, 0, &data);
-    memcpy(data, indices.data(), buffer_size);
+    memcpy(data, indices, buffer_size);
     vkUnmapMemory(m_device->Get(), stagingBufferMemory);
 
     // create gpu buffer
@@ -15,6 +15,8 @@ class IndexBuffer {
     IndexBuffer() = default;
     IndexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
                 const std::vector<Index> &vertices);
+    IndexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer, const Index *indices,
+                u64 indices_count);
     ~IndexBuffer();
     VkBuffer Get() const noexcept;
     u64 getIndicesCount() const noexcept;
@@ -1,8 +1,12 @@
 #include "Pipeline.h"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
+#include <string>
 
 #include <runtime/core/log/Log.h>
+#include <runtime/core/thread/ThreadPool.h>
 
 #include "Device.h"
 #include "Instance.h"
@@ -12,6 +16,31 @@
 #include "Vertex.h"
 
 namespace Horizon {
+
+// the values are read from constants in place, both have to outlive the pipeline creation
+static VkSpecializationInfo ToVkSpecializationInfo(const SpecializationConstants &constants,
+                                                   std::vector<VkSpecializationMapEntry> &entries) noexcept {
+    entries.resize(constants.size());
+    for (u32 i = 0; i < constants.size(); i++) {
+        entries[i].constantID = constants[i].constant_id;
+        entries[i].offset =
+            static_cast<u32>(i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, value));
+        entries[i].size = sizeof(u32);
+    }
+    VkSpecializationInfo specialization_info{};
+    specialization_info.mapEntryCount = static_cast<u32>(entries.size());
+    specialization_info.pMapEntries = entries.data();
+    specialization_info.dataSize = constants.size() * sizeof(SpecializationConstant);
+    specialization_info.pData = constants.data();
+    return specialization_info;
+}
+
+static void AppendSpecializationKey(std::string &key, const SpecializationConstants &constants) noexcept {
+    for (const SpecializationConstant &constant : constants) {
+        key += ' ' + std::to_string(constant.constant_id) + '=' + std::to_string(constant.value);
+    }
+}
+
 Pipeline::Pipeline(std::shared_ptr<Device> device) noexcept : m_device(device) {}
 
 Pipeline::~Pipeline() noexcept {
@@ -61,6 +90,36 @@ std::vector<VkImage> GraphicsPipeline::getPresentImages() const noexcept { retur
 
 std::vector<VkClearValue> GraphicsPipeline::getClearValues() const noexcept { return m_clear_values; }
 
+void GraphicsPipeline::Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain) noexcept {
+    m_render_context.width = width;
+    m_render_context.height = height;
+    UpdateViewport(width, height);
+    m_framebuffer->Resize(width, height, swap_chain);
+}
+
+void GraphicsPipeline::SetRenderExtent(u32 width, u32 height) noexcept {
+    UpdateViewport(std::min(width, m_render_context.width), std::min(height, m_render_context.height));
+}
+
+void GraphicsPipeline::Rebuild(const GraphicsPipelineCreateInfo &create_info) noexcept {
+    VkPipeline old_pipeline = m_pipeline;
+    // CreatePipeline resets the viewport to the full framebuffer
+    VkViewport viewport = m_viewport;
+    CreatePipeline(create_info);
+    m_viewport = viewport;
+    vkDestroyPipeline(m_device->Get(), old_pipeline, nullptr);
+}
+
+void GraphicsPipeline::UpdateViewport(u32 width, u32 height) noexcept {
+    // A viewport basically describes the region of the framebuffer that the output will be rendered to
+    m_viewport.width = static_cast<f32>(width);
+    m_viewport.height = -static_cast<f32>(height);
+    m_viewport.x = 0.0f;
+    m_viewport.y = -m_viewport.height;
+    m_viewport.minDepth = 0.0f;
+    m_viewport.maxDepth = 1.0f;
+}
+
 void GraphicsPipeline::CreatePipelineLayout(const GraphicsPipelineCreateInfo &create_info) {
     //auto &layouts = create_info.descriptor_layouts;
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -102,15 +161,28 @@ void GraphicsPipeline::CreatePipeline(const GraphicsPipelineCreateInfo &create_i
     pipelineShaderStageCreateInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
     pipelineShaderStageCreateInfos[0].module = create_info.vs->Get();
     pipelineShaderStageCreateInfos[0].pName = "main";
+    std::vector<VkSpecializationMapEntry> vs_map_entries;
+    VkSpecializationInfo vs_specialization_info = ToVkSpecializationInfo(create_info.vs_specialization, vs_map_entries);
+    if (!create_info.vs_specialization.empty()) {
+        pipelineShaderStageCreateInfos[0].pSpecializationInfo = &vs_specialization_info;
+    }
 
     // pixel shader
     pipelineShaderStageCreateInfos[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     pipelineShaderStageCreateInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     pipelineShaderStageCreateInfos[1].module = create_info.ps->Get();
     pipelineShaderStageCreateInfos[1].pName = "main";
+    std::vector<VkSpecializationMapEntry> ps_map_entries;
+    VkSpecializationInfo ps_specialization_info = ToVkSpecializationInfo(create_info.ps_specialization, ps_map_entries);
+    if (!create_info.ps_specialization.empty()) {
+        pipelineShaderStageCreateInfos[1].pSpecializationInfo = &ps_specialization_info;
+    }
 
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    bool compressed = create_info.vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED;
+    auto bindingDescription =
+        compressed ? CompressedVertex::getBindingDescription() : Vertex::getBindingDescription();
+    auto attributeDescriptions =
+        compressed ? CompressedVertex::getAttributeDescriptions() : Vertex::getAttributeDescriptions();
 
     VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo{};
     vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -125,37 +197,15 @@ void GraphicsPipeline::CreatePipeline(const GraphicsPipelineCreateInfo &create_i
     inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
 
-    // A viewport basically describes the region of the framebuffer that the output will be rendered to
-    m_viewport.width = static_cast<f32>(m_render_context.width);
-    m_viewport.height = -static_cast<f32>(m_render_context.height);
-    m_viewport.x = 0.0f;
-    m_viewport.y = -m_viewport.height;
-    m_viewport.minDepth = 0.0f;
-    m_viewport.maxDepth = 1.0f;
-
-    // m_viewport.width = static_cast<f32>(m_swap_chain->getExtent().width);
-    // m_viewport.height = static_cast<f32>(m_swap_chain->getExtent().height);
-    // m_viewport.x = 0.0f;
-    // m_viewport.y = 0.0f;
-    // m_viewport.minDepth = 0.0f;
-    // m_viewport.maxDepth = 1.0f;
-
-    // Any pixels outside the scissor rectangles will be discarded by the rasterizer
-
-    VkExtent2D extent;
-    extent.width = m_render_context.width;
-    extent.height = m_render_context.height;
-
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = extent;
+    UpdateViewport(m_render_context.width, m_render_context.height);
 
+    // viewport and scissor are set when a render pass begins, only their count is part of the pipeline
     VkPipelineViewportStateCreateInfo viewportStateCreateInfo{};
     viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
     viewportStateCreateInfo.viewportCount = 1;
-    viewportStateCreateInfo.pViewports = &m_viewport;
+    viewportStateCreateInfo.pViewports = nullptr;
     viewportStateCreateInfo.scissorCount = 1;
-    viewportStateCreateInfo.pScissors = &scissor;
+    viewportStateCreateInfo.pScissors = nullptr;
 
     VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo{};
     rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -209,7 +259,8 @@ void GraphicsPipeline::CreatePipeline(const GraphicsPipelineCreateInfo &create_i
     colorBlendingStateCreateInfo.blendConstants[2] = 0.0f;
     colorBlendingStateCreateInfo.blendConstants[3] = 0.0f;
 
-    std::array<VkDynamicState, 2> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_LINE_WIDTH};
+    std::array<VkDynamicState, 3> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR,
+                                                   VK_DYNAMIC_STATE_LINE_WIDTH};
 
     VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo{};
     dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
@@ -239,6 +290,19 @@ void GraphicsPipeline::CreatePipeline(const GraphicsPipelineCreateInfo &create_i
 
 PipelineManager::PipelineManager(std::shared_ptr<Device> device) : m_device(device) {}
 
+std::string PipelineManager::GetPipelineKey(const GraphicsPipelineCreateInfo &create_info) {
+    std::string key = create_info.name;
+    AppendSpecializationKey(key, create_info.vs_specialization);
+    AppendSpecializationKey(key, create_info.ps_specialization);
+    return key;
+}
+
+std::string PipelineManager::GetPipelineKey(const ComputePipelineCreateInfo &create_info) {
+    std::string key = create_info.name;
+    AppendSpecializationKey(key, create_info.cs_specialization);
+    return key;
+}
+
 std::shared_ptr<Pipeline>
 PipelineManager::CreateGraphicsPipeline(const GraphicsPipelineCreateInfo &create_info,
                                         const std::vector<AttachmentCreateInfo> &_attachment_create_info,
@@ -249,6 +313,8 @@ PipelineManager::CreateGraphicsPipeline(const GraphicsPipelineCreateInfo &create
         auto &pipelineVal = m_pipeline_map[hashKey];
         pipelineVal.pipeline =
             std::make_shared<GraphicsPipeline>(m_device, create_info, _attachment_create_info, _render_context);
+        pipelineVal.graphics_create_info = create_info;
+        WatchShaders(pipelineVal);
     } else {
         LOG_INFO("pipeline exist");
     }
@@ -261,6 +327,8 @@ std::shared_ptr<Pipeline> PipelineManager::CreateComputePipeline(const ComputePi
     if (!m_pipeline_map[hashKey].pipeline) {
         auto &pipelineVal = m_pipeline_map[hashKey];
         pipelineVal.pipeline = std::make_shared<ComputePipeline>(m_device, create_info);
+        pipelineVal.compute_create_info = create_info;
+        WatchShaders(pipelineVal);
     } else {
         LOG_INFO("pipeline exist");
     }
@@ -276,6 +344,8 @@ void PipelineManager::createPresentPipeline(const GraphicsPipelineCreateInfo &cr
         auto &pipelineVal = m_pipeline_map[hashKey];
         pipelineVal.pipeline = std::make_shared<GraphicsPipeline>(m_device, create_info, _attachment_create_info,
                                                                   _render_context, swap_chain);
+        pipelineVal.graphics_create_info = create_info;
+        WatchShaders(pipelineVal);
     }
 }
 
@@ -289,6 +359,151 @@ std::shared_ptr<Pipeline> PipelineManager::Get(const std::string &name) {
     }
 }
 
+void PipelineManager::Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain) noexcept {
+    for (auto &[name, val] : m_pipeline_map) {
+        if (!val.pipeline || val.pipeline->GetType() != PipelineType::GRAPHICS) {
+            continue;
+        }
+        std::shared_ptr<GraphicsPipeline> pipeline = std::static_pointer_cast<GraphicsPipeline>(val.pipeline);
+        pipeline->Resize(width, height, name == "present" ? swap_chain : nullptr);
+    }
+}
+
+std::vector<std::shared_ptr<Pipeline>> PipelineManager::Update() noexcept {
+    if (!ShaderCompiler::IsAvailable()) {
+        return {};
+    }
+    if (m_shader_reload) {
+        if (m_shader_reload->pending.load(std::memory_order_acquire) != 0) {
+            return {};
+        }
+        std::shared_ptr<ShaderReload> reload = std::move(m_shader_reload);
+        return RebuildPipelines(*reload);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_last_shader_poll < SHADER_POLL_INTERVAL) {
+        return {};
+    }
+    m_last_shader_poll = now;
+    std::vector<std::string> changed = m_shader_watcher.Poll();
+    if (changed.empty()) {
+        return {};
+    }
+
+    // every permutation that includes a changed file, once even when several pipelines share it
+    auto reload = std::make_shared<ShaderReload>();
+    for (const auto &[name, val] : m_pipeline_map) {
+        for (const std::shared_ptr<Shader> &shader :
+             {val.graphics_create_info.vs, val.graphics_create_info.ps, val.compute_create_info.cs}) {
+            if (!shader || std::find(reload->sources.begin(), reload->sources.end(), shader->GetSource()) !=
+                               reload->sources.end()) {
+                continue;
+            }
+            const std::vector<std::string> &dependencies = shader->GetDependencies();
+            if (std::find_first_of(dependencies.begin(), dependencies.end(), changed.begin(), changed.end()) !=
+                dependencies.end()) {
+                reload->sources.push_back(shader->GetSource());
+            }
+        }
+    }
+    if (reload->sources.empty()) {
+        return {};
+    }
+    u32 count = static_cast<u32>(reload->sources.size());
+    LOG_INFO("recompiling {} shaders", count);
+    reload->results.resize(count);
+    reload->pending.store(count, std::memory_order_relaxed);
+    for (u32 i = 0; i < count; i++) {
+        // the tasks own the reload, a manager destroyed before they finish leaves them nothing to touch
+        ThreadPool::GetInstance().Submit([reload, i]() {
+            reload->results[i] = ShaderCompiler::Compile(reload->sources[i]);
+            reload->pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    m_shader_reload = reload;
+    return {};
+}
+
+void PipelineManager::WatchShaders(const PipelineVal &val) noexcept {
+    for (const std::shared_ptr<Shader> &shader :
+         {val.graphics_create_info.vs, val.graphics_create_info.ps, val.compute_create_info.cs}) {
+        if (!shader) {
+            continue;
+        }
+        for (const std::string &dependency : shader->GetDependencies()) {
+            m_shader_watcher.Watch(dependency);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<Pipeline>> PipelineManager::RebuildPipelines(const ShaderReload &reload) noexcept {
+    std::vector<std::shared_ptr<Shader>> shaders(reload.sources.size());
+    for (u32 i = 0; i < reload.sources.size(); i++) {
+        if (reload.results[i].spirv.empty()) {
+            LOG_ERROR("{}: {}", reload.sources[i].path, reload.results[i].error);
+            continue;
+        }
+        shaders[i] = std::make_shared<Shader>(m_device->Get(), reload.sources[i], reload.results[i]);
+    }
+    // the replacement of a recompiled shader, the shader itself when it was not recompiled or failed to
+    auto get_new_shader = [&](const std::shared_ptr<Shader> &shader, bool &replaced, bool &failed) {
+        if (!shader) {
+            return shader;
+        }
+        auto it = std::find(reload.sources.begin(), reload.sources.end(), shader->GetSource());
+        if (it == reload.sources.end()) {
+            return shader;
+        }
+        const std::shared_ptr<Shader> &new_shader = shaders[it - reload.sources.begin()];
+        replaced = true;
+        failed |= !new_shader;
+        return new_shader ? new_shader : shader;
+    };
+
+    std::vector<std::shared_ptr<Pipeline>> rebuilt;
+    bool idle = false;
+    for (auto &[name, val] : m_pipeline_map) {
+        if (!val.pipeline) {
+            continue;
+        }
+        bool replaced = false, failed = false;
+        if (val.pipeline->GetType() == PipelineType::GRAPHICS) {
+            GraphicsPipelineCreateInfo create_info = val.graphics_create_info;
+            create_info.vs = get_new_shader(create_info.vs, replaced, failed);
+            create_info.ps = get_new_shader(create_info.ps, replaced, failed);
+            if (!replaced || failed) {
+                continue;
+            }
+            if (!idle) {
+                vkDeviceWaitIdle(m_device->Get());
+                idle = true;
+            }
+            std::static_pointer_cast<GraphicsPipeline>(val.pipeline)->Rebuild(create_info);
+            val.graphics_create_info = create_info;
+        } else if (val.pipeline->GetType() == PipelineType::COMPUTE) {
+            ComputePipelineCreateInfo create_info = val.compute_create_info;
+            create_info.cs = get_new_shader(create_info.cs, replaced, failed);
+            if (!replaced || failed) {
+                continue;
+            }
+            if (!idle) {
+                vkDeviceWaitIdle(m_device->Get());
+                idle = true;
+            }
+            std::static_pointer_cast<ComputePipeline>(val.pipeline)->Rebuild(create_info);
+            val.compute_create_info = create_info;
+        } else {
+            continue;
+        }
+        // an edit may have added includes
+        WatchShaders(val);
+        LOG_INFO("rebuilt pipeline {}", name);
+        rebuilt.push_back(val.pipeline);
+    }
+    return rebuilt;
+}
+
 ComputePipeline::ComputePipeline(std::shared_ptr<Device> device, const ComputePipelineCreateInfo &create_info) noexcept
     : Pipeline(device) {
     m_group_count_x = create_info.group_count_x;
@@ -307,6 +522,12 @@ u32 ComputePipeline::GroupCountY() const noexcept { return m_group_count_y; }
 
 u32 ComputePipeline::GroupCountZ() const noexcept { return m_group_count_z; }
 
+void ComputePipeline::Rebuild(const ComputePipelineCreateInfo &create_info) noexcept {
+    VkPipeline old_pipeline = m_pipeline;
+    CreatePipeline(create_info);
+    vkDestroyPipeline(m_device->Get(), old_pipeline, nullptr);
+}
+
 void ComputePipeline::CreatePipelineLayout(const ComputePipelineCreateInfo &create_info) noexcept {
     //auto &layouts = create_info.descriptor_layouts;
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -348,10 +569,15 @@ void ComputePipeline::CreatePipeline(const ComputePipelineCreateInfo &create_inf
     pipeline_shader_stage_create_info.stage = VK_SHADER_STAGE_COMPUTE_BIT;
     pipeline_shader_stage_create_info.module = create_info.cs->Get();
     pipeline_shader_stage_create_info.pName = "main";
+    std::vector<VkSpecializationMapEntry> map_entries;
+    VkSpecializationInfo specialization_info = ToVkSpecializationInfo(create_info.cs_specialization, map_entries);
+    if (!create_info.cs_specialization.empty()) {
+        pipeline_shader_stage_create_info.pSpecializationInfo = &specialization_info;
+    }
 
     VkComputePipelineCreateInfo compute_pipeline_create_info{};
     compute_pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    compute_pipeline_create_info.flags = 0;
+    compute_pipeline_create_info.flags = create_info.dispatch_base ? VK_PIPELINE_CREATE_DISPATCH_BASE_BIT : 0;
     compute_pipeline_create_info.layout = m_pipeline_layout;
     compute_pipeline_create_info.stage = pipeline_shader_stage_create_info;
     compute_pipeline_create_info.basePipelineHandle = nullptr;
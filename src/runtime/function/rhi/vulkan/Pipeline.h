@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <unordered_map>
 #include <vector>
 
@@ -13,24 +15,38 @@
 #include "ShaderModule.h"
 #include "Surface.h"
 #include "SwapChain.h"
+#include <runtime/core/io/FileWatcher.h>
 #include <runtime/function/rhi/RenderContext.h>
 namespace Horizon {
 
+// a 32 bit specialization constant of a shader, by its constant_id. ints and floats are passed as their bits
+struct SpecializationConstant {
+    u32 constant_id;
+    u32 value;
+};
+
+using SpecializationConstants = std::vector<SpecializationConstant>;
+
 struct GraphicsPipelineCreateInfo {
     std::string name;
     std::shared_ptr<Shader> vs, ps;
+    // constants the shader does not declare are ignored
+    SpecializationConstants vs_specialization, ps_specialization;
     std::shared_ptr<DescriptorSetLayouts> descriptor_layouts;
     std::shared_ptr<PushConstants> push_constants;
-    // VkPipelineVertexInputStateCreateInfo;
+    VertexFormat vertex_format = VertexFormat::VERTEX_FORMAT_FULL;
     // descriptorsetlayout
 };
 
 struct ComputePipelineCreateInfo {
     std::string name;
     std::shared_ptr<Shader> cs;
+    SpecializationConstants cs_specialization;
     std::shared_ptr<DescriptorSetLayouts> descriptor_layouts;
     std::shared_ptr<PushConstants> push_constants;
     u32 group_count_x = 1, group_count_y = 1, group_count_z = 1;
+    // allows CommandBuffer::DispatchBase to record a part of the groups
+    bool dispatch_base = false;
 };
 
 class Pipeline {
@@ -66,10 +82,19 @@ class GraphicsPipeline : public Pipeline {
     std::shared_ptr<AttachmentDescriptor> GetFrameBufferAttachment(u32 attahmentIndex) const noexcept;
     std::vector<VkImage> getPresentImages() const noexcept;
     std::vector<VkClearValue> getClearValues() const noexcept;
+    // recreates the render targets at the new size, viewport and scissor are dynamic so the pipeline itself is kept
+    void Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain = nullptr) noexcept;
+    // viewport, scissor and render area of the next recorded passes, a corner of the framebuffer. Resize resets it
+    // to the full framebuffer
+    void SetRenderExtent(u32 width, u32 height) noexcept;
+    // replaces the vk pipeline with one of the shaders in create_info, layout, render targets and viewport stay.
+    // the old one is destroyed at once, the device must be done with it
+    void Rebuild(const GraphicsPipelineCreateInfo &create_info) noexcept;
 
   private:
     void CreatePipelineLayout(const GraphicsPipelineCreateInfo &create_info);
     void CreatePipeline(const GraphicsPipelineCreateInfo &create_info);
+    void UpdateViewport(u32 width, u32 height) noexcept;
 
   private:
     RenderContext m_render_context;
@@ -85,6 +110,8 @@ class ComputePipeline : public Pipeline {
     u32 GroupCountX() const noexcept;
     u32 GroupCountY() const noexcept;
     u32 GroupCountZ() const noexcept;
+    // the same for compute, group counts stay
+    void Rebuild(const ComputePipelineCreateInfo &create_info) noexcept;
 
   private:
     void CreatePipelineLayout(const ComputePipelineCreateInfo &create_info) noexcept;
@@ -112,20 +139,52 @@ class PipelineManager {
                                const std::vector<AttachmentCreateInfo> &_attachment_create_info,
                                RenderContext &_render_context, std::shared_ptr<SwapChain> swap_chain);
 
+    // pipelines created with specialization constants are not found by name
     std::shared_ptr<Pipeline> Get(const std::string &name);
 
+    // resizes the render targets of every graphics pipeline, the present pipeline takes the recreated swap chain
+    void Resize(u32 width, u32 height, std::shared_ptr<SwapChain> swap_chain) noexcept;
+
+    // shader hot reload, call between frames. polls the glsl files of every pipeline's shaders at most every
+    // SHADER_POLL_INTERVAL, compiles the shaders that depend on changed files on the thread pool and, on a later
+    // call once all of them are done, waits for the device and rebuilds the affected pipelines in place. a pipeline
+    // with a shader that failed to compile keeps its old one. returns the pipelines rebuilt by this call, always
+    // empty without shaderc
+    std::vector<std::shared_ptr<Pipeline>> Update() noexcept;
+
   private:
     // convert pipelinecreateinfo and pipelinename to u32 hash key, https://dev.to/muiz6/string-hashing-in-c-1np3
-    inline std::string GetPipelineKey(const GraphicsPipelineCreateInfo &create_info) { return create_info.name; }
+    // pipelines of a name with other specialization constants are kept apart
+    std::string GetPipelineKey(const GraphicsPipelineCreateInfo &create_info);
 
-    inline std::string GetPipelineKey(const ComputePipelineCreateInfo &create_info) { return create_info.name; }
+    std::string GetPipelineKey(const ComputePipelineCreateInfo &create_info);
 
   private:
     struct PipelineVal {
         std::shared_ptr<Pipeline> pipeline;
+        // what a hot reload rebuilds the pipeline from, the create info of the other type is left empty
+        GraphicsPipelineCreateInfo graphics_create_info;
+        ComputePipelineCreateInfo compute_create_info;
     };
+
+    // the shaders changed on disk and their compile results, filled in by the thread pool
+    struct ShaderReload {
+        std::vector<ShaderSource> sources;
+        std::vector<ShaderCompileResult> results;
+        std::atomic<u32> pending{0};
+    };
+
+    void WatchShaders(const PipelineVal &val) noexcept;
+    std::vector<std::shared_ptr<Pipeline>> RebuildPipelines(const ShaderReload &reload) noexcept;
+
+  private:
+    static constexpr std::chrono::milliseconds SHADER_POLL_INTERVAL{500};
+
     std::shared_ptr<Device> m_device;
     std::shared_ptr<SwapChain> m_swap_chain;
     std::unordered_map<std::string, PipelineVal> m_pipeline_map;
+    FileWatcher m_shader_watcher;
+    std::chrono::steady_clock::time_point m_last_shader_poll;
+    std::shared_ptr<ShaderReload> m_shader_reload;
 };
 } // namespace Horizon
\ No newline at end of file
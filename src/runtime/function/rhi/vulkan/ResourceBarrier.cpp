@@ -5,6 +5,10 @@
 namespace Horizon {
 
 void InsertBarrier(u32 i, std::shared_ptr<CommandBuffer> command_buffer, const BarrierDesc &desc) noexcept {
+    InsertBarrier(command_buffer->Get(i), desc);
+}
+
+void InsertBarrier(VkCommandBuffer command_buffer, const BarrierDesc &desc) noexcept {
     VkPipelineStageFlags src_stage = ToVkPipelineStage(desc.src_stage);
     VkPipelineStageFlags dst_stage = ToVkPipelineStage(desc.dst_stage);
 
@@ -37,7 +41,7 @@ void InsertBarrier(u32 i, std::shared_ptr<CommandBuffer> command_buffer, const B
         }
     }
 
-    vkCmdPipelineBarrier(command_buffer->Get(i), src_stage, dst_stage, 0, 0, nullptr,
+    vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, 0, 0, nullptr,
                          desc.buffer_memory_barriers.size(), buffer_memory_barriers.data(),
                          desc.image_memory_barriers.size(), image_memory_barriers.data());
 }
@@ -32,4 +32,6 @@ struct BarrierDesc {
 
 void InsertBarrier(u32 i, std::shared_ptr<CommandBuffer> command_buffer, const BarrierDesc &desc) noexcept;
 
+void InsertBarrier(VkCommandBuffer command_buffer, const BarrierDesc &desc) noexcept;
+
 } // namespace Horizon
\ No newline at end of file
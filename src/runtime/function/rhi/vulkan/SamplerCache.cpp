@@ -0,0 +1,70 @@
+#include "SamplerCache.h"
+
+#include <runtime/core/hash/Hash.h>
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+bool SamplerDesc::operator==(const SamplerDesc &other) const noexcept {
+    return mag_filter == other.mag_filter && min_filter == other.min_filter && mipmap_mode == other.mipmap_mode &&
+           address_mode_u == other.address_mode_u && address_mode_v == other.address_mode_v &&
+           address_mode_w == other.address_mode_w && max_lod == other.max_lod && border_color == other.border_color;
+}
+
+size_t SamplerCache::DescHash::operator()(const SamplerDesc &desc) const noexcept {
+    u64 hash = Hash::Combine(0, static_cast<u64>(desc.mag_filter));
+    hash = Hash::Combine(hash, static_cast<u64>(desc.min_filter));
+    hash = Hash::Combine(hash, static_cast<u64>(desc.mipmap_mode));
+    hash = Hash::Combine(hash, static_cast<u64>(desc.address_mode_u));
+    hash = Hash::Combine(hash, static_cast<u64>(desc.address_mode_v));
+    hash = Hash::Combine(hash, static_cast<u64>(desc.address_mode_w));
+    hash = Hash::Hash64(&desc.max_lod, sizeof(f32), hash);
+    hash = Hash::Combine(hash, static_cast<u64>(desc.border_color));
+    return static_cast<size_t>(hash);
+}
+
+SamplerCache::SamplerCache(VkDevice device) noexcept : m_device(device) {}
+
+SamplerCache::~SamplerCache() noexcept {
+    for (auto &[desc, sampler] : m_samplers) {
+        vkDestroySampler(m_device, sampler, nullptr);
+    }
+}
+
+VkSampler SamplerCache::Get(const SamplerDesc &desc) noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_samplers.find(desc);
+    if (it != m_samplers.end()) {
+        return it->second;
+    }
+
+    VkSamplerCreateInfo sampler_info{};
+    sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    sampler_info.magFilter = desc.mag_filter;
+    sampler_info.minFilter = desc.min_filter;
+    sampler_info.mipmapMode = desc.mipmap_mode;
+    sampler_info.addressModeU = desc.address_mode_u;
+    sampler_info.addressModeV = desc.address_mode_v;
+    sampler_info.addressModeW = desc.address_mode_w;
+    sampler_info.mipLodBias = 0.0f;
+    sampler_info.anisotropyEnable = VK_FALSE;
+    sampler_info.maxAnisotropy = 1.0f;
+    sampler_info.compareEnable = VK_FALSE;
+    sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+    sampler_info.minLod = 0.0f;
+    sampler_info.maxLod = desc.max_lod;
+    sampler_info.borderColor = desc.border_color;
+    sampler_info.unnormalizedCoordinates = VK_FALSE;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    CHECK_VK_RESULT(vkCreateSampler(m_device, &sampler_info, nullptr, &sampler));
+    m_samplers.emplace(desc, sampler);
+    return sampler;
+}
+
+u32 SamplerCache::GetSamplerCount() const noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<u32>(m_samplers.size());
+}
+
+} // namespace Horizon
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include <vulkan/vulkan.hpp>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// the sampler state textures and attachments choose from, the rest is fixed: no anisotropy, no depth compare and
+// normalized coordinates
+struct SamplerDesc {
+    VkFilter mag_filter = VK_FILTER_LINEAR;
+    VkFilter min_filter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode address_mode_u = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    VkSamplerAddressMode address_mode_v = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    VkSamplerAddressMode address_mode_w = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    // image views limit the levels, so the default fits every texture whatever its mip count
+    f32 max_lod = VK_LOD_CLAMP_NONE;
+    VkBorderColor border_color = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+    bool operator==(const SamplerDesc &other) const noexcept;
+};
+
+// one immutable VkSampler per distinct SamplerDesc, shared by everything that samples with that state. samplers are
+// never destroyed before the device, so handles can be kept anywhere, including as immutable samplers of a
+// descriptor set layout
+class SamplerCache {
+  public:
+    SamplerCache(VkDevice device) noexcept;
+    ~SamplerCache() noexcept;
+    SamplerCache(const SamplerCache &) = delete;
+    SamplerCache &operator=(const SamplerCache &) = delete;
+
+    // created on first use
+    VkSampler Get(const SamplerDesc &desc) noexcept;
+    u32 GetSamplerCount() const noexcept;
+
+  private:
+    struct DescHash {
+        size_t operator()(const SamplerDesc &desc) const noexcept;
+    };
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    mutable std::mutex m_mutex;
+    std::unordered_map<SamplerDesc, VkSampler, DescHash> m_samplers;
+};
+
+} // namespace Horizon
@@ -0,0 +1,232 @@
+#include "ShaderCompiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <unordered_set>
+
+#ifdef HORIZON_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+#include <runtime/core/hash/Hash.h>
+#include <runtime/core/io/MappedFile.h>
+#include <runtime/core/log/Log.h>
+#include <runtime/core/path/Path.h>
+
+namespace Horizon::ShaderCompiler {
+
+// part of every source hash, bump it when the compile options change
+static constexpr u64 COMPILER_VERSION = 1;
+
+static bool ReadText(const std::string &path, std::string &text) noexcept {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// next to the including file, what glslc does without -I
+static std::string ResolveInclude(const std::string &including_path, const std::string &name) noexcept {
+    return (std::filesystem::path(including_path).parent_path() / name).lexically_normal().generic_string();
+}
+
+// the names of the #include "..." lines
+static std::vector<std::string> GetIncludes(const std::string &text) noexcept {
+    std::vector<std::string> includes;
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        u64 begin = line.find_first_not_of(" \t");
+        if (begin == std::string::npos || line.compare(begin, 8, "#include") != 0) {
+            continue;
+        }
+        u64 open = line.find('"', begin + 8);
+        u64 close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close != std::string::npos) {
+            includes.push_back(line.substr(open + 1, close - open - 1));
+        }
+    }
+    return includes;
+}
+
+static std::string GetCachePath(u64 key) noexcept {
+    char name[32];
+    std::snprintf(name, sizeof(name), "shader-%016llx.spv", static_cast<unsigned long long>(key));
+    return Path::GetCachePath(name);
+}
+
+static bool LoadCache(const std::string &path, std::vector<u32> &spirv) noexcept {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return false;
+    }
+    MappedFile file(path);
+    if (!file.IsValid() || file.GetSize() % sizeof(u32) != 0) {
+        return false;
+    }
+    spirv.resize(file.GetSize() / sizeof(u32));
+    std::memcpy(spirv.data(), file.GetData(), file.GetSize());
+    return true;
+}
+
+static void SaveCache(const std::string &path, const std::vector<u32> &spirv) noexcept {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_WARN("failed to open {}", temp_path);
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(spirv.data()),
+                   static_cast<std::streamsize>(sizeof(u32) * spirv.size()));
+        if (!file) {
+            LOG_WARN("failed to write {}", temp_path);
+            file.close();
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        LOG_WARN("failed to move {} to {}: {}", temp_path, path, error.message());
+        std::filesystem::remove(temp_path, error);
+    }
+}
+
+#ifdef HORIZON_SHADERC
+
+static shaderc_shader_kind GetShaderKind(const std::string &path) noexcept {
+    std::string extension = std::filesystem::path(path).extension().string();
+    if (extension == ".vert") {
+        return shaderc_vertex_shader;
+    }
+    if (extension == ".frag") {
+        return shaderc_fragment_shader;
+    }
+    if (extension == ".comp") {
+        return shaderc_compute_shader;
+    }
+    return shaderc_glsl_infer_from_source;
+}
+
+// the includes are read again while compiling, the source hash only saw their contents
+class Includer : public shaderc::CompileOptions::IncluderInterface {
+  public:
+    shaderc_include_result *GetInclude(const char *requested_source, shaderc_include_type,
+                                       const char *requesting_source, size_t) override {
+        Include *include = new Include;
+        include->path = ResolveInclude(requesting_source, requested_source);
+        if (!ReadText(include->path, include->content)) {
+            // an empty name tells shaderc the include failed, the content is the message
+            include->content = "cannot open " + include->path;
+            include->path.clear();
+        }
+        include->result.source_name = include->path.c_str();
+        include->result.source_name_length = include->path.size();
+        include->result.content = include->content.c_str();
+        include->result.content_length = include->content.size();
+        include->result.user_data = include;
+        return &include->result;
+    }
+
+    void ReleaseInclude(shaderc_include_result *data) override { delete static_cast<Include *>(data->user_data); }
+
+  private:
+    struct Include {
+        std::string path;
+        std::string content;
+        shaderc_include_result result;
+    };
+};
+
+#endif
+
+bool IsAvailable() noexcept {
+#ifdef HORIZON_SHADERC
+    return true;
+#else
+    return false;
+#endif
+}
+
+u64 GetSourceHash(const ShaderSource &source, std::vector<std::string> *dependencies) noexcept {
+    u64 key = Hash::Hash64(source.path, COMPILER_VERSION);
+    for (const ShaderDefine &define : source.defines) {
+        key = Hash::Hash64(define.name, key);
+        key = Hash::Hash64(define.value, key);
+    }
+    // every file once, in the order they are first included
+    std::vector<std::string> files{
+        std::filesystem::path(Path::GetShaderSourcePath(source.path)).lexically_normal().generic_string()};
+    std::unordered_set<std::string> visited{files[0]};
+    for (u64 i = 0; i < files.size(); i++) {
+        std::string text;
+        if (!ReadText(files[i], text)) {
+            key = Hash::Hash64(files[i], key);
+            continue;
+        }
+        key = Hash::Hash64(text, key);
+        for (const std::string &name : GetIncludes(text)) {
+            std::string include = ResolveInclude(files[i], name);
+            if (visited.insert(include).second) {
+                files.push_back(include);
+            }
+        }
+    }
+    if (dependencies) {
+        *dependencies = std::move(files);
+    }
+    return key;
+}
+
+ShaderCompileResult Compile(const ShaderSource &source) noexcept {
+    ShaderCompileResult result;
+    u64 key = GetSourceHash(source, &result.dependencies);
+    std::string cache_path = GetCachePath(key);
+    if (LoadCache(cache_path, result.spirv)) {
+        return result;
+    }
+#ifdef HORIZON_SHADERC
+    const std::string &path = result.dependencies[0];
+    std::string text;
+    if (!ReadText(path, text)) {
+        result.error = "cannot open " + path;
+        return result;
+    }
+    shaderc::CompileOptions options;
+    options.SetIncluder(std::make_unique<Includer>());
+    for (const ShaderDefine &define : source.defines) {
+        if (define.value.empty()) {
+            options.AddMacroDefinition(define.name);
+        } else {
+            options.AddMacroDefinition(define.name, define.value);
+        }
+    }
+    shaderc::Compiler compiler;
+    shaderc::SpvCompilationResult module =
+        compiler.CompileGlslToSpv(text, GetShaderKind(source.path), path.c_str(), options);
+    if (module.GetCompilationStatus() != shaderc_compilation_status_success) {
+        result.error = module.GetErrorMessage();
+        return result;
+    }
+    result.spirv.assign(module.cbegin(), module.cend());
+    // a file saved while it compiled would leave its old hash pointing at the new code
+    if (GetSourceHash(source) == key) {
+        SaveCache(cache_path, result.spirv);
+    }
+#else
+    result.error = "no cached spirv for " + source.path + " and the runtime was built without shaderc";
+#endif
+    return result;
+}
+
+} // namespace Horizon::ShaderCompiler
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// #define name value ahead of the source, an empty value defines the name alone
+struct ShaderDefine {
+    std::string name;
+    std::string value;
+
+    bool operator==(const ShaderDefine &other) const noexcept { return name == other.name && value == other.value; }
+};
+
+using ShaderDefines = std::vector<ShaderDefine>;
+
+// a glsl source under assets/shaders and the defines of one permutation of it, the stage follows from the extension
+struct ShaderSource {
+    std::string path;
+    ShaderDefines defines;
+
+    bool operator==(const ShaderSource &other) const noexcept {
+        return path == other.path && defines == other.defines;
+    }
+};
+
+struct ShaderCompileResult {
+    std::vector<u32> spirv;
+    // the source and every file it includes, missing ones too
+    std::vector<std::string> dependencies;
+    // compiler output when spirv is empty
+    std::string error;
+};
+
+// compiles glsl with shaderc in process. the spirv is cached under assets/cache by a hash of the source, the files
+// it includes and the defines, so unchanged shaders load without compiling
+namespace ShaderCompiler {
+
+// false when the runtime was built without shaderc, only cached spirv can be returned then
+bool IsAvailable() noexcept;
+
+// cached or freshly compiled spirv of source, thread safe. includes are resolved relative to the including file
+ShaderCompileResult Compile(const ShaderSource &source) noexcept;
+
+// covers the source, the files it includes and the defines, a missing file by its path only
+u64 GetSourceHash(const ShaderSource &source, std::vector<std::string> *dependencies = nullptr) noexcept;
+
+} // namespace ShaderCompiler
+
+} // namespace Horizon
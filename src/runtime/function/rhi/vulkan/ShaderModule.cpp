@@ -1,33 +1,86 @@
 #include "ShaderModule.h"
 
+#include <cstring>
 #include <fstream>
 #include <vector>
 
 #include <runtime/core/log/Log.h>
+#include <runtime/core/path/Path.h>
 
 namespace Horizon {
 
+static constexpr u32 SPIRV_MAGIC = 0x07230203;
+
+static bool IsSpirv(const std::vector<char> &code) noexcept {
+    u32 magic = 0;
+    if (code.size() < sizeof(u32) || code.size() % sizeof(u32) != 0) {
+        return false;
+    }
+    std::memcpy(&magic, code.data(), sizeof(u32));
+    return magic == SPIRV_MAGIC;
+}
+
 Shader::Shader(VkDevice device, const std::string &path) : m_device(device) {
     std::vector<char> code = readFile(path);
-    if (code.empty()) {
-        LOG_ERROR("shader code in {} is empty", path);
+    if (!IsSpirv(code)) {
+        // no module is created, the pipelines using the shader fail to build
+        LOG_ERROR("{} is missing or not spirv, build the shaders target or run compileshaders.py", path);
+        return;
     }
-    VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shaderModuleCreateInfo.codeSize = code.size();
-    shaderModuleCreateInfo.pCode = reinterpret_cast<const u32 *>(code.data());
-    CHECK_VK_RESULT(vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &m_shader_module));
+    CreateShaderModule(reinterpret_cast<const u32 *>(code.data()), code.size());
+}
+
+Shader::Shader(VkDevice device, const ShaderSource &source) : m_device(device), m_source(source) {
+    ShaderCompileResult compiled = ShaderCompiler::Compile(source);
+    m_dependencies = std::move(compiled.dependencies);
+    if (!compiled.spirv.empty()) {
+        CreateShaderModule(compiled.spirv.data(), sizeof(u32) * compiled.spirv.size());
+        return;
+    }
+    // without shaderc this is the usual path until the spirv cache is filled
+    if (ShaderCompiler::IsAvailable()) {
+        LOG_ERROR("{}: {}", source.path, compiled.error);
+    }
+    if (!source.defines.empty()) {
+        LOG_ERROR("{}: the precompiled spirv is built without the defines", source.path);
+    }
+    std::string path = Path::GetShaderPath(source.path + ".spv");
+    std::vector<char> code = readFile(path);
+    if (!IsSpirv(code)) {
+        // no module is created, the pipelines using the shader fail to build
+        LOG_ERROR("{} is missing or not spirv, build the shaders target or run compileshaders.py", path);
+        return;
+    }
+    CreateShaderModule(reinterpret_cast<const u32 *>(code.data()), code.size());
+}
+
+Shader::Shader(VkDevice device, const ShaderSource &source, const ShaderCompileResult &compiled)
+    : m_device(device), m_source(source), m_dependencies(compiled.dependencies) {
+    CreateShaderModule(compiled.spirv.data(), sizeof(u32) * compiled.spirv.size());
 }
 
 Shader::~Shader() { vkDestroyShaderModule(m_device, m_shader_module, nullptr); }
 
 VkShaderModule Shader::Get() const noexcept { return m_shader_module; }
 
+const ShaderSource &Shader::GetSource() const noexcept { return m_source; }
+
+const std::vector<std::string> &Shader::GetDependencies() const noexcept { return m_dependencies; }
+
+void Shader::CreateShaderModule(const u32 *code, u64 size) {
+    VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+    shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shaderModuleCreateInfo.codeSize = size;
+    shaderModuleCreateInfo.pCode = code;
+    CHECK_VK_RESULT(vkCreateShaderModule(m_device, &shaderModuleCreateInfo, nullptr, &m_shader_module));
+}
+
 std::vector<char> Shader::readFile(const std::string &path) {
 
     std::ifstream file(path, std::ios::ate | std::ios::binary);
     if (!file.is_open()) {
         LOG_ERROR("failed to open shader file: {}", path);
+        return {};
     }
     size_t fileSize = (size_t)file.tellg();
     std::vector<char> buffer(fileSize);
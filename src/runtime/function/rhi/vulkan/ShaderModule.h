@@ -1,5 +1,6 @@
 #pragma once
 
+#include <runtime/function/rhi/vulkan/ShaderCompiler.h>
 #include <runtime/function/rhi/vulkan/VulkanEnums.h>
 #include <string>
 
@@ -7,15 +8,26 @@ namespace Horizon {
 
 class Shader {
   public:
+    // precompiled spirv
     Shader(VkDevice device, const std::string &path);
+    // compiled through ShaderCompiler, the spirv compileshaders.py wrote for source.path is loaded when that fails
+    Shader(VkDevice device, const ShaderSource &source);
+    // spirv compiled elsewhere, a hot reload compiles on the thread pool
+    Shader(VkDevice device, const ShaderSource &source, const ShaderCompileResult &compiled);
     ~Shader();
     VkShaderModule Get() const noexcept;
+    const ShaderSource &GetSource() const noexcept;
+    // the glsl files a hot reload watches, empty for spirv loaded by path
+    const std::vector<std::string> &GetDependencies() const noexcept;
 
   private:
     std::vector<char> readFile(const std::string &path);
+    void CreateShaderModule(const u32 *code, u64 size);
 
   private:
-    VkShaderModule m_shader_module;
+    VkShaderModule m_shader_module = VK_NULL_HANDLE;
     VkDevice m_device;
+    ShaderSource m_source;
+    std::vector<std::string> m_dependencies;
 };
 } // namespace Horizon
@@ -0,0 +1,45 @@
+#include "StorageBuffer.h"
+
+namespace Horizon {
+
+StorageBuffer::StorageBuffer(std::shared_ptr<Device> device, VkBufferUsageFlags additional_usage)
+    : m_device(device), m_additional_usage(additional_usage) {}
+
+StorageBuffer::~StorageBuffer() { destroy(); }
+
+bool StorageBuffer::update(const void *data, u64 buffer_size) {
+    if (buffer_size == 0) {
+        return false;
+    }
+    bool recreated = buffer_size > m_size;
+    if (recreated) {
+        destroy();
+        vk_createBuffer(m_device->Get(), m_device->getPhysicalDevice(), buffer_size,
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | m_additional_usage,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_storage_buffer,
+                        m_storage_buffer_memory);
+        m_size = buffer_size;
+        bufferDescriptrInfo.buffer = m_storage_buffer;
+        bufferDescriptrInfo.offset = 0;
+        bufferDescriptrInfo.range = buffer_size;
+    }
+    void *mapped;
+    vkMapMemory(m_device->Get(), m_storage_buffer_memory, 0, buffer_size, 0, &mapped);
+    memcpy(mapped, data, buffer_size);
+    vkUnmapMemory(m_device->Get(), m_storage_buffer_memory);
+    return recreated;
+}
+
+VkBuffer StorageBuffer::Get() const noexcept { return m_storage_buffer; }
+
+u64 StorageBuffer::size() const noexcept { return m_size; }
+
+void StorageBuffer::destroy() noexcept {
+    if (m_storage_buffer) {
+        vkDestroyBuffer(m_device->Get(), m_storage_buffer, nullptr);
+        vkFreeMemory(m_device->Get(), m_storage_buffer_memory, nullptr);
+        m_storage_buffer = VK_NULL_HANDLE;
+        m_storage_buffer_memory = VK_NULL_HANDLE;
+    }
+}
+} // namespace Horizon
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include "CommandBuffer.h"
+#include "Device.h"
+#include "VulkanBuffer.h"
+#include <runtime/function/rhi/RenderContext.h>
+
+namespace Horizon {
+// host visible storage buffer, grows on demand
+class StorageBuffer : public DescriptorBase {
+  public:
+    // additional_usage is or'ed into the storage usage, e.g. for buffers that also feed indirect draws
+    StorageBuffer(std::shared_ptr<Device>, VkBufferUsageFlags additional_usage = 0);
+    ~StorageBuffer();
+    // true when the data outgrew the buffer and it was recreated, descriptors that point at the old one have to be
+    // rebound before the next use
+    bool update(const void *data, u64 buffer_size);
+    VkBuffer Get() const noexcept;
+    u64 size() const noexcept;
+
+  private:
+    void destroy() noexcept;
+
+  private:
+    std::shared_ptr<Device> m_device = nullptr;
+    VkBuffer m_storage_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_storage_buffer_memory = VK_NULL_HANDLE;
+    VkBufferUsageFlags m_additional_usage = 0;
+    u64 m_size = 0;
+};
+
+} // namespace Horizon
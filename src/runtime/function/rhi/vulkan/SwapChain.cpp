@@ -1,5 +1,7 @@
 #include "SwapChain.h"
 
+#include <algorithm>
+
 #include <runtime/core/log/Log.h>
 
 #include "Device.h"
@@ -10,7 +12,7 @@
 namespace Horizon {
 SwapChain::SwapChain(RenderContext &render_context, std::shared_ptr<Device> device, std::shared_ptr<Surface> surface)
     : m_render_context(render_context), m_device(device), m_surface(surface) {
-    createSwapChain();
+    createSwapChain({m_render_context.width, m_render_context.height});
 
     createImageViews();
 }
@@ -25,26 +27,33 @@ VkImageView SwapChain::getImageView(u32 i) const noexcept { return imageViews[i]
 
 VkFormat SwapChain::getImageFormat() const noexcept { return mImageFormat; }
 
+VkPresentModeKHR SwapChain::getPresentMode() const noexcept { return mPresentMode; }
+
+VkExtent2D SwapChain::getExtent() const noexcept { return mExtent; }
+
 void SwapChain::recreate(VkExtent2D newExtent) {
-    cleanup();
+    destroyImageViews();
 
-    createSwapChain();
+    VkSwapchainKHR old_swap_chain = m_swap_chain;
+    createSwapChain(newExtent, old_swap_chain);
+    vkDestroySwapchainKHR(m_device->Get(), old_swap_chain, nullptr);
 
     createImageViews();
 }
 
 // private:
 
-void SwapChain::createSwapChain() {
+void SwapChain::createSwapChain(VkExtent2D extent, VkSwapchainKHR old_swap_chain) {
     // Get necessary swapchain properties
     SurfaceSupportDetails details(m_device->getPhysicalDevice(), m_surface->Get());
     QueueFamilyIndices indices = m_device->getQueueFamilyIndices();
     VkSurfaceFormatKHR surfaceFormat = chooseSurfaceFormat(details.getFormats());
-    VkPresentModeKHR presentMode = choosePresentMode(details.getPresentModes());
+    mPresentMode = choosePresentMode(details.getPresentModes());
     VkSurfaceCapabilitiesKHR surfaceCapabilities = details.getCapabilities();
     u32 imag_count = m_render_context.swap_chain_image_count; // how many images we would like to have in swap chain
 
     mImageFormat = surfaceFormat.format;
+    mExtent = chooseExtent(surfaceCapabilities, extent);
 
     VkSwapchainCreateInfoKHR swap_chain_create_info{};
     swap_chain_create_info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -52,15 +61,16 @@ void SwapChain::createSwapChain() {
     swap_chain_create_info.minImageCount = imag_count;
     swap_chain_create_info.imageFormat = mImageFormat;
     swap_chain_create_info.imageColorSpace = surfaceFormat.colorSpace;
-    swap_chain_create_info.imageExtent = {m_render_context.width, m_render_context.height};
+    swap_chain_create_info.imageExtent = mExtent;
     swap_chain_create_info.imageArrayLayers = 1;
     swap_chain_create_info.imageUsage =
         VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
         VK_IMAGE_USAGE_TRANSFER_DST_BIT; //  the image can be used as the source of a transfer command.
     swap_chain_create_info.preTransform = surfaceCapabilities.currentTransform; // rotatioin/flip
     swap_chain_create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swap_chain_create_info.presentMode = presentMode;
+    swap_chain_create_info.presentMode = mPresentMode;
     swap_chain_create_info.clipped = VK_TRUE;
+    swap_chain_create_info.oldSwapchain = old_swap_chain;
 
     // handle swap chain images that will be used across multiple queue families
     if (indices.getGraphics() != indices.getPresent()) {
@@ -101,20 +111,34 @@ VkSurfaceFormatKHR SwapChain::chooseSurfaceFormat(std::vector<VkSurfaceFormatKHR
     return availableFormats[0];
 }
 
-VkPresentModeKHR SwapChain::choosePresentMode(std::vector<VkPresentModeKHR> availablePresentModes) const noexcept {
-    // simplest mode
+VkPresentModeKHR
+SwapChain::choosePresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) const noexcept {
+    VkPresentModeKHR preferred = VK_PRESENT_MODE_FIFO_KHR;
+    switch (m_render_context.present_mode) {
+    case PresentMode::PRESENT_MODE_MAILBOX:
+        preferred = VK_PRESENT_MODE_MAILBOX_KHR;
+        break;
+    case PresentMode::PRESENT_MODE_IMMEDIATE:
+        preferred = VK_PRESENT_MODE_IMMEDIATE_KHR;
+        break;
+    default:
+        break;
+    }
+    if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferred) !=
+        availablePresentModes.end()) {
+        return preferred;
+    }
+    // the only mode every surface supports
+    LOG_WARN("present mode {} not supported, using fifo", static_cast<u32>(preferred));
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-VkExtent2D SwapChain::chooseExtent(VkSurfaceCapabilitiesKHR capabilities) {
+VkExtent2D SwapChain::chooseExtent(VkSurfaceCapabilitiesKHR capabilities, VkExtent2D extent) const noexcept {
     // can choose any extent
     if (capabilities.currentExtent.width != (std::numeric_limits<u32>::max)()) {
         return capabilities.currentExtent;
     }
-    i32 width, height;
-    glfwGetFramebufferSize(m_window->getWindow(), &width, &height);
-
-    VkExtent2D actualExtent = {static_cast<u32>(width), static_cast<u32>(height)};
+    VkExtent2D actualExtent = extent;
 
     // extent height and width: (minAvailable <= extent <= maxAvailable) && (extent <= actualExtent)
     actualExtent.width = (std::max)(capabilities.minImageExtent.width,
@@ -134,10 +158,15 @@ u32 SwapChain::chooseMinImageCount(VkSurfaceCapabilitiesKHR capabilities) {
     return imag_count;
 }
 
-void SwapChain::cleanup() {
+void SwapChain::destroyImageViews() {
     for (auto &imageView : imageViews) {
         vkDestroyImageView(m_device->Get(), imageView, nullptr);
     }
+    imageViews.clear();
+}
+
+void SwapChain::cleanup() {
+    destroyImageViews();
     vkDestroySwapchainKHR(m_device->Get(), m_swap_chain, nullptr);
 }
 
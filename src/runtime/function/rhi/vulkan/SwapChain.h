@@ -27,33 +27,39 @@ class SwapChain {
 
     VkFormat getImageFormat() const noexcept;
 
+    VkPresentModeKHR getPresentMode() const noexcept;
+
+    VkExtent2D getExtent() const noexcept;
+
+    // the old swap chain is handed to the new one and destroyed after, the surface may clamp the requested extent
     void recreate(VkExtent2D newExtent);
 
   private:
-    void createSwapChain();
+    void createSwapChain(VkExtent2D extent, VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE);
 
     VkSurfaceFormatKHR chooseSurfaceFormat(std::vector<VkSurfaceFormatKHR> availableFormats) const noexcept;
 
-    VkPresentModeKHR choosePresentMode(std::vector<VkPresentModeKHR> availablePresentModes) const noexcept;
+    VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes) const noexcept;
 
-    VkExtent2D chooseExtent(VkSurfaceCapabilitiesKHR capabilities);
+    VkExtent2D chooseExtent(VkSurfaceCapabilitiesKHR capabilities, VkExtent2D extent) const noexcept;
 
     static u32 chooseMinImageCount(VkSurfaceCapabilitiesKHR capabilities);
 
     void createImageViews();
 
+    void destroyImageViews();
+
     void cleanup();
 
   private:
     RenderContext &m_render_context;
     const VkSurfaceFormatKHR PREFERRED_PRESENT_FORMAT = {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
-    const VkPresentModeKHR PREFERRED_PRESENT_MODE = VK_PRESENT_MODE_MAILBOX_KHR;
     std::shared_ptr<Device> m_device = nullptr;
     std::shared_ptr<Surface> m_surface = nullptr;
-    std::shared_ptr<Window> m_window = nullptr;
     VkSwapchainKHR m_swap_chain;
-    //VkExtent2D mExtent;	// swap extent is the resolution of swap chain images
+    VkExtent2D mExtent; // swap extent is the resolution of swap chain images
     VkFormat mImageFormat;
+    VkPresentModeKHR mPresentMode = VK_PRESENT_MODE_FIFO_KHR;
     std::vector<VkImage> images; // handle of swapchain images
     std::vector<VkImageView>
         imageViews; // An image view is quite literally a view into an image. It describes how to access the image and which part of the image to access
@@ -1,7 +1,11 @@
 #include "Texture.h"
 
+#include <algorithm>
+
 #include <stb_image.h>
 
+#include <runtime/core/image/ImageFormat.h>
+#include <runtime/core/image/Mipmap.h>
 #include <runtime/core/log/Log.h>
 
 #include "VulkanBuffer.h"
@@ -12,7 +16,7 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
     : m_device(device), m_command_buffer(command_buffer) {}
 
 Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
-                 tinygltf::Image &gltfimage)
+                 tinygltf::Image &gltfimage, bool srgb)
     : m_device(device), m_command_buffer(command_buffer) {
     u8 *buffer = nullptr;
     VkDeviceSize buffer_size = 0;
@@ -34,11 +38,120 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
         deleteBuffer = true;
     } else {
         buffer = &gltfimage.image[0];
-        buffer_size = gltfimage.image.size();
     }
-    texWidth = gltfimage.width;
-    texHeight = gltfimage.height;
+    createFromRgba8(buffer, static_cast<u32>(gltfimage.width), static_cast<u32>(gltfimage.height), 1, srgb);
+    if (deleteBuffer) {
+        delete[] buffer;
+    }
+}
+
+Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer, const u8 *pixels,
+                 u32 width, u32 height, u32 mip_count, bool srgb)
+    : m_device(device), m_command_buffer(command_buffer) {
+    createFromRgba8(pixels, width, height, mip_count, srgb);
+}
+
+static void RecordImageBarrier(VkCommandBuffer cmdbuf, VkImage image, u32 base_level, u32 level_count,
+                               VkImageLayout old_layout, VkImageLayout new_layout, VkAccessFlags src_access,
+                               VkAccessFlags dst_access, VkPipelineStageFlags src_stage,
+                               VkPipelineStageFlags dst_stage) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = old_layout;
+    barrier.newLayout = new_layout;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = base_level;
+    barrier.subresourceRange.levelCount = level_count;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmdbuf, src_stage, dst_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void Texture::createFromRgba8(const u8 *buffer, u32 width, u32 height, u32 mip_count, bool srgb) {
+    texWidth = static_cast<i32>(width);
+    texHeight = static_cast<i32>(height);
+    mipLevels = Mipmap::GetLevelCount(width, height);
+    u32 uploaded_levels = std::clamp(mip_count, 1u, mipLevels);
+    if (uploaded_levels > 1) {
+        // a chain from the caller is taken as is
+        mipLevels = uploaded_levels;
+    }
+
+    // srgb content is blitted through an srgb alias of the image so the filter sees linear values, the view stays
+    // unorm so sampling is unchanged
+    VkFormat blit_format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    std::vector<u8> chain;
+    if (uploaded_levels < mipLevels && !supportsLinearBlit(blit_format)) {
+        chain = Mipmap::GenerateRgba8(buffer, width, height, srgb);
+        buffer = chain.data();
+        uploaded_levels = mipLevels;
+    }
+    bool blit = uploaded_levels < mipLevels;
+    upload(blit ? blit_format : VK_FORMAT_R8G8B8A8_UNORM, buffer, width, height, uploaded_levels, blit);
+}
+
+Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer, VkFormat format,
+                 const u8 *levels, u32 width, u32 height, u32 mip_count)
+    : m_device(device), m_command_buffer(command_buffer) {
+    VkFormat unorm_format = ImageFormat::GetUnormFormat(format);
+    if (unorm_format == VK_FORMAT_R8G8B8A8_UNORM) {
+        createFromRgba8(levels, width, height, mip_count, false);
+        return;
+    }
+    texWidth = static_cast<i32>(width);
+    texHeight = static_cast<i32>(height);
+    mipLevels = std::clamp(mip_count, 1u, Mipmap::GetLevelCount(width, height));
+    if (canSample(*m_device, unorm_format)) {
+        upload(unorm_format, levels, width, height, mipLevels, false);
+        return;
+    }
+
+    // the device cannot sample the blocks, expand every level on the cpu
+    std::vector<u8> chain(Mipmap::GetChainSize(width, height, mipLevels));
+    for (u32 level = 0; level < mipLevels; level++) {
+        u32 level_width = Mipmap::GetLevelExtent(width, level), level_height = Mipmap::GetLevelExtent(height, level);
+        ImageFormat::DecodeRgba8(unorm_format, levels, level_width, level_height,
+                                 chain.data() + Mipmap::GetChainSize(width, height, level));
+        levels += ImageFormat::GetLevelSize(unorm_format, level_width, level_height);
+    }
+    upload(VK_FORMAT_R8G8B8A8_UNORM, chain.data(), width, height, mipLevels, false);
+}
+
+Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer, VkFormat format,
+                 const u8 *levels, u32 width, u32 height, u32 mip_count, VkCommandBuffer upload_command_buffer)
+    : m_device(device), m_command_buffer(command_buffer) {
+    texWidth = static_cast<i32>(width);
+    texHeight = static_cast<i32>(height);
+    mipLevels = std::clamp(mip_count, 1u, Mipmap::GetLevelCount(width, height));
+    upload(ImageFormat::GetUnormFormat(format), levels, width, height, mipLevels, false, upload_command_buffer);
+}
+
+bool Texture::CanLoad(const Device &device, VkFormat format) noexcept {
+    VkFormat unorm_format = ImageFormat::GetUnormFormat(format);
+    return ImageFormat::CanDecode(unorm_format) ||
+           (ImageFormat::GetBlockSize(unorm_format) != 0 && canSample(device, unorm_format));
+}
+
+bool Texture::canSample(const Device &device, VkFormat format) noexcept {
+    if (ImageFormat::IsBlockCompressed(format) && !device.SupportsTextureCompressionBC()) {
+        return false;
+    }
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(device.getPhysicalDevice(), format, &properties);
+    VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
 
+void Texture::upload(VkFormat format, const u8 *levels, u32 width, u32 height, u32 level_count, bool blit,
+                     VkCommandBuffer command_buffer) {
+    VkFormat view_format = ImageFormat::GetUnormFormat(format);
+    VkDeviceSize buffer_size = ImageFormat::GetChainSize(format, width, height, level_count);
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
     vk_createBuffer(m_device->Get(), m_device->getPhysicalDevice(), buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
@@ -47,21 +160,20 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
 
     void *data;
     vkMapMemory(m_device->Get(), stagingBufferMemory, 0, buffer_size, 0, &data);
-    memcpy(data, buffer, static_cast<size_t>(buffer_size));
+    memcpy(data, levels, static_cast<size_t>(buffer_size));
     vkUnmapMemory(m_device->Get(), stagingBufferMemory);
 
-    //stbi_image_free(buffer);
-
     // create image
     VkImageCreateInfo image_create_info{};
     image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.flags = format != view_format ? VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT : 0;
     image_create_info.imageType = VK_IMAGE_TYPE_2D;
     image_create_info.extent.width = static_cast<uint32_t>(texWidth);
     image_create_info.extent.height = static_cast<uint32_t>(texHeight);
     image_create_info.extent.depth = 1;
-    image_create_info.mipLevels = 1;
+    image_create_info.mipLevels = mipLevels;
     image_create_info.arrayLayers = 1;
-    image_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_create_info.format = format;
     image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
     image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
     image_create_info.usage =
@@ -81,35 +193,71 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     CHECK_VK_RESULT(vkAllocateMemory(m_device->Get(), &allocInfo, nullptr, &m_image_memory));
+    m_memory_size = memRequirements.size;
 
     vkBindImageMemory(m_device->Get(), m_image, m_image_memory, 0);
 
-    transitionImageLayout(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    copyBufferToImage(stagingBuffer, m_image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    transitionImageLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    vkDestroyBuffer(m_device->Get(), stagingBuffer, nullptr);
-    vkFreeMemory(m_device->Get(), stagingBufferMemory, nullptr);
-
-    createImageView(VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_VIEW_TYPE_2D);
+    // upload and mip generation go into one submission
+    bool wait = command_buffer == VK_NULL_HANDLE;
+    VkCommandBuffer cmdbuf = wait ? m_command_buffer->beginSingleTimeCommands() : command_buffer;
+    RecordImageBarrier(cmdbuf, m_image, 0, mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    std::vector<VkBufferImageCopy> regions(level_count);
+    for (u32 level = 0; level < level_count; level++) {
+        VkBufferImageCopy &region = regions[level];
+        region.bufferOffset = ImageFormat::GetChainSize(format, width, height, level);
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {Mipmap::GetLevelExtent(width, level), Mipmap::GetLevelExtent(height, level), 1};
+    }
+    vkCmdCopyBufferToImage(cmdbuf, stagingBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<u32>(regions.size()), regions.data());
+
+    // every level is blitted from the one above it, which is done afterwards and moves on to shader reads
+    if (blit) {
+        for (u32 level = 1; level < mipLevels; level++) {
+            RecordImageBarrier(cmdbuf, m_image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+                               VK_ACCESS_TRANSFER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+            VkImageBlit region{};
+            region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+            region.srcOffsets[1] = {static_cast<i32>(Mipmap::GetLevelExtent(width, level - 1)),
+                                    static_cast<i32>(Mipmap::GetLevelExtent(height, level - 1)), 1};
+            region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+            region.dstOffsets[1] = {static_cast<i32>(Mipmap::GetLevelExtent(width, level)),
+                                    static_cast<i32>(Mipmap::GetLevelExtent(height, level)), 1};
+            vkCmdBlitImage(cmdbuf, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
+
+            RecordImageBarrier(cmdbuf, m_image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT,
+                               VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                               VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        }
+    }
+    u32 remaining_level = blit ? mipLevels - 1 : 0;
+    RecordImageBarrier(cmdbuf, m_image, remaining_level, mipLevels - remaining_level,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    if (wait) {
+        m_command_buffer->endSingleTimeCommands(cmdbuf);
+        vkDestroyBuffer(m_device->Get(), stagingBuffer, nullptr);
+        vkFreeMemory(m_device->Get(), stagingBufferMemory, nullptr);
+    } else {
+        m_staging_buffer = stagingBuffer;
+        m_staging_memory = stagingBufferMemory;
+    }
 
-    VkSamplerCreateInfo samplerInfo{};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.anisotropyEnable = VK_FALSE;
-    samplerInfo.maxAnisotropy = 1.0;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-
-    vkCreateSampler(m_device->Get(), &samplerInfo, nullptr, &m_sampler);
+    createImageView(view_format, VK_IMAGE_VIEW_TYPE_2D);
+    createSampler();
 
     // fill descriptor info
     imageDescriptorInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -117,6 +265,14 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
     imageDescriptorInfo.sampler = m_sampler;
 }
 
+bool Texture::supportsLinearBlit(VkFormat format) const {
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(m_device->getPhysicalDevice(), format, &properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                    VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
 Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
                  TextureCreateInfo create_info)
     : m_device(device), m_command_buffer(command_buffer) {
@@ -128,6 +284,7 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
     image_create_info.extent.width = create_info.width;
     image_create_info.extent.height = create_info.height;
     image_create_info.extent.depth = create_info.depth;
+    m_extent = image_create_info.extent;
     image_create_info.mipLevels = 1;
     image_create_info.arrayLayers = 1;
     image_create_info.format = ToVkImageFormat(create_info.texture_format);
@@ -149,6 +306,7 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     CHECK_VK_RESULT(vkAllocateMemory(m_device->Get(), &allocInfo, nullptr, &m_image_memory));
+    m_memory_size = memRequirements.size;
 
     vkBindImageMemory(m_device->Get(), m_image, m_image_memory, 0);
 
@@ -195,8 +353,25 @@ Texture::Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer>
 Texture::~Texture() {
     vkDestroyImage(m_device->Get(), m_image, nullptr);
     vkDestroyImageView(m_device->Get(), m_image_view, nullptr);
-    vkDestroySampler(m_device->Get(), m_sampler, nullptr);
     vkFreeMemory(m_device->Get(), m_image_memory, nullptr);
+    if (m_staging_buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_device->Get(), m_staging_buffer, nullptr);
+        vkFreeMemory(m_device->Get(), m_staging_memory, nullptr);
+    }
+}
+
+void Texture::swapImage(Texture &other) noexcept {
+    std::swap(texWidth, other.texWidth);
+    std::swap(texHeight, other.texHeight);
+    std::swap(mipLevels, other.mipLevels);
+    std::swap(m_memory_size, other.m_memory_size);
+    std::swap(m_image, other.m_image);
+    std::swap(m_image_memory, other.m_image_memory);
+    std::swap(m_image_view, other.m_image_view);
+    std::swap(subresource_range, other.subresource_range);
+    // the sampler stays with the texture
+    std::swap(imageDescriptorInfo.imageView, other.imageDescriptorInfo.imageView);
+    std::swap(imageDescriptorInfo.imageLayout, other.imageDescriptorInfo.imageLayout);
 }
 
 void Texture::loadFromFile(const std::string &path, VkImageUsageFlags usage, VkImageLayout layout) {
@@ -209,6 +384,13 @@ void Texture::loadFromFile(const std::string &path, VkImageUsageFlags usage, VkI
         return;
     }
 
+    // sampled textures get a mip chain like the model textures
+    if (layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && (usage & VK_IMAGE_USAGE_SAMPLED_BIT)) {
+        createFromRgba8(buffer, static_cast<u32>(texWidth), static_cast<u32>(texHeight), 1, false);
+        stbi_image_free(buffer);
+        return;
+    }
+
     VkBuffer stagingBuffer;
     VkDeviceMemory stagingBufferMemory;
     vk_createBuffer(m_device->Get(), m_device->getPhysicalDevice(), imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
@@ -250,6 +432,7 @@ void Texture::loadFromFile(const std::string &path, VkImageUsageFlags usage, VkI
                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     CHECK_VK_RESULT(vkAllocateMemory(m_device->Get(), &allocInfo, nullptr, &m_image_memory));
+    m_memory_size = memRequirements.size;
 
     vkBindImageMemory(m_device->Get(), m_image, m_image_memory, 0);
 
@@ -281,7 +464,7 @@ void Texture::transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLa
     barrier.image = m_image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
 
@@ -343,7 +526,7 @@ void Texture::createImageView(VkFormat format, VkImageViewType type) {
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
     subresource_range = viewInfo.subresourceRange;
@@ -351,22 +534,76 @@ void Texture::createImageView(VkFormat format, VkImageViewType type) {
 }
 
 void Texture::createSampler() {
-    VkSamplerCreateInfo samplerInfo{};
-    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    samplerInfo.magFilter = VK_FILTER_LINEAR;
-    samplerInfo.minFilter = VK_FILTER_LINEAR;
-    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    samplerInfo.anisotropyEnable = VK_FALSE;
-    samplerInfo.maxAnisotropy = 1.0;
-    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    samplerInfo.unnormalizedCoordinates = VK_FALSE;
-    samplerInfo.compareEnable = VK_FALSE;
-    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-
-    vkCreateSampler(m_device->Get(), &samplerInfo, nullptr, &m_sampler);
+    // linear clamp, shared through the device's sampler cache
+    m_sampler = m_device->GetSamplerCache().Get(SamplerDesc{});
+}
+
+void Texture::ReadTexels(void *texels, u64 size) noexcept {
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_memory;
+    vk_createBuffer(m_device->Get(), m_device->getPhysicalDevice(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer,
+                    staging_memory);
+
+    VkCommandBuffer cmdbuf = m_command_buffer->beginSingleTimeCommands();
+    // shader writes before the copy, the copy before the host read
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = m_extent;
+    vkCmdCopyImageToBuffer(cmdbuf, m_image, imageDescriptorInfo.imageLayout, staging_buffer, 1, &region);
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+    m_command_buffer->endSingleTimeCommands(cmdbuf);
+
+    void *data;
+    vkMapMemory(m_device->Get(), staging_memory, 0, size, 0, &data);
+    memcpy(texels, data, static_cast<size_t>(size));
+    vkUnmapMemory(m_device->Get(), staging_memory);
+
+    vkDestroyBuffer(m_device->Get(), staging_buffer, nullptr);
+    vkFreeMemory(m_device->Get(), staging_memory, nullptr);
+}
+
+void Texture::WriteTexels(const void *texels, u64 size) noexcept {
+    VkBuffer staging_buffer;
+    VkDeviceMemory staging_memory;
+    vk_createBuffer(m_device->Get(), m_device->getPhysicalDevice(), size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging_buffer,
+                    staging_memory);
+
+    void *data;
+    vkMapMemory(m_device->Get(), staging_memory, 0, size, 0, &data);
+    memcpy(data, texels, static_cast<size_t>(size));
+    vkUnmapMemory(m_device->Get(), staging_memory);
+
+    VkCommandBuffer cmdbuf = m_command_buffer->beginSingleTimeCommands();
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = m_extent;
+    vkCmdCopyBufferToImage(cmdbuf, staging_buffer, m_image, imageDescriptorInfo.imageLayout, 1, &region);
+
+    // the copy before any shader access
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmdbuf, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+    m_command_buffer->endSingleTimeCommands(cmdbuf);
+
+    vkDestroyBuffer(m_device->Get(), staging_buffer, nullptr);
+    vkFreeMemory(m_device->Get(), staging_memory, nullptr);
 }
 
 void Texture::destroy() {
@@ -18,31 +18,75 @@ struct TextureCreateInfo {
 class Texture : public DescriptorBase {
   public:
     Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command);
-    Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command, tinygltf::Image &gltfimage);
+    // srgb marks color content, see createFromRgba8
+    Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command, tinygltf::Image &gltfimage,
+            bool srgb = false);
+    // tightly packed rgba8 pixels, mip_count levels back to back largest first
+    Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command, const u8 *pixels, u32 width,
+            u32 height, u32 mip_count = 1, bool srgb = false);
+    // levels of a format from ImageFormat back to back largest first, as stored in ktx2 files and cooked models. block
+    // formats keep the levels they come with, formats the device cannot sample are expanded to rgba8 on the cpu
+    Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command, VkFormat format, const u8 *levels,
+            u32 width, u32 height, u32 mip_count);
+    // levels of a format the device samples, recorded into upload_command_buffer instead of waiting for the copy. the
+    // staging buffer lives until the texture is destroyed, so keep it around until the submission finished
+    Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command, VkFormat format, const u8 *levels,
+            u32 width, u32 height, u32 mip_count, VkCommandBuffer upload_command_buffer);
     Texture(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
             TextureCreateInfo create_info);
     ~Texture();
+    // false if the device can neither sample nor the cpu decode the format
+    static bool CanLoad(const Device &device, VkFormat format) noexcept;
+    // true if the unorm format is sampled as is, without the cpu decode
+    static bool canSample(const Device &device, VkFormat format) noexcept;
+    // exchanges the gpu image with other, descriptors written afterwards see the new one. the caller makes sure
+    // neither image is in use. samplers are not exchanged
+    void swapImage(Texture &other) noexcept;
     void loadFromFile(const std::string &path, VkImageUsageFlags usage, VkImageLayout layout);
     void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
     void copyBufferToImage(VkBuffer buffer, VkImage image, u32 width, u32 height);
     void createImageView(VkFormat format, VkImageViewType type);
     void createSampler();
     void destroy();
+    // whole image of a TextureCreateInfo texture with TEXTURE_USAGE_RW, texels tightly packed row by row and slice by
+    // slice. size has to match the extent and format. both wait for the queue, for setup and baking only
+    void ReadTexels(void *texels, u64 size) noexcept;
+    void WriteTexels(const void *texels, u64 size) noexcept;
     inline VkImage GetImage() const noexcept { return m_image; }
     inline VkImageSubresourceRange GetSubresourceRange() const noexcept { return subresource_range; }
+    inline u32 GetWidth() const noexcept { return static_cast<u32>(texWidth); }
+    inline u32 GetHeight() const noexcept { return static_cast<u32>(texHeight); }
+    // device memory of the image
+    inline u64 GetMemorySize() const noexcept { return m_memory_size; }
+
+  private:
+    // a single level is extended to a full mip chain by blits in the upload command buffer, or on the cpu when the
+    // format cannot be blitted. srgb content is filtered in linear space, the image stays unorm for sampling
+    void createFromRgba8(const u8 *pixels, u32 width, u32 height, u32 mip_count, bool srgb);
+    bool supportsLinearBlit(VkFormat format) const;
+    // creates the image with mipLevels levels and uploads the first level_count of them in one submission, blit fills
+    // the rest from the level above. srgb formats get a unorm view. without command_buffer the upload waits for the
+    // queue, otherwise it is only recorded and the staging buffer is kept
+    void upload(VkFormat format, const u8 *levels, u32 width, u32 height, u32 level_count, bool blit,
+                VkCommandBuffer command_buffer = VK_NULL_HANDLE);
 
   private:
     std::shared_ptr<Device> m_device = nullptr;
     std::shared_ptr<CommandBuffer> m_command_buffer = nullptr;
     u8 *buffer = nullptr;
     i32 texWidth, texHeight, texChannels;
-    u32 mipLevels;
+    u32 mipLevels = 1;
+    u64 m_memory_size = 0;
+    VkExtent3D m_extent{};
     VkImage m_image;
     VkDeviceMemory m_image_memory;
     VkImageView m_image_view;
-    VkSampler m_sampler;
+    // owned by the sampler cache
+    VkSampler m_sampler = VK_NULL_HANDLE;
     VkImageSubresourceRange subresource_range;
     VkDescriptorImageInfo mDescriptorImageInfo;
+    VkBuffer m_staging_buffer = VK_NULL_HANDLE;
+    VkDeviceMemory m_staging_memory = VK_NULL_HANDLE;
 };
 
 } // namespace Horizon
\ No newline at end of file
@@ -30,4 +30,58 @@ struct Vertex {
     }
 };
 
+// 16 byte vertex, decoded in geometry_compressed.vert
+struct CompressedVertex {
+    // xyz unorm16 relative to the primitive aabb, w unused
+    u64 pos;
+    // octahedral encoded, snorm16 x2
+    u32 normal;
+    // f16 x2
+    u32 uv0;
+
+    static CompressedVertex Encode(const Vertex &vertex, const Math::vec3 &bounds_min,
+                                   const Math::vec3 &bounds_extent) noexcept {
+        CompressedVertex ret;
+        // flat axes have no extent, every vertex sits at the minimum
+        Math::vec3 inv_extent = Math::vec3(bounds_extent.x > 0.0f ? 1.0f / bounds_extent.x : 0.0f,
+                                           bounds_extent.y > 0.0f ? 1.0f / bounds_extent.y : 0.0f,
+                                           bounds_extent.z > 0.0f ? 1.0f / bounds_extent.z : 0.0f);
+        ret.pos = Math::packUnorm4x16(Math::vec4((vertex.pos - bounds_min) * inv_extent, 0.0f));
+        ret.normal = Math::packSnorm2x16(OctEncode(vertex.normal));
+        ret.uv0 = Math::packHalf2x16(vertex.uv0);
+        return ret;
+    }
+
+    // project onto the octahedron and fold the lower hemisphere over the diagonals
+    static Math::vec2 OctEncode(const Math::vec3 &n) noexcept {
+        f32 l1 = Math::abs(n.x) + Math::abs(n.y) + Math::abs(n.z);
+        if (l1 == 0.0f) {
+            return Math::vec2(0.0f);
+        }
+        Math::vec2 p = Math::vec2(n) / l1;
+        if (n.z < 0.0f) {
+            Math::vec2 sign_not_zero = Math::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+            p = (1.0f - Math::abs(Math::vec2(p.y, p.x))) * sign_not_zero;
+        }
+        return p;
+    }
+
+    static VkVertexInputBindingDescription getBindingDescription() {
+        VkVertexInputBindingDescription bindingDescription{0, sizeof(CompressedVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+        return bindingDescription;
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{
+            {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(CompressedVertex, pos)},
+            {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(CompressedVertex, normal)},
+            {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(CompressedVertex, uv0)},
+        };
+
+        return attributeDescriptions;
+    }
+};
+
+static_assert(sizeof(CompressedVertex) == 16, "compressed vertex should be 16 bytes");
+
 } // namespace Horizon
\ No newline at end of file
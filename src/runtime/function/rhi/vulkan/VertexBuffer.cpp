@@ -4,9 +4,18 @@
 namespace Horizon {
 VertexBuffer::VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
                            const std::vector<Vertex> &vertices)
+    : VertexBuffer(device, command_buffer, vertices.data(), vertices.size(), sizeof(Vertex)) {}
+
+VertexBuffer::VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                           const std::vector<CompressedVertex> &vertices)
+    : VertexBuffer(device, command_buffer, vertices.data(), vertices.size(), sizeof(CompressedVertex)) {}
+
+VertexBuffer::VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                           const void *vertices, u64 vertices_count, u64 stride)
     : m_device(device) {
-    m_vertices_count = vertices.size();
-    VkDeviceSize buffer_size = sizeof(vertices[0]) * m_vertices_count;
+    m_vertices_count = vertices_count;
+    VkDeviceSize buffer_size = stride * m_vertices_count;
+    m_size = buffer_size;
 
     // create stage buffer
     VkBuffer stagingBuffer;
@@ -18,7 +27,7 @@ VertexBuffer::VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<Comma
     // upload cpu data
     void *data;
     vkMapMemory(m_device->Get(), stagingBufferMemory, 0, buffer_size, 0, &data);
-    memcpy(data, vertices.data(), buffer_size);
+    memcpy(data, vertices, buffer_size);
     vkUnmapMemory(m_device->Get(), stagingBufferMemory);
 
     // create actual vertex buffer
@@ -65,4 +74,6 @@ VertexBuffer::~VertexBuffer() {
 VkBuffer VertexBuffer::Get() const noexcept { return m_vertex_buffer; }
 
 u64 VertexBuffer::getVerticesCount() const noexcept { return m_vertices_count; }
+
+u64 VertexBuffer::GetSize() const noexcept { return m_size; }
 } // namespace Horizon
\ No newline at end of file
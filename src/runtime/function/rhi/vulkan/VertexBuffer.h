@@ -12,16 +12,22 @@ class VertexBuffer {
     VertexBuffer() = default;
     VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
                  const std::vector<Vertex> &vertices);
+    VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                 const std::vector<CompressedVertex> &vertices);
+    VertexBuffer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer, const void *vertices,
+                 u64 vertices_count, u64 stride);
     //VertexBuffer(const VertexBuffer&& rhs);
     //VertexBuffer& operator=(VertexBuffer&& rhs);
     ~VertexBuffer();
     VkBuffer Get() const noexcept;
     u64 getVerticesCount() const noexcept;
+    u64 GetSize() const noexcept;
 
   private:
     std::shared_ptr<Device> m_device = nullptr;
     VkBuffer m_vertex_buffer;
     VkDeviceMemory m_vertex_buffer_memory;
     u64 m_vertices_count;
+    u64 m_size;
 };
 } // namespace Horizon
\ No newline at end of file
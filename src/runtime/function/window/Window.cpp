@@ -10,16 +10,15 @@ Window::Window(const char *_name, u32 _width, u32 _height) noexcept : width(_wid
         LOG_ERROR("failed to init glfw");
     };
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     m_window = glfwCreateWindow(static_cast<int>(_width), static_cast<int>(_height), _name, nullptr, nullptr);
 
     if (m_window == nullptr) {
         glfwTerminate();
         LOG_ERROR("failed to init window");
     }
-
-    glfwSwapInterval(vsync_enabled ? 1 : 0);
-    LOG_INFO("vsync stat: {}", vsync_enabled);
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetFramebufferSizeCallback(m_window, FramebufferSizeCallback);
 }
 Window::~Window() noexcept {
     glfwDestroyWindow(m_window);
@@ -36,4 +35,32 @@ int Window::ShouldClose() const noexcept { return glfwWindowShouldClose(m_window
 
 void Window::close() noexcept { glfwSetWindowShouldClose(m_window, 1); }
 
+bool Window::ConsumeResize() noexcept {
+    bool resized = m_resized;
+    m_resized = false;
+    return resized;
+}
+
+void Window::WaitWhileMinimized() noexcept {
+    while ((width == 0 || height == 0) && ShouldClose() == 0) {
+        glfwWaitEvents();
+    }
+}
+
+u32 Window::GetRefreshRate() const noexcept {
+    GLFWmonitor *monitor = glfwGetWindowMonitor(m_window);
+    if (monitor == nullptr) {
+        monitor = glfwGetPrimaryMonitor();
+    }
+    const GLFWvidmode *mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return mode ? static_cast<u32>(mode->refreshRate) : 0;
+}
+
+void Window::FramebufferSizeCallback(GLFWwindow *window, int width, int height) noexcept {
+    Window *self = static_cast<Window *>(glfwGetWindowUserPointer(window));
+    self->width = static_cast<u32>(width);
+    self->height = static_cast<u32>(height);
+    self->m_resized = true;
+}
+
 } // namespace Horizon
\ No newline at end of file
@@ -27,10 +27,19 @@ class Window {
     GLFWwindow *getWindow() const noexcept;
     int ShouldClose() const noexcept;
     void close() noexcept;
+    // true once after the framebuffer changed size
+    bool ConsumeResize() noexcept;
+    // blocks while the window is minimized, the framebuffer is then 0x0 and no swap chain can be created for it
+    void WaitWhileMinimized() noexcept;
+    // refresh rate of the monitor the window is on, or of the primary monitor for windowed mode. 0 if unknown
+    u32 GetRefreshRate() const noexcept;
+
+  private:
+    static void FramebufferSizeCallback(GLFWwindow *window, int width, int height) noexcept;
 
   private:
     GLFWwindow *m_window;
     u32 width, height;
-    bool vsync_enabled = false;
+    bool m_resized = false;
 };
 } // namespace Horizon
\ No newline at end of file
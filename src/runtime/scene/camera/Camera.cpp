@@ -17,9 +17,13 @@ void Camera::SetPerspectiveProjectionMatrix(f32 fov, f32 aspect_ratio, f32 nearP
     m_projection = ReversePerspective(fov, aspect_ratio, nearPlane, farPlane);
 }
 
+void Camera::SetAspectRatio(f32 aspect_ratio) noexcept {
+    SetPerspectiveProjectionMatrix(m_fov, aspect_ratio, m_near_plane, m_far_plane);
+}
+
 Math::mat4 Camera::GetProjectionMatrix() const noexcept { return m_projection; }
 
-// Math::vec3 Camera::GetFov() const noexcept { return Math::vec3(); }
+f32 Camera::GetFov() const noexcept { return m_fov; }
 
 Math::vec2 Camera::GetNearFarPlane() const noexcept { return {m_near_plane, m_far_plane}; }
 
@@ -12,6 +12,9 @@ class Camera {
 
     void SetPerspectiveProjectionMatrix(f32 fov, f32 aspect_ratio, f32 near, f32 far) noexcept;
 
+    // rebuilds the projection with the other perspective parameters kept, e.g. after a resize
+    void SetAspectRatio(f32 aspect_ratio) noexcept;
+
     Math::mat4 GetProjectionMatrix() const noexcept;
 
     //void setLookAt(vec3 position, vec3 at, vec3 up = vec3(0.0f, 1.0f, 0.0f));
@@ -19,7 +22,8 @@ class Camera {
 
     Math::vec3 GetPosition() const noexcept;
 
-    Math::vec3 GetFov() const noexcept;
+    // vertical field of view in radians
+    f32 GetFov() const noexcept;
 
     Math::vec2 GetNearFarPlane() const noexcept;
 
@@ -7,9 +7,18 @@ void Material::UpdateDescriptorSet() noexcept {
 
     DescriptorSetUpdateDesc desc;
     desc.BindResource(0, m_material_ub);
-    desc.BindResource(1, base_color_texture);
-    desc.BindResource(2, normal_texture);
-    desc.BindResource(3, metallic_rougness_texture);
+    const std::shared_ptr<Texture> textures[] = {base_color_texture, normal_texture, metallic_rougness_texture};
+    const VkSampler samplers[] = {base_color_sampler, normal_sampler, metallic_rougness_sampler};
+    for (u32 i = 0; i < 3; i++) {
+        if (!m_texture_bindings[i]) {
+            m_texture_bindings[i] = std::make_shared<DescriptorBase>();
+        }
+        m_texture_bindings[i]->imageDescriptorInfo = textures[i]->imageDescriptorInfo;
+        if (samplers[i] != VK_NULL_HANDLE) {
+            m_texture_bindings[i]->imageDescriptorInfo.sampler = samplers[i];
+        }
+        desc.BindResource(i + 1, m_texture_bindings[i]);
+    }
 
     m_material_descriptor_set->UpdateDescriptorSet(desc);
 }
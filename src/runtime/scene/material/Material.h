@@ -16,6 +16,10 @@ class Material {
     std::shared_ptr<Texture> base_color_texture = nullptr;
     std::shared_ptr<Texture> normal_texture = nullptr;
     std::shared_ptr<Texture> metallic_rougness_texture = nullptr;
+    // samplers of the gltf textures from the device's sampler cache, null samples with the texture's own
+    VkSampler base_color_sampler = VK_NULL_HANDLE;
+    VkSampler normal_sampler = VK_NULL_HANDLE;
+    VkSampler metallic_rougness_sampler = VK_NULL_HANDLE;
     //std::shared_ptr<Texture> occlusionTexture;
     //std::shared_ptr<Texture> emissiveTexture;
     // struct TexCoordSets {
@@ -27,6 +31,8 @@ class Material {
     // } texCoordSets;
 
     std::shared_ptr<DescriptorSet> m_material_descriptor_set = nullptr;
+    // slot in the scene's MaterialTable, pushed per draw by bindless geometry pipelines
+    u32 table_index = 0;
 
     struct MaterialUb {
         bool has_base_color = false;
@@ -37,5 +43,9 @@ class Material {
         //Math::vec2 metallicRoughnessFactor = Math::vec2(0.0f);
     } m_material_ubdata;
     std::shared_ptr<UniformBuffer> m_material_ub;
+
+  private:
+    // texture descriptors with the samplers above, refreshed on every update as streamed textures change views
+    std::shared_ptr<DescriptorBase> m_texture_bindings[3];
 };
 } // namespace Horizon
\ No newline at end of file
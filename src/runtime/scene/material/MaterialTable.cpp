@@ -0,0 +1,83 @@
+#include "MaterialTable.h"
+
+#include <algorithm>
+
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+MaterialTable::MaterialTable(std::shared_ptr<Device> device) noexcept : m_device(device) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_device->getPhysicalDevice(), &properties);
+    m_capacity = std::min({MAX_TEXTURES, properties.limits.maxPerStageDescriptorSamplers,
+                           properties.limits.maxPerStageDescriptorSampledImages,
+                           properties.limits.maxDescriptorSetSampledImages});
+
+    std::shared_ptr<DescriptorSetInfo> setInfo = std::make_shared<DescriptorSetInfo>();
+    // material parameters
+    setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_PIXEL_SHADER);
+    // textures of every material
+    setInfo->AddBindingArray(DescriptorType::DESCRIPTOR_TYPE_TEXTURE, SHADER_STAGE_PIXEL_SHADER, m_capacity);
+    m_descriptor_set = std::make_shared<DescriptorSet>(m_device, setInfo);
+
+    m_material_buffer = std::make_shared<StorageBuffer>(m_device);
+}
+
+void MaterialTable::Update(const std::vector<std::shared_ptr<Material>> &materials) noexcept {
+    m_params.clear();
+    m_images.clear();
+    m_texture_slots.clear();
+
+    for (u32 m = 0; m < materials.size(); m++) {
+        Material &material = *materials[m];
+        material.table_index = m;
+
+        MaterialParams params;
+        params.base_color_texture = GetTextureSlot(*material.base_color_texture, material.base_color_sampler);
+        params.normal_texture = GetTextureSlot(*material.normal_texture, material.normal_sampler);
+        params.metallic_roughness_texture =
+            GetTextureSlot(*material.metallic_rougness_texture, material.metallic_rougness_sampler);
+        params.flags = (material.m_material_ubdata.has_base_color ? MATERIAL_HAS_BASE_COLOR : 0) |
+                       (material.m_material_ubdata.has_normal ? MATERIAL_HAS_NORMAL : 0) |
+                       (material.m_material_ubdata.has_metallic_rougness ? MATERIAL_HAS_METALLIC_ROUGHNESS : 0);
+        m_params.push_back(params);
+    }
+    // the storage buffer needs a size even for an empty scene
+    if (m_params.empty()) {
+        m_params.emplace_back();
+    }
+    m_material_buffer->update(m_params.data(), sizeof(MaterialParams) * m_params.size());
+
+    DescriptorSetUpdateDesc desc;
+    desc.BindResource(0, m_material_buffer);
+    desc.BindImageArray(1, m_images);
+    m_descriptor_set->UpdateDescriptorSet(desc);
+}
+
+std::shared_ptr<DescriptorSet> MaterialTable::GetDescriptorSet() const noexcept { return m_descriptor_set; }
+
+u32 MaterialTable::GetTextureCount() const noexcept { return static_cast<u32>(m_images.size()); }
+
+u32 MaterialTable::GetTextureSlot(const Texture &texture, VkSampler sampler) noexcept {
+    VkDescriptorImageInfo info = texture.imageDescriptorInfo;
+    if (sampler != VK_NULL_HANDLE) {
+        info.sampler = sampler;
+    }
+    auto it = m_texture_slots.find({info.imageView, info.sampler});
+    if (it != m_texture_slots.end()) {
+        return it->second;
+    }
+    if (m_images.size() >= m_capacity) {
+        if (!m_overflow_reported) {
+            LOG_WARN("more than {} material textures, the rest sample the first one", m_capacity);
+            m_overflow_reported = true;
+        }
+        return 0;
+    }
+    u32 slot = static_cast<u32>(m_images.size());
+    m_images.push_back(info);
+    m_texture_slots.emplace(std::make_pair(info.imageView, info.sampler), slot);
+    return slot;
+}
+
+} // namespace Horizon
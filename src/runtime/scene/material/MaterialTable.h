@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <runtime/function/rhi/vulkan/Descriptors.h>
+#include <runtime/function/rhi/vulkan/Device.h>
+#include <runtime/function/rhi/vulkan/StorageBuffer.h>
+#include <runtime/scene/material/Material.h>
+
+namespace Horizon {
+
+// every material of a scene in one descriptor set: parameters in a storage buffer indexed by the material index a
+// draw pushes, textures in a partially bound array the parameters point into. draws of different materials share
+// the set, so a material switch costs a push constant instead of a descriptor set bind
+class MaterialTable {
+  public:
+    // upper bound of the texture array, lowered to the device's per stage sampler limits
+    static constexpr u32 MAX_TEXTURES = 4096;
+
+    static constexpr u32 MATERIAL_HAS_BASE_COLOR = 1u << 0;
+    static constexpr u32 MATERIAL_HAS_NORMAL = 1u << 1;
+    static constexpr u32 MATERIAL_HAS_METALLIC_ROUGHNESS = 1u << 2;
+
+    // the device has to support descriptor indexing
+    MaterialTable(std::shared_ptr<Device> device) noexcept;
+    ~MaterialTable() noexcept = default;
+
+    // rewrites the table and assigns Material::table_index. texture views are read again on every call since
+    // streamed textures swap their images, so it runs after the texture streamer and before draws are submitted
+    void Update(const std::vector<std::shared_ptr<Material>> &materials) noexcept;
+
+    std::shared_ptr<DescriptorSet> GetDescriptorSet() const noexcept;
+    u32 GetTextureCount() const noexcept;
+
+  private:
+    // std430 layout of MaterialParams in geometry_bindless.frag
+    struct MaterialParams {
+        u32 base_color_texture = 0;
+        u32 normal_texture = 0;
+        u32 metallic_roughness_texture = 0;
+        // MATERIAL_HAS_* of the textures the material was given, the others sample the empty texture
+        u32 flags = 0;
+    };
+
+    // one array slot per distinct view and sampler, slot 0 once the array is full
+    u32 GetTextureSlot(const Texture &texture, VkSampler sampler) noexcept;
+
+  private:
+    std::shared_ptr<Device> m_device = nullptr;
+    u32 m_capacity = 0;
+    bool m_overflow_reported = false;
+
+    std::vector<MaterialParams> m_params;
+    std::vector<VkDescriptorImageInfo> m_images;
+    std::map<std::pair<VkImageView, VkSampler>, u32> m_texture_slots;
+
+    std::shared_ptr<StorageBuffer> m_material_buffer = nullptr;
+    std::shared_ptr<DescriptorSet> m_descriptor_set = nullptr;
+};
+
+} // namespace Horizon
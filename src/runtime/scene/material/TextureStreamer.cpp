@@ -0,0 +1,275 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <runtime/core/image/ImageFormat.h>
+#include <runtime/core/image/Mipmap.h>
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+TextureStreamer::TextureStreamer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                                 u64 budget) noexcept
+    : m_device(device), m_command_buffer(command_buffer), m_budget(budget) {
+    VkCommandPoolCreateInfo command_pool_create_info{};
+    command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    command_pool_create_info.queueFamilyIndex = m_device->getQueueFamilyIndices().getGraphics();
+    command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    CHECK_VK_RESULT(vkCreateCommandPool(m_device->Get(), &command_pool_create_info, nullptr, &m_command_pool));
+}
+
+TextureStreamer::~TextureStreamer() noexcept {
+    for (Upload &upload : m_uploads) {
+        vkWaitForFences(m_device->Get(), 1, &upload.fence, VK_TRUE, UINT64_MAX);
+        vkDestroyFence(m_device->Get(), upload.fence, nullptr);
+    }
+    m_uploads.clear();
+    vkDestroyCommandPool(m_device->Get(), m_command_pool, nullptr);
+}
+
+std::shared_ptr<Texture> TextureStreamer::Load(VkFormat format, const u8 *levels, u32 width, u32 height,
+                                               u32 mip_count) noexcept {
+    Entry entry;
+    entry.format = ImageFormat::GetUnormFormat(format);
+    entry.width = width;
+    entry.height = height;
+    entry.level_count = std::clamp(mip_count, 1u, Mipmap::GetLevelCount(width, height));
+    if (entry.format != VK_FORMAT_R8G8B8A8_UNORM && !Texture::canSample(*m_device, entry.format)) {
+        // the device cannot sample the blocks, stream the rgba8 expansion instead
+        entry.levels.resize(Mipmap::GetChainSize(width, height, entry.level_count));
+        for (u32 level = 0; level < entry.level_count; level++) {
+            u32 level_width = Mipmap::GetLevelExtent(width, level);
+            u32 level_height = Mipmap::GetLevelExtent(height, level);
+            ImageFormat::DecodeRgba8(entry.format, levels, level_width, level_height,
+                                     entry.levels.data() + Mipmap::GetChainSize(width, height, level));
+            levels += ImageFormat::GetLevelSize(entry.format, level_width, level_height);
+        }
+        entry.format = VK_FORMAT_R8G8B8A8_UNORM;
+    } else {
+        entry.levels.assign(levels, levels + ImageFormat::GetChainSize(entry.format, width, height, entry.level_count));
+    }
+
+    entry.tail_level = entry.level_count - 1;
+    while (entry.tail_level > 0 && std::max(Mipmap::GetLevelExtent(width, entry.tail_level - 1),
+                                            Mipmap::GetLevelExtent(height, entry.tail_level - 1)) <= TAIL_EXTENT) {
+        entry.tail_level--;
+    }
+    if (entry.tail_level == 0) {
+        return std::make_shared<Texture>(m_device, m_command_buffer, entry.format, entry.levels.data(), width, height,
+                                         entry.level_count);
+    }
+
+    u32 tail = entry.tail_level;
+    std::shared_ptr<Texture> texture = std::make_shared<Texture>(
+        m_device, m_command_buffer, entry.format,
+        entry.levels.data() + ImageFormat::GetChainSize(entry.format, width, height, tail),
+        Mipmap::GetLevelExtent(width, tail), Mipmap::GetLevelExtent(height, tail), entry.level_count - tail);
+    entry.texture = texture;
+    entry.resident_level = entry.target_level = tail;
+    entry.requested_level = entry.level_count;
+    // an upload still in flight for an expired texture finishes into its old slot
+    auto free_entry = std::find_if(m_free_entries.begin(), m_free_entries.end(), [&](u32 index) {
+        return m_entries[index].resident_level == m_entries[index].target_level;
+    });
+    u32 index = static_cast<u32>(m_entries.size());
+    if (free_entry != m_free_entries.end()) {
+        index = *free_entry;
+        m_free_entries.erase(free_entry);
+        m_entries[index] = std::move(entry);
+    } else {
+        m_entries.push_back(std::move(entry));
+    }
+    m_entry_indices.emplace(texture.get(), index);
+    return texture;
+}
+
+void TextureStreamer::Request(const Texture *texture, f32 uv_per_pixel) noexcept {
+    auto it = m_entry_indices.find(texture);
+    if (it == m_entry_indices.end()) {
+        return;
+    }
+    Entry &entry = m_entries[it->second];
+    // texels of level 0 between two pixels, every level above halves them
+    f32 texels = uv_per_pixel * static_cast<f32>(std::max(entry.width, entry.height));
+    u32 level = texels > 1.0f ? static_cast<u32>(std::min(std::log2(texels), 31.0f)) : 0;
+    entry.requested_level = std::min({entry.requested_level, level, entry.tail_level});
+    entry.last_used_frame = m_frame;
+}
+
+void TextureStreamer::Update() noexcept {
+    FinishUploads();
+
+    // textures of unloaded models
+    for (auto it = m_entry_indices.begin(); it != m_entry_indices.end();) {
+        Entry &entry = m_entries[it->second];
+        if (entry.texture.expired()) {
+            // the weak pointer would hold on to the storage make_shared gave the texture
+            entry.texture.reset();
+            std::vector<u8>().swap(entry.levels);
+            m_free_entries.push_back(it->second);
+            it = m_entry_indices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    u64 committed = 0;
+    std::vector<u32> wanted;
+    for (const auto &[texture, index] : m_entry_indices) {
+        const Entry &entry = m_entries[index];
+        committed += GetResidentSize(entry, entry.target_level);
+        if (entry.requested_level < entry.target_level && entry.resident_level == entry.target_level) {
+            wanted.push_back(index);
+        }
+    }
+    // the largest gap between what is resident and what is sampled first
+    std::sort(wanted.begin(), wanted.end(), [&](u32 a, u32 b) {
+        const Entry &entry_a = m_entries[a], &entry_b = m_entries[b];
+        return entry_a.target_level - entry_a.requested_level > entry_b.target_level - entry_b.requested_level;
+    });
+
+    u32 upload_count = 0;
+    u64 upload_size = 0;
+    auto can_upload = [&]() {
+        return upload_count < MAX_UPLOADS_PER_FRAME && upload_size < MAX_UPLOAD_SIZE_PER_FRAME;
+    };
+    auto evict = [&]() {
+        u32 drop_level = 0;
+        i32 victim = FindEvictionCandidate(drop_level);
+        if (victim < 0) {
+            return false;
+        }
+        Entry &entry = m_entries[victim];
+        committed -= GetResidentSize(entry, entry.target_level) - GetResidentSize(entry, drop_level);
+        upload_count++;
+        upload_size += GetResidentSize(entry, drop_level);
+        BeginUpload(static_cast<u32>(victim), drop_level);
+        return true;
+    };
+
+    // over budget without anything new, e.g. after the budget shrank
+    while (committed > m_budget && can_upload() && evict()) {
+    }
+
+    for (u32 index : wanted) {
+        if (!can_upload()) {
+            break;
+        }
+        Entry &entry = m_entries[index];
+        // make room from the least recently used textures, or settle for a coarser level
+        u32 level = entry.requested_level;
+        while (level < entry.target_level &&
+               committed + GetResidentSize(entry, level) - GetResidentSize(entry, entry.target_level) > m_budget) {
+            if (!can_upload() || !evict()) {
+                level++;
+            }
+        }
+        if (level < entry.target_level && can_upload()) {
+            committed += GetResidentSize(entry, level) - GetResidentSize(entry, entry.target_level);
+            upload_count++;
+            upload_size += GetResidentSize(entry, level);
+            BeginUpload(index, level);
+        }
+    }
+
+    for (const auto &[texture, index] : m_entry_indices) {
+        m_entries[index].requested_level = m_entries[index].level_count;
+    }
+    m_frame++;
+}
+
+void TextureStreamer::SetBudget(u64 budget) noexcept { m_budget = budget; }
+
+TextureStreamingStats TextureStreamer::GetStats() const noexcept {
+    TextureStreamingStats stats;
+    stats.textures = static_cast<u32>(m_entry_indices.size());
+    stats.pending_uploads = static_cast<u32>(m_uploads.size());
+    for (const auto &[texture, index] : m_entry_indices) {
+        stats.resident_size += GetResidentSize(m_entries[index], m_entries[index].target_level);
+    }
+    stats.budget = m_budget;
+    return stats;
+}
+
+u64 TextureStreamer::GetResidentSize(const Entry &entry, u32 level) const noexcept {
+    return ImageFormat::GetChainSize(entry.format, Mipmap::GetLevelExtent(entry.width, level),
+                                     Mipmap::GetLevelExtent(entry.height, level), entry.level_count - level);
+}
+
+void TextureStreamer::BeginUpload(u32 entry_index, u32 level) noexcept {
+    Entry &entry = m_entries[entry_index];
+    Upload upload;
+    upload.entry = entry_index;
+
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.commandPool = m_command_pool;
+    alloc_info.commandBufferCount = 1;
+    CHECK_VK_RESULT(vkAllocateCommandBuffers(m_device->Get(), &alloc_info, &upload.command_buffer));
+
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(upload.command_buffer, &begin_info);
+    upload.texture = std::make_shared<Texture>(
+        m_device, m_command_buffer, entry.format,
+        entry.levels.data() + ImageFormat::GetChainSize(entry.format, entry.width, entry.height, level),
+        Mipmap::GetLevelExtent(entry.width, level), Mipmap::GetLevelExtent(entry.height, level),
+        entry.level_count - level, upload.command_buffer);
+    vkEndCommandBuffer(upload.command_buffer);
+
+    VkFenceCreateInfo fence_info{};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    CHECK_VK_RESULT(vkCreateFence(m_device->Get(), &fence_info, nullptr, &upload.fence));
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &upload.command_buffer;
+    CHECK_VK_RESULT(vkQueueSubmit(m_device->getGraphicQueue(), 1, &submit_info, upload.fence));
+
+    entry.target_level = level;
+    m_uploads.push_back(std::move(upload));
+}
+
+void TextureStreamer::FinishUploads() noexcept {
+    for (auto it = m_uploads.begin(); it != m_uploads.end();) {
+        if (vkGetFenceStatus(m_device->Get(), it->fence) != VK_SUCCESS) {
+            ++it;
+            continue;
+        }
+        Entry &entry = m_entries[it->entry];
+        if (std::shared_ptr<Texture> texture = entry.texture.lock()) {
+            texture->swapImage(*it->texture);
+        }
+        entry.resident_level = entry.target_level;
+        // the upload texture now holds the old image and releases it together with the staging buffer
+        vkDestroyFence(m_device->Get(), it->fence, nullptr);
+        vkFreeCommandBuffers(m_device->Get(), m_command_pool, 1, &it->command_buffer);
+        it = m_uploads.erase(it);
+    }
+}
+
+i32 TextureStreamer::FindEvictionCandidate(u32 &drop_level) const noexcept {
+    i32 candidate = -1;
+    for (const auto &[texture, index] : m_entry_indices) {
+        const Entry &entry = m_entries[index];
+        if (entry.resident_level != entry.target_level) {
+            continue;
+        }
+        // textures drawn this frame keep what they sample
+        u32 level = entry.last_used_frame == m_frame ? entry.requested_level : entry.tail_level;
+        if (level <= entry.target_level) {
+            continue;
+        }
+        if (candidate < 0 || entry.last_used_frame < m_entries[candidate].last_used_frame) {
+            candidate = static_cast<i32>(index);
+            drop_level = level;
+        }
+    }
+    return candidate;
+}
+
+} // namespace Horizon
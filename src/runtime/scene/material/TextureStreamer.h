@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <runtime/function/rhi/vulkan/CommandBuffer.h>
+#include <runtime/function/rhi/vulkan/Device.h>
+#include <runtime/function/rhi/vulkan/Texture.h>
+
+namespace Horizon {
+
+struct TextureStreamingStats {
+    u32 textures = 0;
+    u32 pending_uploads = 0;
+    // estimated from the resident levels, images being replaced count with their new levels
+    u64 resident_size = 0;
+    u64 budget = 0;
+};
+
+// keeps the full mip chain of every streamed texture in system memory and only the levels the view needs on the gpu.
+// a texture starts out with its coarse tail, finer levels are requested per frame from the screen space texel density
+// of the primitives using it. a change of residency rebuilds the image in a command buffer of its own, the texture
+// swaps to the new image once its fence is signaled. the uploads share the graphics queue that the frame loop waits
+// idle on, so they complete within the frame that issued them: they are bounded per frame rather than asynchronous,
+// the fence only matters once frames overlap. least recently used textures drop back to what is still requested, or
+// to their tail, when the budget runs out
+class TextureStreamer {
+  public:
+    // levels whose larger side is at most this many texels are loaded up front and never evicted
+    static constexpr u32 TAIL_EXTENT = 64;
+    // bounds the upload work, and with it the time, streaming adds to one frame
+    static constexpr u32 MAX_UPLOADS_PER_FRAME = 4;
+    static constexpr u64 MAX_UPLOAD_SIZE_PER_FRAME = 32ull * 1024 * 1024;
+
+    TextureStreamer(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
+                    u64 budget) noexcept;
+    ~TextureStreamer() noexcept;
+
+    // levels of a format from ImageFormat back to back largest first, they are copied. formats the device cannot
+    // sample are expanded to rgba8 first. textures with nothing above their tail are created fully resident and not
+    // streamed
+    std::shared_ptr<Texture> Load(VkFormat format, const u8 *levels, u32 width, u32 height, u32 mip_count) noexcept;
+
+    // uv_per_pixel is the uv distance between neighbouring pixels of a draw sampling the texture, the finest level a
+    // frame asks for wins. unknown textures are ignored
+    void Request(const Texture *texture, f32 uv_per_pixel) noexcept;
+
+    // finishes completed uploads, evicts and starts new ones from the requests since the last call. textures swap
+    // their images here, so it has to run while the gpu is idle and before descriptors are written
+    void Update() noexcept;
+
+    void SetBudget(u64 budget) noexcept;
+    TextureStreamingStats GetStats() const noexcept;
+
+  private:
+    struct Entry {
+        std::weak_ptr<Texture> texture;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        u32 width = 0;
+        u32 height = 0;
+        u32 level_count = 0;
+        std::vector<u8> levels;
+        // finest level on the gpu, and the one an upload in flight switches to
+        u32 resident_level = 0;
+        u32 target_level = 0;
+        u32 tail_level = 0;
+        // level_count while nothing asked for the texture this frame
+        u32 requested_level = 0;
+        u64 last_used_frame = 0;
+    };
+
+    struct Upload {
+        u32 entry = 0;
+        std::shared_ptr<Texture> texture = nullptr;
+        VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+    };
+
+    // device memory of levels [level, level_count)
+    u64 GetResidentSize(const Entry &entry, u32 level) const noexcept;
+    void BeginUpload(u32 entry_index, u32 level) noexcept;
+    void FinishUploads() noexcept;
+    // least recently used texture holding more than it needs, -1 if none
+    i32 FindEvictionCandidate(u32 &drop_level) const noexcept;
+
+  private:
+    std::shared_ptr<Device> m_device = nullptr;
+    std::shared_ptr<CommandBuffer> m_command_buffer = nullptr;
+    VkCommandPool m_command_pool = VK_NULL_HANDLE;
+    u64 m_budget = 0;
+    u64 m_frame = 1;
+
+    std::vector<Entry> m_entries;
+    std::unordered_map<const Texture *, u32> m_entry_indices;
+    // slots of m_entries whose texture expired, Load reuses them once no upload refers to them
+    std::vector<u32> m_free_entries;
+    std::vector<Upload> m_uploads;
+};
+
+} // namespace Horizon
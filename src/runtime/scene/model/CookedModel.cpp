@@ -0,0 +1,265 @@
+#include "CookedModel.h"
+#include "Model.h"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include <json.hpp>
+
+#include <runtime/core/hash/Hash.h>
+#include <runtime/core/image/ImageFormat.h>
+#include <runtime/core/image/Mipmap.h>
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+static u64 AlignSection(u64 offset) noexcept {
+    return (offset + Cooked::SECTION_ALIGNMENT - 1) & ~(Cooked::SECTION_ALIGNMENT - 1);
+}
+
+// gltf uris are percent encoded
+static std::string DecodeUri(const std::string &uri) noexcept {
+    std::string ret;
+    for (size_t i = 0; i < uri.size(); i++) {
+        if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(uri[i + 1]) && std::isxdigit(uri[i + 2])) {
+            ret.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+            i += 2;
+        } else {
+            ret.push_back(uri[i]);
+        }
+    }
+    return ret;
+}
+
+u64 Cooked::HashSource(const std::string &path) noexcept {
+    MappedFile file(path);
+    if (!file.IsValid()) {
+        return 0;
+    }
+    const u8 *data = file.GetData();
+    u64 size = file.GetSize();
+    u64 hash = Hash::Hash64(data, size);
+
+    // the json is the whole file or the first chunk of a glb
+    const u8 *json_begin = data;
+    const u8 *json_end = data + size;
+    if (size >= 20 && std::memcmp(data, "glTF", 4) == 0) {
+        u32 json_size;
+        std::memcpy(&json_size, data + 12, sizeof(u32));
+        json_begin = data + 20;
+        json_end = json_begin + std::min<u64>(json_size, size - 20);
+    }
+    nlohmann::json json = nlohmann::json::parse(json_begin, json_end, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        return hash;
+    }
+
+    // a missing file is hashed by name only, so it shows up as a change once it appears
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+    for (const char *key : {"buffers", "images"}) {
+        if (!json.contains(key) || !json[key].is_array()) {
+            continue;
+        }
+        for (const nlohmann::json &entry : json[key]) {
+            if (!entry.contains("uri") || !entry["uri"].is_string()) {
+                continue;
+            }
+            std::string uri = entry["uri"].get<std::string>();
+            if (uri.compare(0, 5, "data:") == 0) {
+                continue;
+            }
+            hash = Hash::Hash64(uri, hash);
+            std::string external_path = directory + DecodeUri(uri);
+            std::error_code error;
+            if (!std::filesystem::is_regular_file(external_path, error)) {
+                continue;
+            }
+            MappedFile external(external_path);
+            if (external.IsValid()) {
+                hash = Hash::Hash64(external.GetData(), external.GetSize(), hash);
+            }
+        }
+    }
+    return hash;
+}
+
+void CookedModelWriter::SetSection(Cooked::Section section, const void *data, u64 size) noexcept {
+    m_data[section] = data;
+    m_sizes[section] = size;
+}
+
+bool CookedModelWriter::Write(const std::string &path, Cooked::Header header) const noexcept {
+    u64 offset = AlignSection(sizeof(Cooked::Header));
+    for (u32 s = 0; s < Cooked::SECTION_COUNT; s++) {
+        header.sections[s] = {offset, m_sizes[s]};
+        offset = AlignSection(offset + m_sizes[s]);
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("failed to open {}", temp_path);
+            return false;
+        }
+        const char padding[Cooked::SECTION_ALIGNMENT] = {};
+        auto pad = [&]() {
+            u64 position = static_cast<u64>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(AlignSection(position) - position));
+        };
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Cooked::Header));
+        pad();
+        for (u32 s = 0; s < Cooked::SECTION_COUNT; s++) {
+            if (m_sizes[s] > 0) {
+                file.write(static_cast<const char *>(m_data[s]), static_cast<std::streamsize>(m_sizes[s]));
+            }
+            pad();
+        }
+        if (!file) {
+            LOG_ERROR("failed to write {}", temp_path);
+            file.close();
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        LOG_ERROR("failed to move {} to {}: {}", temp_path, path, error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+CookedModelReader::CookedModelReader(const std::string &path) noexcept : m_path(path), m_file(path) {}
+
+bool CookedModelReader::Load(u64 source_hash, u32 vertex_stride) noexcept {
+    if (!m_file.IsValid() || m_file.GetSize() < sizeof(Cooked::Header)) {
+        return false;
+    }
+    std::memcpy(&m_header, m_file.GetData(), sizeof(Cooked::Header));
+    if (m_header.magic != Cooked::MAGIC || m_header.version != Cooked::VERSION) {
+        LOG_WARN("{}: not a cooked model of version {}", m_path, Cooked::VERSION);
+        return false;
+    }
+    if (m_header.source_hash != source_hash || m_header.vertex_stride != vertex_stride) {
+        LOG_WARN("{}: cooked from different sources", m_path);
+        return false;
+    }
+
+    const u64 record_sizes[Cooked::SECTION_COUNT] = {vertex_stride,
+                                                     sizeof(u32),
+                                                     sizeof(Cooked::Primitive),
+                                                     sizeof(PrimitiveLod),
+                                                     sizeof(MeshOptimizer::Meshlet),
+                                                     sizeof(Cooked::Mesh),
+                                                     sizeof(u32),
+                                                     sizeof(Cooked::Transform),
+                                                     sizeof(Cooked::Node),
+                                                     sizeof(Cooked::Material),
+                                                     sizeof(Cooked::Texture),
+                                                     sizeof(Cooked::Image),
+                                                     1};
+    for (u32 s = 0; s < Cooked::SECTION_COUNT; s++) {
+        const Cooked::SectionRange &range = m_header.sections[s];
+        if (range.offset % Cooked::SECTION_ALIGNMENT != 0 || range.offset > m_file.GetSize() ||
+            range.size > m_file.GetSize() - range.offset || range.size % record_sizes[s] != 0 ||
+            range.size / record_sizes[s] > std::numeric_limits<u32>::max()) {
+            LOG_WARN("{}: section {} is out of bounds", m_path, s);
+            return false;
+        }
+    }
+    if (!Validate()) {
+        LOG_WARN("{}: broken cross references", m_path);
+        return false;
+    }
+    return true;
+}
+
+bool CookedModelReader::Validate() const noexcept {
+    u64 vertex_count = GetSectionSize(Cooked::SECTION_VERTICES) / m_header.vertex_stride;
+    u64 index_count = GetSectionSize(Cooked::SECTION_INDICES) / sizeof(u32);
+    auto in_range = [](u64 first, u64 count, u64 size) { return first <= size && count <= size - first; };
+    auto optional_index = [](i32 index, u32 size) {
+        return index == Cooked::INVALID_INDEX || (index >= 0 && static_cast<u32>(index) < size);
+    };
+
+    auto primitives = GetTable<Cooked::Primitive>(Cooked::SECTION_PRIMITIVES);
+    auto lods = GetTable<PrimitiveLod>(Cooked::SECTION_LODS);
+    auto meshlets = GetTable<MeshOptimizer::Meshlet>(Cooked::SECTION_MESHLETS);
+    auto meshes = GetTable<Cooked::Mesh>(Cooked::SECTION_MESHES);
+    auto instances = GetTable<u32>(Cooked::SECTION_INSTANCES);
+    auto transforms = GetTable<Cooked::Transform>(Cooked::SECTION_TRANSFORMS);
+    auto nodes = GetTable<Cooked::Node>(Cooked::SECTION_NODES);
+    auto materials = GetTable<Cooked::Material>(Cooked::SECTION_MATERIALS);
+    auto textures = GetTable<Cooked::Texture>(Cooked::SECTION_TEXTURES);
+    auto images = GetTable<Cooked::Image>(Cooked::SECTION_IMAGES);
+    u64 pixel_size = GetSectionSize(Cooked::SECTION_PIXELS);
+
+    bool valid = true;
+    for (const Cooked::Primitive &primitive : primitives) {
+        valid &= in_range(primitive.first_index, primitive.index_count, index_count);
+        valid &= in_range(primitive.first_vertex, primitive.vertex_count, vertex_count);
+        valid &= primitive.material < materials.count;
+        valid &= in_range(primitive.first_lod, primitive.lod_count, lods.count);
+        valid &= in_range(primitive.first_meshlet, primitive.meshlet_count, meshlets.count);
+    }
+    for (const PrimitiveLod &lod : lods) {
+        valid &= in_range(lod.firstIndex, lod.indexCount, index_count);
+    }
+    for (const MeshOptimizer::Meshlet &meshlet : meshlets) {
+        valid &= in_range(meshlet.first_index, meshlet.index_count, index_count);
+    }
+    for (const Cooked::Mesh &mesh : meshes) {
+        valid &= in_range(mesh.first_primitive, mesh.primitive_count, primitives.count);
+        valid &= in_range(mesh.first_instance, mesh.instance_count, instances.count);
+    }
+    for (u32 instance : instances) {
+        valid &= instance < transforms.count;
+    }
+    for (u32 t = 0; t < transforms.count; t++) {
+        valid &= optional_index(transforms[t].parent, t);
+    }
+    for (u32 n = 0; n < nodes.count; n++) {
+        valid &= nodes[n].parent == Cooked::INVALID_INDEX || (nodes[n].parent > static_cast<i32>(n) &&
+                                                              static_cast<u32>(nodes[n].parent) < nodes.count);
+        valid &= nodes[n].transform < transforms.count;
+        valid &= optional_index(nodes[n].mesh, meshes.count);
+    }
+    for (const Cooked::Material &material : materials) {
+        valid &= optional_index(material.base_color_texture, textures.count);
+        valid &= optional_index(material.normal_texture, textures.count);
+        valid &= optional_index(material.metallic_roughness_texture, textures.count);
+    }
+    for (const Cooked::Texture &texture : textures) {
+        valid &= optional_index(texture.image, images.count);
+    }
+    for (const Cooked::Image &image : images) {
+        valid &= in_range(image.pixel_offset, image.pixel_size, pixel_size);
+        if (image.width == 0 || image.height == 0) {
+            continue;
+        }
+        VkFormat format = static_cast<VkFormat>(image.format);
+        valid &= ImageFormat::GetBlockSize(format) != 0 && image.mip_count >= 1 &&
+                 image.mip_count <= Mipmap::GetLevelCount(image.width, image.height) &&
+                 image.pixel_size >= ImageFormat::GetChainSize(format, image.width, image.height, image.mip_count);
+    }
+    return valid;
+}
+
+const Cooked::Header &CookedModelReader::GetHeader() const noexcept { return m_header; }
+
+const u8 *CookedModelReader::GetSectionData(Cooked::Section section) const noexcept {
+    return m_file.GetData() + m_header.sections[section].offset;
+}
+
+u64 CookedModelReader::GetSectionSize(Cooked::Section section) const noexcept {
+    return m_header.sections[section].size;
+}
+
+} // namespace Horizon
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <runtime/core/io/MappedFile.h>
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// runtime model format written by the cooker: a header followed by flat tables of fixed size records. every section
+// starts 16 byte aligned, so a mapped file is used in place. vertex and index blobs are already in gpu layout and go
+// straight into staging buffers, the tables are walked without any parsing. records are stored in native byte order,
+// cooked files are a per machine cache and not an interchange format
+namespace Cooked {
+
+static constexpr u32 MAGIC = 0x444d5a48; // "HZMD"
+// bump whenever a record layout or the mesh processing behind the cooked data changes
+static constexpr u32 VERSION = 5;
+static constexpr u64 SECTION_ALIGNMENT = 16;
+
+enum Section : u32 {
+    // gpu vertices, Vertex or CompressedVertex depending on the vertex format
+    SECTION_VERTICES = 0,
+    // u32 indices of every lod
+    SECTION_INDICES,
+    SECTION_PRIMITIVES,
+    // PrimitiveLod records
+    SECTION_LODS,
+    // MeshOptimizer::Meshlet records
+    SECTION_MESHLETS,
+    SECTION_MESHES,
+    // transform of every mesh instance, indexes SECTION_TRANSFORMS
+    SECTION_INSTANCES,
+    SECTION_TRANSFORMS,
+    SECTION_NODES,
+    SECTION_MATERIALS,
+    SECTION_TEXTURES,
+    SECTION_IMAGES,
+    // texel data of every image, mip levels follow each other largest first
+    SECTION_PIXELS,
+    SECTION_COUNT
+};
+
+struct SectionRange {
+    u64 offset = 0;
+    u64 size = 0;
+};
+
+struct Header {
+    u32 magic = MAGIC;
+    u32 version = VERSION;
+    // source files and load options the model was cooked from
+    u64 source_hash = 0;
+    u32 vertex_format = 0;
+    u32 vertex_stride = 0;
+    SectionRange sections[SECTION_COUNT];
+};
+
+struct Primitive {
+    u32 first_index;
+    u32 index_count;
+    u32 first_vertex;
+    u32 vertex_count;
+    u32 material;
+    u32 first_lod;
+    u32 lod_count;
+    u32 first_meshlet;
+    u32 meshlet_count;
+    Math::vec3 bounds_min;
+    Math::vec3 bounds_max;
+    f32 uv_density;
+};
+
+struct Mesh {
+    u32 first_primitive;
+    u32 primitive_count;
+    u32 first_instance;
+    u32 instance_count;
+};
+
+// parent precedes its children, INVALID_INDEX hangs the transform off the model root
+struct Transform {
+    i32 parent;
+    Math::vec3 translation;
+    Math::quat rotation;
+    Math::vec3 scale;
+    Math::mat4 matrix;
+};
+
+// stored children first like the loader links them, parent follows the node or is INVALID_INDEX for a root
+struct Node {
+    i32 parent;
+    // gltf node index
+    u32 index;
+    u32 transform;
+    i32 mesh;
+};
+
+// texture indices, INVALID_INDEX falls back to the empty texture
+struct Material {
+    i32 base_color_texture;
+    i32 normal_texture;
+    i32 metallic_roughness_texture;
+};
+
+// sampler state as gltf enums, -1 where the gltf sampler leaves a filter undefined
+struct Texture {
+    i32 image;
+    i32 mag_filter;
+    i32 min_filter;
+    i32 wrap_s;
+    i32 wrap_t;
+};
+
+// pixel_offset is relative to SECTION_PIXELS, an image without pixels failed to decode at cook time. format is a
+// VkFormat from ImageFormat, mip_count levels down from the full size
+struct Image {
+    u32 width;
+    u32 height;
+    u32 mip_count;
+    u32 format;
+    u64 pixel_offset;
+    u64 pixel_size;
+};
+
+static constexpr i32 INVALID_INDEX = -1;
+
+// read only view of one section
+template <typename T> struct Table {
+    const T *data = nullptr;
+    u32 count = 0;
+
+    const T &operator[](u32 index) const noexcept { return data[index]; }
+    const T *begin() const noexcept { return data; }
+    const T *end() const noexcept { return data + count; }
+};
+
+// hash of a gltf or glb file and every external buffer and image it references, 0 if the file cannot be read
+u64 HashSource(const std::string &path) noexcept;
+
+} // namespace Cooked
+
+// collects the sections of one model and writes them out in a single pass, the data must stay alive until Write
+class CookedModelWriter {
+  public:
+    void SetSection(Cooked::Section section, const void *data, u64 size) noexcept;
+
+    template <typename T> void SetSection(Cooked::Section section, const std::vector<T> &records) noexcept {
+        SetSection(section, records.data(), sizeof(T) * records.size());
+    }
+
+    // written next to the target and renamed, an interrupted cook never leaves a truncated file behind
+    bool Write(const std::string &path, Cooked::Header header) const noexcept;
+
+  private:
+    const void *m_data[Cooked::SECTION_COUNT] = {};
+    u64 m_sizes[Cooked::SECTION_COUNT] = {};
+};
+
+class CookedModelReader {
+  public:
+    CookedModelReader(const std::string &path) noexcept;
+    ~CookedModelReader() noexcept = default;
+
+    // false if the file is missing, cooked from other sources or malformed. every cross reference between the tables
+    // is checked here so the loader can index them blindly
+    bool Load(u64 source_hash, u32 vertex_stride) noexcept;
+
+    const Cooked::Header &GetHeader() const noexcept;
+    const u8 *GetSectionData(Cooked::Section section) const noexcept;
+    u64 GetSectionSize(Cooked::Section section) const noexcept;
+
+    template <typename T> Cooked::Table<T> GetTable(Cooked::Section section) const noexcept {
+        return {reinterpret_cast<const T *>(GetSectionData(section)),
+                static_cast<u32>(GetSectionSize(section) / sizeof(T))};
+    }
+
+  private:
+    bool Validate() const noexcept;
+
+  private:
+    std::string m_path;
+    MappedFile m_file;
+    Cooked::Header m_header;
+};
+
+} // namespace Horizon
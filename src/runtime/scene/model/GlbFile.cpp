@@ -0,0 +1,161 @@
+#include "GlbFile.h"
+
+#include <cstring>
+
+#include <json.hpp>
+
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+// https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#binary-gltf-layout
+static constexpr u32 GLB_MAGIC = 0x46546C67;
+static constexpr u32 GLB_VERSION = 2;
+static constexpr u32 GLB_CHUNK_JSON = 0x4E4F534A;
+static constexpr u32 GLB_CHUNK_BIN = 0x004E4942;
+static constexpr u32 GLB_HEADER_SIZE = 12;
+static constexpr u32 GLB_CHUNK_HEADER_SIZE = 8;
+// tinygltf copies byteLength bytes of the embedded buffer, it is handed this many instead of the real chunk
+static constexpr u32 PLACEHOLDER_BIN_SIZE = 4;
+
+GlbFile::GlbFile(const std::string &path) noexcept : m_path(path), m_file(path) {}
+
+bool GlbFile::Load(tinygltf::TinyGLTF &context, tinygltf::Model &model, std::string &error, std::string &warning,
+                   ImageDecoder *decoder) noexcept {
+    if (!m_file.IsValid()) {
+        error = "failed to map " + m_path;
+        return false;
+    }
+
+    const u8 *data = m_file.GetData();
+    u64 size = m_file.GetSize();
+    auto read_u32 = [&](u64 offset) {
+        u32 value;
+        std::memcpy(&value, data + offset, sizeof(u32));
+        return value;
+    };
+    if (size < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE || read_u32(0) != GLB_MAGIC || read_u32(4) != GLB_VERSION) {
+        error = m_path + " is not a glb 2.0 file";
+        return false;
+    }
+    u64 json_size = read_u32(GLB_HEADER_SIZE);
+    u64 json_offset = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+    if (read_u32(GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON || json_offset + json_size > size) {
+        error = m_path + ": invalid json chunk";
+        return false;
+    }
+    // the BIN chunk is optional
+    u64 bin_header = json_offset + ((json_size + 3) & ~3ull);
+    if (bin_header + GLB_CHUNK_HEADER_SIZE <= size && read_u32(bin_header + 4) == GLB_CHUNK_BIN) {
+        m_bin = data + bin_header + GLB_CHUNK_HEADER_SIZE;
+        m_bin_size = std::min<u64>(read_u32(bin_header), size - bin_header - GLB_CHUNK_HEADER_SIZE);
+    }
+
+    nlohmann::json json = nlohmann::json::parse(data + json_offset, data + json_offset + json_size, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        error = m_path + ": failed to parse json chunk";
+        return false;
+    }
+
+    // shrink the embedded buffer to a placeholder and point its images at a placeholder view, the real bytes are
+    // resolved through the mapping
+    if (m_bin && json.contains("buffers")) {
+        nlohmann::json &buffers = json["buffers"];
+        for (u32 b = 0; b < buffers.size(); b++) {
+            if (!buffers[b].contains("uri")) {
+                m_bin_buffer = static_cast<i32>(b);
+                buffers[b]["byteLength"] = PLACEHOLDER_BIN_SIZE;
+                break;
+            }
+        }
+    }
+    if (m_bin_buffer >= 0 && json.contains("images") && json.contains("bufferViews")) {
+        nlohmann::json &views = json["bufferViews"];
+        nlohmann::json &images = json["images"];
+        u32 placeholder_view = static_cast<u32>(views.size());
+        bool has_embedded_images = false;
+        m_images.resize(images.size());
+        for (u32 i = 0; i < images.size(); i++) {
+            if (!images[i].contains("bufferView")) {
+                continue;
+            }
+            u32 view_index = images[i]["bufferView"].get<u32>();
+            if (view_index >= views.size() || views[view_index].value("buffer", -1) != m_bin_buffer) {
+                continue;
+            }
+            const nlohmann::json &view = views[view_index];
+            m_images[i].offset = view.value("byteOffset", 0ull);
+            m_images[i].size = view.value("byteLength", 0ull);
+            images[i]["bufferView"] = placeholder_view;
+            has_embedded_images = true;
+        }
+        if (has_embedded_images) {
+            views.push_back({{"buffer", m_bin_buffer}, {"byteLength", PLACEHOLDER_BIN_SIZE}});
+        }
+    }
+
+    // rebuild a minimal glb around the patched json
+    std::string patched = json.dump();
+    patched.resize((patched.size() + 3) & ~size_t(3), ' ');
+    u32 bin_chunk_size = m_bin_buffer >= 0 ? GLB_CHUNK_HEADER_SIZE + PLACEHOLDER_BIN_SIZE : 0;
+    u32 header[5] = {GLB_MAGIC, GLB_VERSION,
+                     static_cast<u32>(GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + patched.size() + bin_chunk_size),
+                     static_cast<u32>(patched.size()), GLB_CHUNK_JSON};
+    std::vector<u8> glb(header[2], 0);
+    std::memcpy(glb.data(), header, sizeof(header));
+    std::memcpy(glb.data() + sizeof(header), patched.data(), patched.size());
+    if (bin_chunk_size > 0) {
+        u32 bin_chunk[2] = {PLACEHOLDER_BIN_SIZE, GLB_CHUNK_BIN};
+        std::memcpy(glb.data() + sizeof(header) + patched.size(), bin_chunk, sizeof(bin_chunk));
+    }
+
+    std::string base_dir = m_path.substr(0, m_path.find_last_of("/\\") + 1);
+    m_image_decoder = decoder;
+    context.SetImageLoader(&GlbFile::LoadImage, this);
+    bool loaded = context.LoadBinaryFromMemory(&model, &error, &warning, glb.data(), static_cast<u32>(glb.size()),
+                                               base_dir);
+    context.RemoveImageLoader();
+    return loaded;
+}
+
+std::vector<const u8 *> GlbFile::GetBufferData(const tinygltf::Model &model) const noexcept {
+    std::vector<const u8 *> buffers(model.buffers.size());
+    for (u32 b = 0; b < model.buffers.size(); b++) {
+        buffers[b] = static_cast<i32>(b) == m_bin_buffer ? m_bin : model.buffers[b].data.data();
+    }
+    return buffers;
+}
+
+void GlbFile::Release() noexcept {
+    m_file.Release();
+    m_bin = nullptr;
+    m_bin_size = 0;
+}
+
+bool GlbFile::LoadImage(tinygltf::Image *image, const int image_index, std::string *error, std::string *warning,
+                        int required_width, int required_height, const unsigned char *bytes, int size,
+                        void *user_data) {
+    const GlbFile *glb = static_cast<const GlbFile *>(user_data);
+    bool mapped = false;
+    if (image_index >= 0 && static_cast<u32>(image_index) < glb->m_images.size() &&
+        glb->m_images[image_index].size > 0) {
+        const ByteRange &range = glb->m_images[image_index];
+        if (range.offset + range.size > glb->m_bin_size) {
+            *error += "image " + std::to_string(image_index) + " exceeds the BIN chunk\n";
+            return false;
+        }
+        bytes = glb->m_bin + range.offset;
+        size = static_cast<int>(range.size);
+        mapped = true;
+    }
+    // embedded images are decoded straight from the mapping, other bytes only live for this call
+    if (glb->m_image_decoder) {
+        glb->m_image_decoder->Enqueue(image_index, bytes, static_cast<u64>(size), !mapped);
+        return true;
+    }
+    // null options expand every image to rgba like the default loader
+    return tinygltf::LoadImageData(image, image_index, error, warning, required_width, required_height, bytes, size,
+                                   nullptr);
+}
+
+} // namespace Horizon
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <tiny_gltf.h>
+
+#include <runtime/core/io/MappedFile.h>
+#include <runtime/core/math/Math.h>
+#include <runtime/scene/model/ImageDecoder.h>
+
+namespace Horizon {
+
+// binary gltf container. the file is memory mapped and tinygltf only parses the json chunk, the embedded buffer is
+// never copied: accessors read from the mapped BIN chunk and embedded images are decoded straight from it
+class GlbFile {
+  public:
+    GlbFile(const std::string &path) noexcept;
+    ~GlbFile() noexcept = default;
+
+    // images are queued on decoder if given, it must be drained before Release
+    bool Load(tinygltf::TinyGLTF &context, tinygltf::Model &model, std::string &error, std::string &warning,
+              ImageDecoder *decoder = nullptr) noexcept;
+
+    // base address of every gltf buffer, valid until Release
+    std::vector<const u8 *> GetBufferData(const tinygltf::Model &model) const noexcept;
+
+    // drop the mapping once the data is uploaded
+    void Release() noexcept;
+
+  private:
+    static bool LoadImage(tinygltf::Image *image, const int image_index, std::string *error, std::string *warning,
+                          int required_width, int required_height, const unsigned char *bytes, int size,
+                          void *user_data);
+
+  private:
+    std::string m_path;
+    MappedFile m_file;
+    const u8 *m_bin = nullptr;
+    u64 m_bin_size = 0;
+    // gltf buffer backed by the BIN chunk, the one without an uri
+    i32 m_bin_buffer = -1;
+
+    struct ByteRange {
+        u64 offset = 0;
+        u64 size = 0;
+    };
+    // images embedded in the BIN chunk, indexed by gltf image
+    std::vector<ByteRange> m_images;
+    ImageDecoder *m_image_decoder = nullptr;
+};
+
+} // namespace Horizon
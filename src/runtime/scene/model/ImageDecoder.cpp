@@ -0,0 +1,133 @@
+#include "ImageDecoder.h"
+
+#include <runtime/core/image/Ktx2.h>
+#include <runtime/core/log/Log.h>
+#include <runtime/core/thread/ThreadPool.h>
+
+namespace Horizon {
+
+ImageDecoder::ImageDecoder(bool parallel) noexcept : m_parallel(parallel) {}
+
+ImageDecoder::~ImageDecoder() noexcept {
+    for (auto &job : m_jobs) {
+        if (job) {
+            Wait(*job);
+        }
+    }
+}
+
+void ImageDecoder::Install(tinygltf::TinyGLTF &context) noexcept {
+    context.SetImageLoader(&ImageDecoder::LoadImage, this);
+}
+
+void ImageDecoder::Enqueue(i32 image_index, const u8 *bytes, u64 size, bool copy) noexcept {
+    if (image_index < 0) {
+        return;
+    }
+    if (static_cast<u32>(image_index) >= m_jobs.size()) {
+        m_jobs.resize(image_index + 1);
+    }
+    auto job = std::make_shared<Job>();
+    job->image_index = image_index;
+    job->bytes = bytes;
+    job->size = size;
+    if (copy) {
+        job->encoded.assign(bytes, bytes + size);
+        job->bytes = job->encoded.data();
+    }
+    m_jobs[image_index] = job;
+
+    if (m_parallel) {
+        ThreadPool::GetInstance().Submit([this, job]() { Decode(*job); });
+    } else {
+        Decode(*job);
+    }
+}
+
+bool ImageDecoder::Collect(u32 image_index, tinygltf::Model &model) noexcept {
+    if (image_index >= m_jobs.size() || !m_jobs[image_index] || image_index >= model.images.size()) {
+        return false;
+    }
+    Job &job = *m_jobs[image_index];
+    Wait(job);
+    if (job.collected) {
+        return job.decoded;
+    }
+    job.collected = true;
+    if (!job.warning.empty()) {
+        LOG_WARN("image {}: {}", image_index, job.warning);
+    }
+    if (!job.decoded) {
+        LOG_ERROR("image {}: failed to decode {}", image_index, job.error);
+        return false;
+    }
+
+    tinygltf::Image &image = model.images[image_index];
+    image.width = job.image.width;
+    image.height = job.image.height;
+    image.component = job.image.component;
+    image.bits = job.image.bits;
+    image.pixel_type = job.image.pixel_type;
+    image.image = std::move(job.image.image);
+    return true;
+}
+
+void ImageDecoder::CollectAll(tinygltf::Model &model) noexcept {
+    for (u32 i = 0; i < m_jobs.size(); i++) {
+        Collect(i, model);
+    }
+}
+
+bool ImageDecoder::LoadImage(tinygltf::Image *image, const int image_index, std::string *error, std::string *warning,
+                             int required_width, int required_height, const unsigned char *bytes, int size,
+                             void *user_data) {
+    // tinygltf owns bytes only for the duration of the call
+    static_cast<ImageDecoder *>(user_data)->Enqueue(image_index, bytes, static_cast<u64>(size), true);
+    return true;
+}
+
+void ImageDecoder::Decode(Job &job) noexcept {
+    bool decoded;
+    if (Ktx2::IsKtx2(job.bytes, job.size)) {
+        // ktx2 containers stay encoded for the texture upload, component 0 keeps them off the rgba8 paths
+        Ktx2::Image ktx2;
+        decoded = Ktx2::Parse(job.bytes, job.size, ktx2, job.error);
+        if (decoded) {
+            job.image.width = static_cast<int>(ktx2.width);
+            job.image.height = static_cast<int>(ktx2.height);
+            job.image.component = 0;
+            job.image.bits = 0;
+            if (job.encoded.empty()) {
+                job.image.image.assign(job.bytes, job.bytes + job.size);
+            } else {
+                job.image.image = std::move(job.encoded);
+            }
+        }
+    } else {
+        // null options expand every image to rgba like the default loader
+        decoded = tinygltf::LoadImageData(&job.image, job.image_index, &job.error, &job.warning, 0, 0, job.bytes,
+                                          static_cast<int>(job.size), nullptr);
+    }
+    std::vector<u8>().swap(job.encoded);
+    // notified under the lock, once Wait sees done the owner may destroy the decoder and with it m_condition
+    std::lock_guard<std::mutex> lock(m_mutex);
+    job.decoded = decoded;
+    job.done = true;
+    m_condition.notify_all();
+}
+
+void ImageDecoder::Wait(Job &job) noexcept {
+    auto done = [&]() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return job.done;
+    };
+    // help with queued decodes instead of idling, the job may already run on a worker
+    while (!done()) {
+        if (!ThreadPool::GetInstance().RunPendingTask()) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&]() { return job.done; });
+        }
+    }
+}
+
+} // namespace Horizon
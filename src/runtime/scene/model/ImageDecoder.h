@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <tiny_gltf.h>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// decodes gltf images on the thread pool. as tinygltf's image loader it only queues the encoded bytes, so decoding
+// overlaps with the rest of the parse, and the model collects every image right before uploading it. ktx2 containers
+// are only validated and handed over encoded
+class ImageDecoder {
+  public:
+    // a serial decoder runs every image inline in Enqueue, like tinygltf's default loader
+    ImageDecoder(bool parallel = true) noexcept;
+    // waits for queued images, their bytes may point into a mapping the owner is about to release
+    ~ImageDecoder() noexcept;
+    ImageDecoder(const ImageDecoder &) = delete;
+    ImageDecoder(ImageDecoder &&) = delete;
+    ImageDecoder &operator=(const ImageDecoder &) = delete;
+    ImageDecoder &operator=(ImageDecoder &&) = delete;
+
+    // route the context's image callback through this decoder
+    void Install(tinygltf::TinyGLTF &context) noexcept;
+
+    // bytes must stay valid until the image is collected unless copy is set
+    void Enqueue(i32 image_index, const u8 *bytes, u64 size, bool copy) noexcept;
+
+    // wait for one image and move its pixels into model.images[image_index], the calling thread runs queued tasks
+    // meanwhile. false if the image was never queued or failed to decode
+    bool Collect(u32 image_index, tinygltf::Model &model) noexcept;
+    void CollectAll(tinygltf::Model &model) noexcept;
+
+    static bool LoadImage(tinygltf::Image *image, const int image_index, std::string *error, std::string *warning,
+                          int required_width, int required_height, const unsigned char *bytes, int size,
+                          void *user_data);
+
+  private:
+    struct Job {
+        i32 image_index = 0;
+        std::vector<u8> encoded;
+        const u8 *bytes = nullptr;
+        u64 size = 0;
+        tinygltf::Image image;
+        std::string error;
+        std::string warning;
+        bool decoded = false;
+        bool done = false;
+        bool collected = false;
+    };
+
+    void Decode(Job &job) noexcept;
+    void Wait(Job &job) noexcept;
+
+  private:
+    bool m_parallel = true;
+    // indexed by gltf image, null for images that were not queued
+    std::vector<std::shared_ptr<Job>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+} // namespace Horizon
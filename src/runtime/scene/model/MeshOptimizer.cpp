@@ -0,0 +1,635 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace Horizon::MeshOptimizer {
+
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+static constexpr u32 FORSYTH_CACHE_SIZE = 32;
+static constexpr f32 FORSYTH_CACHE_DECAY_POWER = 1.5f;
+static constexpr f32 FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+static constexpr f32 FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+static constexpr f32 FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+// cache size used to find cluster boundaries for overdraw optimization
+static constexpr u32 OVERDRAW_CACHE_SIZE = 16;
+
+static constexpr u32 INVALID_VERTEX = std::numeric_limits<u32>::max();
+
+// a cone is only worth testing if every triangle normal is within ~84 degrees of its axis
+static constexpr f32 MESHLET_CONE_MIN_DOT = 0.1f;
+
+// symmetric 4x4 error quadric, a is the upper 3x3, b the offset and c the constant. weight is the summed triangle
+// area so the error is an area weighted mean of squared plane distances
+struct Quadric {
+    f64 a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    f64 b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    f64 c = 0.0;
+    f64 weight = 0.0;
+
+    static Quadric FromPlane(const Math::vec3 &n, f32 d, f32 w) noexcept {
+        Quadric q;
+        q.a00 = w * n.x * n.x, q.a01 = w * n.x * n.y, q.a02 = w * n.x * n.z;
+        q.a11 = w * n.y * n.y, q.a12 = w * n.y * n.z, q.a22 = w * n.z * n.z;
+        q.b0 = w * n.x * d, q.b1 = w * n.y * d, q.b2 = w * n.z * d;
+        q.c = w * d * d;
+        q.weight = w;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &o) noexcept {
+        a00 += o.a00, a01 += o.a01, a02 += o.a02, a11 += o.a11, a12 += o.a12, a22 += o.a22;
+        b0 += o.b0, b1 += o.b1, b2 += o.b2;
+        c += o.c;
+        weight += o.weight;
+        return *this;
+    }
+
+    f64 Evaluate(const Math::vec3 &p) const noexcept {
+        f64 x = p.x, y = p.y, z = p.z;
+        f64 e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+    }
+};
+
+void VertexCacheStats::Accumulate(const VertexCacheStats &other) noexcept {
+    triangles += other.triangles;
+    vertices += other.vertices;
+    misses += other.misses;
+    acmr = triangles > 0 ? static_cast<f32>(misses) / static_cast<f32>(triangles) : 0.0f;
+    atvr = vertices > 0 ? static_cast<f32>(misses) / static_cast<f32>(vertices) : 0.0f;
+}
+
+VertexCacheStats AnalyzeVertexCache(const u32 *indices, u32 index_count, u32 vertex_count, u32 cache_size) noexcept {
+    VertexCacheStats stats;
+    stats.triangles = index_count / 3;
+
+    // a vertex is in the fifo if fewer than cache_size misses happened since it was loaded
+    std::vector<u32> timestamps(vertex_count, 0);
+    std::vector<u8> referenced(vertex_count, 0);
+    u32 time = cache_size + 1;
+    for (u32 i = 0; i < stats.triangles * 3; i++) {
+        u32 v = indices[i];
+        if (time - timestamps[v] > cache_size) {
+            timestamps[v] = time++;
+            stats.misses++;
+        }
+        if (!referenced[v]) {
+            referenced[v] = 1;
+            stats.vertices++;
+        }
+    }
+    stats.acmr = stats.triangles > 0 ? static_cast<f32>(stats.misses) / static_cast<f32>(stats.triangles) : 0.0f;
+    stats.atvr = stats.vertices > 0 ? static_cast<f32>(stats.misses) / static_cast<f32>(stats.vertices) : 0.0f;
+    return stats;
+}
+
+static f32 VertexScore(i32 cache_position, u32 remaining_valence) noexcept {
+    // no triangle left to emit
+    if (remaining_valence == 0) {
+        return -1.0f;
+    }
+
+    f32 score = 0.0f;
+    if (cache_position >= 0) {
+        // the vertices of the last triangle get a fixed score so the next one does not simply reuse an edge
+        if (cache_position < 3) {
+            score = FORSYTH_LAST_TRIANGLE_SCORE;
+        } else {
+            f32 scaler = 1.0f / static_cast<f32>(FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<f32>(cache_position - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+        }
+    }
+    // boost vertices with few triangles left so they do not linger as isolated triangles
+    score += FORSYTH_VALENCE_BOOST_SCALE *
+             std::pow(static_cast<f32>(remaining_valence), -FORSYTH_VALENCE_BOOST_POWER);
+    return score;
+}
+
+void OptimizeVertexCache(u32 *indices, u32 index_count, u32 vertex_count) noexcept {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // vertex to triangle adjacency, emitted triangles are swapped out of each list
+    std::vector<u32> remaining(vertex_count, 0);
+    for (u32 i = 0; i < triangle_count * 3; i++) {
+        remaining[indices[i]]++;
+    }
+    std::vector<u32> offsets(vertex_count + 1, 0);
+    for (u32 v = 0; v < vertex_count; v++) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<u32> adjacency(triangle_count * 3);
+    {
+        std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+        for (u32 i = 0; i < triangle_count * 3; i++) {
+            adjacency[fill[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<i32> cache_position(vertex_count, -1);
+    std::vector<f32> vertex_score(vertex_count);
+    for (u32 v = 0; v < vertex_count; v++) {
+        vertex_score[v] = VertexScore(-1, remaining[v]);
+    }
+    auto triangle_score = [&](u32 t) {
+        return vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+    };
+
+    std::vector<u8> emitted(triangle_count, 0);
+    std::vector<u32> output;
+    output.reserve(triangle_count * 3);
+
+    // one extra triangle worth of slots for vertices that are pushed out by the emitted triangle
+    std::array<u32, FORSYTH_CACHE_SIZE + 3> cache{};
+    std::array<u32, FORSYTH_CACHE_SIZE + 3> new_cache{};
+    u32 cache_count = 0;
+
+    i32 best = 0;
+    f32 best_score = triangle_score(0);
+    for (u32 t = 1; t < triangle_count; t++) {
+        f32 score = triangle_score(t);
+        if (score > best_score) {
+            best = static_cast<i32>(t);
+            best_score = score;
+        }
+    }
+    u32 cursor = 0;
+
+    while (best >= 0) {
+        const u32 *triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+
+        for (u32 k = 0; k < 3; k++) {
+            u32 v = triangle[k];
+            u32 *list = &adjacency[offsets[v]];
+            u32 *end = list + remaining[v];
+            u32 *found = std::find(list, end, static_cast<u32>(best));
+            if (found != end) {
+                std::swap(*found, *(end - 1));
+                remaining[v]--;
+            }
+        }
+
+        // the emitted triangle moves to the front of the lru cache
+        u32 new_count = 0;
+        for (u32 k = 0; k < 3; k++) {
+            if (std::find(new_cache.begin(), new_cache.begin() + new_count, triangle[k]) ==
+                new_cache.begin() + new_count) {
+                new_cache[new_count++] = triangle[k];
+            }
+        }
+        for (u32 c = 0; c < cache_count; c++) {
+            u32 v = cache[c];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                new_cache[new_count++] = v;
+            }
+        }
+
+        // vertices past the cache size were just evicted, their score still has to drop
+        for (u32 c = 0; c < new_count; c++) {
+            u32 v = new_cache[c];
+            cache_position[v] = c < FORSYTH_CACHE_SIZE ? static_cast<i32>(c) : -1;
+            vertex_score[v] = VertexScore(cache_position[v], remaining[v]);
+        }
+
+        // only triangles touching the cache changed their score
+        best = -1;
+        best_score = -1.0f;
+        for (u32 c = 0; c < new_count; c++) {
+            u32 v = new_cache[c];
+            for (u32 a = 0; a < remaining[v]; a++) {
+                u32 t = adjacency[offsets[v] + a];
+                f32 score = triangle_score(t);
+                if (score > best_score) {
+                    best = static_cast<i32>(t);
+                    best_score = score;
+                }
+            }
+        }
+
+        cache_count = std::min(new_count, FORSYTH_CACHE_SIZE);
+        std::copy(new_cache.begin(), new_cache.begin() + cache_count, cache.begin());
+
+        // nothing adjacent to the cache, continue with the next triangle in input order
+        if (best < 0) {
+            while (cursor < triangle_count && emitted[cursor]) {
+                cursor++;
+            }
+            if (cursor < triangle_count) {
+                best = static_cast<i32>(cursor);
+            }
+        }
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(u32 *indices, u32 index_count, const Vertex *vertices, u32 vertex_count,
+                      f32 threshold) noexcept {
+    u32 triangle_count = index_count / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // a triangle missing the cache with all three vertices starts a new cluster, moving whole clusters around
+    // barely changes the cache behaviour inside them
+    std::vector<u32> cluster_starts;
+    {
+        std::vector<u32> timestamps(vertex_count, 0);
+        u32 time = OVERDRAW_CACHE_SIZE + 1;
+        for (u32 t = 0; t < triangle_count; t++) {
+            u32 misses = 0;
+            for (u32 k = 0; k < 3; k++) {
+                u32 v = indices[t * 3 + k];
+                if (time - timestamps[v] > OVERDRAW_CACHE_SIZE) {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+            if (t == 0 || misses == 3) {
+                cluster_starts.push_back(t);
+            }
+        }
+    }
+    u32 cluster_count = static_cast<u32>(cluster_starts.size());
+    if (cluster_count < 2) {
+        return;
+    }
+    cluster_starts.push_back(triangle_count);
+
+    // area weighted centroid and normal of every cluster
+    std::vector<Math::vec3> cluster_centroids(cluster_count, Math::vec3(0.0f));
+    std::vector<Math::vec3> cluster_normals(cluster_count, Math::vec3(0.0f));
+    std::vector<f32> cluster_areas(cluster_count, 0.0f);
+    Math::vec3 mesh_centroid = Math::vec3(0.0f);
+    f32 mesh_area = 0.0f;
+    for (u32 c = 0; c < cluster_count; c++) {
+        for (u32 t = cluster_starts[c]; t < cluster_starts[c + 1]; t++) {
+            const Math::vec3 &p0 = vertices[indices[t * 3]].pos;
+            const Math::vec3 &p1 = vertices[indices[t * 3 + 1]].pos;
+            const Math::vec3 &p2 = vertices[indices[t * 3 + 2]].pos;
+            Math::vec3 normal = Math::cross(p1 - p0, p2 - p0);
+            f32 area = Math::length(normal);
+            cluster_centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+            cluster_normals[c] += normal;
+            cluster_areas[c] += area;
+        }
+        mesh_centroid += cluster_centroids[c];
+        mesh_area += cluster_areas[c];
+    }
+    if (mesh_area <= 0.0f) {
+        return;
+    }
+    mesh_centroid /= mesh_area;
+
+    // clusters facing away from the mesh centre are likely to occlude the rest, draw them first
+    std::vector<f32> cluster_keys(cluster_count, 0.0f);
+    for (u32 c = 0; c < cluster_count; c++) {
+        f32 normal_length = Math::length(cluster_normals[c]);
+        if (cluster_areas[c] > 0.0f && normal_length > 0.0f) {
+            Math::vec3 centroid = cluster_centroids[c] / cluster_areas[c];
+            cluster_keys[c] = Math::dot(centroid - mesh_centroid, cluster_normals[c] / normal_length);
+        }
+    }
+    std::vector<u32> cluster_order(cluster_count);
+    std::iota(cluster_order.begin(), cluster_order.end(), 0);
+    std::stable_sort(cluster_order.begin(), cluster_order.end(),
+                     [&](u32 a, u32 b) { return cluster_keys[a] > cluster_keys[b]; });
+
+    std::vector<u32> output;
+    output.reserve(triangle_count * 3);
+    for (u32 c : cluster_order) {
+        output.insert(output.end(), indices + cluster_starts[c] * 3, indices + cluster_starts[c + 1] * 3);
+    }
+
+    f32 acmr_before = AnalyzeVertexCache(indices, triangle_count * 3, vertex_count).acmr;
+    f32 acmr_after = AnalyzeVertexCache(output.data(), triangle_count * 3, vertex_count).acmr;
+    if (acmr_after > acmr_before * threshold) {
+        return;
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeVertexFetch(u32 *indices, u32 index_count, Vertex *vertices, u32 vertex_count) noexcept {
+    std::vector<u32> remap(vertex_count, INVALID_VERTEX);
+    u32 next = 0;
+    for (u32 i = 0; i < index_count; i++) {
+        u32 &v = indices[i];
+        if (remap[v] == INVALID_VERTEX) {
+            remap[v] = next++;
+        }
+        v = remap[v];
+    }
+    for (u32 v = 0; v < vertex_count; v++) {
+        if (remap[v] == INVALID_VERTEX) {
+            remap[v] = next++;
+        }
+    }
+
+    std::vector<Vertex> source(vertices, vertices + vertex_count);
+    for (u32 v = 0; v < vertex_count; v++) {
+        vertices[remap[v]] = source[v];
+    }
+}
+
+f32 Simplify(std::vector<u32> &destination, const u32 *indices, u32 index_count, const Vertex *vertices,
+             u32 vertex_count, u32 target_index_count) noexcept {
+    u32 triangle_count = index_count / 3;
+    u32 target_triangle_count = target_index_count / 3;
+    destination.assign(indices, indices + triangle_count * 3);
+    if (triangle_count <= target_triangle_count) {
+        return 0.0f;
+    }
+
+    // vertices sharing a position carry different attributes (uv or normal seams), moving one would tear the mesh.
+    // vertices on open or non manifold edges are locked as well so borders stay in place.
+    std::vector<u8> locked(vertex_count, 0);
+    {
+        std::vector<u32> sorted(vertex_count);
+        std::iota(sorted.begin(), sorted.end(), 0);
+        auto position_less = [&](u32 a, u32 b) {
+            const Math::vec3 &pa = vertices[a].pos;
+            const Math::vec3 &pb = vertices[b].pos;
+            return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+        };
+        std::sort(sorted.begin(), sorted.end(), position_less);
+        for (u32 i = 1; i < vertex_count; i++) {
+            if (vertices[sorted[i - 1]].pos == vertices[sorted[i]].pos) {
+                locked[sorted[i - 1]] = locked[sorted[i]] = 1;
+            }
+        }
+
+        std::vector<u64> edges;
+        edges.reserve(triangle_count * 3);
+        for (u32 t = 0; t < triangle_count; t++) {
+            for (u32 k = 0; k < 3; k++) {
+                u32 a = indices[t * 3 + k];
+                u32 b = indices[t * 3 + (k + 1) % 3];
+                edges.push_back((static_cast<u64>(std::min(a, b)) << 32) | std::max(a, b));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t run = i;
+            while (run < edges.size() && edges[run] == edges[i]) {
+                run++;
+            }
+            if (run - i != 2) {
+                locked[edges[i] >> 32] = locked[edges[i] & 0xffffffff] = 1;
+            }
+            i = run;
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    for (u32 t = 0; t < triangle_count; t++) {
+        const Math::vec3 &p0 = vertices[indices[t * 3]].pos;
+        Math::vec3 normal = Math::cross(vertices[indices[t * 3 + 1]].pos - p0, vertices[indices[t * 3 + 2]].pos - p0);
+        f32 area = Math::length(normal);
+        if (area <= 0.0f) {
+            continue;
+        }
+        normal /= area;
+        Quadric q = Quadric::FromPlane(normal, -Math::dot(normal, p0), area);
+        for (u32 k = 0; k < 3; k++) {
+            quadrics[indices[t * 3 + k]] += q;
+        }
+    }
+
+    struct Collapse {
+        u32 from;
+        u32 to;
+        f64 error;
+    };
+    std::vector<Collapse> collapses;
+    std::vector<u32> best_target(vertex_count);
+    std::vector<f64> best_error(vertex_count);
+    std::vector<u32> offsets(vertex_count + 1);
+    std::vector<u32> adjacency;
+    std::vector<u8> touched(vertex_count);
+    std::vector<u32> collapse_target(vertex_count);
+    f64 max_error = 0.0;
+
+    // every pass collapses the cheapest independent edges, then rebuilds adjacency from the shrunk index list
+    while (triangle_count > target_triangle_count) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (u32 i = 0; i < triangle_count * 3; i++) {
+            offsets[destination[i] + 1]++;
+        }
+        for (u32 v = 0; v < vertex_count; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(triangle_count * 3);
+        {
+            std::vector<u32> fill(offsets.begin(), offsets.end() - 1);
+            for (u32 i = 0; i < triangle_count * 3; i++) {
+                adjacency[fill[destination[i]]++] = i / 3;
+            }
+        }
+
+        std::fill(best_target.begin(), best_target.end(), INVALID_VERTEX);
+        for (u32 t = 0; t < triangle_count; t++) {
+            for (u32 k = 0; k < 6; k++) {
+                u32 from = destination[t * 3 + k % 3];
+                u32 to = destination[t * 3 + (k % 3 + (k < 3 ? 1 : 2)) % 3];
+                if (locked[from] || from == to) {
+                    continue;
+                }
+                Quadric q = quadrics[from];
+                q += quadrics[to];
+                f64 error = q.Evaluate(vertices[to].pos);
+                if (best_target[from] == INVALID_VERTEX || error < best_error[from]) {
+                    best_target[from] = to;
+                    best_error[from] = error;
+                }
+            }
+        }
+        collapses.clear();
+        for (u32 v = 0; v < vertex_count; v++) {
+            if (best_target[v] != INVALID_VERTEX) {
+                collapses.push_back({v, best_target[v], best_error[v]});
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &a, const Collapse &b) { return a.error < b.error; });
+
+        std::fill(touched.begin(), touched.end(), 0);
+        std::fill(collapse_target.begin(), collapse_target.end(), INVALID_VERTEX);
+        u32 collapsed = 0;
+        u32 remaining_triangles = triangle_count;
+        for (const Collapse &collapse : collapses) {
+            if (remaining_triangles <= target_triangle_count) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // reject collapses that flip a triangle around the moved vertex
+            bool flips = false;
+            u32 removed = 0;
+            for (u32 a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; a++) {
+                const u32 *triangle = &destination[adjacency[a] * 3];
+                if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                    removed++;
+                    continue;
+                }
+                Math::vec3 p[3], q[3];
+                for (u32 k = 0; k < 3; k++) {
+                    p[k] = vertices[triangle[k]].pos;
+                    q[k] = triangle[k] == collapse.from ? vertices[collapse.to].pos : p[k];
+                }
+                Math::vec3 n0 = Math::cross(p[1] - p[0], p[2] - p[0]);
+                Math::vec3 n1 = Math::cross(q[1] - q[0], q[2] - q[0]);
+                // also reject normals turning by more than ~75 degrees, several of those in a row add up to a flip
+                flips = Math::dot(n0, n1) <= 0.25f * Math::length(n0) * Math::length(n1);
+            }
+            if (flips) {
+                continue;
+            }
+
+            // the neighbourhood is frozen for the rest of the pass so later collapses see valid adjacency
+            for (u32 a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++) {
+                const u32 *triangle = &destination[adjacency[a] * 3];
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+            quadrics[collapse.to] += quadrics[collapse.from];
+            collapse_target[collapse.from] = collapse.to;
+            max_error = std::max(max_error, collapse.error);
+            remaining_triangles -= std::min(removed, remaining_triangles);
+            collapsed++;
+        }
+        if (collapsed == 0) {
+            break;
+        }
+
+        // rewrite the moved vertices and drop triangles that became degenerate
+        u32 write = 0;
+        for (u32 t = 0; t < triangle_count; t++) {
+            u32 triangle[3];
+            for (u32 k = 0; k < 3; k++) {
+                u32 v = destination[t * 3 + k];
+                triangle[k] = collapse_target[v] != INVALID_VERTEX ? collapse_target[v] : v;
+            }
+            if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2]) {
+                continue;
+            }
+            std::copy(triangle, triangle + 3, &destination[write * 3]);
+            write++;
+        }
+        triangle_count = write;
+        destination.resize(triangle_count * 3);
+    }
+
+    return static_cast<f32>(std::sqrt(max_error));
+}
+
+static void ComputeMeshletBounds(Meshlet &meshlet, const u32 *indices, const Vertex *vertices,
+                                 const std::vector<u32> &meshlet_vertices) noexcept {
+    Math::vec3 center(0.0f);
+    for (u32 v : meshlet_vertices) {
+        center += vertices[v].pos;
+    }
+    center /= static_cast<f32>(meshlet_vertices.size());
+    f32 radius = 0.0f;
+    for (u32 v : meshlet_vertices) {
+        radius = std::max(radius, Math::length(vertices[v].pos - center));
+    }
+    meshlet.center = center;
+    meshlet.radius = radius;
+
+    // cone around the average face normal, degenerate triangles never face the camera and are skipped
+    std::vector<std::pair<Math::vec3, Math::vec3>> planes;
+    Math::vec3 axis(0.0f);
+    for (u32 i = meshlet.first_index; i < meshlet.first_index + meshlet.index_count; i += 3) {
+        const Math::vec3 &p0 = vertices[indices[i]].pos;
+        Math::vec3 n = Math::cross(vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0);
+        f32 length = Math::length(n);
+        if (length > 0.0f) {
+            planes.emplace_back(p0, n / length);
+            axis += n / length;
+        }
+    }
+    f32 axis_length = Math::length(axis);
+    if (planes.empty() || axis_length == 0.0f) {
+        return;
+    }
+    axis /= axis_length;
+
+    f32 min_dot = 1.0f;
+    for (const auto &plane : planes) {
+        min_dot = std::min(min_dot, Math::dot(plane.second, axis));
+    }
+    if (min_dot <= MESHLET_CONE_MIN_DOT) {
+        return;
+    }
+
+    // move the apex back along the axis until it is behind the plane of every triangle
+    f32 max_t = 0.0f;
+    for (const auto &plane : planes) {
+        max_t = std::max(max_t, Math::dot(center - plane.first, plane.second) / Math::dot(axis, plane.second));
+    }
+    meshlet.cone_apex = center - axis * max_t;
+    meshlet.cone_axis = axis;
+    meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+}
+
+std::vector<Meshlet> BuildMeshlets(const u32 *indices, u32 index_count, const Vertex *vertices, u32 vertex_count,
+                                   u32 max_vertices, u32 max_triangles) noexcept {
+    std::vector<Meshlet> meshlets;
+    if (index_count < 3 || max_vertices < 3 || max_triangles == 0) {
+        return meshlets;
+    }
+
+    // owner[v] is the meshlet the vertex was last added to
+    std::vector<u32> owner(vertex_count, INVALID_VERTEX);
+    std::vector<u32> meshlet_vertices;
+    Meshlet meshlet;
+    auto flush = [&]() {
+        ComputeMeshletBounds(meshlet, indices, vertices, meshlet_vertices);
+        meshlets.push_back(meshlet);
+        meshlet = Meshlet{};
+        meshlet.first_index = meshlets.back().first_index + meshlets.back().index_count;
+        meshlet_vertices.clear();
+    };
+
+    u32 triangle_count = index_count / 3;
+    for (u32 t = 0; t < triangle_count; t++) {
+        const u32 *triangle = &indices[t * 3];
+        u32 meshlet_index = static_cast<u32>(meshlets.size());
+        u32 new_vertices = 0;
+        for (u32 k = 0; k < 3; k++) {
+            // a vertex repeated within the triangle is only new once
+            bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+            new_vertices += owner[triangle[k]] != meshlet_index && !repeated;
+        }
+        if (meshlet_vertices.size() + new_vertices > max_vertices || meshlet.index_count / 3 >= max_triangles) {
+            flush();
+            meshlet_index++;
+        }
+        for (u32 k = 0; k < 3; k++) {
+            if (owner[triangle[k]] != meshlet_index) {
+                owner[triangle[k]] = meshlet_index;
+                meshlet_vertices.push_back(triangle[k]);
+            }
+        }
+        meshlet.index_count += 3;
+    }
+    if (meshlet.index_count > 0) {
+        flush();
+    }
+    return meshlets;
+}
+
+} // namespace Horizon::MeshOptimizer
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+#include <runtime/function/rhi/vulkan/Vertex.h>
+
+// index and vertex reordering for triangle lists. every function works on one primitive, indices are relative to the
+// start of its vertex range.
+namespace Horizon::MeshOptimizer {
+
+struct VertexCacheStats {
+    u32 triangles = 0;
+    u32 vertices = 0;
+    u32 misses = 0;
+    // average cache miss ratio, transformed vertices per triangle. 0.5 is the optimum for regular grids, 3 the worst
+    f32 acmr = 0.0f;
+    // average transform to vertex ratio, 1 means every vertex is shaded exactly once
+    f32 atvr = 0.0f;
+
+    void Accumulate(const VertexCacheStats &other) noexcept;
+};
+
+// simulate a fifo post transform cache
+VertexCacheStats AnalyzeVertexCache(const u32 *indices, u32 index_count, u32 vertex_count,
+                                    u32 cache_size = 16) noexcept;
+
+// reorder triangles for post transform cache hits, forsyth's greedy scoring over an lru cache
+void OptimizeVertexCache(u32 *indices, u32 index_count, u32 vertex_count) noexcept;
+
+// reorder clusters of the cache optimized order so outward facing ones come first, the result is rejected if the
+// acmr grows by more than threshold
+void OptimizeOverdraw(u32 *indices, u32 index_count, const Vertex *vertices, u32 vertex_count,
+                      f32 threshold = 1.05f) noexcept;
+
+// renumber vertices in order of first use, unreferenced vertices move to the end
+void OptimizeVertexFetch(u32 *indices, u32 index_count, Vertex *vertices, u32 vertex_count) noexcept;
+
+// quadric error edge collapse towards target_index_count. the result indexes the input vertices, vertices on attribute
+// seams or open borders are never moved. returns the object space distance to the input surface, an estimate from the
+// accumulated quadrics.
+f32 Simplify(std::vector<u32> &destination, const u32 *indices, u32 index_count, const Vertex *vertices,
+             u32 vertex_count, u32 target_index_count) noexcept;
+
+// a cluster of consecutive triangles, small enough to be culled as a unit
+struct Meshlet {
+    u32 first_index = 0;
+    u32 index_count = 0;
+    // bounding sphere
+    Math::vec3 center{0.0f};
+    f32 radius = 0.0f;
+    // every triangle faces away from a camera with dot(normalize(cone_apex - camera), cone_axis) >= cone_cutoff,
+    // a cutoff of 1 disables the test
+    Math::vec3 cone_apex{0.0f};
+    Math::vec3 cone_axis{0.0f};
+    f32 cone_cutoff = 1.0f;
+};
+
+// split the triangle list into meshlets of consecutive triangles, run it after OptimizeVertexCache so the clusters are
+// spatially coherent. indices are not reordered, first_index is relative to the start of the list
+std::vector<Meshlet> BuildMeshlets(const u32 *indices, u32 index_count, const Vertex *vertices, u32 vertex_count,
+                                   u32 max_vertices = 64, u32 max_triangles = 124) noexcept;
+
+} // namespace Horizon::MeshOptimizer
@@ -1,114 +1,812 @@
 #include "Model.h"
+#include "CookedModel.h"
+#include "GlbFile.h"
+#include "ImageDecoder.h"
+#include "MeshOptimizer.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <runtime/core/hash/Hash.h>
+#include <runtime/core/image/ImageFormat.h>
+#include <runtime/core/image/Ktx2.h>
+#include <runtime/core/image/Mipmap.h>
 #include <runtime/core/log/Log.h>
 #include <runtime/core/path/Path.h>
+#include <runtime/core/thread/ThreadPool.h>
 #include <runtime/function/rhi/vulkan/VulkanBuffer.h>
 
 namespace Horizon {
+
+// a lod is used while its projected error stays below this many pixels
+static constexpr f32 LOD_PIXEL_ERROR = 1.0f;
+// switching to a coarser lod needs extra margin so lods do not flicker around the threshold
+static constexpr f32 LOD_HYSTERESIS = 0.75f;
+
+static constexpr u32 MESHLET_MAX_VERTICES = 64;
+static constexpr u32 MESHLET_MAX_TRIANGLES = 124;
+// smaller primitives are drawn whole, splitting them only adds indirect draws
+static constexpr u32 MESHLET_MIN_TRIANGLES = 2 * MESHLET_MAX_TRIANGLES;
+
+// std430 layouts read by meshlet_cull.comp
+struct GpuMeshlet {
+    Math::vec4 sphere;
+    Math::vec4 cone_apex;
+    Math::vec4 cone_axis_cutoff;
+};
+
+struct GpuCullSlot {
+    u32 meshlet;
+    u32 instance;
+    u32 first_index;
+    u32 index_count;
+};
+
+// read one element of an accessor as floats, normalized integer components are mapped to [0, 1] / [-1, 1].
+// buffers holds the base address of every gltf buffer
+static Math::vec4 ReadAccessorElement(const tinygltf::Model &model, const std::vector<const u8 *> &buffers,
+                                      const tinygltf::Accessor &accessor, size_t index) noexcept {
+    const tinygltf::BufferView &view = model.bufferViews[accessor.bufferView];
+    const u8 *data = buffers[view.buffer] + accessor.byteOffset + view.byteOffset;
+    i32 stride = accessor.ByteStride(view);
+    i32 component_count = std::min(tinygltf::GetNumComponentsInType(accessor.type), 4);
+    const u8 *element = data + index * stride;
+
+    Math::vec4 ret(0.0f);
+    for (i32 c = 0; c < component_count; c++) {
+        switch (accessor.componentType) {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+            ret[c] = reinterpret_cast<const f32 *>(element)[c];
+            break;
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            f32 v = reinterpret_cast<const i8 *>(element)[c];
+            ret[c] = accessor.normalized ? std::max(v / 127.0f, -1.0f) : v;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
+            f32 v = element[c];
+            ret[c] = accessor.normalized ? v / 255.0f : v;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            f32 v = reinterpret_cast<const i16 *>(element)[c];
+            ret[c] = accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            f32 v = reinterpret_cast<const u16 *>(element)[c];
+            ret[c] = accessor.normalized ? v / 65535.0f : v;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            ret[c] = static_cast<f32>(reinterpret_cast<const u32 *>(element)[c]);
+            break;
+        default:
+            LOG_ERROR("unsupported accessor component type {}", accessor.componentType);
+            return ret;
+        }
+    }
+    return ret;
+}
+
+// texture indices of a gltf material, the cooked model stores the same table
+static Cooked::Material GetMaterialTextures(const tinygltf::Material &mat) noexcept {
+    auto texture_index = [](const tinygltf::ParameterMap &parameters, const char *name) {
+        auto parameter = parameters.find(name);
+        return parameter != parameters.end() ? parameter->second.TextureIndex() : Cooked::INVALID_INDEX;
+    };
+    Cooked::Material ret;
+    ret.base_color_texture = texture_index(mat.values, "baseColorTexture");
+    ret.normal_texture = texture_index(mat.additionalValues, "normalTexture");
+    ret.metallic_roughness_texture = texture_index(mat.values, "metallicRoughnessTexture");
+    return ret;
+}
+
+// 8 bit rgb or rgba image expanded to rgba8
+static std::vector<u8> GetRgba8(const tinygltf::Image &image) noexcept {
+    u64 texel_count = static_cast<u64>(image.width) * static_cast<u64>(image.height);
+    std::vector<u8> rgba(texel_count * 4, 255);
+    if (image.component == 4) {
+        std::memcpy(rgba.data(), image.image.data(), rgba.size());
+    } else {
+        for (u64 t = 0; t < texel_count; t++) {
+            std::memcpy(rgba.data() + t * 4, image.image.data() + t * 3, 3);
+        }
+    }
+    return rgba;
+}
+
+// square root of the uv area over the object space area of a triangle list, non indexed lists start at first_vertex
+static f32 GetUvDensity(const std::vector<Vertex> &vertices, const u32 *indices, u32 count,
+                        u32 first_vertex = 0) noexcept {
+    f64 uv_area = 0.0, area = 0.0;
+    for (u32 i = 0; i + 2 < count; i += 3) {
+        const Vertex &v0 = vertices[indices ? indices[i] : first_vertex + i];
+        const Vertex &v1 = vertices[indices ? indices[i + 1] : first_vertex + i + 1];
+        const Vertex &v2 = vertices[indices ? indices[i + 2] : first_vertex + i + 2];
+        area += Math::length(Math::cross(v1.pos - v0.pos, v2.pos - v0.pos));
+        Math::vec2 e1 = v1.uv0 - v0.uv0, e2 = v2.uv0 - v0.uv0;
+        uv_area += std::abs(e1.x * e2.y - e1.y * e2.x);
+    }
+    return area > 0.0 ? static_cast<f32>(std::sqrt(uv_area / area)) : 0.0f;
+}
+
+// the texture's sampler, or the default one with undefined filters and repeat wrapping
+static tinygltf::Sampler GetTextureSampler(const tinygltf::Model &model, const tinygltf::Texture &texture) noexcept {
+    if (texture.sampler >= 0 && texture.sampler < static_cast<i32>(model.samplers.size())) {
+        return model.samplers[texture.sampler];
+    }
+    return tinygltf::Sampler();
+}
+
+static VkSamplerAddressMode GetAddressMode(i32 wrap) noexcept {
+    switch (wrap) {
+    case TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE:
+        return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    case TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT:
+        return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+    default:
+        return VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    }
+}
+
+// gltf filters and wraps, undefined filters are trilinear. minification without mipmaps clamps to the top level
+static SamplerDesc GetSamplerDesc(i32 mag_filter, i32 min_filter, i32 wrap_s, i32 wrap_t) noexcept {
+    SamplerDesc desc;
+    desc.mag_filter = mag_filter == TINYGLTF_TEXTURE_FILTER_NEAREST ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+    switch (min_filter) {
+    case TINYGLTF_TEXTURE_FILTER_NEAREST:
+    case TINYGLTF_TEXTURE_FILTER_LINEAR:
+        desc.min_filter = min_filter == TINYGLTF_TEXTURE_FILTER_NEAREST ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+        desc.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        desc.max_lod = 0.25f;
+        break;
+    case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_NEAREST:
+        desc.min_filter = VK_FILTER_NEAREST;
+        desc.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        break;
+    case TINYGLTF_TEXTURE_FILTER_LINEAR_MIPMAP_NEAREST:
+        desc.min_filter = VK_FILTER_LINEAR;
+        desc.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        break;
+    case TINYGLTF_TEXTURE_FILTER_NEAREST_MIPMAP_LINEAR:
+        desc.min_filter = VK_FILTER_NEAREST;
+        desc.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        break;
+    default:
+        desc.min_filter = VK_FILTER_LINEAR;
+        desc.mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        break;
+    }
+    desc.address_mode_u = GetAddressMode(wrap_s);
+    desc.address_mode_v = GetAddressMode(wrap_t);
+    desc.address_mode_w = desc.address_mode_v;
+    return desc;
+}
+
+// ktx2 image of a KHR_texture_basisu texture, its plain source is the fallback. etc1s and uastc payloads are not
+// transcoded, Ktx2::Parse rejects them and such textures always load the fallback
+static i32 GetBasisuSource(const tinygltf::Texture &texture) noexcept {
+    auto extension = texture.extensions.find("KHR_texture_basisu");
+    if (extension == texture.extensions.end() || !extension->second.Has("source")) {
+        return Cooked::INVALID_INDEX;
+    }
+    return extension->second.Get("source").GetNumberAsInt();
+}
+
+// images sampled as base color hold srgb encoded color, everything else is linear data
+static std::vector<bool> GetColorImages(const tinygltf::Model &model) noexcept {
+    std::vector<bool> ret(model.images.size(), false);
+    for (const tinygltf::Material &material : model.materials) {
+        i32 texture = GetMaterialTextures(material).base_color_texture;
+        if (texture >= 0 && texture < static_cast<i32>(model.textures.size())) {
+            for (i32 image : {model.textures[texture].source, GetBasisuSource(model.textures[texture])}) {
+                if (image >= 0 && image < static_cast<i32>(ret.size())) {
+                    ret[image] = true;
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+// everything that changes the cooked data besides the source files
+static u64 HashLoadOptions(u64 hash, const ModelLoadOptions &options) noexcept {
+    hash = Hash::Combine(hash, Cooked::VERSION);
+    hash = Hash::Combine(hash, static_cast<u64>(options.vertex_format));
+    hash = Hash::Combine(hash, options.optimize_meshes);
+    hash = Hash::Hash64(options.lod_ratios.data(), sizeof(f32) * options.lod_ratios.size(), hash);
+    hash = Hash::Combine(hash, options.build_meshlets);
+    hash = Hash::Combine(hash, MESHLET_MAX_VERTICES);
+    hash = Hash::Combine(hash, MESHLET_MAX_TRIANGLES);
+    hash = Hash::Combine(hash, MESHLET_MIN_TRIANGLES);
+    hash = Hash::Combine(hash, options.compressed_textures);
+    return hash;
+}
+
 Model::Model(const std::string &path, std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
-             std::shared_ptr<DescriptorSet> m_scene_descriptor_set) noexcept
-    : m_device(device), m_command_buffer(command_buffer), m_scene_descriptor_set(m_scene_descriptor_set) {
+             std::shared_ptr<DescriptorSet> m_scene_descriptor_set, std::shared_ptr<TransformHierarchy> transforms,
+             std::shared_ptr<TextureStreamer> texture_streamer, const ModelLoadOptions &options) noexcept
+    : m_device(device), m_command_buffer(command_buffer),
+      m_texture_streamer(options.stream_textures ? texture_streamer : nullptr),
+      m_scene_descriptor_set(m_scene_descriptor_set), m_transforms(transforms), m_vertex_format(options.vertex_format) {
+
+    m_root_transform = m_transforms->AddNode(TransformHierarchy::INVALID_PARENT);
+
+    auto load_start = std::chrono::steady_clock::now();
+
+    // cooked models are cached by the hash of their sources and load options, a hit skips gltf parsing, image
+    // decoding and every mesh processing pass
+    u64 source_hash = Cooked::HashSource(path);
+    std::string cooked_path;
+    if (source_hash != 0) {
+        source_hash = HashLoadOptions(source_hash, options);
+        char name[32];
+        std::snprintf(name, sizeof(name), "-%016llx.model", static_cast<unsigned long long>(source_hash));
+        cooked_path = Path::GetCachePath(std::filesystem::path(path).stem().string() + name);
+    }
+
+    std::error_code error;
+    bool cooked = !cooked_path.empty() && std::filesystem::is_regular_file(cooked_path, error) &&
+                  LoadCooked(cooked_path, source_hash);
+    bool loaded = cooked || LoadSource(path, options, cooked_path, source_hash);
+    if (loaded) {
+        // lay out instances mesh by mesh so each mesh draws a contiguous range
+        u32 instance_count = 0;
+        for (auto &mesh : m_meshes) {
+            mesh->first_instance = instance_count;
+            instance_count += static_cast<u32>(mesh->instances.size());
+        }
+        m_instance_matrices.resize(instance_count, Math::mat4(1.0f));
+        CreateMeshletBuffers();
+        LOG_DEBUG("{}: {} unique meshes, {} instances", path, m_meshes.size(), instance_count);
+        LOG_DEBUG("{}: {} vertices, vertex buffer {} KB", path, m_vertex_buffer->getVerticesCount(),
+                  m_vertex_buffer->GetSize() / 1024);
+        LogTextureMemory(path);
+        LOG_INFO("{}: loaded {}in {} ms", path, cooked ? "from cache " : "",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - load_start)
+                     .count());
+    }
+
+    if (m_instance_matrices.empty()) {
+        m_instance_matrices.emplace_back(1.0f);
+    }
+    std::shared_ptr<DescriptorSetInfo> instanceSetInfo = std::make_shared<DescriptorSetInfo>();
+    instanceSetInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_VERTEX_SHADER);
+    m_instance_descriptor_set = std::make_shared<DescriptorSet>(m_device, instanceSetInfo);
+    m_instance_buffer = std::make_shared<StorageBuffer>(m_device);
+    m_instance_buffer->update(m_instance_matrices.data(), sizeof(Math::mat4) * m_instance_matrices.size());
+}
 
+Model::~Model() noexcept {}
+
+bool Model::LoadSource(const std::string &path, const ModelLoadOptions &options, const std::string &cooked_path,
+                       u64 source_hash) noexcept {
     tinygltf::TinyGLTF gltf_context;
     std::string error, warning;
 
     tinygltf::Model gltf_model;
 
-    bool file_loaded = gltf_context.LoadASCIIFromFile(&gltf_model, &error, &warning, path);
-    if (file_loaded) {
-        LoadTextures(gltf_model);
-        LoadMaterials(gltf_model);
-        const tinygltf::Scene &scene = gltf_model.scenes[gltf_model.defaultScene > -1 ? gltf_model.defaultScene : 0];
-        for (size_t i = 0; i < scene.nodes.size(); i++) {
-            const tinygltf::Node node = gltf_model.nodes[scene.nodes[i]];
-            f32 scale = 1.0;
-            LoadNode(nullptr, node, scene.nodes[i], gltf_model, m_indices, m_vertices, scale);
+    // glb buffers stay in the mapped file until the geometry is uploaded
+    bool is_binary = path.size() >= 4 && path.compare(path.size() - 4, 4, ".glb") == 0;
+    std::unique_ptr<GlbFile> glb_file = nullptr;
+    bool file_loaded = false;
+    // images decode on the thread pool while tinygltf keeps parsing, declared after the glb so pending decodes are
+    // drained before the mapping goes away
+    ImageDecoder image_decoder;
+    if (is_binary) {
+        glb_file = std::make_unique<GlbFile>(path);
+        file_loaded = glb_file->Load(gltf_context, gltf_model, error, warning, &image_decoder);
+        m_buffer_data = glb_file->GetBufferData(gltf_model);
+    } else {
+        image_decoder.Install(gltf_context);
+        file_loaded = gltf_context.LoadASCIIFromFile(&gltf_model, &error, &warning, path);
+        for (const tinygltf::Buffer &buffer : gltf_model.buffers) {
+            m_buffer_data.push_back(buffer.data.data());
         }
+    }
+    if (!file_loaded) {
+        LOG_ERROR("{} {}", error, warning);
+        return false;
+    }
 
-        m_vertex_buffer = std::make_shared<VertexBuffer>(m_device, m_command_buffer, m_vertices);
-        m_index_buffer = std::make_shared<IndexBuffer>(m_device, m_command_buffer, m_indices);
+    std::vector<i32> texture_images = LoadTextures(gltf_model, &image_decoder, options.compressed_textures);
+    // images no texture references, the cooker stores every image
+    image_decoder.CollectAll(gltf_model);
+    LoadMaterials(gltf_model);
+    const tinygltf::Scene &scene = gltf_model.scenes[gltf_model.defaultScene > -1 ? gltf_model.defaultScene : 0];
+    for (size_t i = 0; i < scene.nodes.size(); i++) {
+        const tinygltf::Node node = gltf_model.nodes[scene.nodes[i]];
+        f32 scale = 1.0;
+        LoadNode(nullptr, node, scene.nodes[i], gltf_model, m_indices, m_vertices, scale);
+    }
+
+    // every accessor is decoded, drop the source buffers before the optimizer passes allocate
+    m_buffer_data.clear();
+    if (glb_file) {
+        glb_file->Release();
+    }
+    for (tinygltf::Buffer &buffer : gltf_model.buffers) {
+        std::vector<unsigned char>().swap(buffer.data);
+    }
+
+    if (options.optimize_meshes) {
+        OptimizeMeshes(path);
+    }
+    GenerateLods(path, options.lod_ratios);
+    if (options.build_meshlets) {
+        BuildMeshlets(path);
+    }
+
+    std::vector<CompressedVertex> compressed_vertices;
+    if (m_vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED) {
+        compressed_vertices = CompressVertices();
+        m_vertex_buffer = std::make_shared<VertexBuffer>(m_device, m_command_buffer, compressed_vertices);
     } else {
-        LOG_ERROR("{} {}", error, warning);
+        m_vertex_buffer = std::make_shared<VertexBuffer>(m_device, m_command_buffer, m_vertices);
+    }
+    m_index_buffer = std::make_shared<IndexBuffer>(m_device, m_command_buffer, m_indices);
+
+    if (!cooked_path.empty()) {
+        if (m_vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED) {
+            WriteCooked(cooked_path, source_hash, gltf_model, texture_images, compressed_vertices.data());
+        } else {
+            WriteCooked(cooked_path, source_hash, gltf_model, texture_images, m_vertices.data());
+        }
     }
+    return true;
 }
 
-Model::~Model() noexcept {}
+// mirrors the source path: textures, materials, transforms, meshes and nodes are rebuilt from the tables in the order
+// they were cooked, the vertex and index blobs are uploaded straight from the mapping. node names are not cooked
+bool Model::LoadCooked(const std::string &cooked_path, u64 source_hash) noexcept {
+    CookedModelReader file(cooked_path);
+    if (!file.Load(source_hash, GetVertexStride())) {
+        return false;
+    }
+    auto images = file.GetTable<Cooked::Image>(Cooked::SECTION_IMAGES);
+    auto textures = file.GetTable<Cooked::Texture>(Cooked::SECTION_TEXTURES);
+    auto materials = file.GetTable<Cooked::Material>(Cooked::SECTION_MATERIALS);
+    auto transforms = file.GetTable<Cooked::Transform>(Cooked::SECTION_TRANSFORMS);
+    auto meshes = file.GetTable<Cooked::Mesh>(Cooked::SECTION_MESHES);
+    auto primitives = file.GetTable<Cooked::Primitive>(Cooked::SECTION_PRIMITIVES);
+    auto lods = file.GetTable<PrimitiveLod>(Cooked::SECTION_LODS);
+    auto meshlets = file.GetTable<MeshOptimizer::Meshlet>(Cooked::SECTION_MESHLETS);
+    auto instances = file.GetTable<u32>(Cooked::SECTION_INSTANCES);
+    auto nodes = file.GetTable<Cooked::Node>(Cooked::SECTION_NODES);
+
+    // textures sharing an image share its gpu copy, images that failed to decode fall back to the empty texture
+    const u8 *pixels = file.GetSectionData(Cooked::SECTION_PIXELS);
+    std::vector<std::shared_ptr<Texture>> image_textures(images.count, nullptr);
+    std::vector<f64> image_ms(images.count, 0.0);
+    for (u32 i = 0; i < images.count; i++) {
+        VkFormat format = static_cast<VkFormat>(images[i].format);
+        if (images[i].width > 0 && images[i].height > 0 && Texture::CanLoad(*m_device, format)) {
+            auto start = std::chrono::steady_clock::now();
+            image_textures[i] = CreateTexture(format, pixels + images[i].pixel_offset, images[i].width,
+                                              images[i].height, images[i].mip_count);
+            image_ms[i] = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    for (const Cooked::Texture &texture : textures) {
+        bool valid = texture.image != Cooked::INVALID_INDEX;
+        m_textures.push_back(valid ? image_textures[texture.image] : nullptr);
+        m_texture_load_ms.push_back(valid ? image_ms[texture.image] : 0.0);
+        m_texture_samplers.push_back(m_device->GetSamplerCache().Get(
+            GetSamplerDesc(texture.mag_filter, texture.min_filter, texture.wrap_s, texture.wrap_t)));
+    }
+    LoadEmptyTexture();
+    for (const Cooked::Material &material : materials) {
+        m_materials.push_back(CreateMaterial(material.base_color_texture, material.normal_texture,
+                                             material.metallic_roughness_texture));
+    }
 
-void Model::Draw(std::shared_ptr<Pipeline> pipeline, VkCommandBuffer command_buffer) noexcept {
-    const VkDeviceSize offsets[1] = {0};
-    VkBuffer vertexBuffer = m_vertex_buffer->Get();
+    u32 first_transform = m_transforms->GetNodeCount();
+    for (const Cooked::Transform &transform : transforms) {
+        i32 parent = transform.parent != Cooked::INVALID_INDEX ? static_cast<i32>(first_transform) + transform.parent
+                                                               : static_cast<i32>(m_root_transform);
+        m_transforms->AddNode(parent, transform.translation, transform.rotation, transform.scale, transform.matrix);
+    }
 
-    vkCmdBindVertexBuffers(command_buffer, 0, 1, &vertexBuffer, offsets);
-    vkCmdBindIndexBuffer(command_buffer, m_index_buffer->Get(), 0, VK_INDEX_TYPE_UINT32);
-    for (auto &node : m_nodes) {
-        DrawNode(node, pipeline, command_buffer);
-    }
-}
-
-void Model::LoadTextures(tinygltf::Model &gltfModel) noexcept {
-    //auto getVkFilterMode = [](int32_t filterMode)
-    //{
-    //	switch (filterMode) {
-    //	case 9728:
-    //		return VK_FILTER_NEAREST;
-    //	case 9729:
-    //		return VK_FILTER_LINEAR;
-    //	case 9984:
-    //		return VK_FILTER_NEAREST;
-    //	case 9985:
-    //		return VK_FILTER_NEAREST;
-    //	case 9986:
-    //		return VK_FILTER_LINEAR;
-    //	case 9987:
-    //		return VK_FILTER_LINEAR;
-    //	default:
-    //		return VK_FILTER_NEAREST;
-    //	}
-    //};
-
-    //auto getVkWrapMode = [](int32_t wrapMode)
-    //{
-    //	switch (wrapMode) {
-    //	case 10497:
-    //		return VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    //	case 33071:
-    //		return VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    //	case 33648:
-    //		return VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-    //	default:
-    //		return VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    //	}
-    //};
-
-    //std::vector<VkSamplerCreateInfo> samplers;
-
-    //for (tinygltf::Sampler smpl : gltfModel.samplers) {
-    //	VkSamplerCreateInfo sampler{};
-    //	sampler.minFilter = getVkFilterMode(smpl.minFilter);
-    //	sampler.magFilter = getVkFilterMode(smpl.magFilter);
-    //	sampler.addressModeU = getVkWrapMode(smpl.wrapS);
-    //	sampler.addressModeV = getVkWrapMode(smpl.wrapT);
-    //	sampler.addressModeW = sampler.addressModeV;
-    //	samplers.push_back(sampler);
-    //}
+    for (const Cooked::Mesh &cooked_mesh : meshes) {
+        std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(m_device);
+        for (u32 p = cooked_mesh.first_primitive; p < cooked_mesh.first_primitive + cooked_mesh.primitive_count; p++) {
+            const Cooked::Primitive &cooked_primitive = primitives[p];
+            auto primitive =
+                std::make_shared<MeshPrimitive>(cooked_primitive.first_index, cooked_primitive.index_count,
+                                                cooked_primitive.vertex_count, m_materials[cooked_primitive.material]);
+            primitive->firstVertex = cooked_primitive.first_vertex;
+            primitive->bounds_min = cooked_primitive.bounds_min;
+            primitive->bounds_max = cooked_primitive.bounds_max;
+            primitive->uv_density = cooked_primitive.uv_density;
+            primitive->lods.assign(lods.begin() + cooked_primitive.first_lod,
+                                   lods.begin() + cooked_primitive.first_lod + cooked_primitive.lod_count);
+            primitive->first_meshlet = cooked_primitive.first_meshlet;
+            primitive->meshlet_count = cooked_primitive.meshlet_count;
+            mesh->primitives.push_back(primitive);
+        }
+        for (u32 i = cooked_mesh.first_instance; i < cooked_mesh.first_instance + cooked_mesh.instance_count; i++) {
+            mesh->instances.push_back(first_transform + instances[i]);
+        }
+        m_meshes.push_back(mesh);
+    }
+    m_meshlets.assign(meshlets.begin(), meshlets.end());
 
+    for (const Cooked::Node &cooked_node : nodes) {
+        std::shared_ptr<Node> node = std::make_shared<Node>();
+        node->index = cooked_node.index;
+        node->transform_index = first_transform + cooked_node.transform;
+        node->mesh = cooked_node.mesh != Cooked::INVALID_INDEX ? m_meshes[cooked_node.mesh] : nullptr;
+        m_linear_nodes.push_back(node);
+    }
+    for (u32 n = 0; n < nodes.count; n++) {
+        if (nodes[n].parent != Cooked::INVALID_INDEX) {
+            m_linear_nodes[n]->m_parent = m_linear_nodes[nodes[n].parent];
+            m_linear_nodes[nodes[n].parent]->m_children.push_back(m_linear_nodes[n]);
+        } else {
+            m_nodes.push_back(m_linear_nodes[n]);
+        }
+    }
+
+    u32 vertex_stride = file.GetHeader().vertex_stride;
+    m_vertex_buffer =
+        std::make_shared<VertexBuffer>(m_device, m_command_buffer, file.GetSectionData(Cooked::SECTION_VERTICES),
+                                       file.GetSectionSize(Cooked::SECTION_VERTICES) / vertex_stride, vertex_stride);
+    auto indices = file.GetTable<Index>(Cooked::SECTION_INDICES);
+    m_index_buffer = std::make_shared<IndexBuffer>(m_device, m_command_buffer, indices.data, indices.count);
+    return true;
+}
+
+// runs at the end of the source path while the decoded gltf images are still around. vertices are the gpu vertices of
+// the model's vertex format
+void Model::WriteCooked(const std::string &cooked_path, u64 source_hash, const tinygltf::Model &gltf_model,
+                        const std::vector<i32> &texture_images, const void *vertices) const noexcept {
+    // decoded images are stored as rgba8 with a full mip chain, ktx2 images with the levels and format they come with.
+    // anything the texture upload cannot take stays empty like a failed decode
+    std::vector<bool> color_images = GetColorImages(gltf_model);
+    std::vector<Cooked::Image> images;
+    u64 pixel_size = 0;
+    for (const tinygltf::Image &image : gltf_model.images) {
+        Cooked::Image cooked_image{};
+        cooked_image.format = VK_FORMAT_R8G8B8A8_UNORM;
+        u64 texel_count = static_cast<u64>(std::max(image.width, 0)) * static_cast<u64>(std::max(image.height, 0));
+        Ktx2::Image ktx2;
+        std::string error;
+        if (Ktx2::IsKtx2(image.image.data(), image.image.size())) {
+            if (Ktx2::Parse(image.image.data(), image.image.size(), ktx2, error)) {
+                cooked_image.width = ktx2.width;
+                cooked_image.height = ktx2.height;
+                cooked_image.format = ktx2.format;
+                cooked_image.mip_count = static_cast<u32>(ktx2.levels.size());
+            }
+        } else if (texel_count > 0 && image.bits == 8 && (image.component == 3 || image.component == 4) &&
+                   image.image.size() >= texel_count * image.component) {
+            cooked_image.width = static_cast<u32>(image.width);
+            cooked_image.height = static_cast<u32>(image.height);
+            cooked_image.mip_count = Mipmap::GetLevelCount(cooked_image.width, cooked_image.height);
+        }
+        if (cooked_image.mip_count > 0) {
+            cooked_image.pixel_offset = (pixel_size + Cooked::SECTION_ALIGNMENT - 1) & ~(Cooked::SECTION_ALIGNMENT - 1);
+            cooked_image.pixel_size = ImageFormat::GetChainSize(static_cast<VkFormat>(cooked_image.format),
+                                                                cooked_image.width, cooked_image.height,
+                                                                cooked_image.mip_count);
+            pixel_size = cooked_image.pixel_offset + cooked_image.pixel_size;
+        }
+        images.push_back(cooked_image);
+    }
+    std::vector<u8> pixels(pixel_size, 0);
+    ThreadPool::GetInstance().ParallelFor(static_cast<u32>(images.size()), 1, [&](u32 begin, u32 end) {
+        for (u32 i = begin; i < end; i++) {
+            const tinygltf::Image &image = gltf_model.images[i];
+            const Cooked::Image &cooked_image = images[i];
+            if (cooked_image.pixel_size == 0) {
+                continue;
+            }
+            Ktx2::Image ktx2;
+            std::string error;
+            if (Ktx2::Parse(image.image.data(), image.image.size(), ktx2, error)) {
+                std::vector<u8> levels = Ktx2::PackLevels(ktx2);
+                std::memcpy(pixels.data() + cooked_image.pixel_offset, levels.data(), levels.size());
+                continue;
+            }
+            std::vector<u8> rgba = GetRgba8(image);
+            std::vector<u8> chain = Mipmap::GenerateRgba8(rgba.data(), cooked_image.width, cooked_image.height,
+                                                          color_images[i]);
+            std::memcpy(pixels.data() + cooked_image.pixel_offset, chain.data(), chain.size());
+        }
+    });
+
+    // the image each texture was loaded from, which for KHR_texture_basisu is the ktx2 source or its fallback
+    std::vector<Cooked::Texture> textures;
+    for (u32 t = 0; t < texture_images.size() && t < gltf_model.textures.size(); t++) {
+        i32 image = texture_images[t];
+        bool valid = image >= 0 && image < static_cast<i32>(images.size());
+        const tinygltf::Sampler sampler = GetTextureSampler(gltf_model, gltf_model.textures[t]);
+        textures.push_back(Cooked::Texture{valid ? image : Cooked::INVALID_INDEX, sampler.magFilter, sampler.minFilter,
+                                           sampler.wrapS, sampler.wrapT});
+    }
+
+    std::vector<Cooked::Material> materials;
+    auto texture_or_invalid = [&](i32 index) {
+        return index >= 0 && index < static_cast<i32>(textures.size()) ? index : Cooked::INVALID_INDEX;
+    };
+    for (const tinygltf::Material &material : gltf_model.materials) {
+        Cooked::Material cooked_material = GetMaterialTextures(material);
+        cooked_material.base_color_texture = texture_or_invalid(cooked_material.base_color_texture);
+        cooked_material.normal_texture = texture_or_invalid(cooked_material.normal_texture);
+        cooked_material.metallic_roughness_texture = texture_or_invalid(cooked_material.metallic_roughness_texture);
+        materials.push_back(cooked_material);
+    }
+
+    // every transform added after the root belongs to this model
+    u32 first_transform = m_root_transform + 1;
+    std::vector<Cooked::Transform> transforms;
+    for (u32 t = first_transform; t < m_transforms->GetNodeCount(); t++) {
+        i32 parent = m_transforms->GetParent(t);
+        transforms.push_back(Cooked::Transform{
+            parent == static_cast<i32>(m_root_transform) ? Cooked::INVALID_INDEX
+                                                         : parent - static_cast<i32>(first_transform),
+            m_transforms->GetTranslation(t), m_transforms->GetRotation(t), m_transforms->GetScale(t),
+            m_transforms->GetLocalMatrix(t)});
+    }
+
+    std::unordered_map<const Material *, u32> material_indices;
+    for (u32 m = 0; m < m_materials.size(); m++) {
+        material_indices.emplace(m_materials[m].get(), m);
+    }
+    std::unordered_map<const Mesh *, i32> mesh_indices;
+    std::vector<Cooked::Mesh> meshes;
+    std::vector<Cooked::Primitive> primitives;
+    std::vector<PrimitiveLod> lods;
+    std::vector<u32> instances;
+    for (auto &mesh : m_meshes) {
+        mesh_indices.emplace(mesh.get(), static_cast<i32>(meshes.size()));
+        meshes.push_back(Cooked::Mesh{static_cast<u32>(primitives.size()), static_cast<u32>(mesh->primitives.size()),
+                                      static_cast<u32>(instances.size()), static_cast<u32>(mesh->instances.size())});
+        for (auto &primitive : mesh->primitives) {
+            auto material = material_indices.find(primitive->material.get());
+            if (material == material_indices.end()) {
+                LOG_WARN("{}: primitive without a material, model is not cooked", cooked_path);
+                return;
+            }
+            primitives.push_back(Cooked::Primitive{
+                primitive->firstIndex, primitive->indexCount, primitive->firstVertex, primitive->vertexCount,
+                material->second, static_cast<u32>(lods.size()), static_cast<u32>(primitive->lods.size()),
+                primitive->first_meshlet, primitive->meshlet_count, primitive->bounds_min, primitive->bounds_max,
+                primitive->uv_density});
+            lods.insert(lods.end(), primitive->lods.begin(), primitive->lods.end());
+        }
+        for (u32 transform : mesh->instances) {
+            instances.push_back(transform - first_transform);
+        }
+    }
+
+    std::unordered_map<const Node *, i32> node_indices;
+    for (u32 n = 0; n < m_linear_nodes.size(); n++) {
+        node_indices.emplace(m_linear_nodes[n].get(), static_cast<i32>(n));
+    }
+    std::vector<Cooked::Node> nodes;
+    for (auto &node : m_linear_nodes) {
+        auto mesh = node->mesh ? mesh_indices.find(node->mesh.get()) : mesh_indices.end();
+        nodes.push_back(Cooked::Node{node->m_parent ? node_indices.at(node->m_parent.get()) : Cooked::INVALID_INDEX,
+                                     node->index, node->transform_index - first_transform,
+                                     mesh != mesh_indices.end() ? mesh->second : Cooked::INVALID_INDEX});
+    }
+
+    Cooked::Header header;
+    header.source_hash = source_hash;
+    header.vertex_format = static_cast<u32>(m_vertex_format);
+    header.vertex_stride = GetVertexStride();
+
+    CookedModelWriter writer;
+    writer.SetSection(Cooked::SECTION_VERTICES, vertices, u64(header.vertex_stride) * m_vertices.size());
+    writer.SetSection(Cooked::SECTION_INDICES, m_indices);
+    writer.SetSection(Cooked::SECTION_PRIMITIVES, primitives);
+    writer.SetSection(Cooked::SECTION_LODS, lods);
+    writer.SetSection(Cooked::SECTION_MESHLETS, m_meshlets);
+    writer.SetSection(Cooked::SECTION_MESHES, meshes);
+    writer.SetSection(Cooked::SECTION_INSTANCES, instances);
+    writer.SetSection(Cooked::SECTION_TRANSFORMS, transforms);
+    writer.SetSection(Cooked::SECTION_NODES, nodes);
+    writer.SetSection(Cooked::SECTION_MATERIALS, materials);
+    writer.SetSection(Cooked::SECTION_TEXTURES, textures);
+    writer.SetSection(Cooked::SECTION_IMAGES, images);
+    writer.SetSection(Cooked::SECTION_PIXELS, pixels);
+    if (writer.Write(cooked_path, header)) {
+        LOG_INFO("cooked {}", cooked_path);
+    }
+}
+
+u32 Model::GetVertexStride() const noexcept {
+    return m_vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED ? sizeof(CompressedVertex) : sizeof(Vertex);
+}
+
+void Model::Submit(RenderQueue &queue, Pipeline *pipeline, const Math::mat4 &view, const Math::vec2 &near_far,
+                   f32 lod_scale, bool meshlet_culling, VkDescriptorSet material_table_set) noexcept {
+    if (!m_vertex_buffer) {
+        return;
+    }
+    u32 pipeline_id = queue.GetPipelineId(pipeline);
+    for (auto &mesh : m_meshes) {
+        if (mesh->instances.empty()) {
+            continue;
+        }
+        for (auto &primitive : mesh->primitives) {
+            Math::vec4 center = Math::vec4((primitive->bounds_max + primitive->bounds_min) * 0.5f, 1.0f);
+            f32 radius = Math::length(primitive->bounds_max - primitive->bounds_min) * 0.5f;
+            f32 depth = near_far.y;
+            // distance over scale of the nearest instance, the smallest value gives the largest screen error
+            f32 lod_distance = std::numeric_limits<f32>::max();
+            // the same for instances not entirely behind the camera, they decide the texture levels
+            f32 texture_distance = std::numeric_limits<f32>::max();
+            for (u32 i = 0; i < mesh->instances.size(); i++) {
+                const Math::mat4 &model = m_instance_matrices[mesh->first_instance + i];
+                Math::vec3 view_center = Math::vec3(view * model * center);
+                // view space looks down -z
+                depth = std::min(depth, -view_center.z);
+
+                f32 scale = std::max({Math::length(Math::vec3(model[0])), Math::length(Math::vec3(model[1])),
+                                      Math::length(Math::vec3(model[2]))});
+                f32 distance = std::max(Math::length(view_center) - radius * scale, near_far.x);
+                lod_distance = std::min(lod_distance, distance / std::max(scale, 1e-6f));
+                if (view_center.z - radius * scale < 0.0f) {
+                    texture_distance = std::min(texture_distance, distance / std::max(scale, 1e-6f));
+                }
+            }
+
+            if (m_texture_streamer && primitive->uv_density > 0.0f &&
+                texture_distance < std::numeric_limits<f32>::max()) {
+                // lod_scale is pixels per unit at unit distance, so this is the uv step between two pixels
+                f32 uv_per_pixel = primitive->uv_density * texture_distance / lod_scale;
+                const Material &material = *primitive->material;
+                for (const Texture *texture : {material.base_color_texture.get(), material.normal_texture.get(),
+                                               material.metallic_rougness_texture.get()}) {
+                    m_texture_streamer->Request(texture, uv_per_pixel);
+                }
+            }
+
+            if (!primitive->lods.empty()) {
+                auto projected_error = [&](u32 lod) { return primitive->lods[lod].error / lod_distance * lod_scale; };
+                u32 lod = std::min(primitive->current_lod, static_cast<u32>(primitive->lods.size() - 1));
+                while (lod > 0 && projected_error(lod) > LOD_PIXEL_ERROR) {
+                    lod--;
+                }
+                while (lod + 1 < primitive->lods.size() &&
+                       projected_error(lod + 1) < LOD_PIXEL_ERROR * LOD_HYSTERESIS) {
+                    lod++;
+                }
+                primitive->current_lod = lod;
+            }
+
+            DrawCommand command;
+            command.key = RenderQueue::MakeSortKey(pipeline_id, queue.GetMaterialId(primitive->material.get()), depth,
+                                                   near_far.x, near_far.y);
+            command.pipeline = pipeline;
+            if (material_table_set != VK_NULL_HANDLE) {
+                command.material_set = material_table_set;
+                command.material_index = primitive->material->table_index;
+            } else {
+                command.material_set = primitive->material->m_material_descriptor_set->Get();
+            }
+            command.instance_set = m_instance_descriptor_set->Get();
+            command.vertex_buffer = m_vertex_buffer->Get();
+            command.index_buffer = m_index_buffer->Get();
+            command.first_index = primitive->firstIndex;
+            command.index_count = primitive->indexCount;
+            if (!primitive->lods.empty()) {
+                command.first_index = primitive->lods[primitive->current_lod].firstIndex;
+                command.index_count = primitive->lods[primitive->current_lod].indexCount;
+            }
+            command.first_instance = mesh->first_instance;
+            command.instance_count = static_cast<u32>(mesh->instances.size());
+            if (meshlet_culling && primitive->meshlet_count > 0 && primitive->current_lod == 0) {
+                command.indirect_buffer = m_indirect_buffer->Get();
+                command.indirect_offset = primitive->first_cull_slot * sizeof(VkDrawIndexedIndirectCommand);
+                command.indirect_draw_count = primitive->meshlet_count * command.instance_count;
+            }
+            if (m_vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED) {
+                command.dequantization.position_scale =
+                    Math::vec4(primitive->bounds_max - primitive->bounds_min, 0.0f);
+                command.dequantization.position_offset = Math::vec4(primitive->bounds_min, 1.0f);
+            }
+            queue.Push(command);
+        }
+    }
+}
+
+std::vector<i32> Model::LoadTextures(tinygltf::Model &gltfModel, ImageDecoder *decoder,
+                                     bool compressed_textures) noexcept {
+    // failed images map to null textures, materials fall back to the empty texture for them
+    LoadEmptyTexture();
+    // textures sharing an image share its gpu copy
+    std::vector<std::shared_ptr<Texture>> image_textures(gltfModel.images.size(), nullptr);
+    std::vector<bool> failed_images(gltfModel.images.size(), false);
+    std::vector<f64> image_ms(gltfModel.images.size(), 0.0);
+    std::vector<bool> color_images = GetColorImages(gltfModel);
+    std::vector<i32> texture_images;
     for (tinygltf::Texture &tex : gltfModel.textures) {
-        //auto& image = gltfModel.images[tex.source];
-        //VkSamplerCreateInfo samplerinfo;
-        //if (tex.sampler == -1) {
-        //	samplerinfo.magFilter = VK_FILTER_LINEAR;
-        //	samplerinfo.minFilter = VK_FILTER_LINEAR;
-        //	samplerinfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        //	samplerinfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        //	samplerinfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        //}
-        //else {
-        //	samplerinfo = samplers[tex.sampler];
-        //}
-
-        m_textures.emplace_back(std::make_shared<Texture>(m_device, m_command_buffer, gltfModel.images[tex.source]));
+        const tinygltf::Sampler sampler = GetTextureSampler(gltfModel, tex);
+        m_texture_samplers.push_back(m_device->GetSamplerCache().Get(
+            GetSamplerDesc(sampler.magFilter, sampler.minFilter, sampler.wrapS, sampler.wrapT)));
+
+        // a ktx2 source comes first when compressed textures are on, the plain source is its fallback
+        i32 texture_image = Cooked::INVALID_INDEX;
+        for (i32 source : {compressed_textures ? GetBasisuSource(tex) : Cooked::INVALID_INDEX, tex.source}) {
+            if (source < 0 || source >= static_cast<i32>(gltfModel.images.size())) {
+                continue;
+            }
+            if (!image_textures[source] && !failed_images[source]) {
+                auto start = std::chrono::steady_clock::now();
+                image_textures[source] = LoadImageTexture(gltfModel, source, decoder, color_images[source]);
+                failed_images[source] = !image_textures[source];
+                image_ms[source] =
+                    std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            if (image_textures[source]) {
+                texture_image = source;
+                break;
+            }
+        }
+        m_textures.push_back(texture_image >= 0 ? image_textures[texture_image] : nullptr);
+        m_texture_load_ms.push_back(texture_image >= 0 ? image_ms[texture_image] : 0.0);
+        texture_images.push_back(texture_image);
     }
+    return texture_images;
+}
+
+// each upload runs here while the pool keeps decoding the images that follow
+std::shared_ptr<Texture> Model::LoadImageTexture(tinygltf::Model &gltfModel, i32 image_index, ImageDecoder *decoder,
+                                                 bool srgb) noexcept {
+    if (decoder) {
+        decoder->Collect(image_index, gltfModel);
+    }
+    tinygltf::Image &image = gltfModel.images[image_index];
+    if (Ktx2::IsKtx2(image.image.data(), image.image.size())) {
+        Ktx2::Image ktx2;
+        std::string error;
+        if (!Ktx2::Parse(image.image.data(), image.image.size(), ktx2, error)) {
+            LOG_WARN("image {}: {}", image_index, error);
+            return nullptr;
+        }
+        if (!Texture::CanLoad(*m_device, ktx2.format)) {
+            LOG_WARN("image {}: format {} is not supported", image_index, static_cast<u32>(ktx2.format));
+            return nullptr;
+        }
+        std::vector<u8> levels = Ktx2::PackLevels(ktx2);
+        return CreateTexture(ktx2.format, levels.data(), ktx2.width, ktx2.height,
+                             static_cast<u32>(ktx2.levels.size()));
+    }
+    if (image.width <= 0 || image.height <= 0 || image.component <= 0 || image.image.empty()) {
+        return nullptr;
+    }
+    u64 texel_count = static_cast<u64>(image.width) * static_cast<u64>(image.height);
+    // an image no larger than the tail would be fully resident anyway, its mips are blitted on the gpu
+    u32 extent = static_cast<u32>(std::max(image.width, image.height));
+    if (!m_texture_streamer || extent <= TextureStreamer::TAIL_EXTENT || image.bits != 8 ||
+        (image.component != 3 && image.component != 4) || image.image.size() < texel_count * image.component) {
+        return std::make_shared<Texture>(m_device, m_command_buffer, image, srgb);
+    }
+    // streamed textures keep every level in system memory, the chain is built on the cpu like the cooker does
+    u32 width = static_cast<u32>(image.width), height = static_cast<u32>(image.height);
+    std::vector<u8> rgba = GetRgba8(image);
+    std::vector<u8> chain = Mipmap::GenerateRgba8(rgba.data(), width, height, srgb);
+    return CreateTexture(VK_FORMAT_R8G8B8A8_UNORM, chain.data(), width, height, Mipmap::GetLevelCount(width, height));
+}
 
+std::shared_ptr<Texture> Model::CreateTexture(VkFormat format, const u8 *levels, u32 width, u32 height,
+                                              u32 mip_count) noexcept {
+    if (m_texture_streamer) {
+        return m_texture_streamer->Load(format, levels, width, height, mip_count);
+    }
+    return std::make_shared<Texture>(m_device, m_command_buffer, format, levels, width, height, mip_count);
+}
+
+void Model::LoadEmptyTexture() noexcept {
     if (!m_empty_texture) {
         m_empty_texture = std::make_shared<Texture>(m_device, m_command_buffer);
         m_empty_texture->loadFromFile(Path::GetTexturePath("black.jpg"),
@@ -117,90 +815,112 @@ void Model::LoadTextures(tinygltf::Model &gltfModel) noexcept {
     }
 }
 
-void Model::LoadMaterials(tinygltf::Model &gltfModel) noexcept {
-    for (tinygltf::Material &mat : gltfModel.materials) {
-        std::shared_ptr<Material> material = std::make_shared<Material>();
-        // bc
-        if (mat.values.find("baseColorTexture") != mat.values.end()) {
-            material->base_color_texture = m_textures[mat.values["baseColorTexture"].TextureIndex()];
-            //material->texCoordSets.baseColor = mat.values["base_color_texture"].TextureTexCoord();
-            material->m_material_ubdata.has_base_color = true;
-        } else {
-            LOG_WARN("no base color texture found, use an empty texture instead");
-            material->base_color_texture = m_empty_texture;
-        }
-
-        //if (mat.values.find("baseColorFactor") != mat.values.end()) {
-        //	material.m_material_ubdata.baseColorFactor = Math::make_vec4(mat.values["baseColorFactor"].ColorFactor().data());
-        //} else{
-        //	LOG_WARN("no base color factor found, use default param instead");
-        //}
+void Model::LogTextureMemory(const std::string &path) const noexcept {
+    std::unordered_map<const Texture *, f64> load_ms;
+    for (u32 t = 0; t < m_textures.size() && t < m_texture_load_ms.size(); t++) {
+        load_ms[m_textures[t].get()] = m_texture_load_ms[t];
+    }
+    auto rgba8_size = [](const Texture &texture) {
+        return Mipmap::GetChainSize(texture.GetWidth(), texture.GetHeight(),
+                                    Mipmap::GetLevelCount(texture.GetWidth(), texture.GetHeight()));
+    };
 
-        // normal
-        if (mat.additionalValues.find("normalTexture") != mat.additionalValues.end()) {
-            material->normal_texture = m_textures[mat.additionalValues["normalTexture"].TextureIndex()];
-            //material->texCoordSets.normal = mat.additionalValues["normal_texture"].TextureTexCoord();
-            material->m_material_ubdata.has_normal = true;
-        } else {
-            LOG_WARN("no normal texture found, use an empty texture instead");
-            material->normal_texture = m_empty_texture;
+    // textures shared between materials count once in the totals
+    std::unordered_set<const Texture *> counted;
+    u64 total_size = 0, total_rgba8_size = 0;
+    f64 total_ms = 0.0;
+    for (u32 m = 0; m < m_materials.size(); m++) {
+        const Material &material = *m_materials[m];
+        u64 size = 0, rgba8 = 0;
+        f64 ms = 0.0;
+        for (const Texture *texture : {material.base_color_texture.get(), material.normal_texture.get(),
+                                       material.metallic_rougness_texture.get()}) {
+            if (!texture || texture == m_empty_texture.get()) {
+                continue;
+            }
+            size += texture->GetMemorySize();
+            rgba8 += rgba8_size(*texture);
+            ms += load_ms[texture];
+            if (counted.insert(texture).second) {
+                total_size += texture->GetMemorySize();
+                total_rgba8_size += rgba8_size(*texture);
+                total_ms += load_ms[texture];
+            }
         }
+        LOG_DEBUG("{}: material {} textures {} KB, {} KB as rgba8, loaded in {:.1f} ms", path, m, size / 1024,
+                  rgba8 / 1024, ms);
+    }
+    LOG_INFO("{}: textures {} KB, {} KB as rgba8, loaded in {:.1f} ms", path, total_size / 1024,
+             total_rgba8_size / 1024, total_ms);
+}
 
-        // metallic roughtness
-        if (mat.values.find("metallicRoughnessTexture") != mat.values.end()) {
-            material->metallic_rougness_texture = m_textures[mat.values["metallicRoughnessTexture"].TextureIndex()];
-            //material->texCoordSets.metallicRoughness = mat.values["metallic_rougness_texture"].TextureTexCoord();
-            material->m_material_ubdata.has_metallic_rougness = true;
-        } else {
-            LOG_WARN("no metallicRoughness texture found, use an empty texture instead");
-            material->metallic_rougness_texture = m_empty_texture;
-        }
-        /*
-			if (mat.values.find("roughnessFactor") != mat.values.end()) {
-				material.m_material_ubdata.metallicRoughnessFactor.y = static_cast<f32>(mat.values["roughnessFactor"].Factor());
-			} else{
-				LOG_WARN("no roughnessFactor found, use default param instead");
-			}
-			if (mat.values.find("metallicFactor") != mat.values.end()) {
-				material.m_material_ubdata.metallicRoughnessFactor.x = static_cast<f32>(mat.values["metallicFactor"].Factor());
-			} else{
-				LOG_WARN("no metallicFactor found, use default param instead");
-			}*/
-
-        //if (mat.additionalValues.find("emissiveTexture") != mat.additionalValues.end()) {
-        //	material.emissiveTexture = &textures[mat.additionalValues["emissiveTexture"].TextureIndex()];
-        //	material.texCoordSets.emissive = mat.additionalValues["emissiveTexture"].TextureTexCoord();
-        //}
-        //if (mat.additionalValues.find("occlusionTexture") != mat.additionalValues.end()) {
-        //	material.occlusionTexture = &textures[mat.additionalValues["occlusionTexture"].TextureIndex()];
-        //	material.texCoordSets.occlusion = mat.additionalValues["occlusionTexture"].TextureTexCoord();
-        //}
-        //if (mat.additionalValues.find("emissiveFactor") != mat.additionalValues.end()) {
-        //	material.emissiveFactor = Math::vec4(Math::make_vec3(mat.additionalValues["emissiveFactor"].ColorFactor().data()), 1.0);
-        //	material.emissiveFactor = Math::vec4(0.0f);
-        //}
-
-        material->m_material_ub = std::make_shared<UniformBuffer>(m_device);
-
-        std::shared_ptr<DescriptorSetInfo> setInfo = std::make_shared<DescriptorSetInfo>();
-        // material parameters
-        setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-                            SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
-        // albedo/normal/metallicroughness
-        setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
-                            SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
-        setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
-                            SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
-        setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
-                            SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
-        material->m_material_descriptor_set = std::make_shared<DescriptorSet>(m_device, setInfo);
-
-        m_materials.push_back(material);
+void Model::LoadMaterials(tinygltf::Model &gltfModel) noexcept {
+    for (tinygltf::Material &mat : gltfModel.materials) {
+        Cooked::Material textures = GetMaterialTextures(mat);
+        m_materials.push_back(
+            CreateMaterial(textures.base_color_texture, textures.normal_texture, textures.metallic_roughness_texture));
     }
     // Push a default material at the end of the list for meshes with no material assigned
     //m_materials.push_back(Material());
 }
 
+std::shared_ptr<Material> Model::CreateMaterial(i32 base_color_texture, i32 normal_texture,
+                                                i32 metallic_roughness_texture) noexcept {
+    auto get_texture = [&](i32 index) {
+        return index >= 0 && index < static_cast<i32>(m_textures.size()) ? m_textures[index] : nullptr;
+    };
+    auto get_sampler = [&](i32 index) {
+        return index >= 0 && index < static_cast<i32>(m_texture_samplers.size()) ? m_texture_samplers[index]
+                                                                                 : VK_NULL_HANDLE;
+    };
+    std::shared_ptr<Material> material = std::make_shared<Material>();
+    // bc
+    if (std::shared_ptr<Texture> texture = get_texture(base_color_texture)) {
+        material->base_color_texture = texture;
+        material->base_color_sampler = get_sampler(base_color_texture);
+        material->m_material_ubdata.has_base_color = true;
+    } else {
+        LOG_WARN("no base color texture found, use an empty texture instead");
+        material->base_color_texture = m_empty_texture;
+    }
+
+    // normal
+    if (std::shared_ptr<Texture> texture = get_texture(normal_texture)) {
+        material->normal_texture = texture;
+        material->normal_sampler = get_sampler(normal_texture);
+        material->m_material_ubdata.has_normal = true;
+    } else {
+        LOG_WARN("no normal texture found, use an empty texture instead");
+        material->normal_texture = m_empty_texture;
+    }
+
+    // metallic roughtness
+    if (std::shared_ptr<Texture> texture = get_texture(metallic_roughness_texture)) {
+        material->metallic_rougness_texture = texture;
+        material->metallic_rougness_sampler = get_sampler(metallic_roughness_texture);
+        material->m_material_ubdata.has_metallic_rougness = true;
+    } else {
+        LOG_WARN("no metallicRoughness texture found, use an empty texture instead");
+        material->metallic_rougness_texture = m_empty_texture;
+    }
+
+    material->m_material_ub = std::make_shared<UniformBuffer>(m_device);
+
+    std::shared_ptr<DescriptorSetInfo> setInfo = std::make_shared<DescriptorSetInfo>();
+    // material parameters
+    setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                        SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
+    // albedo/normal/metallicroughness
+    setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
+                        SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
+    setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
+                        SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
+    setInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_TEXTURE,
+                        SHADER_STAGE_VERTEX_SHADER | SHADER_STAGE_PIXEL_SHADER);
+    material->m_material_descriptor_set = std::make_shared<DescriptorSet>(m_device, setInfo);
+    return material;
+}
+
 void Model::LoadNode(std::shared_ptr<Node> m_parent, const tinygltf::Node &node, uint32_t nodeIndex,
                      const tinygltf::Model &model, std::vector<u32> &indices, std::vector<Vertex> &vertices,
                      f32 globalscale) noexcept {
@@ -208,26 +928,29 @@ void Model::LoadNode(std::shared_ptr<Node> m_parent, const tinygltf::Node &node,
     newNode->index = nodeIndex;
     newNode->m_parent = m_parent;
     newNode->name = node.name;
-    newNode->matrix = Math::mat4(1.0f);
 
     // Generate local node matrix
     Math::vec3 translation = Math::vec3(0.0f);
     if (node.translation.size() == 3) {
         translation = Math::make_vec3(node.translation.data());
-        newNode->translation = translation;
     }
+    Math::quat rotation = Math::quat(1.0f, 0.0f, 0.0f, 0.0f);
     if (node.rotation.size() == 4) {
-        newNode->rotation = Math::make_quat(node.rotation.data());
+        rotation = Math::make_quat(node.rotation.data());
     }
     Math::vec3 scale = Math::vec3(1.0f);
     if (node.scale.size() == 3) {
         scale = Math::make_vec3(node.scale.data());
-        newNode->scale = scale;
     }
+    Math::mat4 matrix = Math::mat4(1.0f);
     if (node.matrix.size() == 16) {
-        newNode->matrix = Math::make_mat4x4(node.matrix.data());
+        matrix = Math::make_mat4x4(node.matrix.data());
     };
 
+    // register before the children so the hierarchy stays in topological order
+    i32 parent_transform = static_cast<i32>(m_parent ? m_parent->transform_index : m_root_transform);
+    newNode->transform_index = m_transforms->AddNode(parent_transform, translation, rotation, scale, matrix);
+
     // Node with m_children
     if (node.children.size() > 0) {
         for (size_t i = 0; i < node.children.size(); i++) {
@@ -237,173 +960,471 @@ void Model::LoadNode(std::shared_ptr<Node> m_parent, const tinygltf::Node &node,
 
     // Node contains mesh data
     if (node.mesh > -1) {
-        const tinygltf::Mesh mesh = model.meshes[node.mesh];
-        std::shared_ptr<Mesh> newMesh = std::make_shared<Mesh>(m_device, newNode->matrix);
-        for (size_t j = 0; j < mesh.primitives.size(); j++) {
-            const tinygltf::Primitive &primitive = mesh.primitives[j];
-            uint32_t indexStart = static_cast<uint32_t>(indices.size());
-            uint32_t vertexStart = static_cast<uint32_t>(vertices.size());
-            uint32_t indexCount = 0;
-            uint32_t vertexCount = 0;
-            Math::vec3 posMin{};
-            Math::vec3 posMax{};
-            bool hasSkin = false;
-            bool hasIndices = primitive.indices > -1;
-            // Vertices
-            {
-                const f32 *bufferPos = nullptr;
-                const f32 *bufferNormals = nullptr;
-                const f32 *bufferTexCoordSet0 = nullptr;
-                const f32 *bufferTexCoordSet1 = nullptr;
-                const void *bufferJoints = nullptr;
-                const f32 *bufferWeights = nullptr;
-
-                int posByteStride;
-                int normByteStride;
-                int uv0ByteStride;
-                int uv1ByteStride;
-                int jointByteStride;
-                int weightByteStride;
-
-                int jointComponentType;
-
-                // Position attribute is required
-                assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
-
-                const tinygltf::Accessor &posAccessor = model.accessors[primitive.attributes.find("POSITION")->second];
-                const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
-                bufferPos = reinterpret_cast<const f32 *>(
-                    &(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-                posMin = Math::vec3(posAccessor.minValues[0], posAccessor.minValues[1], posAccessor.minValues[2]);
-                posMax = Math::vec3(posAccessor.maxValues[0], posAccessor.maxValues[1], posAccessor.maxValues[2]);
-                vertexCount = static_cast<uint32_t>(posAccessor.count);
-                posByteStride = posAccessor.ByteStride(posView) ? (posAccessor.ByteStride(posView) / sizeof(f32))
-                                                                : sizeof(Math::vec3) * 8;
-
-                if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &normAccessor =
-                        model.accessors[primitive.attributes.find("NORMAL")->second];
-                    const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
-                    bufferNormals = reinterpret_cast<const f32 *>(
-                        &(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
-                    normByteStride = normAccessor.ByteStride(normView)
-                                         ? (normAccessor.ByteStride(normView) / sizeof(f32))
-                                         : sizeof(Math::vec3) * 8;
-                }
+        // meshes referenced by several nodes are loaded once and drawn instanced
+        auto cached = m_mesh_cache.find(node.mesh);
+        std::shared_ptr<Mesh> mesh = nullptr;
+        if (cached != m_mesh_cache.end()) {
+            mesh = cached->second;
+        } else {
+            mesh = LoadMesh(node.mesh, model, indices, vertices);
+            if (mesh) {
+                m_mesh_cache.emplace(node.mesh, mesh);
+                m_meshes.push_back(mesh);
+            }
+        }
+        if (mesh) {
+            if (node.extensions.find("EXT_mesh_gpu_instancing") != node.extensions.end()) {
+                LoadGpuInstances(node, model, newNode->transform_index, mesh->instances);
+            } else {
+                mesh->instances.push_back(newNode->transform_index);
+            }
+        }
+        newNode->mesh = mesh;
+    }
+    if (m_parent) {
+        m_parent->m_children.push_back(newNode);
+    } else {
+        m_nodes.push_back(newNode);
+    }
+    m_linear_nodes.push_back(newNode);
+}
 
-                if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-                    const tinygltf::Accessor &uvAccessor =
-                        model.accessors[primitive.attributes.find("TEXCOORD_0")->second];
-                    const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-                    bufferTexCoordSet0 = reinterpret_cast<const f32 *>(
-                        &(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-                    uv0ByteStride = uvAccessor.ByteStride(uvView) ? (uvAccessor.ByteStride(uvView) / sizeof(f32))
-                                                                  : sizeof(Math::vec3) * 8;
+std::shared_ptr<Mesh> Model::LoadMesh(i32 meshIndex, const tinygltf::Model &model, std::vector<u32> &indices,
+                                      std::vector<Vertex> &vertices) noexcept {
+    const tinygltf::Mesh &mesh = model.meshes[meshIndex];
+    std::shared_ptr<Mesh> newMesh = std::make_shared<Mesh>(m_device);
+    for (size_t j = 0; j < mesh.primitives.size(); j++) {
+        const tinygltf::Primitive &primitive = mesh.primitives[j];
+        uint32_t indexStart = static_cast<uint32_t>(indices.size());
+        uint32_t vertexStart = static_cast<uint32_t>(vertices.size());
+        uint32_t indexCount = 0;
+        uint32_t vertexCount = 0;
+        Math::vec3 posMin{std::numeric_limits<f32>::max()};
+        Math::vec3 posMax{std::numeric_limits<f32>::lowest()};
+        bool hasIndices = primitive.indices > -1;
+        // Vertices
+        {
+            // Position attribute is required
+            assert(primitive.attributes.find("POSITION") != primitive.attributes.end());
+
+            auto find_accessor = [&](const char *name) -> const tinygltf::Accessor * {
+                auto attribute = primitive.attributes.find(name);
+                return attribute != primitive.attributes.end() ? &model.accessors[attribute->second] : nullptr;
+            };
+            // components are converted per element, so KHR_mesh_quantization inputs (normalized or plain
+            // byte/short) load the same way as floats
+            const tinygltf::Accessor *posAccessor = find_accessor("POSITION");
+            const tinygltf::Accessor *normAccessor = find_accessor("NORMAL");
+            const tinygltf::Accessor *uvAccessor = find_accessor("TEXCOORD_0");
+
+            vertexCount = static_cast<uint32_t>(posAccessor->count);
+            for (size_t v = 0; v < posAccessor->count; v++) {
+                Vertex vert;
+                vert.pos = Math::vec3(ReadAccessorElement(model, m_buffer_data, *posAccessor, v));
+                vert.normal = Math::vec3(0.0f);
+                if (normAccessor) {
+                    Math::vec3 normal = Math::vec3(ReadAccessorElement(model, m_buffer_data, *normAccessor, v));
+                    vert.normal = Math::length(normal) > 0.0f ? Math::normalize(normal) : normal;
                 }
-                for (size_t v = 0; v < posAccessor.count; v++) {
-                    Vertex vert;
-                    vert.pos = Math::make_vec3(&bufferPos[v * posByteStride]);
-                    vert.normal = Math::normalize(Math::vec3(
-                        bufferNormals ? Math::make_vec3(&bufferNormals[v * normByteStride]) : Math::vec3(0.0f)));
-                    vert.uv0 =
-                        bufferTexCoordSet0 ? Math::make_vec2(&bufferTexCoordSet0[v * uv0ByteStride]) : Math::vec3(0.0f);
-                    //vert.uv1 = bufferTexCoordSet1 ? Math::make_vec2(&bufferTexCoordSet1[v * uv1ByteStride]) : Math::vec3(0.0f);
-                    vertices.push_back(vert);
+                vert.uv0 = uvAccessor ? Math::vec2(ReadAccessorElement(model, m_buffer_data, *uvAccessor, v))
+                                      : Math::vec2(0.0f);
+                posMin = Math::min(posMin, vert.pos);
+                posMax = Math::max(posMax, vert.pos);
+                vertices.push_back(vert);
+            }
+            if (vertexCount == 0) {
+                posMin = posMax = Math::vec3(0.0f);
+            }
+        }
+        // Indices
+        if (hasIndices) {
+            const tinygltf::Accessor &accessor = model.accessors[primitive.indices > -1 ? primitive.indices : 0];
+            const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
+
+            indexCount = static_cast<uint32_t>(accessor.count);
+            const void *dataPtr = m_buffer_data[bufferView.buffer] + accessor.byteOffset + bufferView.byteOffset;
+
+            switch (accessor.componentType) {
+            case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
+                const uint32_t *buf = static_cast<const uint32_t *>(dataPtr);
+                for (size_t index = 0; index < accessor.count; index++) {
+                    indices.push_back(buf[index] + vertexStart);
                 }
+                break;
             }
-            // Indices
-            if (hasIndices) {
-                const tinygltf::Accessor &accessor = model.accessors[primitive.indices > -1 ? primitive.indices : 0];
-                const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
-
-                indexCount = static_cast<uint32_t>(accessor.count);
-                const void *dataPtr = &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-
-                switch (accessor.componentType) {
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-                    const uint32_t *buf = static_cast<const uint32_t *>(dataPtr);
-                    for (size_t index = 0; index < accessor.count; index++) {
-                        indices.push_back(buf[index] + vertexStart);
-                    }
-                    break;
+            case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
+                const uint16_t *buf = static_cast<const uint16_t *>(dataPtr);
+                for (size_t index = 0; index < accessor.count; index++) {
+                    indices.push_back(buf[index] + vertexStart);
                 }
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-                    const uint16_t *buf = static_cast<const uint16_t *>(dataPtr);
-                    for (size_t index = 0; index < accessor.count; index++) {
-                        indices.push_back(buf[index] + vertexStart);
-                    }
-                    break;
+                break;
+            }
+            case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
+                const uint8_t *buf = static_cast<const uint8_t *>(dataPtr);
+                for (size_t index = 0; index < accessor.count; index++) {
+                    indices.push_back(buf[index] + vertexStart);
                 }
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-                    const uint8_t *buf = static_cast<const uint8_t *>(dataPtr);
-                    for (size_t index = 0; index < accessor.count; index++) {
-                        indices.push_back(buf[index] + vertexStart);
-                    }
+                break;
+            }
+            default:
+                //std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
+                return nullptr;
+            }
+        }
+        auto newPrimitive = std::make_shared<MeshPrimitive>(
+            indexStart, indexCount, vertexCount,
+            primitive.material > -1 ? m_materials[primitive.material] : m_materials[0]);
+        newPrimitive->firstVertex = vertexStart;
+        newPrimitive->bounds_min = posMin;
+        newPrimitive->bounds_max = posMax;
+        newPrimitive->uv_density = hasIndices ? GetUvDensity(vertices, indices.data() + indexStart, indexCount)
+                                              : GetUvDensity(vertices, nullptr, vertexCount, vertexStart);
+        newMesh->primitives.emplace_back(newPrimitive);
+    }
+    return newMesh;
+}
+
+// EXT_mesh_gpu_instancing, every instance becomes a child transform of the node
+void Model::LoadGpuInstances(const tinygltf::Node &node, const tinygltf::Model &model, u32 parentTransform,
+                             std::vector<u32> &instances) noexcept {
+    const tinygltf::Value &attributes = node.extensions.at("EXT_mesh_gpu_instancing").Get("attributes");
+
+    auto get_accessor = [&](const char *name) -> const tinygltf::Accessor * {
+        if (!attributes.Has(name)) {
+            return nullptr;
+        }
+        return &model.accessors[attributes.Get(name).GetNumberAsInt()];
+    };
+    const tinygltf::Accessor *translations = get_accessor("TRANSLATION");
+    const tinygltf::Accessor *rotations = get_accessor("ROTATION");
+    const tinygltf::Accessor *scales = get_accessor("SCALE");
+
+    size_t count = translations ? translations->count : rotations ? rotations->count : scales ? scales->count : 0;
+    for (size_t i = 0; i < count; i++) {
+        Math::vec3 translation = Math::vec3(0.0f);
+        Math::quat rotation = Math::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        Math::vec3 scale = Math::vec3(1.0f);
+        if (translations) {
+            translation = Math::vec3(ReadAccessorElement(model, m_buffer_data, *translations, i));
+        }
+        if (rotations) {
+            Math::vec4 r = ReadAccessorElement(model, m_buffer_data, *rotations, i);
+            rotation = Math::quat(r.w, r.x, r.y, r.z);
+        }
+        if (scales) {
+            scale = Math::vec3(ReadAccessorElement(model, m_buffer_data, *scales, i));
+        }
+        instances.push_back(
+            m_transforms->AddNode(static_cast<i32>(parentTransform), translation, rotation, scale, Math::mat4(1.0f)));
+    }
+}
+
+// quantize positions against each primitive's bounds, Submit hands the same bounds to the shader for decoding
+std::vector<CompressedVertex> Model::CompressVertices() const noexcept {
+    std::vector<CompressedVertex> compressed(m_vertices.size());
+    for (auto &mesh : m_meshes) {
+        for (auto &primitive : mesh->primitives) {
+            Math::vec3 extent = primitive->bounds_max - primitive->bounds_min;
+            for (u32 v = primitive->firstVertex; v < primitive->firstVertex + primitive->vertexCount; v++) {
+                compressed[v] = CompressedVertex::Encode(m_vertices[v], primitive->bounds_min, extent);
+            }
+        }
+    }
+    return compressed;
+}
+
+// primitives own disjoint index and vertex ranges, so they are optimized in parallel
+void Model::OptimizeMeshes(const std::string &path) noexcept {
+    std::vector<MeshPrimitive *> primitives;
+    for (auto &mesh : m_meshes) {
+        for (auto &primitive : mesh->primitives) {
+            if (primitive->hasIndices && primitive->indexCount >= 3) {
+                primitives.push_back(primitive.get());
+            }
+        }
+    }
+    if (primitives.empty()) {
+        return;
+    }
+
+    std::vector<MeshOptimizer::VertexCacheStats> stats_before(primitives.size());
+    std::vector<MeshOptimizer::VertexCacheStats> stats_after(primitives.size());
+    ThreadPool::GetInstance().ParallelFor(static_cast<u32>(primitives.size()), 1, [&](u32 begin, u32 end) {
+        for (u32 p = begin; p < end; p++) {
+            MeshPrimitive *primitive = primitives[p];
+            u32 *indices = &m_indices[primitive->firstIndex];
+            Vertex *vertices = &m_vertices[primitive->firstVertex];
+            u32 vertex_count = primitive->vertexCount;
+
+            // the optimizer works on primitive local indices
+            bool valid = true;
+            for (u32 i = 0; i < primitive->indexCount; i++) {
+                valid &= indices[i] >= primitive->firstVertex && indices[i] - primitive->firstVertex < vertex_count;
+            }
+            if (!valid) {
+                LOG_WARN("{}: primitive indexes outside its vertex range, skip optimization", path);
+                continue;
+            }
+            for (u32 i = 0; i < primitive->indexCount; i++) {
+                indices[i] -= primitive->firstVertex;
+            }
+
+            stats_before[p] = MeshOptimizer::AnalyzeVertexCache(indices, primitive->indexCount, vertex_count);
+            MeshOptimizer::OptimizeVertexCache(indices, primitive->indexCount, vertex_count);
+            MeshOptimizer::OptimizeOverdraw(indices, primitive->indexCount, vertices, vertex_count);
+            MeshOptimizer::OptimizeVertexFetch(indices, primitive->indexCount, vertices, vertex_count);
+            stats_after[p] = MeshOptimizer::AnalyzeVertexCache(indices, primitive->indexCount, vertex_count);
+
+            for (u32 i = 0; i < primitive->indexCount; i++) {
+                indices[i] += primitive->firstVertex;
+            }
+        }
+    });
+
+    MeshOptimizer::VertexCacheStats before, after;
+    for (u32 p = 0; p < primitives.size(); p++) {
+        before.Accumulate(stats_before[p]);
+        after.Accumulate(stats_after[p]);
+    }
+    LOG_INFO("{}: optimized {} primitives, acmr {:.3f} -> {:.3f}, atvr {:.3f} -> {:.3f}", path, primitives.size(),
+             before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+// every lod is simplified from the full resolution indices so its error is measured against the original surface
+void Model::GenerateLods(const std::string &path, const std::vector<f32> &ratios) noexcept {
+    std::vector<MeshPrimitive *> primitives;
+    for (auto &mesh : m_meshes) {
+        for (auto &primitive : mesh->primitives) {
+            primitive->lods = {PrimitiveLod{primitive->firstIndex, primitive->indexCount, 0.0f}};
+            if (primitive->hasIndices && primitive->indexCount >= 3 && !ratios.empty()) {
+                primitives.push_back(primitive.get());
+            }
+        }
+    }
+    if (primitives.empty()) {
+        return;
+    }
+
+    // lod indices are primitive local until they are appended to the shared index buffer
+    std::vector<std::vector<std::vector<u32>>> lod_indices(primitives.size());
+    std::vector<std::vector<f32>> lod_errors(primitives.size());
+    ThreadPool::GetInstance().ParallelFor(static_cast<u32>(primitives.size()), 1, [&](u32 begin, u32 end) {
+        for (u32 p = begin; p < end; p++) {
+            MeshPrimitive *primitive = primitives[p];
+            const Vertex *vertices = &m_vertices[primitive->firstVertex];
+            std::vector<u32> indices(m_indices.begin() + primitive->firstIndex,
+                                     m_indices.begin() + primitive->firstIndex + primitive->indexCount);
+            bool valid = true;
+            for (u32 &index : indices) {
+                valid &= index >= primitive->firstVertex && index - primitive->firstVertex < primitive->vertexCount;
+                index -= primitive->firstVertex;
+            }
+            if (!valid) {
+                continue;
+            }
+
+            u32 previous_count = primitive->indexCount;
+            for (f32 ratio : ratios) {
+                u32 target = static_cast<u32>(static_cast<f32>(primitive->indexCount) * ratio) / 3 * 3;
+                std::vector<u32> lod;
+                f32 error = MeshOptimizer::Simplify(lod, indices.data(), primitive->indexCount, vertices,
+                                                    primitive->vertexCount, target);
+                // locked seams and borders can stall the simplifier, a level that barely shrinks is not worth it
+                if (lod.empty() || lod.size() > previous_count * 9 / 10) {
                     break;
                 }
-                default:
-                    //std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
-                    return;
-                }
+                MeshOptimizer::OptimizeVertexCache(lod.data(), static_cast<u32>(lod.size()), primitive->vertexCount);
+                previous_count = static_cast<u32>(lod.size());
+                lod_indices[p].push_back(std::move(lod));
+                lod_errors[p].push_back(error);
+            }
+        }
+    });
+
+    for (u32 p = 0; p < primitives.size(); p++) {
+        MeshPrimitive *primitive = primitives[p];
+        for (u32 l = 0; l < lod_indices[p].size(); l++) {
+            u32 first_index = static_cast<u32>(m_indices.size());
+            for (u32 index : lod_indices[p][l]) {
+                m_indices.push_back(index + primitive->firstVertex);
             }
-            newMesh->primitives.emplace_back(std::make_shared<MeshPrimitive>(
-                indexStart, indexCount, vertexCount,
-                primitive.material > -1 ? m_materials[primitive.material] : m_materials[0]));
+            primitive->lods.push_back(
+                PrimitiveLod{first_index, static_cast<u32>(lod_indices[p][l].size()), lod_errors[p][l]});
         }
-        newNode->mesh = newMesh;
     }
-    if (m_parent) {
-        m_parent->m_children.push_back(newNode);
-    } else {
-        m_nodes.push_back(newNode);
+
+    // primitives that stopped early count with their coarsest level
+    std::vector<u32> level_triangles(ratios.size() + 1, 0);
+    for (MeshPrimitive *primitive : primitives) {
+        for (u32 l = 0; l < level_triangles.size(); l++) {
+            level_triangles[l] += primitive->lods[std::min<size_t>(l, primitive->lods.size() - 1)].indexCount / 3;
+        }
     }
-    m_linear_nodes.push_back(newNode);
+    std::string levels = std::to_string(level_triangles[0]);
+    for (u32 l = 1; l < level_triangles.size(); l++) {
+        levels += " / " + std::to_string(level_triangles[l]);
+    }
+    LOG_INFO("{}: lod triangles {}", path, levels);
 }
 
-void Model::DrawNode(std::shared_ptr<Node> node, std::shared_ptr<Pipeline> pipeline,
-                     VkCommandBuffer command_buffer) noexcept {
-    if (node->mesh) {
-        for (auto &primitive : node->mesh->primitives) {
-            std::vector<VkDescriptorSet> descriptors{m_scene_descriptor_set->Get(),
-                                                     primitive->material->m_material_descriptor_set->Get()};
+// meshlets only cover lods[0], coarser lods are cheap enough to draw whole
+void Model::BuildMeshlets(const std::string &path) noexcept {
+    std::vector<MeshPrimitive *> primitives;
+    for (auto &mesh : m_meshes) {
+        for (auto &primitive : mesh->primitives) {
+            if (primitive->hasIndices && primitive->indexCount / 3 >= MESHLET_MIN_TRIANGLES) {
+                primitives.push_back(primitive.get());
+            }
+        }
+    }
+    if (primitives.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<MeshOptimizer::Meshlet>> primitive_meshlets(primitives.size());
+    ThreadPool::GetInstance().ParallelFor(static_cast<u32>(primitives.size()), 1, [&](u32 begin, u32 end) {
+        for (u32 p = begin; p < end; p++) {
+            MeshPrimitive *primitive = primitives[p];
+            std::vector<u32> indices(m_indices.begin() + primitive->firstIndex,
+                                     m_indices.begin() + primitive->firstIndex + primitive->indexCount);
+            bool valid = true;
+            for (u32 &index : indices) {
+                valid &= index >= primitive->firstVertex && index - primitive->firstVertex < primitive->vertexCount;
+                index -= primitive->firstVertex;
+            }
+            if (!valid) {
+                continue;
+            }
+            primitive_meshlets[p] =
+                MeshOptimizer::BuildMeshlets(indices.data(), primitive->indexCount, &m_vertices[primitive->firstVertex],
+                                             primitive->vertexCount, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+        }
+    });
+
+    u32 cones = 0;
+    for (u32 p = 0; p < primitives.size(); p++) {
+        MeshPrimitive *primitive = primitives[p];
+        primitive->first_meshlet = static_cast<u32>(m_meshlets.size());
+        primitive->meshlet_count = static_cast<u32>(primitive_meshlets[p].size());
+        for (MeshOptimizer::Meshlet &meshlet : primitive_meshlets[p]) {
+            meshlet.first_index += primitive->firstIndex;
+            cones += meshlet.cone_cutoff < 1.0f;
+            m_meshlets.push_back(meshlet);
+        }
+    }
+    LOG_INFO("{}: {} primitives split into {} meshlets, {} with a backface cone", path, primitives.size(),
+             m_meshlets.size(), cones);
+}
+
+// one cull slot per meshlet and instance, laid out so every primitive owns a contiguous range of indirect draws
+void Model::CreateMeshletBuffers() noexcept {
+    if (m_meshlets.empty()) {
+        return;
+    }
+
+    std::vector<GpuMeshlet> gpu_meshlets(m_meshlets.size());
+    for (u32 m = 0; m < m_meshlets.size(); m++) {
+        const MeshOptimizer::Meshlet &meshlet = m_meshlets[m];
+        gpu_meshlets[m].sphere = Math::vec4(meshlet.center, meshlet.radius);
+        gpu_meshlets[m].cone_apex = Math::vec4(meshlet.cone_apex, 1.0f);
+        gpu_meshlets[m].cone_axis_cutoff = Math::vec4(meshlet.cone_axis, meshlet.cone_cutoff);
+    }
 
-            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetLayout(), 0,
-                                    descriptors.size(), descriptors.data(), 0, 0);
-            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->Get());
-            if (pipeline->hasPushConstants()) {
-                vkCmdPushConstants(command_buffer, pipeline->GetLayout(), SHADER_STAGE_VERTEX_SHADER, 0,
-                                   sizeof(node->mesh->m_mesh_push_constant), &node->mesh->m_mesh_push_constant);
+    std::vector<GpuCullSlot> slots;
+    for (auto &mesh : m_meshes) {
+        for (auto &primitive : mesh->primitives) {
+            primitive->first_cull_slot = static_cast<u32>(slots.size());
+            for (u32 i = 0; i < mesh->instances.size(); i++) {
+                for (u32 m = primitive->first_meshlet; m < primitive->first_meshlet + primitive->meshlet_count; m++) {
+                    slots.push_back(GpuCullSlot{m, mesh->first_instance + i, m_meshlets[m].first_index,
+                                                m_meshlets[m].index_count});
+                }
             }
-            vkCmdDrawIndexed(command_buffer, primitive->indexCount, 1, primitive->firstIndex, 0, 0);
         }
     }
-    for (auto &child : node->m_children) {
-        DrawNode(child, pipeline, command_buffer);
+    m_cull_slot_count = static_cast<u32>(slots.size());
+    if (m_cull_slot_count == 0) {
+        return;
     }
+
+    m_meshlet_buffer = std::make_shared<StorageBuffer>(m_device);
+    m_meshlet_buffer->update(gpu_meshlets.data(), sizeof(GpuMeshlet) * gpu_meshlets.size());
+    m_cull_slot_buffer = std::make_shared<StorageBuffer>(m_device);
+    m_cull_slot_buffer->update(slots.data(), sizeof(GpuCullSlot) * slots.size());
+    std::vector<VkDrawIndexedIndirectCommand> draws(m_cull_slot_count, VkDrawIndexedIndirectCommand{});
+    m_indirect_buffer = std::make_shared<StorageBuffer>(m_device, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+    m_indirect_buffer->update(draws.data(), sizeof(VkDrawIndexedIndirectCommand) * draws.size());
+
+    // meshlets, cull slots, instance matrices, indirect draws
+    std::shared_ptr<DescriptorSetInfo> cullSetInfo = std::make_shared<DescriptorSetInfo>();
+    cullSetInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_COMPUTE_SHADER);
+    cullSetInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_COMPUTE_SHADER);
+    cullSetInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_COMPUTE_SHADER);
+    cullSetInfo->AddBinding(DescriptorType::DESCRIPTOR_TYPE_RW_BUFFER, SHADER_STAGE_COMPUTE_SHADER);
+    m_cull_descriptor_set = std::make_shared<DescriptorSet>(m_device, cullSetInfo);
+
+    LOG_DEBUG("{} meshlets, {} cull slots, meshlet buffers {} KB", m_meshlets.size(), m_cull_slot_count,
+              (m_meshlet_buffer->size() + m_cull_slot_buffer->size() + m_indirect_buffer->size()) / 1024);
 }
 
-void Model::UpdateDescriptors() noexcept {
-    for (auto &material : m_materials) {
-        material->UpdateDescriptorSet();
+void Model::RecordMeshletCulling(VkCommandBuffer command_buffer, Pipeline *pipeline,
+                                 MeshletCullParams params) const noexcept {
+    if (!m_cull_descriptor_set) {
+        return;
     }
+    params.slot_count = m_cull_slot_count;
+    VkDescriptorSet set = m_cull_descriptor_set->Get();
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->Get());
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetLayout(), 0, 1, &set, 0,
+                            nullptr);
+    vkCmdPushConstants(command_buffer, pipeline->GetLayout(), ToVkShaderStageFlags(SHADER_STAGE_COMPUTE_SHADER), 0,
+                       sizeof(MeshletCullParams), &params);
+    // the group count depends on the model, so this bypasses CommandBuffer::Dispatch
+    vkCmdDispatch(command_buffer, (m_cull_slot_count + MESHLET_CULL_GROUP_SIZE - 1) / MESHLET_CULL_GROUP_SIZE, 1, 1);
 }
 
-void Model::UpdateModelMatrix() noexcept {
-    for (auto &node : m_nodes) {
-        UpdateNodeModelMatrix(node);
+void Model::UpdateDescriptors(bool material_sets) noexcept {
+    if (material_sets) {
+        for (auto &material : m_materials) {
+            material->UpdateDescriptorSet();
+        }
+    }
+    DescriptorSetUpdateDesc desc;
+    desc.BindResource(0, m_instance_buffer);
+    m_instance_descriptor_set->UpdateDescriptorSet(desc);
+
+    if (m_cull_descriptor_set) {
+        DescriptorSetUpdateDesc cull_desc;
+        cull_desc.BindResource(0, m_meshlet_buffer);
+        cull_desc.BindResource(1, m_cull_slot_buffer);
+        cull_desc.BindResource(2, m_instance_buffer);
+        cull_desc.BindResource(3, m_indirect_buffer);
+        m_cull_descriptor_set->UpdateDescriptorSet(cull_desc);
     }
 }
 
-void Model::UpdateNodeModelMatrix(std::shared_ptr<Node> node) noexcept {
+void Model::UpdateModelMatrix() noexcept {
+    if (m_transform_version == m_transforms->GetVersion()) {
+        return;
+    }
 
-    // update model matrix for each node
-    if (node->mesh) {
-        node->update(m_model_matrix);
+    // only copy world matrices that changed since the last sync
+    bool changed = false;
+    for (auto &mesh : m_meshes) {
+        for (u32 i = 0; i < mesh->instances.size(); i++) {
+            u32 transform = mesh->instances[i];
+            if (m_transforms->GetWorldVersion(transform) > m_transform_version) {
+                m_instance_matrices[mesh->first_instance + i] = m_transforms->GetWorldMatrix(transform);
+                changed = true;
+            }
+        }
     }
-    for (auto &child : node->m_children) {
-        UpdateNodeModelMatrix(child);
+    if (changed &&
+        m_instance_buffer->update(m_instance_matrices.data(), sizeof(Math::mat4) * m_instance_matrices.size())) {
+        // the instance and cull sets still point at the destroyed buffer
+        UpdateDescriptors(false);
     }
+    m_transform_version = m_transforms->GetVersion();
 }
 
 //std::shared_ptr<DescriptorSet> Model::getMeshDescriptorSet()
@@ -432,7 +1453,17 @@ std::shared_ptr<DescriptorSet> Model::GetMaterialDescriptorSet() noexcept {
     return nullptr;
 }
 
-void Model::SetModelMatrix(const Math::mat4 &modelMatrix) noexcept { m_model_matrix = modelMatrix; }
+std::shared_ptr<DescriptorSet> Model::GetInstanceDescriptorSet() const noexcept { return m_instance_descriptor_set; }
+
+const std::vector<std::shared_ptr<Material>> &Model::GetMaterials() const noexcept { return m_materials; }
+
+std::shared_ptr<DescriptorSet> Model::GetMeshletCullDescriptorSet() const noexcept { return m_cull_descriptor_set; }
+
+std::shared_ptr<StorageBuffer> Model::GetIndirectBuffer() const noexcept { return m_indirect_buffer; }
+
+void Model::SetModelMatrix(const Math::mat4 &modelMatrix) noexcept {
+    m_transforms->SetLocalMatrix(m_root_transform, modelMatrix);
+}
 
 std::shared_ptr<DescriptorSet> Model::GetNodeMaterialDescriptorSet(std::shared_ptr<Node> node) noexcept {
     if (node->mesh) {
@@ -446,8 +1477,7 @@ std::shared_ptr<DescriptorSet> Model::GetNodeMaterialDescriptorSet(std::shared_p
     return nullptr;
 }
 
-Mesh::Mesh(std::shared_ptr<Device> device, Math::mat4 model) noexcept : m_device(device) {
-    m_mesh_push_constant.modelMatrix = model;
+Mesh::Mesh(std::shared_ptr<Device> device) noexcept : m_device(device) {
     //meshUb = std::make_shared<UniformBuffer>(m_device);
     //std::shared_ptr<DescriptorSetInfo> setInfo = std::make_shared<DescriptorSetInfo>();
     //setInfo->AddBinding(DESCRIPTOR_TYPE_UNIFORM_BUFFER, SHADER_STAGE_VERTEX_SHADER);
@@ -464,29 +1494,4 @@ Node::Node() noexcept {}
 
 Node::~Node() noexcept {}
 
-Math::mat4 Node::localMatrix() noexcept {
-    return Math::translate(Math::mat4(1.0f), translation) * Math::mat4_cast(rotation) *
-           Math::scale(Math::mat4(1.0f), scale) * matrix;
-}
-
-Math::mat4 Node::getMatrix() noexcept {
-    // local matrix
-    Math::mat4 m = localMatrix();
-    std::shared_ptr<Node> p = m_parent;
-    while (p) {
-        m = p->localMatrix() * m;
-        p = p->m_parent;
-    }
-    return m;
-}
-
-void Node::update(const Math::mat4 &modelMat) noexcept {
-    mesh->m_mesh_push_constant.modelMatrix = modelMat * getMatrix();
-    //mesh->meshUbStruct.model = modelMat * getMatrix();
-    //mesh->meshUb->update(&mesh->meshUbStruct, sizeof(mesh->meshUbStruct));
-
-    for (auto &child : m_children) {
-        child->update(modelMat);
-    }
-}
 } // namespace Horizon
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
 #include <vulkan/vulkan.hpp>
@@ -11,13 +12,26 @@
 #include <runtime/function/rhi/vulkan/Device.h>
 #include <runtime/function/rhi/vulkan/IndexBuffer.h>
 #include <runtime/function/rhi/vulkan/Pipeline.h>
+#include <runtime/function/rhi/vulkan/StorageBuffer.h>
 #include <runtime/function/rhi/vulkan/Texture.h>
 #include <runtime/function/rhi/vulkan/UniformBuffer.h>
 #include <runtime/function/rhi/vulkan/VertexBuffer.h>
 #include <runtime/scene/material/Material.h>
+#include <runtime/scene/material/TextureStreamer.h>
+#include <runtime/scene/model/ImageDecoder.h>
+#include <runtime/scene/model/MeshOptimizer.h>
+#include <runtime/scene/render/RenderQueue.h>
+#include <runtime/scene/scene/TransformHierarchy.h>
 
 namespace Horizon {
 
+struct PrimitiveLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    // object space distance to the full resolution surface
+    f32 error;
+};
+
 class MeshPrimitive {
   public:
     MeshPrimitive(uint32_t firstIndex, uint32_t indexCount, uint32_t vertexCount,
@@ -28,23 +42,36 @@ class MeshPrimitive {
     uint32_t firstIndex;
     uint32_t indexCount;
     uint32_t vertexCount;
+    uint32_t firstVertex = 0;
     bool hasIndices;
+    // object space bounds of the primitive's vertices, compressed positions are quantized against them
+    Math::vec3 bounds_min{0.0f};
+    Math::vec3 bounds_max{0.0f};
+    // uv distance per object space unit along the surface, averaged over the triangles. 0 without texture coordinates
+    f32 uv_density = 0.0f;
+    // lods[0] is the full index range, coarser levels follow in the shared index buffer
+    std::vector<PrimitiveLod> lods;
+    u32 current_lod = 0;
+    // meshlets of lods[0] in the model meshlet buffer, culled per instance into cull slots
+    // first_cull_slot + instance * meshlet_count + meshlet
+    u32 first_meshlet = 0;
+    u32 meshlet_count = 0;
+    u32 first_cull_slot = 0;
 };
 
 class Mesh {
   public:
-    Mesh(std::shared_ptr<Device> device, Math::mat4 model) noexcept;
+    Mesh(std::shared_ptr<Device> device) noexcept;
     ~Mesh() noexcept = default;
 
     std::shared_ptr<Device> m_device;
     ;
     std::vector<std::shared_ptr<MeshPrimitive>> primitives;
 
-    // 128 bytes push constant
-    struct MeshPushConstant {
-        Math::mat4 modelMatrix;
-        Math::mat4 padding;
-    } m_mesh_push_constant;
+    // transform of every node (or gpu instance) drawing this mesh, one instanced draw per primitive
+    std::vector<u32> instances;
+    // offset of this mesh's instances in the model instance buffer
+    u32 first_instance = 0;
 
     //std::shared_ptr<UniformBuffer> meshUb = nullptr;
     //std::shared_ptr<DescriptorSet> meshDescriptorSet = nullptr;
@@ -57,61 +84,156 @@ class Node {
     std::shared_ptr<Node> m_parent;
     uint32_t index;
     std::vector<std::shared_ptr<Node>> m_children;
-    Math::mat4 matrix;
     std::string name;
     std::shared_ptr<Mesh> mesh = nullptr;
     int32_t skinIndex = -1;
-    Math::vec3 translation{};
-    Math::vec3 scale{1.0f};
-    Math::quat rotation{};
-    Math::mat4 localMatrix() noexcept;
-    Math::mat4 getMatrix() noexcept;
-    void update(const Math::mat4 &modelMat) noexcept;
+    // index into the scene transform hierarchy
+    u32 transform_index = 0;
+};
+
+struct ModelLoadOptions {
+    VertexFormat vertex_format = VertexFormat::VERTEX_FORMAT_FULL;
+    // reorder indices for vertex cache and overdraw, then vertices for fetch locality
+    bool optimize_meshes = true;
+    // triangle ratio of each generated lod, empty disables lods
+    std::vector<f32> lod_ratios{0.5f, 0.25f, 0.125f};
+    // split large primitives into meshlets that are culled on the gpu, used at lod 0
+    bool build_meshlets = true;
+    // load the ktx2 source of KHR_texture_basisu textures when the device can take it, off forces the png fallback to
+    // compare memory and load times
+    bool compressed_textures = true;
+    // textures start with their coarse mips and stream finer ones as the view needs them, off keeps every level
+    // resident from load. does not change the cooked data
+    bool stream_textures = true;
+};
+
+// push constants of the meshlet culling pass, world space frustum planes pointing inwards
+struct MeshletCullParams {
+    Math::vec4 frustum_planes[6];
+    Math::vec4 camera_position;
+    u32 slot_count = 0;
 };
 
 class Model {
   public:
+    // local_size_x of meshlet_cull.comp, the cull pipeline is specialized to it
+    static constexpr u32 MESHLET_CULL_GROUP_SIZE = 64;
+
+    // a null texture_streamer loads every texture fully resident
     Model(const std::string &path, std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer,
-          std::shared_ptr<DescriptorSet> m_scene_descriptor_set) noexcept;
+          std::shared_ptr<DescriptorSet> m_scene_descriptor_set, std::shared_ptr<TransformHierarchy> transforms,
+          std::shared_ptr<TextureStreamer> texture_streamer, const ModelLoadOptions &options = {}) noexcept;
     ~Model() noexcept;
-    void Draw(std::shared_ptr<Pipeline> pipeline, VkCommandBuffer command_buffer) noexcept;
-    void LoadTextures(tinygltf::Model &gltfModel) noexcept;
+    // emit one sorted draw per primitive, depth and lod follow the nearest instance in view space.
+    // lod_scale converts object space error at unit distance into pixels. with meshlet_culling primitives at lod 0
+    // draw the indirect commands written by RecordMeshletCulling. streamed textures are requested at the texel density
+    // of the nearest instance in front of the camera. a material_table_set replaces the per material sets, draws then
+    // push Material::table_index instead
+    void Submit(RenderQueue &queue, Pipeline *pipeline, const Math::mat4 &view, const Math::vec2 &near_far,
+                f32 lod_scale, bool meshlet_culling, VkDescriptorSet material_table_set = VK_NULL_HANDLE) noexcept;
+    // write one indirect draw per cull slot, culled meshlets get zero instances. must be recorded outside a render
+    // pass and followed by a barrier on the indirect buffer
+    void RecordMeshletCulling(VkCommandBuffer command_buffer, Pipeline *pipeline,
+                              MeshletCullParams params) const noexcept;
+    // images still queued on decoder are collected right before their upload. returns the image each texture was
+    // created from, -1 for none
+    std::vector<i32> LoadTextures(tinygltf::Model &gltfModel, ImageDecoder *decoder = nullptr,
+                                  bool compressed_textures = true) noexcept;
     void LoadMaterials(tinygltf::Model &gltfModel) noexcept;
     void LoadNode(std::shared_ptr<Node> m_parent, const tinygltf::Node &node, uint32_t nodeIndex,
                   const tinygltf::Model &model, std::vector<u32> &indexBuffer, std::vector<Vertex> &vertexBuffer,
                   f32 globalscale) noexcept;
-    void DrawNode(std::shared_ptr<Node> node, std::shared_ptr<Pipeline> pipeline,
-                  VkCommandBuffer command_buffer) noexcept;
-    void UpdateDescriptors() noexcept;
+    std::shared_ptr<Mesh> LoadMesh(i32 meshIndex, const tinygltf::Model &model, std::vector<u32> &indices,
+                                   std::vector<Vertex> &vertices) noexcept;
+    void LoadGpuInstances(const tinygltf::Node &node, const tinygltf::Model &model, u32 parentTransform,
+                          std::vector<u32> &instances) noexcept;
+    // material sets are left alone while the scene draws through its material table
+    void UpdateDescriptors(bool material_sets = true) noexcept;
+    // copies the world matrices the last TransformHierarchy::Update changed into the instance buffer, the scene
+    // updates the shared hierarchy once per frame before its models sync
     void UpdateModelMatrix() noexcept;
     //std::shared_ptr<DescriptorSet> getMeshDescriptorSet();
     std::shared_ptr<DescriptorSet> GetMaterialDescriptorSet() noexcept;
+    std::shared_ptr<DescriptorSet> GetInstanceDescriptorSet() const noexcept;
+    const std::vector<std::shared_ptr<Material>> &GetMaterials() const noexcept;
+    // null if no primitive was split into meshlets
+    std::shared_ptr<DescriptorSet> GetMeshletCullDescriptorSet() const noexcept;
+    std::shared_ptr<StorageBuffer> GetIndirectBuffer() const noexcept;
     void SetModelMatrix(const Math::mat4 &modelMatrix) noexcept;
 
   private:
-    void UpdateNodeModelMatrix(std::shared_ptr<Node> node) noexcept;
     //void updateNodeDescriptorSet(std::shared_ptr<Node> node);
     //std::shared_ptr<DescriptorSet> getNodeMeshDescriptorSet(std::shared_ptr<Node> node);
     std::shared_ptr<DescriptorSet> GetNodeMaterialDescriptorSet(std::shared_ptr<Node> node) noexcept;
+    bool LoadSource(const std::string &path, const ModelLoadOptions &options, const std::string &cooked_path,
+                    u64 source_hash) noexcept;
+    bool LoadCooked(const std::string &cooked_path, u64 source_hash) noexcept;
+    void WriteCooked(const std::string &cooked_path, u64 source_hash, const tinygltf::Model &gltf_model,
+                     const std::vector<i32> &texture_images, const void *vertices) const noexcept;
+    // through the texture streamer when there is one
+    std::shared_ptr<Texture> CreateTexture(VkFormat format, const u8 *levels, u32 width, u32 height,
+                                           u32 mip_count) noexcept;
+    // null if the image failed to decode or its format cannot be loaded
+    std::shared_ptr<Texture> LoadImageTexture(tinygltf::Model &gltfModel, i32 image_index, ImageDecoder *decoder,
+                                              bool srgb) noexcept;
+    void LoadEmptyTexture() noexcept;
+    // vram of every material's textures next to what they take as rgba8 with mips, the png path
+    void LogTextureMemory(const std::string &path) const noexcept;
+    std::shared_ptr<Material> CreateMaterial(i32 base_color_texture, i32 normal_texture,
+                                             i32 metallic_roughness_texture) noexcept;
+    u32 GetVertexStride() const noexcept;
+    std::vector<CompressedVertex> CompressVertices() const noexcept;
+    void OptimizeMeshes(const std::string &path) noexcept;
+    void GenerateLods(const std::string &path, const std::vector<f32> &ratios) noexcept;
+    void BuildMeshlets(const std::string &path) noexcept;
+    void CreateMeshletBuffers() noexcept;
 
   private:
     std::shared_ptr<Device> m_device;
     std::shared_ptr<CommandBuffer> m_command_buffer;
+    std::shared_ptr<TextureStreamer> m_texture_streamer;
 
     std::shared_ptr<DescriptorSet> m_scene_descriptor_set;
 
-    Math::mat4 m_model_matrix = Math::mat4(1.0);
-
+    // node transforms live in the scene hierarchy, the root node carries the model matrix
+    std::shared_ptr<TransformHierarchy> m_transforms;
+    u32 m_root_transform = 0;
+    u64 m_transform_version = 0;
+
+    // unique meshes keyed by gltf mesh index, nodes referencing the same mesh become instances of it
+    std::unordered_map<i32, std::shared_ptr<Mesh>> m_mesh_cache;
+    std::vector<std::shared_ptr<Mesh>> m_meshes;
+
+    // per instance world matrices, indexed by gl_InstanceIndex in the vertex shader
+    std::vector<Math::mat4> m_instance_matrices;
+    std::shared_ptr<StorageBuffer> m_instance_buffer = nullptr;
+    std::shared_ptr<DescriptorSet> m_instance_descriptor_set = nullptr;
+
+    // meshlet bounds, cull slots and the indirect draws written by the culling pass
+    std::vector<MeshOptimizer::Meshlet> m_meshlets;
+    u32 m_cull_slot_count = 0;
+    std::shared_ptr<StorageBuffer> m_meshlet_buffer = nullptr;
+    std::shared_ptr<StorageBuffer> m_cull_slot_buffer = nullptr;
+    std::shared_ptr<StorageBuffer> m_indirect_buffer = nullptr;
+    std::shared_ptr<DescriptorSet> m_cull_descriptor_set = nullptr;
+
+    VertexFormat m_vertex_format = VertexFormat::VERTEX_FORMAT_FULL;
     std::shared_ptr<VertexBuffer> m_vertex_buffer = nullptr;
     std::shared_ptr<IndexBuffer> m_index_buffer = nullptr;
 
     std::vector<Vertex> m_vertices;
     std::vector<u32> m_indices;
+    // base address of every gltf buffer while loading, glb buffers point into the mapped file
+    std::vector<const u8 *> m_buffer_data;
 
     std::vector<std::shared_ptr<Node>> m_nodes;
     std::vector<std::shared_ptr<Node>> m_linear_nodes;
 
     std::vector<std::shared_ptr<Texture>> m_textures;
+    // upload time of each texture's image, for the load report
+    std::vector<f64> m_texture_load_ms;
+    // gltf sampler of each texture from the device's sampler cache
+    std::vector<VkSampler> m_texture_samplers;
     std::vector<std::shared_ptr<Material>> m_materials;
 
     // TODO: empty texture only need to create once
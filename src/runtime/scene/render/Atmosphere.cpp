@@ -1,12 +1,39 @@
 #include "Atmosphere.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <tuple>
+
+#include <runtime/core/hash/Hash.h>
 #include <runtime/core/path/Path.h>
 #include <runtime/function/rhi/RenderContext.h>
+#include <runtime/function/rhi/vulkan/ResourceBarrier.h>
+#include <runtime/function/rhi/vulkan/ShaderCompiler.h>
 #include <runtime/function/rhi/vulkan/VulkanEnums.h>
 
 namespace Horizon {
+
+static std::vector<u16> ToHalf(const std::vector<f32> &texels) noexcept {
+    std::vector<u16> half(texels.size());
+    for (u64 i = 0; i < texels.size(); i++) {
+        half[i] = Math::packHalf1x16(texels[i]);
+    }
+    return half;
+}
+
+// the lut kernels, a change of any of them or their includes invalidates the lut cache
+static const char *const PRECOMPUTE_SHADERS[] = {
+    "atmosphere/transmittance_lut.comp",       "atmosphere/direct_irradiance_lut.comp",
+    "atmosphere/single_scattering_lut.comp",   "atmosphere/scattering_density.comp",
+    "atmosphere/indirect_irradiance_lut.comp", "atmosphere/multi_scattering_lut.comp"};
+
 Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::shared_ptr<Device> _device,
-                       std::shared_ptr<CommandBuffer> command_buffer, RenderContext &_render_context) noexcept {
+                       std::shared_ptr<CommandBuffer> command_buffer, RenderContext &_render_context,
+                       const AtmosphereParameters &parameters, u32 multi_scattering_order) noexcept
+    : m_multi_scattering_order(multi_scattering_order), m_device(_device), m_command_buffer(command_buffer),
+      m_parameters(parameters), m_lut_size(GetAtmosphereLutSize(_render_context.atmosphere_quality)),
+      m_step_budget(_render_context.atmosphere_step_budget) {
 
     CreateResources(_device, command_buffer);
 
@@ -15,11 +42,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo transmittance_lut_create_info;
     transmittance_lut_create_info.name = "transmittance_lut";
     transmittance_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/transmittance_lut.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/transmittance_lut.comp"});
+    transmittance_lut_create_info.cs_specialization = GetSpecializationConstants(2);
     transmittance_lut_create_info.descriptor_layouts = transmittance_lut_descriptor_set_layouts;
-    transmittance_lut_create_info.group_count_x = 256 / 8;
-    transmittance_lut_create_info.group_count_y = 64 / 8;
+    transmittance_lut_create_info.group_count_x = m_lut_size.transmittance_width / LUT_GROUP_SIZE_2D;
+    transmittance_lut_create_info.group_count_y = m_lut_size.transmittance_height / LUT_GROUP_SIZE_2D;
     transmittance_lut_create_info.group_count_z = 1;
+    transmittance_lut_create_info.dispatch_base = true;
 
     m_transmittance_lut_pass = _pipeline_manager->CreateComputePipeline(transmittance_lut_create_info);
 
@@ -28,11 +57,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo direct_irradiance_lut_create_info;
     direct_irradiance_lut_create_info.name = "direct_irradiance_lut";
     direct_irradiance_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/direct_irradiance_lut.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/direct_irradiance_lut.comp"});
+    direct_irradiance_lut_create_info.cs_specialization = GetSpecializationConstants(2);
     direct_irradiance_lut_create_info.descriptor_layouts = direct_irradiance_lut_descriptor_set_layouts;
-    direct_irradiance_lut_create_info.group_count_x = 64 / 8;
-    direct_irradiance_lut_create_info.group_count_y = 16 / 8;
+    direct_irradiance_lut_create_info.group_count_x = m_lut_size.irradiance_width / LUT_GROUP_SIZE_2D;
+    direct_irradiance_lut_create_info.group_count_y = m_lut_size.irradiance_height / LUT_GROUP_SIZE_2D;
     direct_irradiance_lut_create_info.group_count_z = 1;
+    direct_irradiance_lut_create_info.dispatch_base = true;
 
     m_direct_irradiance_lut_pass = _pipeline_manager->CreateComputePipeline(direct_irradiance_lut_create_info);
 
@@ -41,11 +72,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo single_scattering_lut_create_info;
     single_scattering_lut_create_info.name = "single_scattering_lut";
     single_scattering_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/single_scattering_lut.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/single_scattering_lut.comp"});
+    single_scattering_lut_create_info.cs_specialization = GetSpecializationConstants(3);
     single_scattering_lut_create_info.descriptor_layouts = single_scattering_lut_descriptor_set_layouts;
-    single_scattering_lut_create_info.group_count_x = 256 / 4;
-    single_scattering_lut_create_info.group_count_y = 128 / 4;
-    single_scattering_lut_create_info.group_count_z = 32 / 4;
+    single_scattering_lut_create_info.group_count_x = m_lut_size.GetScatteringWidth() / LUT_GROUP_SIZE_3D;
+    single_scattering_lut_create_info.group_count_y = m_lut_size.GetScatteringHeight() / LUT_GROUP_SIZE_3D;
+    single_scattering_lut_create_info.group_count_z = m_lut_size.GetScatteringDepth() / LUT_GROUP_SIZE_3D;
+    single_scattering_lut_create_info.dispatch_base = true;
 
     m_single_scattering_lut_pass = _pipeline_manager->CreateComputePipeline(single_scattering_lut_create_info);
 
@@ -54,11 +87,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo scattering_density_lut_create_info;
     scattering_density_lut_create_info.name = "scattering_density_lut";
     scattering_density_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/scattering_density.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/scattering_density.comp"});
+    scattering_density_lut_create_info.cs_specialization = GetSpecializationConstants(3);
     scattering_density_lut_create_info.descriptor_layouts = scattering_density_lut_descriptor_set_layouts;
-    scattering_density_lut_create_info.group_count_x = 256 / 4;
-    scattering_density_lut_create_info.group_count_y = 128 / 4;
-    scattering_density_lut_create_info.group_count_z = 32 / 4;
+    scattering_density_lut_create_info.group_count_x = m_lut_size.GetScatteringWidth() / LUT_GROUP_SIZE_3D;
+    scattering_density_lut_create_info.group_count_y = m_lut_size.GetScatteringHeight() / LUT_GROUP_SIZE_3D;
+    scattering_density_lut_create_info.group_count_z = m_lut_size.GetScatteringDepth() / LUT_GROUP_SIZE_3D;
+    scattering_density_lut_create_info.dispatch_base = true;
     scattering_density_lut_create_info.push_constants = scattering_order_push_constants;
 
     m_scattering_density_lut = _pipeline_manager->CreateComputePipeline(scattering_density_lut_create_info);
@@ -68,11 +103,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo indirect_irradiance_lut_create_info;
     indirect_irradiance_lut_create_info.name = "indirect_irradiance_lut";
     indirect_irradiance_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/indirect_irradiance_lut.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/indirect_irradiance_lut.comp"});
+    indirect_irradiance_lut_create_info.cs_specialization = GetSpecializationConstants(2);
     indirect_irradiance_lut_create_info.descriptor_layouts = indirect_irradiance_lut_descriptor_set_layouts;
-    indirect_irradiance_lut_create_info.group_count_x = 64 / 8;
-    indirect_irradiance_lut_create_info.group_count_y = 16 / 8;
+    indirect_irradiance_lut_create_info.group_count_x = m_lut_size.irradiance_width / LUT_GROUP_SIZE_2D;
+    indirect_irradiance_lut_create_info.group_count_y = m_lut_size.irradiance_height / LUT_GROUP_SIZE_2D;
     indirect_irradiance_lut_create_info.group_count_z = 1;
+    indirect_irradiance_lut_create_info.dispatch_base = true;
     indirect_irradiance_lut_create_info.push_constants = scattering_order_push_constants;
     m_indirect_irradiance_lut = _pipeline_manager->CreateComputePipeline(indirect_irradiance_lut_create_info);
 
@@ -81,11 +118,13 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     ComputePipelineCreateInfo multi_scattering_lut_create_info;
     multi_scattering_lut_create_info.name = "multi_scattering_lut";
     multi_scattering_lut_create_info.cs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/multi_scattering_lut.comp.spv"));
+        std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/multi_scattering_lut.comp"});
+    multi_scattering_lut_create_info.cs_specialization = GetSpecializationConstants(3);
     multi_scattering_lut_create_info.descriptor_layouts = multi_scattering_lut_descriptor_set_layouts;
-    multi_scattering_lut_create_info.group_count_x = 256 / 4;
-    multi_scattering_lut_create_info.group_count_y = 128 / 4;
-    multi_scattering_lut_create_info.group_count_z = 32 / 4;
+    multi_scattering_lut_create_info.group_count_x = m_lut_size.GetScatteringWidth() / LUT_GROUP_SIZE_3D;
+    multi_scattering_lut_create_info.group_count_y = m_lut_size.GetScatteringHeight() / LUT_GROUP_SIZE_3D;
+    multi_scattering_lut_create_info.group_count_z = m_lut_size.GetScatteringDepth() / LUT_GROUP_SIZE_3D;
+    multi_scattering_lut_create_info.dispatch_base = true;
 
     m_multi_scattering_lut = _pipeline_manager->CreateComputePipeline(multi_scattering_lut_create_info);
 
@@ -93,7 +132,7 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
 
     //ComputePipelineCreateInfo camera_volume_create_info;
     //camera_volume_create_info.name = "camera_volume";
-    //camera_volume_create_info.cs = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/camera_volume.comp.spv"));
+    //camera_volume_create_info.cs = std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/camera_volume.comp"});
     //camera_volume_create_info.descriptor_layouts = camera_volume_descriptor_set_layouts;
     //camera_volume_create_info.group_count_x = 256 / 4;
     //camera_volume_create_info.group_count_y = 128 / 4;
@@ -105,10 +144,9 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
 
     GraphicsPipelineCreateInfo sky_pipeline_create_info;
     sky_pipeline_create_info.name = "scatter";
-    sky_pipeline_create_info.vs =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/scatter.vert.spv"));
-    sky_pipeline_create_info.ps =
-        std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("atmosphere/scatter.frag.spv"));
+    sky_pipeline_create_info.vs = std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/scatter.vert"});
+    sky_pipeline_create_info.ps = std::make_shared<Shader>(_device->Get(), ShaderSource{"atmosphere/scatter.frag"});
+    sky_pipeline_create_info.ps_specialization = GetSpecializationConstants();
     sky_pipeline_create_info.descriptor_layouts = sky_descriptor_set_layout;
 
     std::vector<AttachmentCreateInfo> sky_attachments_create_info{{TextureFormat::TEXTURE_FORMAT_RGBA16_UNORM,
@@ -122,7 +160,125 @@ Atmosphere::Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::
     m_sky_ubdata.resolution = Math::vec2(_render_context.width, _render_context.height);
 }
 
-Atmosphere::~Atmosphere() noexcept {}
+Atmosphere::~Atmosphere() noexcept {
+    WaitForRecompute();
+    if (m_step_fence != VK_NULL_HANDLE) {
+        vkDestroyFence(m_device->Get(), m_step_fence, nullptr);
+        vkFreeCommandBuffers(m_device->Get(), m_command_buffer->getCommandpool(), 1, &m_step_command_buffer);
+    }
+}
+
+Atmosphere::LutSet Atmosphere::CreateLutSet() const noexcept {
+    TextureCreateInfo transmittance_create_info{TextureType::TEXTURE_TYPE_2D,
+                                                LUT_FORMAT,
+                                                TextureUsage::TEXTURE_USAGE_RW,
+                                                m_lut_size.transmittance_width,
+                                                m_lut_size.transmittance_height,
+                                                1};
+    TextureCreateInfo irradiance_create_info{TextureType::TEXTURE_TYPE_2D,
+                                             LUT_FORMAT,
+                                             TextureUsage::TEXTURE_USAGE_RW,
+                                             m_lut_size.irradiance_width,
+                                             m_lut_size.irradiance_height,
+                                             1};
+    TextureCreateInfo scattering_create_info{TextureType::TEXTURE_TYPE_3D,
+                                             LUT_FORMAT,
+                                             TextureUsage::TEXTURE_USAGE_RW,
+                                             m_lut_size.GetScatteringWidth(),
+                                             m_lut_size.GetScatteringHeight(),
+                                             m_lut_size.GetScatteringDepth()};
+
+    LutSet luts;
+    luts.transmittance = std::make_shared<Texture>(m_device, m_command_buffer, transmittance_create_info);
+    luts.irradiance = std::make_shared<Texture>(m_device, m_command_buffer, irradiance_create_info);
+    luts.scattering = std::make_shared<Texture>(m_device, m_command_buffer, scattering_create_info);
+    luts.parameters = std::make_shared<UniformBuffer>(m_device);
+    WriteParameters(*luts.parameters);
+    luts.key = GetCacheKey();
+    return luts;
+}
+
+void Atmosphere::WriteParameters(UniformBuffer &parameters) const noexcept {
+    ParametersUb ub{};
+    ub.bottom_radius = m_parameters.bottom_radius;
+    ub.top_radius = m_parameters.top_radius;
+    ub.mie_g = m_parameters.mie_g;
+    ub.sun_angular_radius = m_parameters.sun_angular_radius;
+    ub.solar_irradiance = m_parameters.solar_irradiance;
+    ub.mu_s_min = m_parameters.mu_s_min;
+    ub.rayleigh_scattering = m_parameters.rayleigh_scattering;
+    ub.mie_scattering = m_parameters.mie_scattering;
+    ub.mie_extinction = m_parameters.mie_extinction;
+    ub.absorption_extinction = m_parameters.absorption_extinction;
+    ub.ground_albedo = m_parameters.ground_albedo;
+    const DensityProfile *profiles[] = {&m_parameters.rayleigh_density, &m_parameters.mie_density,
+                                        &m_parameters.absorption_density};
+    for (u32 i = 0; i < 6; i++) {
+        const DensityProfileLayer &layer = profiles[i / 2]->layers[i % 2];
+        ub.density_layers[2 * i] = Math::vec4(layer.width, layer.exp_term, layer.exp_scale, layer.linear_term);
+        ub.density_layers[2 * i + 1] = Math::vec4(layer.constant_term, 0.0f, 0.0f, 0.0f);
+    }
+    parameters.update(&ub, sizeof(ParametersUb));
+}
+
+void Atmosphere::CreatePrecomputeTextures() noexcept {
+    TextureCreateInfo transmittance_create_info{TextureType::TEXTURE_TYPE_2D,
+                                                TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
+                                                TextureUsage::TEXTURE_USAGE_RW,
+                                                m_lut_size.transmittance_width,
+                                                m_lut_size.transmittance_height,
+                                                1};
+    TextureCreateInfo irradiance_create_info{TextureType::TEXTURE_TYPE_2D,
+                                             TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
+                                             TextureUsage::TEXTURE_USAGE_RW,
+                                             m_lut_size.irradiance_width,
+                                             m_lut_size.irradiance_height,
+                                             1};
+    TextureCreateInfo scattering_create_info{TextureType::TEXTURE_TYPE_3D,
+                                             TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
+                                             TextureUsage::TEXTURE_USAGE_RW,
+                                             m_lut_size.GetScatteringWidth(),
+                                             m_lut_size.GetScatteringHeight(),
+                                             m_lut_size.GetScatteringDepth()};
+
+    transmittance_lut = std::make_shared<Texture>(m_device, m_command_buffer, transmittance_create_info);
+    direct_irradiance_lut = std::make_shared<Texture>(m_device, m_command_buffer, irradiance_create_info);
+    _irradiance_tex = std::make_shared<Texture>(m_device, m_command_buffer, irradiance_create_info);
+    single_rayleigh_scattering_lut = std::make_shared<Texture>(m_device, m_command_buffer, scattering_create_info);
+    single_mie_scattering_lut = std::make_shared<Texture>(m_device, m_command_buffer, scattering_create_info);
+    _scattering_tex = std::make_shared<Texture>(m_device, m_command_buffer, scattering_create_info);
+    scattering_density_lut = std::make_shared<Texture>(m_device, m_command_buffer, scattering_create_info);
+    multi_scattering_lut = single_rayleigh_scattering_lut;
+}
+
+void Atmosphere::ReleasePrecomputeTextures() noexcept {
+    // the lut descriptor sets still point at them, they are rewritten before the next precomputation
+    transmittance_lut = nullptr;
+    direct_irradiance_lut = nullptr;
+    _irradiance_tex = nullptr;
+    single_rayleigh_scattering_lut = nullptr;
+    single_mie_scattering_lut = nullptr;
+    _scattering_tex = nullptr;
+    scattering_density_lut = nullptr;
+    multi_scattering_lut = nullptr;
+}
+
+u64 Atmosphere::GetMemorySize() const noexcept {
+    u64 size = 0;
+    // multi_scattering_lut is single_rayleigh_scattering_lut
+    for (const std::shared_ptr<Texture> &texture :
+         {transmittance_lut, direct_irradiance_lut, _irradiance_tex, single_rayleigh_scattering_lut,
+          single_mie_scattering_lut, _scattering_tex, scattering_density_lut, m_luts.transmittance, m_luts.irradiance,
+          m_luts.scattering, m_pending_luts.transmittance, m_pending_luts.irradiance, m_pending_luts.scattering,
+          m_retired_luts.transmittance, m_retired_luts.irradiance, m_retired_luts.scattering}) {
+        if (texture) {
+            size += texture->GetMemorySize();
+        }
+    }
+    return size;
+}
+
+void Atmosphere::SetResolution(u32 width, u32 height) noexcept { m_sky_ubdata.resolution = Math::vec2(width, height); }
 
 void Atmosphere::SetCameraParams(Math::mat4 inv_view_projection, Math::vec3 camera_pos) noexcept {
     m_sky_ubdata.inv_view_projection_matrix = inv_view_projection;
@@ -131,69 +287,594 @@ void Atmosphere::SetCameraParams(Math::mat4 inv_view_projection, Math::vec3 came
 }
 
 void Atmosphere::UpdateDescriptorSets() noexcept {
-    if (!precomputed) {
-        // tramsmittance lut
-        m_transmittance_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
-        m_transmittance_lut_descriptor_set->UpdateDescriptorSet(m_transmittance_lut_descriptor_set_update_desc);
+    // render sky
 
-        // direct irradiance lut
-        m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
-        m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(1, direct_irradiance_lut);
-        m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(2, _irradiance_tex);
-        m_direct_irradiance_lut_descriptor_set->UpdateDescriptorSet(m_direct_irradiance_lut_descriptor_set_update_desc);
+    m_sky_descriptor_set_update_desc.BindResource(0, m_sky_ub);
+    m_sky_descriptor_set_update_desc.BindResource(1, m_luts.transmittance);
+    m_sky_descriptor_set_update_desc.BindResource(2, m_luts.scattering);
+    m_sky_descriptor_set->UpdateDescriptorSet(m_sky_descriptor_set_update_desc);
 
-        // single scattering lut
+    DescriptorSetUpdateDesc parameters_update_desc;
+    parameters_update_desc.BindResource(0, m_luts.parameters);
+    m_sky_parameters_descriptor_set->UpdateDescriptorSet(parameters_update_desc);
+}
 
-        //m_single_scattering_lut_ubdata.luminance_from_radiance = Math::mat3(1.0);
-        //m_single_scattering_lut_ubdata.layer = 0;
-        //m_single_scattering_lut_ub->update(&m_single_scattering_lut_ubdata,sizeof(m_single_scattering_lut_ubdata));
+void Atmosphere::Precompute(bool use_cache, AtmosphereLuts *computed_luts) noexcept {
+    // a recompute in flight is dropped
+    WaitForRecompute();
+    m_recompute_stage = RecomputeStage::NONE;
+    m_pending_luts = {};
+    ReleasePrecomputeTextures();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string cache_path = GetCachePath();
+    u64 key = GetCacheKey();
+    AtmosphereLuts luts = GetLutExtents(m_lut_size);
+    m_luts = {};
+    m_luts = CreateLutSet();
+    if (use_cache && AtmosphereLutCache::Load(cache_path, key, luts)) {
+        LOG_INFO("atmosphere luts loaded from {} in {} ms", cache_path,
+                 std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+    } else {
+        // the passes accumulate in rgba32f, their outputs are narrowed once at the end
+        CreatePrecomputeTextures();
+        UpdateLutDescriptorSets(m_luts);
+        VkCommandBuffer command_buffer = m_command_buffer->beginSingleTimeCommands();
+        RecordPrecompute(command_buffer);
+        m_command_buffer->endSingleTimeCommands(command_buffer);
+        LOG_INFO("atmosphere luts computed in {} ms, {} MB during precomputation",
+                 std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                 GetMemorySize() >> 20);
+
+        luts.Allocate();
+        transmittance_lut->ReadTexels(luts.transmittance.data(), sizeof(f32) * luts.transmittance.size());
+        _irradiance_tex->ReadTexels(luts.irradiance.data(), sizeof(f32) * luts.irradiance.size());
+        _scattering_tex->ReadTexels(luts.scattering.data(), sizeof(f32) * luts.scattering.size());
+        ReleasePrecomputeTextures();
+        if (use_cache && AtmosphereLutCache::Save(cache_path, key, luts)) {
+            LOG_INFO("atmosphere luts cached in {}", cache_path);
+        }
+    }
 
-        m_single_scattering_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
-        //m_single_scattering_lut_descriptor_set_update_desc.BindResource(1, m_single_scattering_lut_ub);
-        m_single_scattering_lut_descriptor_set_update_desc.BindResource(1, single_rayleigh_scattering_lut);
-        m_single_scattering_lut_descriptor_set_update_desc.BindResource(2, single_mie_scattering_lut);
-        m_single_scattering_lut_descriptor_set_update_desc.BindResource(3, _scattering_tex);
+    m_luts.transmittance->WriteTexels(ToHalf(luts.transmittance).data(), sizeof(u16) * luts.transmittance.size());
+    m_luts.irradiance->WriteTexels(ToHalf(luts.irradiance).data(), sizeof(u16) * luts.irradiance.size());
+    m_luts.scattering->WriteTexels(ToHalf(luts.scattering).data(), sizeof(u16) * luts.scattering.size());
+    precomputed = true;
+    LOG_INFO("atmosphere luts resident in {} KB", GetMemorySize() >> 10);
+    if (computed_luts) {
+        *computed_luts = std::move(luts);
+    }
+}
 
-        m_single_scattering_lut_descriptor_set->UpdateDescriptorSet(m_single_scattering_lut_descriptor_set_update_desc);
+void Atmosphere::RequestRecompute(const AtmosphereParameters &parameters, u32 multi_scattering_order) noexcept {
+    if (!IsRecomputing() && m_luts.transmittance &&
+        GetCacheKey(parameters, multi_scattering_order, m_lut_size) == m_luts.key) {
+        return;
+    }
+    // the descriptor sets and textures of a running recompute are reused, its last step has to finish first
+    WaitForRecompute();
+    m_parameters = parameters;
+    m_multi_scattering_order = multi_scattering_order;
+
+    if (m_step_fence == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandPool = m_command_buffer->getCommandpool();
+        alloc_info.commandBufferCount = 1;
+        CHECK_VK_RESULT(vkAllocateCommandBuffers(m_device->Get(), &alloc_info, &m_step_command_buffer));
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        CHECK_VK_RESULT(vkCreateFence(m_device->Get(), &fence_info, nullptr, &m_step_fence));
+        m_step_timer = std::make_shared<GpuTimer>(m_device, 1);
+    }
+    if (!transmittance_lut) {
+        CreatePrecomputeTextures();
+    }
+    if (!m_pending_luts.transmittance) {
+        m_pending_luts = CreateLutSet();
+    } else {
+        WriteParameters(*m_pending_luts.parameters);
+        m_pending_luts.key = GetCacheKey();
+    }
+    UpdateLutDescriptorSets(m_pending_luts);
+
+    // the same passes as RecordPrecompute
+    m_recompute_passes.clear();
+    m_recompute_passes.push_back({m_transmittance_lut_pass, m_transmittance_lut_descriptor_set, 0, 0});
+    m_recompute_passes.push_back({m_direct_irradiance_lut_pass, m_direct_irradiance_lut_descriptor_set, 0, 1});
+    m_recompute_passes.push_back({m_single_scattering_lut_pass, m_single_scattering_lut_descriptor_set, 0, 2});
+    for (u32 j = 0; j < m_multi_scattering_order; j++) {
+        i32 order = static_cast<i32>(j);
+        m_recompute_passes.push_back({m_scattering_density_lut, m_scattering_density_lut_descriptor_set, order + 2, 3});
+        m_recompute_passes.push_back(
+            {m_indirect_irradiance_lut, m_indirect_irradiance_lut_descriptor_set, order + 1, 4});
+        m_recompute_passes.push_back({m_multi_scattering_lut, m_multi_scattering_lut_descriptor_set, order + 2, 5});
+    }
+    m_recompute_pass = 0;
+    m_recompute_row = 0;
+    m_recompute_steps = 0;
+    m_recompute_start = std::chrono::steady_clock::now();
+    m_recompute_stage = RecomputeStage::PASSES;
+}
 
-        // SCATTERING DENSITY LUT
+bool Atmosphere::IsRecomputing() const noexcept {
+    return m_recompute_stage == RecomputeStage::PASSES || m_recompute_stage == RecomputeStage::COPY;
+}
 
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(1, single_rayleigh_scattering_lut);
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(2, single_mie_scattering_lut);
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(3, multi_scattering_lut);
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(4, direct_irradiance_lut);
-        m_scattering_density_lut_descriptor_set_update_desc.BindResource(5, scattering_density_lut);
+void Atmosphere::OnPipelinesRebuilt(const std::vector<std::shared_ptr<Pipeline>> &pipelines) noexcept {
+    for (const std::shared_ptr<Pipeline> &pipeline : pipelines) {
+        for (const std::shared_ptr<Pipeline> &lut_pass :
+             {m_transmittance_lut_pass, m_direct_irradiance_lut_pass, m_single_scattering_lut_pass,
+              m_scattering_density_lut, m_indirect_irradiance_lut, m_multi_scattering_lut}) {
+            if (pipeline == lut_pass) {
+                RequestRecompute(m_parameters, m_multi_scattering_order);
+                return;
+            }
+        }
+    }
+}
 
-        m_scattering_density_lut_descriptor_set->UpdateDescriptorSet(
-            m_scattering_density_lut_descriptor_set_update_desc);
+void Atmosphere::Update() noexcept {
+    if (m_step_submitted) {
+        if (vkGetFenceStatus(m_device->Get(), m_step_fence) != VK_SUCCESS) {
+            return;
+        }
+        FinishRecomputeStep();
+    }
+    if (m_recompute_stage == RecomputeStage::PASSES) {
+        if (m_recompute_pass < m_recompute_passes.size()) {
+            RecordRecomputeRows(m_step_command_buffer);
+        } else {
+            RecordRecomputeCopy(m_step_command_buffer);
+        }
+    }
+}
 
-        // indirect irradiance
+void Atmosphere::RecordRecomputeRows(VkCommandBuffer command_buffer) noexcept {
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    // the previous step wrote the inputs of this one
+    RecordPrecomputeBarrier(command_buffer, false);
+    m_step_timer->Begin(0, command_buffer);
+
+    const RecomputePass &pass = m_recompute_passes[m_recompute_pass];
+    std::shared_ptr<ComputePipeline> pipeline = std::static_pointer_cast<ComputePipeline>(pass.pipeline);
+    u32 group_count_y = pipeline->GroupCountY();
+    u32 row_count = group_count_y * pipeline->GroupCountZ();
+    // one row until the pass kind was timed, a slice of the scattering luts without timestamps
+    u32 rows = 1;
+    if (!m_step_timer->IsSupported()) {
+        rows = group_count_y;
+    } else if (m_row_time[pass.kind] > 0.0) {
+        rows = std::max(1u, static_cast<u32>(static_cast<f64>(m_step_budget) / m_row_time[pass.kind]));
+    }
+    u32 begin = m_recompute_row;
+    u32 end = std::min(row_count, begin + rows);
+
+    // whole slices in one dispatch, partial ones at either end
+    m_scattering_order = pass.scattering_order;
+    std::vector<std::shared_ptr<DescriptorSet>> descriptor_sets{pass.descriptor_set, m_lut_parameters_descriptor_set};
+    for (u32 row = begin; row < end;) {
+        u32 y = row % group_count_y;
+        u32 z = row / group_count_y;
+        if (y == 0 && end - row >= group_count_y) {
+            u32 slices = (end - row) / group_count_y;
+            m_command_buffer->DispatchBase(command_buffer, pass.pipeline, descriptor_sets, 0, group_count_y, z, slices);
+            row += slices * group_count_y;
+        } else {
+            u32 count = std::min(group_count_y - y, end - row);
+            m_command_buffer->DispatchBase(command_buffer, pass.pipeline, descriptor_sets, y, count, z, 1);
+            row += count;
+        }
+    }
+    m_step_timer->End(0, command_buffer);
+    vkEndCommandBuffer(command_buffer);
+
+    m_step_kind = pass.kind;
+    m_step_rows = end - begin;
+    m_recompute_row = end;
+    if (m_recompute_row == row_count) {
+        m_recompute_row = 0;
+        m_recompute_pass++;
+    }
+    SubmitRecomputeStep(command_buffer);
+}
 
-        m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(0, single_rayleigh_scattering_lut);
-        m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(1, single_mie_scattering_lut);
-        m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(2, multi_scattering_lut);
-        m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(3, direct_irradiance_lut);
-        m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(4, _irradiance_tex);
+void Atmosphere::RecordRecomputeCopy(VkCommandBuffer command_buffer) noexcept {
+    VkCommandBufferBeginInfo begin_info{};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &begin_info);
+    RecordPrecomputeBarrier(command_buffer, true);
+
+    // blits convert rgba32f to LUT_FORMAT on the device, both formats have to support them which vulkan requires
+    for (auto [src, dst, extent] :
+         {std::make_tuple(transmittance_lut.get(), m_pending_luts.transmittance.get(),
+                          VkOffset3D{static_cast<i32>(m_lut_size.transmittance_width),
+                                     static_cast<i32>(m_lut_size.transmittance_height), 1}),
+          std::make_tuple(_irradiance_tex.get(), m_pending_luts.irradiance.get(),
+                          VkOffset3D{static_cast<i32>(m_lut_size.irradiance_width),
+                                     static_cast<i32>(m_lut_size.irradiance_height), 1}),
+          std::make_tuple(_scattering_tex.get(), m_pending_luts.scattering.get(),
+                          VkOffset3D{static_cast<i32>(m_lut_size.GetScatteringWidth()),
+                                     static_cast<i32>(m_lut_size.GetScatteringHeight()),
+                                     static_cast<i32>(m_lut_size.GetScatteringDepth())})}) {
+        VkImageBlit region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.srcOffsets[1] = extent;
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.dstOffsets[1] = extent;
+        vkCmdBlitImage(command_buffer, src->GetImage(), VK_IMAGE_LAYOUT_GENERAL, dst->GetImage(),
+                       VK_IMAGE_LAYOUT_GENERAL, 1, &region, VK_FILTER_NEAREST);
+    }
 
-        m_indirect_irradiance_lut_descriptor_set->UpdateDescriptorSet(
-            m_indirect_irradiance_lut_descriptor_set_update_desc);
+    BarrierDesc desc;
+    for (const std::shared_ptr<Texture> &texture :
+         {m_pending_luts.transmittance, m_pending_luts.irradiance, m_pending_luts.scattering}) {
+        ImageMemoryBarrierDesc barrier;
+        barrier.src_access_mask = MemoryAccessFlags::ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+        barrier.texture = texture;
+        desc.image_memory_barriers.push_back(barrier);
+    }
+    desc.src_stage = PipelineStageFlags::PIPELINE_STAGE_TRANSFER_BIT;
+    desc.dst_stage = PipelineStageFlags::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    InsertBarrier(command_buffer, desc);
+    vkEndCommandBuffer(command_buffer);
+
+    m_step_rows = 0;
+    m_recompute_stage = RecomputeStage::COPY;
+    SubmitRecomputeStep(command_buffer);
+}
 
-        // multi-scattering
+void Atmosphere::SubmitRecomputeStep(VkCommandBuffer command_buffer) noexcept {
+    // without a command buffer the fence signals once everything submitted before finished
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = command_buffer != VK_NULL_HANDLE ? 1 : 0;
+    submit_info.pCommandBuffers = &command_buffer;
+    CHECK_VK_RESULT(vkQueueSubmit(m_device->getGraphicQueue(), command_buffer != VK_NULL_HANDLE ? 1 : 0,
+                                  &submit_info, m_step_fence));
+    m_step_submitted = true;
+    m_recompute_steps++;
+}
 
-        m_multi_scattering_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
-        m_multi_scattering_lut_descriptor_set_update_desc.BindResource(1, scattering_density_lut);
-        m_multi_scattering_lut_descriptor_set_update_desc.BindResource(2, single_rayleigh_scattering_lut);
-        m_multi_scattering_lut_descriptor_set_update_desc.BindResource(3, _scattering_tex);
+void Atmosphere::FinishRecomputeStep() noexcept {
+    CHECK_VK_RESULT(vkResetFences(m_device->Get(), 1, &m_step_fence));
+    m_step_submitted = false;
 
-        m_multi_scattering_lut_descriptor_set->UpdateDescriptorSet(m_multi_scattering_lut_descriptor_set_update_desc);
+    f64 ms = 0.0;
+    if (m_step_rows > 0 && m_step_timer->GetElapsedTime(0, ms)) {
+        f64 &row_time = m_row_time[m_step_kind];
+        f64 measured = ms / static_cast<f64>(m_step_rows);
+        row_time = row_time > 0.0 ? 0.5 * (row_time + measured) : measured;
     }
-    // render sky
 
-    m_sky_descriptor_set_update_desc.BindResource(0, m_sky_ub);
-    m_sky_descriptor_set_update_desc.BindResource(1, transmittance_lut);
-    m_sky_descriptor_set_update_desc.BindResource(2, _scattering_tex);
-    m_sky_descriptor_set->UpdateDescriptorSet(m_sky_descriptor_set_update_desc);
+    if (m_recompute_stage == RecomputeStage::COPY) {
+        // the copy finished. frames submitted until now may still sample the old luts
+        m_retired_luts = m_luts;
+        m_luts = m_pending_luts;
+        m_pending_luts = {};
+        ReleasePrecomputeTextures();
+        m_recompute_stage = RecomputeStage::RETIRE;
+        LOG_INFO("atmosphere luts recomputed in {} steps, {} ms", m_recompute_steps,
+                 std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - m_recompute_start).count());
+        SubmitRecomputeStep(VK_NULL_HANDLE);
+    } else if (m_recompute_stage == RecomputeStage::RETIRE) {
+        m_retired_luts = {};
+        m_recompute_stage = RecomputeStage::NONE;
+    }
+}
+
+void Atmosphere::WaitForRecompute() noexcept {
+    while (m_step_submitted) {
+        CHECK_VK_RESULT(vkWaitForFences(m_device->Get(), 1, &m_step_fence, VK_TRUE, UINT64_MAX));
+        FinishRecomputeStep();
+    }
+}
+
+AtmosphereLuts Atmosphere::ReadLuts() noexcept {
+    AtmosphereLuts luts = GetLutExtents(m_lut_size);
+    luts.Allocate();
+    std::vector<u16> texels;
+    for (auto [texture, lut] : {std::make_pair(m_luts.transmittance.get(), &luts.transmittance),
+                                std::make_pair(m_luts.irradiance.get(), &luts.irradiance),
+                                std::make_pair(m_luts.scattering.get(), &luts.scattering)}) {
+        texels.resize(lut->size());
+        texture->ReadTexels(texels.data(), sizeof(u16) * texels.size());
+        for (u64 i = 0; i < texels.size(); i++) {
+            (*lut)[i] = Math::unpackHalf1x16(texels[i]);
+        }
+    }
+    return luts;
+}
+
+u64 Atmosphere::GetCacheKey() const noexcept {
+    return GetCacheKey(m_parameters, m_multi_scattering_order, m_lut_size);
+}
+
+std::string Atmosphere::GetCachePath() const noexcept {
+    return GetCachePath(m_parameters, m_multi_scattering_order, m_lut_size);
+}
+
+u64 Atmosphere::GetCacheKey(const AtmosphereParameters &parameters, u32 multi_scattering_order,
+                            const AtmosphereLutSize &lut_size) noexcept {
+    u64 key = parameters.Hash();
+    // the scattering lut width alone does not tell nu from mu_s
+    for (u32 extent : {lut_size.transmittance_width, lut_size.transmittance_height, lut_size.irradiance_width,
+                       lut_size.irradiance_height, lut_size.scattering_r_size, lut_size.scattering_mu_size,
+                       lut_size.scattering_mu_s_size, lut_size.scattering_nu_size, multi_scattering_order}) {
+        key = Hash::Combine(key, extent);
+    }
+    // the glsl rather than the spirv, which may be compiled at runtime
+    for (const char *shader : PRECOMPUTE_SHADERS) {
+        key = Hash::Combine(key, ShaderCompiler::GetSourceHash(ShaderSource{shader}));
+    }
+    return key;
+}
+
+std::string Atmosphere::GetCachePath(const AtmosphereParameters &parameters, u32 multi_scattering_order,
+                                     const AtmosphereLutSize &lut_size) noexcept {
+    char name[40];
+    std::snprintf(name, sizeof(name), "atmosphere-%016llx.lut",
+                  static_cast<unsigned long long>(GetCacheKey(parameters, multi_scattering_order, lut_size)));
+    return Path::GetCachePath(name);
+}
+
+AtmosphereLuts Atmosphere::GetLutExtents(const AtmosphereLutSize &lut_size) noexcept {
+    AtmosphereLuts luts;
+    luts.transmittance_width = lut_size.transmittance_width;
+    luts.transmittance_height = lut_size.transmittance_height;
+    luts.irradiance_width = lut_size.irradiance_width;
+    luts.irradiance_height = lut_size.irradiance_height;
+    luts.scattering_width = lut_size.GetScatteringWidth();
+    luts.scattering_height = lut_size.GetScatteringHeight();
+    luts.scattering_depth = lut_size.GetScatteringDepth();
+    return luts;
+}
+
+const AtmosphereLutSize &Atmosphere::GetLutSize() const noexcept { return m_lut_size; }
+
+SpecializationConstants Atmosphere::GetSpecializationConstants(u32 group_dimensions) const noexcept {
+    SpecializationConstants constants{{0, m_lut_size.transmittance_width},  {1, m_lut_size.transmittance_height},
+                                      {2, m_lut_size.scattering_r_size},    {3, m_lut_size.scattering_mu_size},
+                                      {4, m_lut_size.scattering_mu_s_size}, {5, m_lut_size.scattering_nu_size},
+                                      {6, m_lut_size.irradiance_width},     {7, m_lut_size.irradiance_height}};
+    u32 group_size = group_dimensions == 3 ? LUT_GROUP_SIZE_3D : LUT_GROUP_SIZE_2D;
+    for (u32 i = 0; i < group_dimensions; i++) {
+        constants.push_back({8 + i, group_size});
+    }
+    return constants;
+}
+
+void Atmosphere::UpdateLutDescriptorSets(const LutSet &target) noexcept {
+    DescriptorSetUpdateDesc parameters_update_desc;
+    parameters_update_desc.BindResource(0, target.parameters);
+    m_lut_parameters_descriptor_set->UpdateDescriptorSet(parameters_update_desc);
+
+    // tramsmittance lut
+    m_transmittance_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
+    m_transmittance_lut_descriptor_set->UpdateDescriptorSet(m_transmittance_lut_descriptor_set_update_desc);
+
+    // direct irradiance lut
+    m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
+    m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(1, direct_irradiance_lut);
+    m_direct_irradiance_lut_descriptor_set_update_desc.BindResource(2, _irradiance_tex);
+    m_direct_irradiance_lut_descriptor_set->UpdateDescriptorSet(m_direct_irradiance_lut_descriptor_set_update_desc);
+
+    // single scattering lut
+
+    //m_single_scattering_lut_ubdata.luminance_from_radiance = Math::mat3(1.0);
+    //m_single_scattering_lut_ubdata.layer = 0;
+    //m_single_scattering_lut_ub->update(&m_single_scattering_lut_ubdata,sizeof(m_single_scattering_lut_ubdata));
+
+    m_single_scattering_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
+    //m_single_scattering_lut_descriptor_set_update_desc.BindResource(1, m_single_scattering_lut_ub);
+    m_single_scattering_lut_descriptor_set_update_desc.BindResource(1, single_rayleigh_scattering_lut);
+    m_single_scattering_lut_descriptor_set_update_desc.BindResource(2, single_mie_scattering_lut);
+    m_single_scattering_lut_descriptor_set_update_desc.BindResource(3, _scattering_tex);
+
+    m_single_scattering_lut_descriptor_set->UpdateDescriptorSet(m_single_scattering_lut_descriptor_set_update_desc);
+
+    // SCATTERING DENSITY LUT
+
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(1, single_rayleigh_scattering_lut);
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(2, single_mie_scattering_lut);
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(3, multi_scattering_lut);
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(4, direct_irradiance_lut);
+    m_scattering_density_lut_descriptor_set_update_desc.BindResource(5, scattering_density_lut);
+
+    m_scattering_density_lut_descriptor_set->UpdateDescriptorSet(m_scattering_density_lut_descriptor_set_update_desc);
+
+    // indirect irradiance
+
+    m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(0, single_rayleigh_scattering_lut);
+    m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(1, single_mie_scattering_lut);
+    m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(2, multi_scattering_lut);
+    m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(3, direct_irradiance_lut);
+    m_indirect_irradiance_lut_descriptor_set_update_desc.BindResource(4, _irradiance_tex);
+
+    m_indirect_irradiance_lut_descriptor_set->UpdateDescriptorSet(m_indirect_irradiance_lut_descriptor_set_update_desc);
+
+    // multi-scattering
+
+    m_multi_scattering_lut_descriptor_set_update_desc.BindResource(0, transmittance_lut);
+    m_multi_scattering_lut_descriptor_set_update_desc.BindResource(1, scattering_density_lut);
+    m_multi_scattering_lut_descriptor_set_update_desc.BindResource(2, single_rayleigh_scattering_lut);
+    m_multi_scattering_lut_descriptor_set_update_desc.BindResource(3, _scattering_tex);
+
+    m_multi_scattering_lut_descriptor_set->UpdateDescriptorSet(m_multi_scattering_lut_descriptor_set_update_desc);
+}
+
+void Atmosphere::RecordPrecomputeBarrier(VkCommandBuffer command_buffer, bool copy) noexcept {
+    BarrierDesc desc;
+    // multi_scattering_lut is single_rayleigh_scattering_lut
+    for (const std::shared_ptr<Texture> &texture :
+         {transmittance_lut, direct_irradiance_lut, _irradiance_tex, single_rayleigh_scattering_lut,
+          single_mie_scattering_lut, _scattering_tex, scattering_density_lut}) {
+        ImageMemoryBarrierDesc barrier;
+        barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        barrier.dst_access_mask = copy ? MemoryAccessFlags::ACCESS_TRANSFER_READ_BIT
+                                       : static_cast<MemoryAccessFlags>(MemoryAccessFlags::ACCESS_SHADER_READ_BIT |
+                                                                        MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT);
+        barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+        barrier.texture = texture;
+        desc.image_memory_barriers.push_back(barrier);
+    }
+    desc.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    desc.dst_stage =
+        copy ? PipelineStageFlags::PIPELINE_STAGE_TRANSFER_BIT : PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    InsertBarrier(command_buffer, desc);
+}
+
+void Atmosphere::RecordPrecompute(VkCommandBuffer command_buffer) noexcept {
+    m_command_buffer->Dispatch(command_buffer, m_transmittance_lut_pass,
+                               {m_transmittance_lut_descriptor_set, m_lut_parameters_descriptor_set});
+
+    // barrier
+    {
+        BarrierDesc desc1;
+        ImageMemoryBarrierDesc transmittance_lut_barrier;
+        transmittance_lut_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        transmittance_lut_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        transmittance_lut_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        transmittance_lut_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+        transmittance_lut_barrier.texture = transmittance_lut;
+        desc1.image_memory_barriers.push_back(transmittance_lut_barrier);
+        desc1.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        desc1.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        InsertBarrier(command_buffer, desc1);
+    }
+
+    m_command_buffer->Dispatch(command_buffer, m_direct_irradiance_lut_pass,
+                               {m_direct_irradiance_lut_descriptor_set, m_lut_parameters_descriptor_set});
+
+    m_command_buffer->Dispatch(command_buffer, m_single_scattering_lut_pass,
+                               {m_single_scattering_lut_descriptor_set, m_lut_parameters_descriptor_set});
+
+    // barrier
+    {
+        BarrierDesc desc2;
+
+        ImageMemoryBarrierDesc delta_r_barrier;
+        delta_r_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        delta_r_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        delta_r_barrier.texture = single_rayleigh_scattering_lut;
+        delta_r_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        delta_r_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+        ImageMemoryBarrierDesc delta_mie_barrier;
+        delta_mie_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        delta_mie_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        delta_mie_barrier.texture = single_mie_scattering_lut;
+        delta_mie_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        delta_mie_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+        ImageMemoryBarrierDesc irradiance_barrier;
+        irradiance_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        irradiance_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        irradiance_barrier.texture = direct_irradiance_lut;
+        irradiance_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        irradiance_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+        ImageMemoryBarrierDesc multi_scattering_barrier;
+        multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+        multi_scattering_barrier.texture = multi_scattering_lut;
+        multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+        multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+        desc2.image_memory_barriers.push_back(delta_r_barrier);
+        desc2.image_memory_barriers.push_back(delta_mie_barrier);
+        desc2.image_memory_barriers.push_back(irradiance_barrier);
+        desc2.image_memory_barriers.push_back(multi_scattering_barrier);
+
+        desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+        InsertBarrier(command_buffer, desc2);
+    }
+
+    for (u32 j = 0; j < m_multi_scattering_order; j++) {
+        m_scattering_order = static_cast<i32>(j + 2);
+        m_command_buffer->Dispatch(command_buffer, m_scattering_density_lut,
+                                   {m_scattering_density_lut_descriptor_set, m_lut_parameters_descriptor_set});
+        // barrier
+        {
+            BarrierDesc desc;
+            desc.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            desc.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            InsertBarrier(command_buffer, desc);
+        }
+        m_scattering_order = static_cast<i32>(j + 1);
+        m_command_buffer->Dispatch(command_buffer, m_indirect_irradiance_lut,
+                                   {m_indirect_irradiance_lut_descriptor_set, m_lut_parameters_descriptor_set});
+        // barrier
+        {
+            BarrierDesc desc2;
+
+            ImageMemoryBarrierDesc density_barrier;
+            density_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            density_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+            density_barrier.texture = scattering_density_lut;
+            density_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+            density_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+            ImageMemoryBarrierDesc multi_scattering_barrier;
+            multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            multi_scattering_barrier.texture = single_rayleigh_scattering_lut;
+            multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+            multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+            desc2.image_memory_barriers.push_back(density_barrier);
+            desc2.image_memory_barriers.push_back(multi_scattering_barrier);
+
+            desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                              PipelineStageFlags::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+            InsertBarrier(command_buffer, desc2);
+        }
+        m_scattering_order = static_cast<i32>(j + 2);
+        m_command_buffer->Dispatch(command_buffer, m_multi_scattering_lut,
+                                   {m_multi_scattering_lut_descriptor_set, m_lut_parameters_descriptor_set});
+        // barrier
+        {
+            BarrierDesc desc2;
+
+            ImageMemoryBarrierDesc _scattering_barrier;
+            _scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            _scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            _scattering_barrier.texture = _scattering_tex;
+            _scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+            _scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+            ImageMemoryBarrierDesc multi_scattering_barrier;
+            multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+            multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
+            multi_scattering_barrier.texture = single_rayleigh_scattering_lut;
+            multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
+            multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
+
+            desc2.image_memory_barriers.push_back(_scattering_barrier);
+            desc2.image_memory_barriers.push_back(multi_scattering_barrier);
+
+            desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                              PipelineStageFlags::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+            InsertBarrier(command_buffer, desc2);
+        }
+    }
 }
 
 void Atmosphere::BindResource(u32 binding, std::shared_ptr<DescriptorBase> buffer) noexcept {
@@ -207,6 +888,13 @@ std::shared_ptr<AttachmentDescriptor> Atmosphere::GetFrameBufferAttachment(u32 _
 
 void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
                                  std::shared_ptr<CommandBuffer> command_buffer) noexcept {
+    // atmosphere parameters, set 1 of the lut kernels and the sky pass. the kernels read those of the luts they
+    // compute, the sky those of the luts it samples
+    std::shared_ptr<DescriptorSetInfo> parameters_descriptor_set_create_info = std::make_shared<DescriptorSetInfo>();
+    parameters_descriptor_set_create_info->AddBinding(DescriptorType::DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                                                      SHADER_STAGE_COMPUTE_SHADER | SHADER_STAGE_PIXEL_SHADER);
+    m_lut_parameters_descriptor_set = std::make_shared<DescriptorSet>(_device, parameters_descriptor_set_create_info);
+    m_sky_parameters_descriptor_set = std::make_shared<DescriptorSet>(_device, parameters_descriptor_set_create_info);
 
     // transmittance
 
@@ -220,6 +908,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
 
     transmittance_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     transmittance_lut_descriptor_set_layouts->layouts.push_back(m_transmittance_lut_descriptor_set->GetLayout());
+    transmittance_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     // direct irradiance
 
@@ -238,6 +927,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
     direct_irradiance_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     direct_irradiance_lut_descriptor_set_layouts->layouts.push_back(
         m_direct_irradiance_lut_descriptor_set->GetLayout());
+    direct_irradiance_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     // single scattering lut pass
     m_single_scattering_lut_ub = std::make_shared<UniformBuffer>(_device);
@@ -260,6 +950,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
     single_scattering_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     single_scattering_lut_descriptor_set_layouts->layouts.push_back(
         m_single_scattering_lut_descriptor_set->GetLayout());
+    single_scattering_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     // scattering density
 
@@ -284,6 +975,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
     scattering_density_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     scattering_density_lut_descriptor_set_layouts->layouts.push_back(
         m_scattering_density_lut_descriptor_set->GetLayout());
+    scattering_density_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     // INDIRECT IRRADIANCE
 
@@ -306,6 +998,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
     indirect_irradiance_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     indirect_irradiance_lut_descriptor_set_layouts->layouts.push_back(
         m_indirect_irradiance_lut_descriptor_set->GetLayout());
+    indirect_irradiance_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     // multi scattering
 
@@ -325,6 +1018,7 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
 
     multi_scattering_lut_descriptor_set_layouts = std::make_shared<DescriptorSetLayouts>();
     multi_scattering_lut_descriptor_set_layouts->layouts.push_back(m_multi_scattering_lut_descriptor_set->GetLayout());
+    multi_scattering_lut_descriptor_set_layouts->layouts.push_back(m_lut_parameters_descriptor_set->GetLayout());
 
     //// camera volume
 
@@ -358,45 +1052,15 @@ void Atmosphere::CreateResources(std::shared_ptr<Device> _device,
 
     sky_descriptor_set_layout = std::make_shared<DescriptorSetLayouts>();
     sky_descriptor_set_layout->layouts.push_back(m_sky_descriptor_set->GetLayout());
-
-    // textures and uniform buffers
-
-    transmittance_lut = std::make_shared<Texture>(_device, command_buffer,
-                                                  TextureCreateInfo{TextureType::TEXTURE_TYPE_2D,
-                                                                    TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                                                                    TextureUsage::TEXTURE_USAGE_RW, 256, 64, 1});
-    direct_irradiance_lut = std::make_shared<Texture>(_device, command_buffer,
-                                                      TextureCreateInfo{TextureType::TEXTURE_TYPE_2D,
-                                                                        TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                                                                        TextureUsage::TEXTURE_USAGE_RW, 64, 16, 1});
-    _irradiance_tex = std::make_shared<Texture>(_device, command_buffer,
-                                                TextureCreateInfo{TextureType::TEXTURE_TYPE_2D,
-                                                                  TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                                                                  TextureUsage::TEXTURE_USAGE_RW, 64, 16, 1});
-    single_rayleigh_scattering_lut = std::make_shared<Texture>(
-        _device, command_buffer,
-        TextureCreateInfo{TextureType::TEXTURE_TYPE_3D, TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                          TextureUsage::TEXTURE_USAGE_RW, 256, 128, 32});
-    single_mie_scattering_lut = std::make_shared<Texture>(
-        _device, command_buffer,
-        TextureCreateInfo{TextureType::TEXTURE_TYPE_3D, TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                          TextureUsage::TEXTURE_USAGE_RW, 256, 128, 32});
-    _scattering_tex = std::make_shared<Texture>(_device, command_buffer,
-                                                TextureCreateInfo{TextureType::TEXTURE_TYPE_3D,
-                                                                  TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                                                                  TextureUsage::TEXTURE_USAGE_RW, 256, 128, 32});
-    scattering_density_lut = std::make_shared<Texture>(_device, command_buffer,
-                                                       TextureCreateInfo{TextureType::TEXTURE_TYPE_3D,
-                                                                         TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,
-                                                                         TextureUsage::TEXTURE_USAGE_RW, 256, 128, 32});
-    multi_scattering_lut = single_rayleigh_scattering_lut;
+    sky_descriptor_set_layout->layouts.push_back(m_sky_parameters_descriptor_set->GetLayout());
 
     //scatter_transfer_t = std::make_shared<Texture>(_device, command_buffer, TextureCreateInfo{ TextureType::TEXTURE_TYPE_3D,TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,TextureUsage::TEXTURE_USAGE_RW, 32, 32, 32 });
     //out_transmittance = std::make_shared<Texture>(_device, command_buffer, TextureCreateInfo{ TextureType::TEXTURE_TYPE_3D,TextureFormat::TEXTURE_FORMAT_RGBA32_SFLOAT,TextureUsage::TEXTURE_USAGE_RW, 32, 32, 32 });
 
+    // PerOrder in scattering_density.comp and indirect_irradiance_lut.comp
     scattering_order_push_constants = std::make_shared<PushConstants>();
     scattering_order_push_constants->ranges = {
-        {SHADER_STAGE_COMPUTE_SHADER, 0, 2 * sizeof(Math::mat4)}}; // Push constants have a minimum size of 128 bytes
+        {SHADER_STAGE_COMPUTE_SHADER, 0, sizeof(m_scattering_order), &m_scattering_order}};
 }
 
 } // namespace Horizon
\ No newline at end of file
@@ -1,25 +1,143 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <memory>
+#include <string>
+#include <vector>
+
 #include <runtime/function/rhi/vulkan/CommandBuffer.h>
 #include <runtime/function/rhi/vulkan/Descriptors.h>
+#include <runtime/function/rhi/vulkan/GpuTimer.h>
 #include <runtime/function/rhi/vulkan/Pipeline.h>
 #include <runtime/function/rhi/vulkan/Texture.h>
 #include <runtime/function/rhi/vulkan/UniformBuffer.h>
+#include <runtime/scene/render/AtmosphereLutCache.h>
+#include <runtime/scene/render/AtmosphereParameters.h>
 
 namespace Horizon {
 class Atmosphere {
   public:
+    // workgroup extent of the 2d and 3d lut kernels along each axis, the kernels are specialized to them
+    static constexpr u32 LUT_GROUP_SIZE_2D = 8;
+    static constexpr u32 LUT_GROUP_SIZE_3D = 4;
+    // the luts are kept in half floats once computed, a quarter of the rgba32f precomputation set.
+    // run atmosphere_baker --compare for the error against rgba32f
+    static constexpr TextureFormat LUT_FORMAT = TextureFormat::TEXTURE_FORMAT_RGBA16_SFLOAT;
+
+    // multi_scattering_order passes are added to single scattering. the lut extents follow
+    // RenderContext::atmosphere_quality, the shaders are specialized to them
     Atmosphere(std::shared_ptr<PipelineManager> _pipeline_manager, std::shared_ptr<Device> _device,
-               std::shared_ptr<CommandBuffer> command_buffer, RenderContext &_render_context) noexcept;
+               std::shared_ptr<CommandBuffer> command_buffer, RenderContext &_render_context,
+               const AtmosphereParameters &parameters = {}, u32 multi_scattering_order = 3) noexcept;
     ~Atmosphere() noexcept;
+    // uploads the luts from the lut cache, or computes them in one submission, reads them back and writes the
+    // cache. waits for the queue, call once before the first frame. without use_cache the luts are always computed
+    // and the cache is left alone. computed_luts receives the rgba32f luts before they are narrowed to LUT_FORMAT.
+    // the textures only the precomputation reads are freed at the end
+    void Precompute(bool use_cache = true, AtmosphereLuts *computed_luts = nullptr) noexcept;
+    // computes the luts for multi_scattering_order over the next frames, a slice of the passes per frame within
+    // RenderContext::atmosphere_step_budget of gpu time. the current luts stay in use until the new ones are
+    // complete. the textures of the new set are allocated here, which waits for the queue once. a request while
+    // one runs restarts it, one for the luts in use is ignored
+    void RequestRecompute(const AtmosphereParameters &parameters, u32 multi_scattering_order) noexcept;
+    // submits the next slice of a requested recompute once the previous one finished, and swaps the new luts in
+    // after the last. call once per frame before UpdateDescriptorSets
+    void Update() noexcept;
+    bool IsRecomputing() const noexcept;
+    // recomputes the luts with the current parameters when a lut kernel is among pipelines, after a shader reload
+    // changed the kernels and with them the cache key
+    void OnPipelinesRebuilt(const std::vector<std::shared_ptr<Pipeline>> &pipelines) noexcept;
+    // the luts kept after precomputation, read back from the device and widened to f32
+    AtmosphereLuts ReadLuts() noexcept;
+    // device memory of the lut textures currently allocated
+    u64 GetMemorySize() const noexcept;
+    // covers the parameters, the lut extents, the scattering order and the lut shaders
+    u64 GetCacheKey() const noexcept;
+    std::string GetCachePath() const noexcept;
+    // the same without a device, for luts computed elsewhere
+    static u64 GetCacheKey(const AtmosphereParameters &parameters, u32 multi_scattering_order,
+                           const AtmosphereLutSize &lut_size = {}) noexcept;
+    static std::string GetCachePath(const AtmosphereParameters &parameters, u32 multi_scattering_order,
+                                    const AtmosphereLutSize &lut_size = {}) noexcept;
+    // the extents of the luts kept after precomputation, texels are left empty
+    static AtmosphereLuts GetLutExtents(const AtmosphereLutSize &lut_size = {}) noexcept;
+    const AtmosphereLutSize &GetLutSize() const noexcept;
     void SetCameraParams(Math::mat4 inv_view_projection, Math::vec3 camera_pos) noexcept;
+    // taken into the sky uniform buffer with the next camera params
+    void SetResolution(u32 width, u32 height) noexcept;
     void UpdateDescriptorSets() noexcept;
     void BindResource(u32 binding, std::shared_ptr<DescriptorBase> buffer) noexcept;
     std::shared_ptr<AttachmentDescriptor> GetFrameBufferAttachment(u32 _index) const noexcept;
 
   private:
+    // the luts the sky pass samples, in LUT_FORMAT, and the parameters they are computed for
+    struct LutSet {
+        std::shared_ptr<Texture> transmittance, irradiance, scattering;
+        std::shared_ptr<UniformBuffer> parameters;
+        // GetCacheKey of the parameters
+        u64 key = 0;
+    };
+
+    // std140 layout of AtmosphereUb in assets/shaders/atmosphere/functions.glsl
+    struct ParametersUb {
+        f32 bottom_radius;
+        f32 top_radius;
+        f32 mie_g;
+        f32 sun_angular_radius;
+        Math::vec3 solar_irradiance;
+        f32 mu_s_min;
+        Math::vec3 rayleigh_scattering;
+        f32 pad0;
+        Math::vec3 mie_scattering;
+        f32 pad1;
+        Math::vec3 mie_extinction;
+        f32 pad2;
+        Math::vec3 absorption_extinction;
+        f32 pad3;
+        Math::vec3 ground_albedo;
+        f32 pad4;
+        // rayleigh, mie and absorption density, two layers each. width, exp_term, exp_scale and linear_term, then
+        // constant_term in x
+        Math::vec4 density_layers[12];
+    };
+    static_assert(sizeof(ParametersUb) == 304);
+
+    // a pass of the lut chain, recomputed row by row of its workgroups
+    struct RecomputePass {
+        std::shared_ptr<Pipeline> pipeline;
+        std::shared_ptr<DescriptorSet> descriptor_set;
+        i32 scattering_order;
+        // index into m_row_time, the passes of every scattering order share it
+        u32 kind;
+    };
+
+    // PASSES submits rows of m_recompute_passes and then the copy to LUT_FORMAT, COPY waits for the copy and RETIRE
+    // for the frames that may still sample the previous luts
+    enum class RecomputeStage { NONE, PASSES, COPY, RETIRE };
+
     void CreateResources(std::shared_ptr<Device> device, std::shared_ptr<CommandBuffer> command_buffer) noexcept;
+    // the lut extents, and the workgroup extent of a lut kernel with group_dimensions. the constant_ids of
+    // assets/shaders/atmosphere/definations.glsl and of the kernel workgroups
+    SpecializationConstants GetSpecializationConstants(u32 group_dimensions = 0) const noexcept;
+    // textures and the parameter buffer for m_parameters and m_multi_scattering_order
+    LutSet CreateLutSet() const noexcept;
+    void WriteParameters(UniformBuffer &parameters) const noexcept;
+    // the rgba32f textures the lut passes write
+    void CreatePrecomputeTextures() noexcept;
+    void ReleasePrecomputeTextures() noexcept;
+    // the lut kernels write the precompute textures and read the parameters of target
+    void UpdateLutDescriptorSets(const LutSet &target) noexcept;
+    void RecordPrecompute(VkCommandBuffer command_buffer) noexcept;
+    // makes what the lut passes wrote visible to the next pass or the copy to LUT_FORMAT
+    void RecordPrecomputeBarrier(VkCommandBuffer command_buffer, bool copy) noexcept;
+    // records the rows of the current pass that fit into the step budget
+    void RecordRecomputeRows(VkCommandBuffer command_buffer) noexcept;
+    void RecordRecomputeCopy(VkCommandBuffer command_buffer) noexcept;
+    void SubmitRecomputeStep(VkCommandBuffer command_buffer) noexcept;
+    void FinishRecomputeStep() noexcept;
+    // blocks until the submitted step and the ones it leads to finished
+    void WaitForRecompute() noexcept;
 
   public:
     std::shared_ptr<Pipeline> m_sky_pass, m_transmittance_lut_pass, m_direct_irradiance_lut_pass,
@@ -29,13 +147,20 @@ class Atmosphere {
         m_direct_irradiance_lut_descriptor_set, m_single_scattering_lut_descriptor_set,
         m_scattering_density_lut_descriptor_set, m_indirect_irradiance_lut_descriptor_set,
         m_multi_scattering_lut_descriptor_set, m_camera_volume_descriptor_set;
+    // set 1 of the lut kernels and of the sky pass
+    std::shared_ptr<DescriptorSet> m_lut_parameters_descriptor_set, m_sky_parameters_descriptor_set;
     u32 m_multi_scattering_order = 3;
 
     std::shared_ptr<PushConstants> scattering_order_push_constants;
 
-    std::array<i32, 4> layers = {1, 2, 3, 4};
-
   private:
+    std::shared_ptr<Device> m_device = nullptr;
+    std::shared_ptr<CommandBuffer> m_command_buffer = nullptr;
+    AtmosphereParameters m_parameters;
+    AtmosphereLutSize m_lut_size;
+    // scattering order pushed to the scattering density and indirect irradiance passes
+    i32 m_scattering_order = 2;
+
     std::shared_ptr<DescriptorSetLayouts> transmittance_lut_descriptor_set_layouts;
     std::shared_ptr<DescriptorSetLayouts> direct_irradiance_lut_descriptor_set_layouts;
     std::shared_ptr<DescriptorSetLayouts> single_scattering_lut_descriptor_set_layouts;
@@ -54,7 +179,29 @@ class Atmosphere {
     DescriptorSetUpdateDesc m_multi_scattering_lut_descriptor_set_update_desc;
     DescriptorSetUpdateDesc m_camera_volume_descriptor_set_update_desc;
 
+    LutSet m_luts;
+    // written by the recompute, swapped with m_luts once complete
+    LutSet m_pending_luts;
+    // the previous luts, released once the frames sampling them finished
+    LutSet m_retired_luts;
+
+    RecomputeStage m_recompute_stage = RecomputeStage::NONE;
+    std::vector<RecomputePass> m_recompute_passes;
+    u32 m_recompute_pass = 0, m_recompute_row = 0;
+    // pass kind and rows of the submitted step, the rows are timed to size the next steps. no rows for the copy
+    u32 m_step_kind = 0, m_step_rows = 0;
+    // measured gpu time of a row of each pass kind, 0 until measured
+    std::array<f64, 6> m_row_time{};
+    f32 m_step_budget = 1.0f;
+    u32 m_recompute_steps = 0;
+    std::chrono::steady_clock::time_point m_recompute_start;
+    VkCommandBuffer m_step_command_buffer = VK_NULL_HANDLE;
+    VkFence m_step_fence = VK_NULL_HANDLE;
+    bool m_step_submitted = false;
+    std::shared_ptr<GpuTimer> m_step_timer = nullptr;
+
   public:
+    // written by the lut passes, allocated only while they run
     std::shared_ptr<Texture> transmittance_lut;
     std::shared_ptr<Texture> direct_irradiance_lut;
     std::shared_ptr<Texture> _irradiance_tex;
@@ -0,0 +1,725 @@
+#include "AtmosphereCpuPrecompute.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#include <runtime/core/thread/ThreadPool.h>
+#include <runtime/scene/render/Atmosphere.h>
+
+namespace Horizon::AtmosphereCpuPrecompute {
+
+// the defines of assets/shaders/atmosphere/definations.glsl
+static constexpr f32 PI = 3.14159265359f;
+
+// the parameters and the specialization constants of the shaders, the extents of the luts one Compute call fills.
+// passed down instead of kept in statics so that calls for different lut sizes can overlap
+struct AtmosphereLutContext : AtmosphereParameters {
+    i32 transmittance_texture_width = 0;
+    i32 transmittance_texture_height = 0;
+    i32 irradiance_texture_width = 0;
+    i32 irradiance_texture_height = 0;
+    i32 scattering_texture_r_size = 0;
+    i32 scattering_texture_mu_size = 0;
+    i32 scattering_texture_mu_s_size = 0;
+    i32 scattering_texture_nu_size = 0;
+    i32 scattering_texture_width = 0;
+    i32 scattering_texture_height = 0;
+    i32 scattering_texture_depth = 0;
+};
+
+static_assert(sizeof(Math::vec4) == 4 * sizeof(f32), "luts are copied out as packed rgba");
+
+// sample counts of the integrals in functions.glsl
+static constexpr i32 TRANSMITTANCE_SAMPLE_COUNT = 500;
+static constexpr i32 SCATTERING_SAMPLE_COUNT = 50;
+static constexpr i32 SCATTERING_DENSITY_SAMPLE_COUNT = 16;
+static constexpr i32 INDIRECT_IRRADIANCE_SAMPLE_COUNT = 32;
+
+// rgba texels, x fastest then y then z like an image copied to a buffer, and the linear clamp to edge filtering of the
+// sampler the lut shaders read them through
+struct Lut {
+    i32 width = 0;
+    i32 height = 0;
+    i32 depth = 0;
+    std::vector<Math::vec4> texels;
+
+    Lut(i32 _width, i32 _height, i32 _depth = 1) noexcept
+        : width(_width), height(_height), depth(_depth),
+          texels(static_cast<u64>(_width) * _height * _depth, Math::vec4(0.0f)) {}
+
+    Math::vec4 &At(i32 x, i32 y, i32 z = 0) noexcept {
+        return texels[(static_cast<u64>(z) * height + y) * width + x];
+    }
+    const Math::vec4 &At(i32 x, i32 y, i32 z = 0) const noexcept {
+        return texels[(static_cast<u64>(z) * height + y) * width + x];
+    }
+
+    Math::vec4 Sample(Math::vec2 uv) const noexcept;
+    Math::vec4 Sample(Math::vec3 uvw) const noexcept;
+
+    void CopyTo(std::vector<f32> &rgba) const noexcept {
+        rgba.resize(texels.size() * 4);
+        std::memcpy(rgba.data(), texels.data(), sizeof(Math::vec4) * texels.size());
+    }
+};
+
+// texel centers sit at (i + 0.5) / size, outside the outer centers the edge texel is repeated
+static void GetLinearTaps(f32 coord, i32 size, i32 &i0, i32 &i1, f32 &t) noexcept {
+    f32 x = std::fmax(-1.0f, std::fmin(coord * static_cast<f32>(size) - 0.5f, static_cast<f32>(size)));
+    f32 x0 = std::floor(x);
+    t = x - x0;
+    i0 = std::clamp(static_cast<i32>(x0), 0, size - 1);
+    i1 = std::clamp(static_cast<i32>(x0) + 1, 0, size - 1);
+}
+
+Math::vec4 Lut::Sample(Math::vec2 uv) const noexcept {
+    i32 x0, x1, y0, y1;
+    f32 tx, ty;
+    GetLinearTaps(uv.x, width, x0, x1, tx);
+    GetLinearTaps(uv.y, height, y0, y1, ty);
+    return Math::mix(Math::mix(At(x0, y0), At(x1, y0), tx), Math::mix(At(x0, y1), At(x1, y1), tx), ty);
+}
+
+Math::vec4 Lut::Sample(Math::vec3 uvw) const noexcept {
+    i32 x0, x1, y0, y1, z0, z1;
+    f32 tx, ty, tz;
+    GetLinearTaps(uvw.x, width, x0, x1, tx);
+    GetLinearTaps(uvw.y, height, y0, y1, ty);
+    GetLinearTaps(uvw.z, depth, z0, z1, tz);
+    Math::vec4 near = Math::mix(Math::mix(At(x0, y0, z0), At(x1, y0, z0), tx),
+                                Math::mix(At(x0, y1, z0), At(x1, y1, z0), tx), ty);
+    Math::vec4 far = Math::mix(Math::mix(At(x0, y0, z1), At(x1, y0, z1), tx),
+                               Math::mix(At(x0, y1, z1), At(x1, y1, z1), tx), ty);
+    return Math::mix(near, far, tz);
+}
+
+// rows are handed out one at a time from a shared counter. rows near the horizon cost several times the others, so
+// an idle worker keeps taking rows instead of waiting on a fixed share
+static void ForEachRow(u32 row_count, const std::function<void(u32)> &func) noexcept {
+    ThreadPool &pool = ThreadPool::GetInstance();
+    std::atomic<u32> next_row{0};
+    pool.ParallelFor(pool.GetWorkerCount() + 1, 1, [&](u32, u32) {
+        for (u32 row = next_row.fetch_add(1, std::memory_order_relaxed); row < row_count;
+             row = next_row.fetch_add(1, std::memory_order_relaxed)) {
+            func(row);
+        }
+    });
+}
+
+// functions.glsl from here on, same names and the same order of operations
+
+static f32 ClampCosine(f32 mu) noexcept { return std::clamp(mu, -1.0f, 1.0f); }
+
+static f32 ClampDistance(f32 d) noexcept { return std::max(d, 0.0f); }
+
+static f32 ClampRadius(const AtmosphereLutContext &atmosphere, f32 r) noexcept {
+    return std::clamp(r, atmosphere.bottom_radius, atmosphere.top_radius);
+}
+
+static f32 SafeSqrt(f32 a) noexcept { return std::sqrt(std::max(a, 0.0f)); }
+
+static f32 DistanceToTopAtmosphereBoundary(const AtmosphereLutContext &atmosphere, f32 r, f32 mu) noexcept {
+    f32 discriminant = r * r * (mu * mu - 1.0f) + atmosphere.top_radius * atmosphere.top_radius;
+    return ClampDistance(-r * mu + SafeSqrt(discriminant));
+}
+
+static f32 DistanceToBottomAtmosphereBoundary(const AtmosphereLutContext &atmosphere, f32 r, f32 mu) noexcept {
+    f32 discriminant = r * r * (mu * mu - 1.0f) + atmosphere.bottom_radius * atmosphere.bottom_radius;
+    return ClampDistance(-r * mu - SafeSqrt(discriminant));
+}
+
+static bool RayIntersectsGround(const AtmosphereLutContext &atmosphere, f32 r, f32 mu) noexcept {
+    return mu < 0.0f && r * r * (mu * mu - 1.0f) + atmosphere.bottom_radius * atmosphere.bottom_radius >= 0.0f;
+}
+
+static f32 GetLayerDensity(const DensityProfileLayer &layer, f32 altitude) noexcept {
+    f32 density = layer.exp_term * std::exp(layer.exp_scale * altitude) + layer.linear_term * altitude +
+                  layer.constant_term;
+    return std::clamp(density, 0.0f, 1.0f);
+}
+
+static f32 GetProfileDensity(const DensityProfile &profile, f32 altitude) noexcept {
+    return altitude < profile.layers[0].width ? GetLayerDensity(profile.layers[0], altitude)
+                                              : GetLayerDensity(profile.layers[1], altitude);
+}
+
+// trapezoidal sum over the sample altitudes, both layers are evaluated so the loop has no branch to vectorise around
+template <u64 N>
+static f32 ComputeOpticalLength(const DensityProfile &profile, const std::array<f32, N> &altitudes, f32 dx) noexcept {
+    f32 sum = 0.0f;
+    for (u64 i = 0; i < N; i++) {
+        f32 lower = GetLayerDensity(profile.layers[0], altitudes[i]);
+        f32 upper = GetLayerDensity(profile.layers[1], altitudes[i]);
+        sum += altitudes[i] < profile.layers[0].width ? lower : upper;
+    }
+    sum -= 0.5f * (GetProfileDensity(profile, altitudes[0]) + GetProfileDensity(profile, altitudes[N - 1]));
+    return sum * dx;
+}
+
+static Math::vec3 ComputeTransmittanceToTopAtmosphereBoundary(const AtmosphereLutContext &atmosphere, f32 r,
+                                                              f32 mu) noexcept {
+    f32 dx = DistanceToTopAtmosphereBoundary(atmosphere, r, mu) / static_cast<f32>(TRANSMITTANCE_SAMPLE_COUNT);
+    // the three profiles share the sample points
+    std::array<f32, TRANSMITTANCE_SAMPLE_COUNT + 1> altitudes;
+    for (i32 i = 0; i <= TRANSMITTANCE_SAMPLE_COUNT; i++) {
+        f32 d_i = static_cast<f32>(i) * dx;
+        altitudes[i] = std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r) - atmosphere.bottom_radius;
+    }
+    f32 rayleigh_length = ComputeOpticalLength(atmosphere.rayleigh_density, altitudes, dx);
+    f32 mie_length = ComputeOpticalLength(atmosphere.mie_density, altitudes, dx);
+    f32 absorption_length = ComputeOpticalLength(atmosphere.absorption_density, altitudes, dx);
+    return Math::exp(-(atmosphere.rayleigh_scattering * rayleigh_length + atmosphere.mie_extinction * mie_length +
+                       atmosphere.absorption_extinction * absorption_length));
+}
+
+static f32 GetTextureCoordFromUnitRange(f32 x, f32 texture_size) noexcept {
+    return 0.5f / texture_size + x * (1.0f - 1.0f / texture_size);
+}
+
+static f32 GetUnitRangeFromTextureCoord(f32 u, f32 texture_size) noexcept {
+    return (u - 0.5f / texture_size) / (1.0f - 1.0f / texture_size);
+}
+
+static Math::vec2 GetTransmittanceTextureUvFromRMu(const AtmosphereLutContext &atmosphere, f32 r, f32 mu) noexcept {
+    f32 H = std::sqrt(atmosphere.top_radius * atmosphere.top_radius -
+                      atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 rho = SafeSqrt(r * r - atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 d = DistanceToTopAtmosphereBoundary(atmosphere, r, mu);
+    f32 d_min = atmosphere.top_radius - r;
+    f32 d_max = rho + H;
+    f32 x_mu = (d - d_min) / (d_max - d_min);
+    f32 x_r = rho / H;
+    return Math::vec2(GetTextureCoordFromUnitRange(x_mu, atmosphere.transmittance_texture_width),
+                      GetTextureCoordFromUnitRange(x_r, atmosphere.transmittance_texture_height));
+}
+
+static void GetRMuFromTransmittanceTextureUv(const AtmosphereLutContext &atmosphere, Math::vec2 uv, f32 &r,
+                                             f32 &mu) noexcept {
+    f32 x_mu = GetUnitRangeFromTextureCoord(uv.x, atmosphere.transmittance_texture_width);
+    f32 x_r = GetUnitRangeFromTextureCoord(uv.y, atmosphere.transmittance_texture_height);
+    f32 H = std::sqrt(atmosphere.top_radius * atmosphere.top_radius -
+                      atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 rho = H * x_r;
+    r = std::sqrt(rho * rho + atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 d_min = atmosphere.top_radius - r;
+    f32 d_max = rho + H;
+    f32 d = d_min + x_mu * (d_max - d_min);
+    mu = d == 0.0f ? 1.0f : (H * H - rho * rho - d * d) / (2.0f * r * d);
+    mu = ClampCosine(mu);
+}
+
+static Math::vec3 GetTransmittanceToTopAtmosphereBoundary(const AtmosphereLutContext &atmosphere,
+                                                          const Lut &transmittance_texture, f32 r, f32 mu) noexcept {
+    return Math::vec3(transmittance_texture.Sample(GetTransmittanceTextureUvFromRMu(atmosphere, r, mu)));
+}
+
+static Math::vec3 GetTransmittance(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture, f32 r,
+                                   f32 mu, f32 d, bool ray_r_mu_intersects_ground) noexcept {
+    f32 r_d = ClampRadius(atmosphere, std::sqrt(d * d + 2.0f * r * mu * d + r * r));
+    f32 mu_d = ClampCosine((r * mu + d) / r_d);
+    if (ray_r_mu_intersects_ground) {
+        return Math::min(GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r_d, -mu_d) /
+                             GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r, -mu),
+                         Math::vec3(1.0f));
+    } else {
+        return Math::min(GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r, mu) /
+                             GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r_d, mu_d),
+                         Math::vec3(1.0f));
+    }
+}
+
+static Math::vec3 GetTransmittanceToSun(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture,
+                                        f32 r, f32 mu_s) noexcept {
+    f32 sin_theta_h = atmosphere.bottom_radius / r;
+    f32 cos_theta_h = -std::sqrt(std::max(1.0f - sin_theta_h * sin_theta_h, 0.0f));
+    return GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r, mu_s) *
+           Math::smoothstep(-sin_theta_h * atmosphere.sun_angular_radius,
+                            sin_theta_h * atmosphere.sun_angular_radius, mu_s - cos_theta_h);
+}
+
+static f32 DistanceToNearestAtmosphereBoundary(const AtmosphereLutContext &atmosphere, f32 r, f32 mu,
+                                               bool ray_r_mu_intersects_ground) noexcept {
+    return ray_r_mu_intersects_ground ? DistanceToBottomAtmosphereBoundary(atmosphere, r, mu)
+                                      : DistanceToTopAtmosphereBoundary(atmosphere, r, mu);
+}
+
+// the trapezoid weights of SCATTERING_SAMPLE_COUNT intervals
+static const std::array<f32, SCATTERING_SAMPLE_COUNT + 1> &GetScatteringSampleWeights() noexcept {
+    static const std::array<f32, SCATTERING_SAMPLE_COUNT + 1> weights = [] {
+        std::array<f32, SCATTERING_SAMPLE_COUNT + 1> w;
+        w.fill(1.0f);
+        w.front() = w.back() = 0.5f;
+        return w;
+    }();
+    return weights;
+}
+
+static void ComputeSingleScattering(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture, f32 r,
+                                    f32 mu, f32 mu_s, f32 nu, bool ray_r_mu_intersects_ground, Math::vec3 &rayleigh,
+                                    Math::vec3 &mie) noexcept {
+    f32 dx = DistanceToNearestAtmosphereBoundary(atmosphere, r, mu, ray_r_mu_intersects_ground) /
+             static_cast<f32>(SCATTERING_SAMPLE_COUNT);
+    // positions along the ray first, the lut lookups after
+    std::array<f32, SCATTERING_SAMPLE_COUNT + 1> r_d, mu_s_d;
+    for (i32 i = 0; i <= SCATTERING_SAMPLE_COUNT; i++) {
+        f32 d_i = static_cast<f32>(i) * dx;
+        r_d[i] = ClampRadius(atmosphere, std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r));
+        mu_s_d[i] = ClampCosine((r * mu_s + d_i * nu) / r_d[i]);
+    }
+    const std::array<f32, SCATTERING_SAMPLE_COUNT + 1> &weights = GetScatteringSampleWeights();
+    Math::vec3 rayleigh_sum(0.0f), mie_sum(0.0f);
+    for (i32 i = 0; i <= SCATTERING_SAMPLE_COUNT; i++) {
+        f32 d_i = static_cast<f32>(i) * dx;
+        Math::vec3 transmittance =
+            GetTransmittance(atmosphere, transmittance_texture, r, mu, d_i, ray_r_mu_intersects_ground) *
+            GetTransmittanceToSun(atmosphere, transmittance_texture, r_d[i], mu_s_d[i]);
+        f32 altitude = r_d[i] - atmosphere.bottom_radius;
+        rayleigh_sum += transmittance * GetProfileDensity(atmosphere.rayleigh_density, altitude) * weights[i];
+        mie_sum += transmittance * GetProfileDensity(atmosphere.mie_density, altitude) * weights[i];
+    }
+    rayleigh = rayleigh_sum * dx * atmosphere.solar_irradiance * atmosphere.rayleigh_scattering;
+    mie = mie_sum * dx * atmosphere.solar_irradiance * atmosphere.mie_scattering;
+}
+
+static f32 RayleighPhaseFunction(f32 nu) noexcept {
+    f32 k = 3.0f / (16.0f * PI);
+    return k * (1.0f + nu * nu);
+}
+
+static f32 MiePhaseFunction(f32 g, f32 nu) noexcept {
+    f32 k = 3.0f / (8.0f * PI) * (1.0f - g * g) / (2.0f + g * g);
+    return k * (1.0f + nu * nu) / std::pow(1.0f + g * g - 2.0f * g * nu, 1.5f);
+}
+
+static Math::vec4 GetScatteringTextureUvwzFromRMuMuSNu(const AtmosphereLutContext &atmosphere, f32 r, f32 mu,
+                                                       f32 mu_s, f32 nu, bool ray_r_mu_intersects_ground) noexcept {
+    f32 H = std::sqrt(atmosphere.top_radius * atmosphere.top_radius -
+                      atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 rho = SafeSqrt(r * r - atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 u_r = GetTextureCoordFromUnitRange(rho / H, atmosphere.scattering_texture_r_size);
+
+    f32 r_mu = r * mu;
+    f32 discriminant = r_mu * r_mu - r * r + atmosphere.bottom_radius * atmosphere.bottom_radius;
+    f32 u_mu;
+    if (ray_r_mu_intersects_ground) {
+        f32 d = -r_mu - SafeSqrt(discriminant);
+        f32 d_min = r - atmosphere.bottom_radius;
+        f32 d_max = rho;
+        u_mu = 0.5f - 0.5f * GetTextureCoordFromUnitRange(d_max == d_min ? 0.0f : (d - d_min) / (d_max - d_min),
+                                                          atmosphere.scattering_texture_mu_size * 0.5f);
+    } else {
+        f32 d = -r_mu + SafeSqrt(discriminant + H * H);
+        f32 d_min = atmosphere.top_radius - r;
+        f32 d_max = rho + H;
+        u_mu = 0.5f + 0.5f * GetTextureCoordFromUnitRange((d - d_min) / (d_max - d_min),
+                                                          atmosphere.scattering_texture_mu_size * 0.5f);
+    }
+
+    f32 d = DistanceToTopAtmosphereBoundary(atmosphere, atmosphere.bottom_radius, mu_s);
+    f32 d_min = atmosphere.top_radius - atmosphere.bottom_radius;
+    f32 d_max = H;
+    f32 a = (d - d_min) / (d_max - d_min);
+    f32 D = DistanceToTopAtmosphereBoundary(atmosphere, atmosphere.bottom_radius, atmosphere.mu_s_min);
+    f32 A = (D - d_min) / (d_max - d_min);
+    f32 u_mu_s = GetTextureCoordFromUnitRange(std::max(1.0f - a / A, 0.0f) / (1.0f + a),
+                                              atmosphere.scattering_texture_mu_s_size);
+    f32 u_nu = (nu + 1.0f) / 2.0f;
+    return Math::vec4(u_nu, u_mu_s, u_mu, u_r);
+}
+
+static void GetRMuMuSNuFromScatteringTextureUvwz(const AtmosphereLutContext &atmosphere, Math::vec4 uvwz, f32 &r,
+                                                 f32 &mu, f32 &mu_s, f32 &nu,
+                                                 bool &ray_r_mu_intersects_ground) noexcept {
+    f32 H = std::sqrt(atmosphere.top_radius * atmosphere.top_radius -
+                      atmosphere.bottom_radius * atmosphere.bottom_radius);
+    f32 rho = H * GetUnitRangeFromTextureCoord(uvwz.w, atmosphere.scattering_texture_r_size);
+    r = std::sqrt(rho * rho + atmosphere.bottom_radius * atmosphere.bottom_radius);
+
+    if (uvwz.z < 0.5f) {
+        f32 d_min = r - atmosphere.bottom_radius;
+        f32 d_max = rho;
+        f32 d = d_min + (d_max - d_min) * GetUnitRangeFromTextureCoord(1.0f - 2.0f * uvwz.z,
+                                                                       atmosphere.scattering_texture_mu_size / 2);
+        mu = d == 0.0f ? -1.0f : ClampCosine(-(rho * rho + d * d) / (2.0f * r * d));
+        ray_r_mu_intersects_ground = true;
+    } else {
+        f32 d_min = atmosphere.top_radius - r;
+        f32 d_max = rho + H;
+        f32 d = d_min + (d_max - d_min) * GetUnitRangeFromTextureCoord(2.0f * uvwz.z - 1.0f,
+                                                                       atmosphere.scattering_texture_mu_size / 2);
+        mu = d == 0.0f ? 1.0f : ClampCosine((H * H - rho * rho - d * d) / (2.0f * r * d));
+        ray_r_mu_intersects_ground = false;
+    }
+
+    f32 x_mu_s = GetUnitRangeFromTextureCoord(uvwz.y, atmosphere.scattering_texture_mu_s_size);
+    f32 d_min = atmosphere.top_radius - atmosphere.bottom_radius;
+    f32 d_max = H;
+    f32 D = DistanceToTopAtmosphereBoundary(atmosphere, atmosphere.bottom_radius, atmosphere.mu_s_min);
+    f32 A = (D - d_min) / (d_max - d_min);
+    f32 a = (A - x_mu_s * A) / (1.0f + x_mu_s * A);
+    f32 d = d_min + std::min(a, A) * (d_max - d_min);
+    mu_s = d == 0.0f ? 1.0f : ClampCosine((H * H - d * d) / (2.0f * atmosphere.bottom_radius * d));
+    nu = ClampCosine(uvwz.x * 2.0f - 1.0f);
+}
+
+static void GetRMuMuSNuFromScatteringTextureFragCoord(const AtmosphereLutContext &atmosphere, Math::vec3 frag_coord,
+                                                      f32 &r, f32 &mu, f32 &mu_s, f32 &nu,
+                                                      bool &ray_r_mu_intersects_ground) noexcept {
+    const Math::vec4 SCATTERING_TEXTURE_SIZE(
+        atmosphere.scattering_texture_nu_size - 1, atmosphere.scattering_texture_mu_s_size,
+        atmosphere.scattering_texture_mu_size, atmosphere.scattering_texture_r_size);
+    f32 frag_coord_nu = std::floor(frag_coord.x / static_cast<f32>(atmosphere.scattering_texture_mu_s_size));
+    f32 frag_coord_mu_s = Math::mod(frag_coord.x, static_cast<f32>(atmosphere.scattering_texture_mu_s_size));
+    Math::vec4 uvwz =
+        Math::vec4(frag_coord_nu, frag_coord_mu_s, frag_coord.y, frag_coord.z) / SCATTERING_TEXTURE_SIZE;
+    GetRMuMuSNuFromScatteringTextureUvwz(atmosphere, uvwz, r, mu, mu_s, nu, ray_r_mu_intersects_ground);
+    nu = std::clamp(nu, mu * mu_s - std::sqrt((1.0f - mu * mu) * (1.0f - mu_s * mu_s)),
+                    mu * mu_s + std::sqrt((1.0f - mu * mu) * (1.0f - mu_s * mu_s)));
+}
+
+// the lookup of GetScattering once the lut coordinates are known. only u_nu changes over the azimuths of a ring of
+// directions, the hemisphere integrals map r, mu and mu_s once per ring
+static Math::vec3 GetScattering(const AtmosphereLutContext &atmosphere, const Lut &scattering_texture,
+                                Math::vec4 uvwz) noexcept {
+    f32 nu_size = static_cast<f32>(atmosphere.scattering_texture_nu_size);
+    f32 tex_coord_x = uvwz.x * (nu_size - 1.0f);
+    f32 tex_x = std::floor(tex_coord_x);
+    f32 lerp = tex_coord_x - tex_x;
+    Math::vec3 uvw0((tex_x + uvwz.y) / nu_size, uvwz.z, uvwz.w);
+    Math::vec3 uvw1((tex_x + 1.0f + uvwz.y) / nu_size, uvwz.z, uvwz.w);
+    return Math::vec3(scattering_texture.Sample(uvw0) * (1.0f - lerp) + scattering_texture.Sample(uvw1) * lerp);
+}
+
+static Math::vec3 GetScattering(const AtmosphereLutContext &atmosphere, const Lut &scattering_texture, f32 r, f32 mu,
+                                f32 mu_s, f32 nu, bool ray_r_mu_intersects_ground) noexcept {
+    return GetScattering(atmosphere, scattering_texture,
+                         GetScatteringTextureUvwzFromRMuMuSNu(atmosphere, r, mu, mu_s, nu, ray_r_mu_intersects_ground));
+}
+
+static Math::vec3 GetScattering(const AtmosphereLutContext &atmosphere, const Lut &single_rayleigh_scattering_texture,
+                                const Lut &single_mie_scattering_texture, const Lut &multiple_scattering_texture,
+                                Math::vec4 uvwz, f32 nu, i32 scattering_order) noexcept {
+    if (scattering_order == 1) {
+        Math::vec3 rayleigh = GetScattering(atmosphere, single_rayleigh_scattering_texture, uvwz);
+        Math::vec3 mie = GetScattering(atmosphere, single_mie_scattering_texture, uvwz);
+        return rayleigh * RayleighPhaseFunction(nu) + mie * MiePhaseFunction(atmosphere.mie_g, nu);
+    } else {
+        return GetScattering(atmosphere, multiple_scattering_texture, uvwz);
+    }
+}
+
+static Math::vec2 GetIrradianceTextureUvFromRMuS(const AtmosphereLutContext &atmosphere, f32 r, f32 mu_s) noexcept {
+    f32 x_r = (r - atmosphere.bottom_radius) / (atmosphere.top_radius - atmosphere.bottom_radius);
+    f32 x_mu_s = mu_s * 0.5f + 0.5f;
+    return Math::vec2(GetTextureCoordFromUnitRange(x_mu_s, atmosphere.irradiance_texture_width),
+                      GetTextureCoordFromUnitRange(x_r, atmosphere.irradiance_texture_height));
+}
+
+static void GetRMuSFromIrradianceTextureUv(const AtmosphereLutContext &atmosphere, Math::vec2 uv, f32 &r,
+                                           f32 &mu_s) noexcept {
+    f32 x_mu_s = GetUnitRangeFromTextureCoord(uv.x, atmosphere.irradiance_texture_width);
+    f32 x_r = GetUnitRangeFromTextureCoord(uv.y, atmosphere.irradiance_texture_height);
+    r = atmosphere.bottom_radius + x_r * (atmosphere.top_radius - atmosphere.bottom_radius);
+    mu_s = ClampCosine(2.0f * x_mu_s - 1.0f);
+}
+
+static Math::vec3 GetIrradiance(const AtmosphereLutContext &atmosphere, const Lut &irradiance_texture, f32 r,
+                                f32 mu_s) noexcept {
+    return Math::vec3(irradiance_texture.Sample(GetIrradianceTextureUvFromRMuS(atmosphere, r, mu_s)));
+}
+
+// cos and sin of (i + 0.5) * PI / divisor, the azimuths the hemisphere integrals step through for every texel
+template <i32 COUNT, i32 DIVISOR>
+static const std::array<Math::vec2, COUNT> &GetAngleTable() noexcept {
+    static const std::array<Math::vec2, COUNT> table = [] {
+        std::array<Math::vec2, COUNT> angles;
+        for (i32 i = 0; i < COUNT; i++) {
+            f32 angle = (static_cast<f32>(i) + 0.5f) * (PI / static_cast<f32>(DIVISOR));
+            angles[i] = Math::vec2(std::cos(angle), std::sin(angle));
+        }
+        return angles;
+    }();
+    return table;
+}
+
+static Math::vec3 ComputeScatteringDensity(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture,
+                                           const Lut &single_rayleigh_scattering_texture,
+                                           const Lut &single_mie_scattering_texture,
+                                           const Lut &multiple_scattering_texture, const Lut &irradiance_texture,
+                                           f32 r, f32 mu, f32 mu_s, f32 nu, i32 scattering_order) noexcept {
+    constexpr i32 SAMPLE_COUNT = SCATTERING_DENSITY_SAMPLE_COUNT;
+    Math::vec3 zenith_direction(0.0f, 0.0f, 1.0f);
+    Math::vec3 omega(std::sqrt(1.0f - mu * mu), 0.0f, mu);
+    f32 sun_dir_x = omega.x == 0.0f ? 0.0f : (nu - mu * mu_s) / omega.x;
+    f32 sun_dir_y = std::sqrt(std::max(1.0f - sun_dir_x * sun_dir_x - mu_s * mu_s, 0.0f));
+    Math::vec3 omega_s(sun_dir_x, sun_dir_y, mu_s);
+
+    const f32 dphi = PI / static_cast<f32>(SAMPLE_COUNT);
+    const f32 dtheta = PI / static_cast<f32>(SAMPLE_COUNT);
+    const std::array<Math::vec2, SAMPLE_COUNT> &thetas = GetAngleTable<SAMPLE_COUNT, SAMPLE_COUNT>();
+    const std::array<Math::vec2, 2 * SAMPLE_COUNT> &phis = GetAngleTable<2 * SAMPLE_COUNT, SAMPLE_COUNT>();
+    // only depend on r, the shader evaluates them for every direction
+    Math::vec3 rayleigh_scattering =
+        atmosphere.rayleigh_scattering * GetProfileDensity(atmosphere.rayleigh_density, r - atmosphere.bottom_radius);
+    Math::vec3 mie_scattering =
+        atmosphere.mie_scattering * GetProfileDensity(atmosphere.mie_density, r - atmosphere.bottom_radius);
+    bool ground_reflects = atmosphere.ground_albedo != Math::vec3(0.0f);
+
+    Math::vec3 rayleigh_mie(0.0f);
+    for (i32 l = 0; l < SAMPLE_COUNT; l++) {
+        f32 cos_theta = thetas[l].x;
+        f32 sin_theta = thetas[l].y;
+        bool ray_r_theta_intersects_ground = RayIntersectsGround(atmosphere, r, cos_theta);
+        Math::vec4 uvwz =
+            GetScatteringTextureUvwzFromRMuMuSNu(atmosphere, r, cos_theta, mu_s, 0.0f, ray_r_theta_intersects_ground);
+        f32 distance_to_ground = 0.0f;
+        Math::vec3 transmittance_to_ground(0.0f);
+        if (ray_r_theta_intersects_ground && ground_reflects) {
+            distance_to_ground = DistanceToBottomAtmosphereBoundary(atmosphere, r, cos_theta);
+            transmittance_to_ground =
+                GetTransmittance(atmosphere, transmittance_texture, r, cos_theta, distance_to_ground, true) *
+                atmosphere.ground_albedo * (1.0f / PI);
+        }
+        f32 domega_i = dtheta * dphi * sin_theta;
+        for (i32 m = 0; m < 2 * SAMPLE_COUNT; m++) {
+            Math::vec3 omega_i(phis[m].x * sin_theta, phis[m].y * sin_theta, cos_theta);
+            f32 nu1 = Math::dot(omega_s, omega_i);
+            uvwz.x = (nu1 + 1.0f) / 2.0f;
+            Math::vec3 incident_radiance =
+                GetScattering(atmosphere, single_rayleigh_scattering_texture, single_mie_scattering_texture,
+                              multiple_scattering_texture, uvwz, nu1, scattering_order - 1);
+            // the light of the last bounce off the ground, zero without albedo
+            if (ray_r_theta_intersects_ground && ground_reflects) {
+                Math::vec3 ground_normal = Math::normalize(zenith_direction * r + omega_i * distance_to_ground);
+                Math::vec3 ground_irradiance = GetIrradiance(atmosphere, irradiance_texture, atmosphere.bottom_radius,
+                                                             Math::dot(ground_normal, omega_s));
+                incident_radiance += transmittance_to_ground * ground_irradiance;
+            }
+            f32 nu2 = Math::dot(omega, omega_i);
+            rayleigh_mie += incident_radiance *
+                            (rayleigh_scattering * RayleighPhaseFunction(nu2) +
+                             mie_scattering * MiePhaseFunction(atmosphere.mie_g, nu2)) *
+                            domega_i;
+        }
+    }
+    return rayleigh_mie;
+}
+
+static Math::vec3 ComputeMultipleScattering(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture,
+                                            const Lut &scattering_density_texture, f32 r, f32 mu, f32 mu_s, f32 nu,
+                                            bool ray_r_mu_intersects_ground) noexcept {
+    f32 dx = DistanceToNearestAtmosphereBoundary(atmosphere, r, mu, ray_r_mu_intersects_ground) /
+             static_cast<f32>(SCATTERING_SAMPLE_COUNT);
+    std::array<f32, SCATTERING_SAMPLE_COUNT + 1> r_i, mu_i, mu_s_i;
+    for (i32 i = 0; i <= SCATTERING_SAMPLE_COUNT; i++) {
+        f32 d_i = static_cast<f32>(i) * dx;
+        r_i[i] = ClampRadius(atmosphere, std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r));
+        mu_i[i] = ClampCosine((r * mu + d_i) / r_i[i]);
+        mu_s_i[i] = ClampCosine((r * mu_s + d_i * nu) / r_i[i]);
+    }
+    const std::array<f32, SCATTERING_SAMPLE_COUNT + 1> &weights = GetScatteringSampleWeights();
+    Math::vec3 rayleigh_mie_sum(0.0f);
+    for (i32 i = 0; i <= SCATTERING_SAMPLE_COUNT; i++) {
+        f32 d_i = static_cast<f32>(i) * dx;
+        Math::vec3 rayleigh_mie_i =
+            GetScattering(atmosphere, scattering_density_texture, r_i[i], mu_i[i], mu_s_i[i], nu,
+                          ray_r_mu_intersects_ground) *
+            GetTransmittance(atmosphere, transmittance_texture, r, mu, d_i, ray_r_mu_intersects_ground) * dx;
+        rayleigh_mie_sum += rayleigh_mie_i * weights[i];
+    }
+    return rayleigh_mie_sum;
+}
+
+static Math::vec3 ComputeDirectIrradiance(const AtmosphereLutContext &atmosphere, const Lut &transmittance_texture,
+                                          f32 r, f32 mu_s) noexcept {
+    f32 alpha_s = atmosphere.sun_angular_radius;
+    f32 average_cosine_factor =
+        mu_s < -alpha_s ? 0.0f : (mu_s > alpha_s ? mu_s : (mu_s + alpha_s) * (mu_s + alpha_s) / (4.0f * alpha_s));
+    return atmosphere.solar_irradiance *
+           GetTransmittanceToTopAtmosphereBoundary(atmosphere, transmittance_texture, r, mu_s) * average_cosine_factor;
+}
+
+static Math::vec3 ComputeIndirectIrradiance(const AtmosphereLutContext &atmosphere,
+                                            const Lut &single_rayleigh_scattering_texture,
+                                            const Lut &single_mie_scattering_texture,
+                                            const Lut &multiple_scattering_texture, f32 r, f32 mu_s,
+                                            i32 scattering_order) noexcept {
+    constexpr i32 SAMPLE_COUNT = INDIRECT_IRRADIANCE_SAMPLE_COUNT;
+    const f32 dphi = PI / static_cast<f32>(SAMPLE_COUNT);
+    const f32 dtheta = PI / static_cast<f32>(SAMPLE_COUNT);
+    const std::array<Math::vec2, SAMPLE_COUNT / 2> &thetas = GetAngleTable<SAMPLE_COUNT / 2, SAMPLE_COUNT>();
+    const std::array<Math::vec2, 2 * SAMPLE_COUNT> &phis = GetAngleTable<2 * SAMPLE_COUNT, SAMPLE_COUNT>();
+
+    Math::vec3 result(0.0f);
+    Math::vec3 omega_s(std::sqrt(1.0f - mu_s * mu_s), 0.0f, mu_s);
+    for (i32 j = 0; j < SAMPLE_COUNT / 2; j++) {
+        f32 cos_theta = thetas[j].x;
+        f32 sin_theta = thetas[j].y;
+        f32 domega = dtheta * dphi * sin_theta;
+        Math::vec4 uvwz = GetScatteringTextureUvwzFromRMuMuSNu(atmosphere, r, cos_theta, mu_s, 0.0f, false);
+        for (i32 i = 0; i < 2 * SAMPLE_COUNT; i++) {
+            Math::vec3 omega(phis[i].x * sin_theta, phis[i].y * sin_theta, cos_theta);
+            f32 nu = Math::dot(omega, omega_s);
+            uvwz.x = (nu + 1.0f) / 2.0f;
+            result += GetScattering(atmosphere, single_rayleigh_scattering_texture, single_mie_scattering_texture,
+                                    multiple_scattering_texture, uvwz, nu, scattering_order) *
+                      omega.z * domega;
+        }
+    }
+    return result;
+}
+
+static AtmosphereLutContext GetLutContext(const AtmosphereParameters &parameters,
+                                          const AtmosphereLutSize &lut_size) noexcept {
+    AtmosphereLutContext atmosphere;
+    static_cast<AtmosphereParameters &>(atmosphere) = parameters;
+    atmosphere.transmittance_texture_width = static_cast<i32>(lut_size.transmittance_width);
+    atmosphere.transmittance_texture_height = static_cast<i32>(lut_size.transmittance_height);
+    atmosphere.irradiance_texture_width = static_cast<i32>(lut_size.irradiance_width);
+    atmosphere.irradiance_texture_height = static_cast<i32>(lut_size.irradiance_height);
+    atmosphere.scattering_texture_r_size = static_cast<i32>(lut_size.scattering_r_size);
+    atmosphere.scattering_texture_mu_size = static_cast<i32>(lut_size.scattering_mu_size);
+    atmosphere.scattering_texture_mu_s_size = static_cast<i32>(lut_size.scattering_mu_s_size);
+    atmosphere.scattering_texture_nu_size = static_cast<i32>(lut_size.scattering_nu_size);
+    atmosphere.scattering_texture_width =
+        atmosphere.scattering_texture_nu_size * atmosphere.scattering_texture_mu_s_size;
+    atmosphere.scattering_texture_height = atmosphere.scattering_texture_mu_size;
+    atmosphere.scattering_texture_depth = atmosphere.scattering_texture_r_size;
+    return atmosphere;
+}
+
+void Compute(const AtmosphereParameters &parameters, u32 multi_scattering_order, const AtmosphereLutSize &lut_size,
+             AtmosphereLuts &luts) noexcept {
+    const AtmosphereLutContext atmosphere = GetLutContext(parameters, lut_size);
+    luts = Atmosphere::GetLutExtents(lut_size);
+
+    // transmittance_lut.comp
+    Lut transmittance(atmosphere.transmittance_texture_width, atmosphere.transmittance_texture_height);
+    ForEachRow(transmittance.height, [&](u32 y) {
+        for (i32 x = 0; x < transmittance.width; x++) {
+            Math::vec2 frag_coord(x + 0.5f, y + 0.5f);
+            f32 r, mu;
+            GetRMuFromTransmittanceTextureUv(
+                atmosphere, frag_coord / Math::vec2(transmittance.width, transmittance.height), r, mu);
+            transmittance.At(x, y) = Math::vec4(ComputeTransmittanceToTopAtmosphereBoundary(atmosphere, r, mu), 1.0f);
+        }
+    });
+
+    // direct_irradiance_lut.comp, the irradiance lut starts out at zero
+    Lut delta_irradiance(atmosphere.irradiance_texture_width, atmosphere.irradiance_texture_height);
+    Lut irradiance(delta_irradiance.width, delta_irradiance.height);
+    const Math::vec2 IRRADIANCE_TEXTURE_SIZE(irradiance.width, irradiance.height);
+    ForEachRow(irradiance.height, [&](u32 y) {
+        for (i32 x = 0; x < irradiance.width; x++) {
+            f32 r, mu_s;
+            GetRMuSFromIrradianceTextureUv(atmosphere, Math::vec2(x + 0.5f, y + 0.5f) / IRRADIANCE_TEXTURE_SIZE, r,
+                                           mu_s);
+            delta_irradiance.At(x, y) =
+                Math::vec4(ComputeDirectIrradiance(atmosphere, transmittance, r, mu_s), 0.0f);
+        }
+    });
+
+    // single_scattering_lut.comp. the multiple scattering of each order is kept in delta_rayleigh once single
+    // rayleigh is no longer read, like the multi_scattering_lut alias of the atmosphere pass
+    Lut scattering(atmosphere.scattering_texture_width, atmosphere.scattering_texture_height,
+                   atmosphere.scattering_texture_depth);
+    Lut delta_rayleigh(scattering.width, scattering.height, scattering.depth);
+    Lut delta_mie(scattering.width, scattering.height, scattering.depth);
+    Lut &multiple_scattering = delta_rayleigh;
+    const u32 SCATTERING_ROW_COUNT = scattering.height * scattering.depth;
+    ForEachRow(SCATTERING_ROW_COUNT, [&](u32 row) {
+        i32 y = row % scattering.height, z = row / scattering.height;
+        for (i32 x = 0; x < scattering.width; x++) {
+            f32 r, mu, mu_s, nu;
+            bool ray_r_mu_intersects_ground;
+            GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, Math::vec3(x + 0.5f, y + 0.5f, z + 0.5f), r, mu,
+                                                      mu_s, nu, ray_r_mu_intersects_ground);
+            Math::vec3 rayleigh, mie;
+            ComputeSingleScattering(atmosphere, transmittance, r, mu, mu_s, nu, ray_r_mu_intersects_ground, rayleigh,
+                                    mie);
+            delta_rayleigh.At(x, y, z) = Math::vec4(rayleigh, 0.0f);
+            delta_mie.At(x, y, z) = Math::vec4(mie, 0.0f);
+            scattering.At(x, y, z) = Math::vec4(rayleigh, mie.r);
+        }
+    });
+
+    Lut scattering_density(scattering.width, scattering.height, scattering.depth);
+    for (u32 j = 0; j < multi_scattering_order; j++) {
+        // scattering_density.comp
+        i32 scattering_order = static_cast<i32>(j + 2);
+        ForEachRow(SCATTERING_ROW_COUNT, [&](u32 row) {
+            i32 y = row % scattering.height, z = row / scattering.height;
+            for (i32 x = 0; x < scattering.width; x++) {
+                f32 r, mu, mu_s, nu;
+                bool ray_r_mu_intersects_ground;
+                GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, Math::vec3(x + 0.5f, y + 0.5f, z + 0.5f), r,
+                                                          mu, mu_s, nu, ray_r_mu_intersects_ground);
+                Math::vec3 density =
+                    ComputeScatteringDensity(atmosphere, transmittance, delta_rayleigh, delta_mie, multiple_scattering,
+                                             delta_irradiance, r, mu, mu_s, nu, scattering_order);
+                scattering_density.At(x, y, z) = Math::vec4(density, 0.0f);
+            }
+        });
+
+        // indirect_irradiance_lut.comp, one order below the density
+        ForEachRow(irradiance.height, [&](u32 y) {
+            for (i32 x = 0; x < irradiance.width; x++) {
+                f32 r, mu_s;
+                GetRMuSFromIrradianceTextureUv(atmosphere, Math::vec2(x + 0.5f, y + 0.5f) / IRRADIANCE_TEXTURE_SIZE,
+                                               r, mu_s);
+                Math::vec4 result(ComputeIndirectIrradiance(atmosphere, delta_rayleigh, delta_mie, multiple_scattering,
+                                                            r, mu_s, scattering_order - 1),
+                                  0.0f);
+                delta_irradiance.At(x, y) = result;
+                irradiance.At(x, y) += result;
+            }
+        });
+
+        // multi_scattering_lut.comp
+        ForEachRow(SCATTERING_ROW_COUNT, [&](u32 row) {
+            i32 y = row % scattering.height, z = row / scattering.height;
+            for (i32 x = 0; x < scattering.width; x++) {
+                f32 r, mu, mu_s, nu;
+                bool ray_r_mu_intersects_ground;
+                GetRMuMuSNuFromScatteringTextureFragCoord(atmosphere, Math::vec3(x + 0.5f, y + 0.5f, z + 0.5f), r,
+                                                          mu, mu_s, nu, ray_r_mu_intersects_ground);
+                Math::vec3 ms = ComputeMultipleScattering(atmosphere, transmittance, scattering_density, r, mu, mu_s,
+                                                          nu, ray_r_mu_intersects_ground);
+                multiple_scattering.At(x, y, z) = Math::vec4(ms, 0.0f);
+                scattering.At(x, y, z) += Math::vec4(ms / RayleighPhaseFunction(nu), 0.0f);
+            }
+        });
+    }
+
+    transmittance.CopyTo(luts.transmittance);
+    irradiance.CopyTo(luts.irradiance);
+    scattering.CopyTo(luts.scattering);
+}
+
+LutError Compare(const std::vector<f32> &texels, const std::vector<f32> &reference) noexcept {
+    LutError error;
+    u64 count = std::min(texels.size(), reference.size());
+    f64 sum = 0.0;
+    u64 finite = 0;
+    for (u64 i = 0; i < count; i++) {
+        if (!std::isfinite(texels[i]) || !std::isfinite(reference[i])) {
+            error.non_finite++;
+            continue;
+        }
+        f32 difference = std::abs(texels[i] - reference[i]);
+        error.max_abs = std::max(error.max_abs, difference);
+        if (std::abs(reference[i]) > 1e-6f) {
+            error.max_rel = std::max(error.max_rel, difference / std::abs(reference[i]));
+        }
+        sum += difference;
+        finite++;
+    }
+    error.mean_abs = finite > 0 ? static_cast<f32>(sum / static_cast<f64>(finite)) : 0.0f;
+    return error;
+}
+
+} // namespace Horizon::AtmosphereCpuPrecompute
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+#include <runtime/scene/render/AtmosphereLutCache.h>
+#include <runtime/scene/render/AtmosphereParameters.h>
+
+// c++ port of the lut shaders in assets/shaders/atmosphere, runs on the thread pool without a device. the luts come out
+// in the layout the atmosphere pass reads back after its own precomputation and can go straight into the lut cache
+namespace Horizon::AtmosphereCpuPrecompute {
+
+// the same passes and scattering orders as Atmosphere::Precompute for the luts of lut_size. reentrant, calls for
+// different parameters or lut sizes may run at the same time
+void Compute(const AtmosphereParameters &parameters, u32 multi_scattering_order, const AtmosphereLutSize &lut_size,
+             AtmosphereLuts &luts) noexcept;
+
+struct LutError {
+    f32 max_abs = 0.0f;
+    f32 mean_abs = 0.0f;
+    // over the texels whose reference is above 1e-6
+    f32 max_rel = 0.0f;
+    // texels that are nan or inf in either lut, left out of the rest
+    u64 non_finite = 0;
+};
+
+// per channel difference of two luts of the same extent
+LutError Compare(const std::vector<f32> &texels, const std::vector<f32> &reference) noexcept;
+
+} // namespace Horizon::AtmosphereCpuPrecompute
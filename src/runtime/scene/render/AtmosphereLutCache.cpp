@@ -0,0 +1,98 @@
+#include "AtmosphereLutCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <runtime/core/io/MappedFile.h>
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+void AtmosphereLuts::Allocate() noexcept {
+    transmittance.resize(static_cast<u64>(transmittance_width) * transmittance_height * 4);
+    irradiance.resize(static_cast<u64>(irradiance_width) * irradiance_height * 4);
+    scattering.resize(static_cast<u64>(scattering_width) * scattering_height * scattering_depth * 4);
+}
+
+bool AtmosphereLutCache::Load(const std::string &path, u64 key, AtmosphereLuts &luts) noexcept {
+    // a first run or new parameters, MappedFile would log the missing file as an error
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return false;
+    }
+    MappedFile file(path);
+    if (!file.IsValid() || file.GetSize() < sizeof(Header)) {
+        return false;
+    }
+    Header header;
+    std::memcpy(&header, file.GetData(), sizeof(Header));
+    if (header.magic != MAGIC || header.version != VERSION) {
+        LOG_WARN("{}: not an atmosphere lut cache of version {}", path, VERSION);
+        return false;
+    }
+    if (header.key != key || header.transmittance_width != luts.transmittance_width ||
+        header.transmittance_height != luts.transmittance_height ||
+        header.irradiance_width != luts.irradiance_width || header.irradiance_height != luts.irradiance_height ||
+        header.scattering_width != luts.scattering_width || header.scattering_height != luts.scattering_height ||
+        header.scattering_depth != luts.scattering_depth) {
+        LOG_WARN("{}: computed for other parameters", path);
+        return false;
+    }
+
+    luts.Allocate();
+    u64 size = sizeof(f32) * (luts.transmittance.size() + luts.irradiance.size() + luts.scattering.size());
+    if (file.GetSize() != sizeof(Header) + size) {
+        LOG_WARN("{}: truncated", path);
+        return false;
+    }
+    const u8 *data = file.GetData() + sizeof(Header);
+    for (std::vector<f32> *texels : {&luts.transmittance, &luts.irradiance, &luts.scattering}) {
+        std::memcpy(texels->data(), data, sizeof(f32) * texels->size());
+        data += sizeof(f32) * texels->size();
+    }
+    return true;
+}
+
+bool AtmosphereLutCache::Save(const std::string &path, u64 key, const AtmosphereLuts &luts) noexcept {
+    Header header;
+    header.key = key;
+    header.transmittance_width = luts.transmittance_width;
+    header.transmittance_height = luts.transmittance_height;
+    header.irradiance_width = luts.irradiance_width;
+    header.irradiance_height = luts.irradiance_height;
+    header.scattering_width = luts.scattering_width;
+    header.scattering_height = luts.scattering_height;
+    header.scattering_depth = luts.scattering_depth;
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LOG_ERROR("failed to open {}", temp_path);
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+        for (const std::vector<f32> *texels : {&luts.transmittance, &luts.irradiance, &luts.scattering}) {
+            file.write(reinterpret_cast<const char *>(texels->data()),
+                       static_cast<std::streamsize>(sizeof(f32) * texels->size()));
+        }
+        if (!file) {
+            LOG_ERROR("failed to write {}", temp_path);
+            file.close();
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error) {
+        LOG_ERROR("failed to move {} to {}: {}", temp_path, path, error.message());
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace Horizon
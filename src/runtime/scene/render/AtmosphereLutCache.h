@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// rgba texels of the luts the atmosphere keeps after precomputation, tightly packed row by row and slice by slice
+struct AtmosphereLuts {
+    u32 transmittance_width = 0;
+    u32 transmittance_height = 0;
+    u32 irradiance_width = 0;
+    u32 irradiance_height = 0;
+    u32 scattering_width = 0;
+    u32 scattering_height = 0;
+    u32 scattering_depth = 0;
+
+    std::vector<f32> transmittance;
+    std::vector<f32> irradiance;
+    std::vector<f32> scattering;
+
+    // sizes the texel vectors for the extents
+    void Allocate() noexcept;
+};
+
+// precomputed luts on disk: a header with the key they were computed for, followed by the transmittance, irradiance
+// and scattering texels as rgba32f. native byte order like the cooked models, a per machine cache
+namespace AtmosphereLutCache {
+
+static constexpr u32 MAGIC = 0x54415a48; // "HZAT"
+// bump whenever the layout or the meaning of the stored texels changes
+static constexpr u32 VERSION = 1;
+
+struct Header {
+    u32 magic = MAGIC;
+    u32 version = VERSION;
+    u64 key = 0;
+    u32 transmittance_width = 0;
+    u32 transmittance_height = 0;
+    u32 irradiance_width = 0;
+    u32 irradiance_height = 0;
+    u32 scattering_width = 0;
+    u32 scattering_height = 0;
+    u32 scattering_depth = 0;
+    u32 pad = 0;
+};
+
+// false if the file is missing, of another version or key, or its extents differ from the ones already set in luts
+bool Load(const std::string &path, u64 key, AtmosphereLuts &luts) noexcept;
+
+// written next to the target and renamed, an interrupted write never leaves a truncated file behind
+bool Save(const std::string &path, u64 key, const AtmosphereLuts &luts) noexcept;
+
+} // namespace AtmosphereLutCache
+
+} // namespace Horizon
@@ -0,0 +1,32 @@
+#include "AtmosphereParameters.h"
+
+#include <cstring>
+
+#include <runtime/core/hash/Hash.h>
+
+namespace Horizon {
+
+static_assert(sizeof(AtmosphereParameters) == 53 * sizeof(f32), "AtmosphereParameters is hashed as raw bytes");
+
+u64 AtmosphereParameters::Hash() const noexcept { return Horizon::Hash::Hash64(this, sizeof(AtmosphereParameters)); }
+
+bool AtmosphereParameters::operator==(const AtmosphereParameters &other) const noexcept {
+    return std::memcmp(this, &other, sizeof(AtmosphereParameters)) == 0;
+}
+
+AtmosphereLutSize GetAtmosphereLutSize(AtmosphereQuality quality) noexcept {
+    AtmosphereLutSize lut_size;
+    if (quality == AtmosphereQuality::ATMOSPHERE_QUALITY_LOW) {
+        // nu is kept, it is interpolated by hand between slices and already coarse
+        lut_size.transmittance_width = 128;
+        lut_size.transmittance_height = 32;
+        lut_size.irradiance_width = 32;
+        lut_size.irradiance_height = 8;
+        lut_size.scattering_r_size = 16;
+        lut_size.scattering_mu_size = 64;
+        lut_size.scattering_mu_s_size = 16;
+    }
+    return lut_size;
+}
+
+} // namespace Horizon
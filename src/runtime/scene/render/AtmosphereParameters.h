@@ -0,0 +1,70 @@
+#pragma once
+
+#include <runtime/core/math/Math.h>
+#include <runtime/function/rhi/RenderContext.h>
+
+namespace Horizon {
+
+// mirrors the structs of assets/shaders/atmosphere/definations.glsl, lengths in km
+struct DensityProfileLayer {
+    f32 width = 0.0f;
+    f32 exp_term = 0.0f;
+    f32 exp_scale = 0.0f;
+    f32 linear_term = 0.0f;
+    f32 constant_term = 0.0f;
+};
+
+struct DensityProfile {
+    DensityProfileLayer layers[2];
+};
+
+// the defaults are earth, the lut kernels and the sky pass read them from Atmosphere::ParametersUb
+struct AtmosphereParameters {
+    f32 bottom_radius = 6360.0f;
+    f32 top_radius = 6460.0f;
+    f32 mie_g = 0.8f;
+    f32 sun_angular_radius = 0.004675f;
+    Math::vec3 solar_irradiance = Math::vec3(1.0f);
+    Math::vec3 rayleigh_scattering = Math::vec3(0.005802f, 0.013558f, 0.033100f);
+    Math::vec3 mie_scattering = Math::vec3(0.003996f);
+    Math::vec3 mie_extinction = Math::vec3(0.004440f);
+    Math::vec3 absorption_extinction = Math::vec3(0.000650f, 0.001881f, 0.000085f);
+    // exponential falloff with a scale height of 8 km
+    DensityProfile rayleigh_density = {{{}, {0.0f, 1.0f, -1.0f / 8.0f, 0.0f, 0.0f}}};
+    // exponential falloff with a scale height of 1.2 km
+    DensityProfile mie_density = {{{}, {0.0f, 1.0f, -1.0f / 1.2f, 0.0f, 0.0f}}};
+    // ozone, a tent between 10 and 40 km peaking at 25 km
+    DensityProfile absorption_density = {
+        {{25.0f, 0.0f, 0.0f, 1.0f / 15.0f, -2.0f / 3.0f}, {0.0f, 0.0f, 0.0f, -1.0f / 15.0f, 8.0f / 3.0f}}};
+    // cosine of the largest sun zenith angle the luts cover, 120 degrees
+    f32 mu_s_min = -0.5f;
+    Math::vec3 ground_albedo = Math::vec3(0.0f);
+
+    // over the bytes, the struct has no padding
+    u64 Hash() const noexcept;
+    bool operator==(const AtmosphereParameters &other) const noexcept;
+    bool operator!=(const AtmosphereParameters &other) const noexcept { return !(*this == other); }
+};
+
+// extents of the luts, the lut kernels and the sky pass take them as specialization constants. the defaults are
+// ATMOSPHERE_QUALITY_HIGH. the 2d extents have to be multiples of Atmosphere::LUT_GROUP_SIZE_2D and the scattering
+// lut extents of Atmosphere::LUT_GROUP_SIZE_3D
+struct AtmosphereLutSize {
+    u32 transmittance_width = 256;
+    u32 transmittance_height = 64;
+    u32 irradiance_width = 64;
+    u32 irradiance_height = 16;
+    // the scattering lut is nu_size * mu_s_size wide, mu_size high and r_size deep
+    u32 scattering_r_size = 32;
+    u32 scattering_mu_size = 128;
+    u32 scattering_mu_s_size = 32;
+    u32 scattering_nu_size = 8;
+
+    u32 GetScatteringWidth() const noexcept { return scattering_nu_size * scattering_mu_s_size; }
+    u32 GetScatteringHeight() const noexcept { return scattering_mu_size; }
+    u32 GetScatteringDepth() const noexcept { return scattering_r_size; }
+};
+
+AtmosphereLutSize GetAtmosphereLutSize(AtmosphereQuality quality) noexcept;
+
+} // namespace Horizon
@@ -0,0 +1,40 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Horizon {
+
+DynamicResolution::DynamicResolution(f32 target_frame_time, f32 min_scale, f32 max_scale) noexcept
+    : m_target_frame_time(target_frame_time), m_min_scale(std::min(min_scale, max_scale)), m_max_scale(max_scale),
+      m_scale(max_scale) {}
+
+bool DynamicResolution::Update(f64 gpu_time) noexcept {
+    m_time_sum += gpu_time;
+    m_frame_count++;
+    if (m_frame_count < SETTLE_FRAMES) {
+        return false;
+    }
+    m_average_frame_time = m_time_sum / m_frame_count;
+    m_time_sum = 0.0;
+    m_frame_count = 0;
+    if (m_average_frame_time <= 0.0) {
+        return false;
+    }
+
+    f32 scale = m_scale * static_cast<f32>(std::sqrt(m_target_frame_time * HEADROOM / m_average_frame_time));
+    scale = std::clamp(scale, m_min_scale, std::min(m_max_scale, m_scale + MAX_INCREASE));
+    // the bounds are always reachable, even from closer than a step
+    bool at_bound = (scale == m_min_scale || scale == m_max_scale) && scale != m_scale;
+    if (std::abs(scale - m_scale) < MIN_STEP && !at_bound) {
+        return false;
+    }
+    m_scale = scale;
+    return true;
+}
+
+f32 DynamicResolution::GetScale() const noexcept { return m_scale; }
+
+f64 DynamicResolution::GetAverageFrameTime() const noexcept { return m_average_frame_time; }
+
+} // namespace Horizon
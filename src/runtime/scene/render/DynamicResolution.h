@@ -0,0 +1,41 @@
+#pragma once
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// picks the per axis render scale that holds a gpu frame time target. timings are averaged over a few frames, the
+// scale then moves towards what the average predicts with pixel cost going with its square. it drops as far as needed
+// at once but only rises in small steps, and changes below a minimum step are ignored so noise does not make the
+// resolution flicker
+class DynamicResolution {
+  public:
+    // frames averaged per decision, frames of an older scale are never mixed in
+    static constexpr u32 SETTLE_FRAMES = 8;
+    // fraction of the target the controller aims for
+    static constexpr f32 HEADROOM = 0.9f;
+    static constexpr f32 MIN_STEP = 0.02f;
+    static constexpr f32 MAX_INCREASE = 0.05f;
+
+    DynamicResolution(f32 target_frame_time, f32 min_scale, f32 max_scale = 1.0f) noexcept;
+    ~DynamicResolution() noexcept = default;
+
+    // gpu time of a frame rendered at the current scale in ms, true when the scale changed
+    bool Update(f64 gpu_time) noexcept;
+
+    f32 GetScale() const noexcept;
+    // average of the frames the last decision was made from
+    f64 GetAverageFrameTime() const noexcept;
+
+  private:
+    f32 m_target_frame_time;
+    f32 m_min_scale;
+    f32 m_max_scale;
+    f32 m_scale;
+
+    f64 m_time_sum = 0.0;
+    u32 m_frame_count = 0;
+    f64 m_average_frame_time = 0.0;
+};
+
+} // namespace Horizon
@@ -1,7 +1,9 @@
 #include "Geometry.h"
+#include <runtime/core/log/Log.h>
 #include <runtime/core/path/Path.h>
 #include <runtime/function/rhi/RenderContext.h>
 #include <runtime/function/rhi/vulkan/VulkanEnums.h>
+#include <runtime/scene/render/RenderQueue.h>
 
 namespace Horizon {
 Geometry::Geometry(const std::shared_ptr<Scene> &_scene, const std::shared_ptr<PipelineManager> &_pipeline_manager,
@@ -9,15 +11,31 @@ Geometry::Geometry(const std::shared_ptr<Scene> &_scene, const std::shared_ptr<P
 
     GraphicsPipelineCreateInfo geometryPipelineCreateInfo;
     geometryPipelineCreateInfo.name = "geometry";
-    geometryPipelineCreateInfo.vs = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("geometry.vert.spv"));
-    geometryPipelineCreateInfo.ps = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("geometry.frag.spv"));
+    geometryPipelineCreateInfo.vertex_format = _render_context.vertex_format;
+    geometryPipelineCreateInfo.push_constants = std::make_shared<PushConstants>();
+    if (_render_context.vertex_format == VertexFormat::VERTEX_FORMAT_COMPRESSED) {
+        geometryPipelineCreateInfo.vs =
+            std::make_shared<Shader>(_device->Get(), ShaderSource{"geometry_compressed.vert"});
+        // per draw position dequantization, pushed by the render queue
+        geometryPipelineCreateInfo.push_constants->ranges.push_back(
+            {SHADER_STAGE_VERTEX_SHADER, 0, sizeof(VertexDequantization)});
+    } else {
+        geometryPipelineCreateInfo.vs = std::make_shared<Shader>(_device->Get(), ShaderSource{"geometry.vert"});
+    }
+    if (_scene->UsesBindlessMaterials()) {
+        geometryPipelineCreateInfo.ps =
+            std::make_shared<Shader>(_device->Get(), ShaderSource{"geometry_bindless.frag"});
+        // per draw material index into the scene's material table
+        geometryPipelineCreateInfo.push_constants->ranges.push_back(
+            {SHADER_STAGE_PIXEL_SHADER, MATERIAL_INDEX_PUSH_OFFSET, sizeof(u32)});
+    } else {
+        geometryPipelineCreateInfo.ps = std::make_shared<Shader>(_device->Get(), ShaderSource{"geometry.frag"});
+    }
+    if (geometryPipelineCreateInfo.push_constants->ranges.empty()) {
+        geometryPipelineCreateInfo.push_constants = nullptr;
+    }
+    // set 0: scene, set 1: material or material table, set 2: per instance transforms
     geometryPipelineCreateInfo.descriptor_layouts = _scene->GetGeometryPassDescriptorLayouts();
-
-    std::shared_ptr<PushConstants> geometryPipelinePushConstants = std::make_shared<PushConstants>();
-
-    geometryPipelinePushConstants->ranges = {
-        {SHADER_STAGE_VERTEX_SHADER, 0, 2 * sizeof(Math::mat4)}}; // Push constants have a minimum size of 128 bytes
-    geometryPipelineCreateInfo.push_constants = geometryPipelinePushConstants;
     // position + depth
     // normal
     // albedo
@@ -35,6 +53,22 @@ Geometry::Geometry(const std::shared_ptr<Scene> &_scene, const std::shared_ptr<P
 
     m_pipeline = _pipeline_manager->CreateGraphicsPipeline(geometryPipelineCreateInfo, geometryAttachmentsCreateInfo,
                                                            _render_context);
+
+    // culled meshlet draws address their instance through firstInstance
+    std::shared_ptr<DescriptorSetLayouts> cullDescriptorLayouts = _scene->GetMeshletCullDescriptorLayouts();
+    if (cullDescriptorLayouts && _device->SupportsDrawIndirectFirstInstance()) {
+        ComputePipelineCreateInfo cullPipelineCreateInfo;
+        cullPipelineCreateInfo.name = "meshlet_cull";
+        cullPipelineCreateInfo.cs = std::make_shared<Shader>(_device->Get(), ShaderSource{"meshlet_cull.comp"});
+        cullPipelineCreateInfo.cs_specialization = {{0, Model::MESHLET_CULL_GROUP_SIZE}};
+        cullPipelineCreateInfo.descriptor_layouts = cullDescriptorLayouts;
+        cullPipelineCreateInfo.push_constants = std::make_shared<PushConstants>();
+        cullPipelineCreateInfo.push_constants->ranges = {
+            {SHADER_STAGE_COMPUTE_SHADER, 0, sizeof(MeshletCullParams)}};
+        m_cull_pipeline = _pipeline_manager->CreateComputePipeline(cullPipelineCreateInfo);
+    } else if (cullDescriptorLayouts) {
+        LOG_WARN("drawIndirectFirstInstance is not supported, meshlet culling disabled");
+    }
 }
 
 Geometry::~Geometry() noexcept {}
@@ -49,4 +83,6 @@ std::shared_ptr<AttachmentDescriptor> Geometry::GetFrameBufferAttachment(u32 _in
 
 std::shared_ptr<Pipeline> Geometry::GetPipeline() const noexcept { return m_pipeline; }
 
+std::shared_ptr<Pipeline> Geometry::GetCullPipeline() const noexcept { return m_cull_pipeline; }
+
 } // namespace Horizon
\ No newline at end of file
@@ -15,9 +15,12 @@ class Geometry {
     void BindResource(u32 binding, std::shared_ptr<DescriptorBase> buffer) noexcept;
     std::shared_ptr<AttachmentDescriptor> GetFrameBufferAttachment(u32 _index) const noexcept;
     std::shared_ptr<Pipeline> GetPipeline() const noexcept;
+    // null if the scene has no meshlets or the device cannot offset instances in indirect draws
+    std::shared_ptr<Pipeline> GetCullPipeline() const noexcept;
 
   private:
     std::shared_ptr<Pipeline> m_pipeline;
+    std::shared_ptr<Pipeline> m_cull_pipeline;
 };
 
 } // namespace Horizon
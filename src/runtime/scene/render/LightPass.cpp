@@ -10,8 +10,9 @@ LightPass::LightPass(std::shared_ptr<Scene> _scene, std::shared_ptr<PipelineMana
     CreateResources();
     GraphicsPipelineCreateInfo LightPassPipelineCreateInfo;
     LightPassPipelineCreateInfo.name = "LightPass";
-    LightPassPipelineCreateInfo.vs = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("simplevs.vert.spv"));
-    LightPassPipelineCreateInfo.ps = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("shading.frag.spv"));
+    LightPassPipelineCreateInfo.vs = std::make_shared<Shader>(_device->Get(), ShaderSource{"simplevs.vert"});
+    LightPassPipelineCreateInfo.ps = std::make_shared<Shader>(_device->Get(), ShaderSource{"shading.frag"});
+    LightPassPipelineCreateInfo.ps_specialization = {{0, Scene::MAX_LIGHT_COUNT}};
     LightPassPipelineCreateInfo.descriptor_layouts = m_descriptor_set_layout;
 
     std::vector<AttachmentCreateInfo> LightPassAttachmentsCreateInfo{
@@ -10,7 +10,7 @@ PostProcess::PostProcess(std::shared_ptr<PipelineManager> _pipeline_manager, std
 
     //ComputePipelineCreateInfo m_tone_mapping_pass_create_info;
     //m_tone_mapping_pass_create_info.name = "transmittance_lut";
-    //m_tone_mapping_pass_create_info.cs = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("postprocess/tonemapping.comp.spv"));
+    //m_tone_mapping_pass_create_info.cs = std::make_shared<Shader>(_device->Get(), ShaderSource{"postprocess/tonemapping.comp"});
     //m_tone_mapping_pass_create_info.descriptor_layouts = tone_mapping_descriptor_set_layouts;
     //m_tone_mapping_pass_create_info.group_count_x = _render_context.width / 8;
     //m_tone_mapping_pass_create_info.group_count_y = _render_context.height / 8;
@@ -28,10 +28,15 @@ PostProcess::PostProcess(std::shared_ptr<PipelineManager> _pipeline_manager, std
 
     GraphicsPipelineCreateInfo pp_ipeline_create_info;
     pp_ipeline_create_info.name = "pp";
-    pp_ipeline_create_info.vs = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("simplevs.vert.spv"));
-    pp_ipeline_create_info.ps = std::make_shared<Shader>(_device->Get(), Path::GetShaderPath("postprocess.frag.spv"));
+    pp_ipeline_create_info.vs = std::make_shared<Shader>(_device->Get(), ShaderSource{"simplevs.vert"});
+    pp_ipeline_create_info.ps = std::make_shared<Shader>(_device->Get(), ShaderSource{"postprocess.frag"});
     pp_ipeline_create_info.descriptor_layouts = pp_descriptor_set_layout;
 
+    // part of the input holding the image, follows the render scale
+    m_push_constants = std::make_shared<PushConstants>();
+    m_push_constants->ranges.push_back({SHADER_STAGE_PIXEL_SHADER, 0, sizeof(Math::vec2), &m_input_scale});
+    pp_ipeline_create_info.push_constants = m_push_constants;
+
     std::vector<AttachmentCreateInfo> pp_attachment_create_info{
         {TextureFormat::TEXTURE_FORMAT_RGBA16_UNORM, COLOR_ATTACHMENT, TextureType::TEXTURE_TYPE_2D,
          _render_context.width, _render_context.height},
@@ -58,6 +63,8 @@ std::shared_ptr<DescriptorSet> PostProcess::GetDescriptorSet() const noexcept {
 
 std::shared_ptr<Pipeline> PostProcess::GetPipeline() const noexcept { return m_pipeline; }
 
+void PostProcess::SetInputScale(f32 scale_x, f32 scale_y) noexcept { m_input_scale = Math::vec2(scale_x, scale_y); }
+
 void PostProcess::CreateResources() noexcept {
     // tone mapping
 
@@ -17,10 +17,15 @@ class PostProcess {
     std::shared_ptr<AttachmentDescriptor> GetFrameBufferAttachment(u32 _index) const noexcept;
     std::shared_ptr<DescriptorSet> GetDescriptorSet() const noexcept;
     std::shared_ptr<Pipeline> GetPipeline() const noexcept;
+    // fraction of the input's width and height holding the rendered image, it is stretched over the whole output
+    void SetInputScale(f32 scale_x, f32 scale_y) noexcept;
 
   private:
     void CreateResources() noexcept;
 
+    Math::vec2 m_input_scale = Math::vec2(1.0f);
+    std::shared_ptr<PushConstants> m_push_constants;
+
     std::shared_ptr<Pipeline> m_pipeline;
     //std::shared_ptr<Pipeline> m_tone_mapping_pass;
 
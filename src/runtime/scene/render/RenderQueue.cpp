@@ -0,0 +1,226 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include <runtime/core/log/Log.h>
+#include <runtime/core/thread/ThreadPool.h>
+
+namespace Horizon {
+
+// below this the thread pool costs more than the sort itself
+static constexpr u32 PARALLEL_SORT_CHUNK_SIZE = 4096;
+static constexpr u32 RADIX_BITS = 8;
+static constexpr u32 RADIX_SIZE = 1 << RADIX_BITS;
+
+void RenderQueue::Reset() noexcept {
+    m_commands.clear();
+    m_entries.clear();
+    m_pipeline_ids.clear();
+    m_material_ids.clear();
+}
+
+void RenderQueue::SetMultiDrawIndirect(bool enabled) noexcept { m_multi_draw_indirect = enabled; }
+
+u32 RenderQueue::GetPipelineId(const Pipeline *pipeline) noexcept {
+    auto res = m_pipeline_ids.emplace(pipeline, static_cast<u32>(m_pipeline_ids.size()));
+    if (res.first->second >= (1u << PIPELINE_BITS)) {
+        LOG_WARN("more than {} pipelines in a render queue, sorting degrades", 1u << PIPELINE_BITS);
+    }
+    return res.first->second & ((1u << PIPELINE_BITS) - 1);
+}
+
+u32 RenderQueue::GetMaterialId(const void *material) noexcept {
+    auto res = m_material_ids.emplace(material, static_cast<u32>(m_material_ids.size()));
+    return res.first->second & ((1u << MATERIAL_BITS) - 1);
+}
+
+u64 RenderQueue::MakeSortKey(u32 pipeline_id, u32 material_id, f32 depth, f32 near_plane, f32 far_plane) noexcept {
+    f64 normalized_depth = std::clamp((static_cast<f64>(depth) - near_plane) / (far_plane - near_plane), 0.0, 1.0);
+    u64 quantized_depth = static_cast<u64>(normalized_depth * static_cast<f64>((1ull << DEPTH_BITS) - 1));
+    return (static_cast<u64>(pipeline_id) << (MATERIAL_BITS + DEPTH_BITS)) |
+           (static_cast<u64>(material_id) << DEPTH_BITS) | quantized_depth;
+}
+
+void RenderQueue::Push(const DrawCommand &command) noexcept { m_commands.push_back(command); }
+
+void RenderQueue::Sort() noexcept {
+    m_entries.resize(m_commands.size());
+    for (u32 i = 0; i < m_commands.size(); i++) {
+        m_entries[i] = SortEntry{m_commands[i].key, i};
+    }
+    RadixSort();
+}
+
+void RenderQueue::RadixSort() noexcept {
+    u32 count = static_cast<u32>(m_entries.size());
+    if (count < 2) {
+        return;
+    }
+    m_scratch.resize(count);
+
+    ThreadPool &pool = ThreadPool::GetInstance();
+    u32 chunk_count = std::clamp((count + PARALLEL_SORT_CHUNK_SIZE - 1) / PARALLEL_SORT_CHUNK_SIZE, 1u,
+                                 pool.GetWorkerCount() + 1);
+    u32 chunk_size = (count + chunk_count - 1) / chunk_count;
+    std::vector<std::array<u32, RADIX_SIZE>> histograms(chunk_count);
+
+    SortEntry *src = m_entries.data();
+    SortEntry *dst = m_scratch.data();
+    for (u32 shift = 0; shift < 64; shift += RADIX_BITS) {
+        pool.ParallelFor(chunk_count, 1, [&](u32 begin, u32 end) {
+            for (u32 chunk = begin; chunk < end; chunk++) {
+                auto &histogram = histograms[chunk];
+                histogram.fill(0);
+                u32 last = std::min(count, (chunk + 1) * chunk_size);
+                for (u32 i = chunk * chunk_size; i < last; i++) {
+                    histogram[(src[i].key >> shift) & (RADIX_SIZE - 1)]++;
+                }
+            }
+        });
+
+        // exclusive prefix sum, digit major so the scatter stays stable across chunks
+        u32 offset = 0;
+        bool single_digit = false;
+        for (u32 digit = 0; digit < RADIX_SIZE; digit++) {
+            u32 digit_total = 0;
+            for (u32 chunk = 0; chunk < chunk_count; chunk++) {
+                u32 n = histograms[chunk][digit];
+                histograms[chunk][digit] = offset + digit_total;
+                digit_total += n;
+            }
+            single_digit |= digit_total == count;
+            offset += digit_total;
+        }
+        // every key shares this digit, the pass would be a plain copy
+        if (single_digit) {
+            continue;
+        }
+
+        pool.ParallelFor(chunk_count, 1, [&](u32 begin, u32 end) {
+            for (u32 chunk = begin; chunk < end; chunk++) {
+                auto &histogram = histograms[chunk];
+                u32 last = std::min(count, (chunk + 1) * chunk_size);
+                for (u32 i = chunk * chunk_size; i < last; i++) {
+                    dst[histogram[(src[i].key >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+                }
+            }
+        });
+        std::swap(src, dst);
+    }
+
+    if (src != m_entries.data()) {
+        std::copy(src, src + count, m_entries.data());
+    }
+}
+
+void RenderQueue::Record(VkCommandBuffer command_buffer, VkDescriptorSet scene_set) noexcept {
+    m_stats = RenderQueueStats{};
+
+    Pipeline *bound_pipeline = nullptr;
+    VkDescriptorSet bound_material = VK_NULL_HANDLE;
+    VkDescriptorSet bound_instance = VK_NULL_HANDLE;
+    VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+    const VertexDequantization *pushed_dequantization = nullptr;
+    u32 pushed_material_index = 0;
+    bool push_dequantization = false;
+    bool push_material_index = false;
+
+    for (const SortEntry &entry : m_entries) {
+        const DrawCommand &command = m_commands[entry.index];
+
+        bool pipeline_changed = command.pipeline != bound_pipeline;
+        if (pipeline_changed) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pipeline->Get());
+            bound_pipeline = command.pipeline;
+            m_stats.binds++;
+
+            push_dequantization = false;
+            push_material_index = false;
+            if (bound_pipeline->hasPushConstants()) {
+                for (const PushConstantRange &range : bound_pipeline->m_push_constants->ranges) {
+                    push_dequantization |= (range.stages & SHADER_STAGE_VERTEX_SHADER) != 0;
+                    push_material_index |= (range.stages & SHADER_STAGE_PIXEL_SHADER) != 0 &&
+                                           range.offset == MATERIAL_INDEX_PUSH_OFFSET;
+                }
+            }
+        }
+
+        // layouts may differ between pipelines, rebind every set after a switch
+        VkPipelineLayout layout = bound_pipeline->GetLayout();
+        bool material_changed = command.material_set != bound_material;
+        bool instance_changed = command.instance_set != bound_instance;
+        if (pipeline_changed) {
+            VkDescriptorSet sets[3] = {scene_set, command.material_set, command.instance_set};
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 3, sets, 0, nullptr);
+            m_stats.binds++;
+        } else if (material_changed && instance_changed) {
+            VkDescriptorSet sets[2] = {command.material_set, command.instance_set};
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 2, sets, 0, nullptr);
+            m_stats.binds++;
+        } else if (material_changed) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1,
+                                    &command.material_set, 0, nullptr);
+            m_stats.binds++;
+        } else if (instance_changed) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 1,
+                                    &command.instance_set, 0, nullptr);
+            m_stats.binds++;
+        }
+        bound_material = command.material_set;
+        bound_instance = command.instance_set;
+
+        if (push_dequantization &&
+            (pipeline_changed || !pushed_dequantization ||
+             std::memcmp(pushed_dequantization, &command.dequantization, sizeof(VertexDequantization)) != 0)) {
+            vkCmdPushConstants(command_buffer, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(VertexDequantization),
+                               &command.dequantization);
+            pushed_dequantization = &command.dequantization;
+        }
+        if (push_material_index && (pipeline_changed || command.material_index != pushed_material_index)) {
+            vkCmdPushConstants(command_buffer, layout, VK_SHADER_STAGE_FRAGMENT_BIT, MATERIAL_INDEX_PUSH_OFFSET,
+                               sizeof(u32), &command.material_index);
+            pushed_material_index = command.material_index;
+        }
+
+        if (command.vertex_buffer != bound_vertex_buffer) {
+            const VkDeviceSize offsets[1] = {0};
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &command.vertex_buffer, offsets);
+            bound_vertex_buffer = command.vertex_buffer;
+            m_stats.binds++;
+        }
+        if (command.index_buffer != bound_index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, command.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+            bound_index_buffer = command.index_buffer;
+            m_stats.binds++;
+        }
+
+        if (command.indirect_buffer == VK_NULL_HANDLE) {
+            vkCmdDrawIndexed(command_buffer, command.index_count, command.instance_count, command.first_index, 0,
+                             command.first_instance);
+        } else if (m_multi_draw_indirect) {
+            vkCmdDrawIndexedIndirect(command_buffer, command.indirect_buffer, command.indirect_offset,
+                                     command.indirect_draw_count, sizeof(VkDrawIndexedIndirectCommand));
+        } else {
+            for (u32 d = 0; d < command.indirect_draw_count; d++) {
+                vkCmdDrawIndexedIndirect(command_buffer, command.indirect_buffer,
+                                         command.indirect_offset + d * sizeof(VkDrawIndexedIndirectCommand), 1,
+                                         sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+        m_stats.draws++;
+        m_stats.triangles += static_cast<u64>(command.index_count / 3) * command.instance_count;
+    }
+
+    // pipeline, descriptor sets, vertex buffer and index buffer for every draw
+    u32 naive_binds = m_stats.draws * 4;
+    m_stats.binds_saved = naive_binds > m_stats.binds ? naive_binds - m_stats.binds : 0;
+}
+
+bool RenderQueue::Empty() const noexcept { return m_commands.empty(); }
+
+const RenderQueueStats &RenderQueue::GetStats() const noexcept { return m_stats; }
+
+} // namespace Horizon
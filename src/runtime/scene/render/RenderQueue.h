@@ -0,0 +1,102 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <runtime/core/math/Math.h>
+#include <runtime/function/rhi/vulkan/Pipeline.h>
+
+namespace Horizon {
+
+// push constants of pipelines drawing compressed vertices, maps unorm16 positions back to object space
+struct VertexDequantization {
+    Math::vec4 position_scale{1.0f};
+    Math::vec4 position_offset{0.0f};
+};
+
+// bindless geometry pipelines read the draw's material index at this push constant offset in the fragment stage
+static constexpr u32 MATERIAL_INDEX_PUSH_OFFSET = sizeof(VertexDequantization);
+
+struct DrawCommand {
+    u64 key = 0;
+    Pipeline *pipeline = nullptr;
+    VkDescriptorSet material_set = VK_NULL_HANDLE;
+    VkDescriptorSet instance_set = VK_NULL_HANDLE;
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    u32 first_index = 0;
+    u32 index_count = 0;
+    u32 first_instance = 0;
+    u32 instance_count = 1;
+    // gpu culled draws read indirect_draw_count VkDrawIndexedIndirectCommands from the indirect buffer instead, the
+    // direct parameters above are kept for statistics
+    VkBuffer indirect_buffer = VK_NULL_HANDLE;
+    u64 indirect_offset = 0;
+    u32 indirect_draw_count = 0;
+    // only pushed if the pipeline declares a vertex push constant range
+    VertexDequantization dequantization;
+    // only pushed if the pipeline declares a fragment range at MATERIAL_INDEX_PUSH_OFFSET, material_set is then the
+    // same for every draw
+    u32 material_index = 0;
+};
+
+struct RenderQueueStats {
+    u32 draws = 0;
+    // indirect draws count before gpu culling
+    u64 triangles = 0;
+    u32 binds = 0;
+    // compared with rebinding pipeline, descriptor sets, vertex and index buffer for every draw
+    u32 binds_saved = 0;
+};
+
+// collects the draws of a pass, sorts them by pipeline, material and front to back depth and records them with
+// redundant state changes elided
+class RenderQueue {
+  public:
+    // key layout, msb to lsb: 12 bit pipeline | 20 bit material | 32 bit quantized depth
+    static constexpr u32 PIPELINE_BITS = 12;
+    static constexpr u32 MATERIAL_BITS = 20;
+    static constexpr u32 DEPTH_BITS = 32;
+
+    RenderQueue() noexcept = default;
+    ~RenderQueue() noexcept = default;
+
+    void Reset() noexcept;
+    // without the multiDrawIndirect feature every indirect command is issued as its own indirect draw
+    void SetMultiDrawIndirect(bool enabled) noexcept;
+
+    // small stable ids for sort keys, valid until the next Reset
+    u32 GetPipelineId(const Pipeline *pipeline) noexcept;
+    u32 GetMaterialId(const void *material) noexcept;
+    // depth is the view space distance, normalized with the camera clip planes
+    static u64 MakeSortKey(u32 pipeline_id, u32 material_id, f32 depth, f32 near_plane, f32 far_plane) noexcept;
+
+    void Push(const DrawCommand &command) noexcept;
+    void Sort() noexcept;
+    void Record(VkCommandBuffer command_buffer, VkDescriptorSet scene_set) noexcept;
+
+    bool Empty() const noexcept;
+    const RenderQueueStats &GetStats() const noexcept;
+
+  private:
+    struct SortEntry {
+        u64 key;
+        u32 index;
+    };
+
+    // lsd radix sort over 8 bit digits, histograms and scatters are split over the thread pool
+    void RadixSort() noexcept;
+
+  private:
+    std::vector<DrawCommand> m_commands;
+    std::vector<SortEntry> m_entries;
+    std::vector<SortEntry> m_scratch;
+    std::unordered_map<const void *, u32> m_pipeline_ids;
+    std::unordered_map<const void *, u32> m_material_ids;
+    RenderQueueStats m_stats;
+    bool m_multi_draw_indirect = false;
+};
+
+} // namespace Horizon
@@ -1,5 +1,7 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <config.hpp>
 #include <filesystem>
 #include <iostream>
@@ -29,6 +31,13 @@ Renderer::Renderer(u32 width, u32 height, std::shared_ptr<Window> window) noexce
     m_pipeline_manager = std::make_shared<PipelineManager>(m_device);
     PrepareAssests();
     CreatePipelines();
+
+    m_gpu_timer = std::make_shared<GpuTimer>(m_device, m_render_context.swap_chain_image_count);
+    if (m_render_context.dynamic_resolution && m_gpu_timer->IsSupported()) {
+        m_dynamic_resolution = std::make_shared<DynamicResolution>(m_render_context.target_frame_time,
+                                                                   m_render_context.min_render_scale);
+    }
+    ApplyRenderScale();
 }
 
 Renderer::~Renderer() noexcept {}
@@ -36,6 +45,13 @@ Renderer::~Renderer() noexcept {}
 void Renderer::Init() noexcept {}
 
 void Renderer::Update() noexcept {
+    if (m_render_context.shader_hot_reload) {
+        std::vector<std::shared_ptr<Pipeline>> rebuilt = m_pipeline_manager->Update();
+        if (!rebuilt.empty()) {
+            m_atmosphere_pass->OnPipelinesRebuilt(rebuilt);
+        }
+    }
+
     m_scene->Prepare();
 
     m_light_pass->BindResource(0, m_scene->m_light_count_ub);
@@ -48,6 +64,8 @@ void Renderer::Update() noexcept {
 
     m_light_pass->UpdateDescriptorSets();
 
+    // may swap in recomputed luts, which the descriptor update below picks up
+    m_atmosphere_pass->Update();
     m_atmosphere_pass->SetCameraParams(m_scene->GetMainCamera()->GetInvViewProjectionMatrix(),
                                        m_scene->GetMainCamera()->GetPosition());
 
@@ -68,167 +86,114 @@ void Renderer::Update() noexcept {
 void Renderer::Render() noexcept {
 
     DrawFrame();
-    m_command_buffer->submit(m_swap_chain);
+    bool presented = m_command_buffer->submit(m_swap_chain);
+    // attachment descriptors are rebound by the next update, so the new targets are picked up from there
+    if (!presented || m_window->ConsumeResize() || m_swap_chain_dirty) {
+        Resize();
+    } else {
+        UpdateRenderScale();
+    }
+
+    const RenderQueueStats &stats = m_scene->GetRenderQueueStats();
+    // lod switches change the triangle count, report whenever the pass changed
+    if (stats.binds_saved != m_last_reported_binds_saved || stats.triangles != m_last_reported_triangles) {
+        LOG_DEBUG("geometry pass: {} draws, {} triangles, {} binds, {} binds saved", stats.draws, stats.triangles,
+                  stats.binds, stats.binds_saved);
+        m_last_reported_binds_saved = stats.binds_saved;
+        m_last_reported_triangles = stats.triangles;
+    }
+
+    // texture residency, reported once the uploads settled
+    TextureStreamingStats streaming = m_scene->GetTextureStreamingStats();
+    if (streaming.pending_uploads == 0 && streaming.resident_size != m_last_reported_texture_size) {
+        LOG_DEBUG("texture streaming: {} textures, {} KB resident, budget {} KB", streaming.textures,
+                  streaming.resident_size / 1024, streaming.budget / 1024);
+        m_last_reported_texture_size = streaming.resident_size;
+    }
+}
+
+void Renderer::Resize() noexcept {
+    m_window->WaitWhileMinimized();
+    if (m_window->getWidth() == 0 || m_window->getHeight() == 0) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    vkDeviceWaitIdle(m_device->Get());
+    m_window->ConsumeResize();
+    m_swap_chain_dirty = false;
+
+    m_swap_chain->recreate({m_window->getWidth(), m_window->getHeight()});
+    VkExtent2D extent = m_swap_chain->getExtent();
+    m_render_context.width = extent.width;
+    m_render_context.height = extent.height;
+
+    m_pipeline_manager->Resize(extent.width, extent.height, m_swap_chain);
+    m_scene->GetMainCamera()->SetAspectRatio(static_cast<f32>(extent.width) / static_cast<f32>(extent.height));
+    ApplyRenderScale();
+
+    LOG_INFO("resized to {}x{} in {:.2f} ms", extent.width, extent.height,
+             std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+void Renderer::UpdateRenderScale() noexcept {
+    f64 gpu_time = 0.0;
+    if (!m_dynamic_resolution || !m_gpu_timer->GetElapsedTime(m_command_buffer->GetLastImageIndex(), gpu_time)) {
+        return;
+    }
+    if (m_dynamic_resolution->Update(gpu_time)) {
+        m_render_context.render_scale = m_dynamic_resolution->GetScale();
+        ApplyRenderScale();
+        LOG_DEBUG("render scale {:.2f} for {:.2f} ms gpu frame time, target {:.2f} ms", m_render_context.render_scale,
+                  m_dynamic_resolution->GetAverageFrameTime(), m_render_context.target_frame_time);
+    }
+}
+
+void Renderer::ApplyRenderScale() noexcept {
+    f32 scale = m_render_context.render_scale;
+    u32 width = std::max(1u, static_cast<u32>(static_cast<f32>(m_render_context.width) * scale + 0.5f));
+    u32 height = std::max(1u, static_cast<u32>(static_cast<f32>(m_render_context.height) * scale + 0.5f));
+
+    // only the viewports move, the targets keep the output size
+    for (const std::shared_ptr<Pipeline> &pipeline :
+         {m_geometry_pass->GetPipeline(), m_light_pass->GetPipeline(), m_atmosphere_pass->m_sky_pass}) {
+        std::static_pointer_cast<GraphicsPipeline>(pipeline)->SetRenderExtent(width, height);
+    }
+    m_atmosphere_pass->SetResolution(width, height);
+    m_post_process_pass->SetInputScale(static_cast<f32>(width) / static_cast<f32>(m_render_context.width),
+                                       static_cast<f32>(height) / static_cast<f32>(m_render_context.height));
 }
 
 void Renderer::Wait() noexcept { vkDeviceWaitIdle(m_device->Get()); }
 
 std::shared_ptr<Camera> Renderer::GetMainCamera() const noexcept { return m_scene->GetMainCamera(); }
 
+void Renderer::SetPresentMode(PresentMode present_mode) noexcept {
+    if (present_mode != m_render_context.present_mode) {
+        m_render_context.present_mode = present_mode;
+        m_swap_chain_dirty = true;
+    }
+}
+
+PresentMode Renderer::GetPresentMode() const noexcept { return m_render_context.present_mode; }
+
+void Renderer::SetAtmosphere(const AtmosphereParameters &parameters, u32 multi_scattering_order) noexcept {
+    m_atmosphere_pass->RequestRecompute(parameters, multi_scattering_order);
+}
+
+const RenderQueueStats &Renderer::GetRenderQueueStats() const noexcept { return m_scene->GetRenderQueueStats(); }
+
 void Renderer::DrawFrame() noexcept {
     for (u32 i = 0; i < m_render_context.swap_chain_image_count; i++) {
         m_command_buffer->beginCommandRecording(i);
+        m_gpu_timer->Begin(i, m_command_buffer);
 
         // geometry pass
+        m_scene->CullMeshlets(i, m_command_buffer, m_geometry_pass->GetCullPipeline());
         m_scene->Draw(i, m_command_buffer, m_geometry_pass->GetPipeline());
 
         m_fullscreen_triangle->Draw(i, m_command_buffer, m_light_pass->GetPipeline(), {m_light_pass->m_descriptorset});
 
         // scattering pass
-
-        if (!m_atmosphere_pass->precomputed) {
-            m_command_buffer->Dispatch(i, m_atmosphere_pass->m_transmittance_lut_pass,
-                                       {m_atmosphere_pass->m_transmittance_lut_descriptor_set});
-
-            // barrier
-            {
-                BarrierDesc desc1;
-                ImageMemoryBarrierDesc transmittance_lut_barrier;
-                transmittance_lut_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                transmittance_lut_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                transmittance_lut_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                transmittance_lut_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-                transmittance_lut_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                transmittance_lut_barrier.texture = m_atmosphere_pass->transmittance_lut;
-                desc1.image_memory_barriers.push_back(transmittance_lut_barrier);
-                desc1.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                desc1.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                InsertBarrier(i, m_command_buffer, desc1);
-            }
-
-            m_command_buffer->Dispatch(i, m_atmosphere_pass->m_direct_irradiance_lut_pass,
-                                       {m_atmosphere_pass->m_direct_irradiance_lut_descriptor_set});
-
-            m_command_buffer->Dispatch(i, m_atmosphere_pass->m_single_scattering_lut_pass,
-                                       {m_atmosphere_pass->m_single_scattering_lut_descriptor_set});
-
-            // barrier
-            {
-                BarrierDesc desc2;
-
-                ImageMemoryBarrierDesc delta_r_barrier;
-                delta_r_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                delta_r_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                delta_r_barrier.texture = m_atmosphere_pass->single_rayleigh_scattering_lut;
-                delta_r_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                delta_r_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                ImageMemoryBarrierDesc delta_mie_barrier;
-                delta_mie_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                delta_mie_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                delta_mie_barrier.texture = m_atmosphere_pass->single_mie_scattering_lut;
-                delta_mie_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                delta_mie_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                ImageMemoryBarrierDesc irradiance_barrier;
-                irradiance_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                irradiance_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                irradiance_barrier.texture = m_atmosphere_pass->direct_irradiance_lut;
-                irradiance_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                irradiance_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                ImageMemoryBarrierDesc multi_scattering_barrier;
-                multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                multi_scattering_barrier.texture = m_atmosphere_pass->multi_scattering_lut;
-                multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                desc2.image_memory_barriers.push_back(delta_r_barrier);
-                desc2.image_memory_barriers.push_back(delta_mie_barrier);
-                desc2.image_memory_barriers.push_back(irradiance_barrier);
-                desc2.image_memory_barriers.push_back(multi_scattering_barrier);
-
-                desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-
-                InsertBarrier(i, m_command_buffer, desc2);
-            }
-
-            for (u32 j = 0; j < m_atmosphere_pass->m_multi_scattering_order; j++) {
-                m_atmosphere_pass->scattering_order_push_constants->ranges[0].value = &m_atmosphere_pass->layers[j + 1];
-                m_command_buffer->Dispatch(i, m_atmosphere_pass->m_scattering_density_lut,
-                                           {m_atmosphere_pass->m_scattering_density_lut_descriptor_set});
-                // barrier
-                {
-                    BarrierDesc desc;
-                    desc.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    desc.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    InsertBarrier(i, m_command_buffer, desc);
-                }
-                m_atmosphere_pass->scattering_order_push_constants->ranges[0].value = &m_atmosphere_pass->layers[j];
-                m_command_buffer->Dispatch(i, m_atmosphere_pass->m_indirect_irradiance_lut,
-                                           {m_atmosphere_pass->m_indirect_irradiance_lut_descriptor_set});
-                // barrier
-                {
-                    BarrierDesc desc2;
-
-                    ImageMemoryBarrierDesc density_barrier;
-                    density_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    density_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                    density_barrier.texture = m_atmosphere_pass->scattering_density_lut;
-                    density_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                    density_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                    ImageMemoryBarrierDesc multi_scattering_barrier;
-                    multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    multi_scattering_barrier.texture = m_atmosphere_pass->single_rayleigh_scattering_lut;
-                    multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                    multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                    desc2.image_memory_barriers.push_back(density_barrier);
-                    desc2.image_memory_barriers.push_back(multi_scattering_barrier);
-
-                    desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT |
-                                      PipelineStageFlags::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-
-                    InsertBarrier(i, m_command_buffer, desc2);
-                }
-                m_atmosphere_pass->scattering_order_push_constants->ranges[0].value = &m_atmosphere_pass->layers[j + 1];
-                m_command_buffer->Dispatch(i, m_atmosphere_pass->m_multi_scattering_lut,
-                                           {m_atmosphere_pass->m_multi_scattering_lut_descriptor_set});
-                // barrier
-                {
-                    BarrierDesc desc2;
-
-                    ImageMemoryBarrierDesc _scattering_barrier;
-                    _scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    _scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    _scattering_barrier.texture = m_atmosphere_pass->_scattering_tex;
-                    _scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                    _scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                    ImageMemoryBarrierDesc multi_scattering_barrier;
-                    multi_scattering_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
-                    multi_scattering_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_SHADER_READ_BIT;
-                    multi_scattering_barrier.texture = m_atmosphere_pass->single_rayleigh_scattering_lut;
-                    multi_scattering_barrier.src_usage = TextureUsage::TEXTURE_USAGE_RW;
-                    multi_scattering_barrier.dst_usage = TextureUsage::TEXTURE_USAGE_RW;
-
-                    desc2.image_memory_barriers.push_back(_scattering_barrier);
-                    desc2.image_memory_barriers.push_back(multi_scattering_barrier);
-
-                    desc2.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    desc2.dst_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT |
-                                      PipelineStageFlags::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-
-                    InsertBarrier(i, m_command_buffer, desc2);
-                }
-            }
-            m_atmosphere_pass->precomputed = true;
-        }
         {
             BarrierDesc desc3;
 
@@ -247,7 +212,8 @@ void Renderer::DrawFrame() noexcept {
         }
 
         m_fullscreen_triangle->Draw(i, m_command_buffer, m_atmosphere_pass->m_sky_pass,
-                                    {m_atmosphere_pass->m_sky_descriptor_set});
+                                    {m_atmosphere_pass->m_sky_descriptor_set,
+                                     m_atmosphere_pass->m_sky_parameters_descriptor_set});
 
         // post process pass
         m_fullscreen_triangle->Draw(i, m_command_buffer, m_post_process_pass->GetPipeline(),
@@ -256,6 +222,7 @@ void Renderer::DrawFrame() noexcept {
         m_fullscreen_triangle->Draw(i, m_command_buffer, m_pipeline_manager->Get("present"), {m_present_descriptorSet},
                                     true);
 
+        m_gpu_timer->End(i, m_command_buffer);
         m_command_buffer->endCommandRecording(i);
     }
 }
@@ -276,7 +243,6 @@ void Renderer::PrepareAssests() noexcept {
     Math::mat4 scale_mat = Math::scale(Math::mat4(1.0f), Math::vec3(20.0)); // a hack value due to mesh precision
     Math::mat4 traslate_mat = Math::translate(Math::mat4(1.0f), Math::vec3(0.0, 6370.0, 0));
     flighthelmet->SetModelMatrix(traslate_mat * scale_mat);
-    flighthelmet->UpdateModelMatrix();
 
     m_scene->AddDirectLight(Math::vec3(1.0), 1.0, Math::normalize(Math::vec3(0.0, -1.0, -1.0)));
 }
@@ -288,6 +254,7 @@ void Renderer::CreatePipelines() noexcept {
     m_light_pass = std::make_shared<LightPass>(m_scene, m_pipeline_manager, m_device, m_render_context);
 
     m_atmosphere_pass = std::make_shared<Atmosphere>(m_pipeline_manager, m_device, m_command_buffer, m_render_context);
+    m_atmosphere_pass->Precompute();
 
     m_post_process_pass = std::make_shared<PostProcess>(m_pipeline_manager, m_device, m_render_context);
 
@@ -302,10 +269,8 @@ void Renderer::CreatePresentPipeline() noexcept {
     std::shared_ptr<DescriptorSetLayouts> presentDescriptorSetLayout = std::make_shared<DescriptorSetLayouts>();
     presentDescriptorSetLayout->layouts.push_back(m_present_descriptorSet->GetLayout());
 
-    std::shared_ptr<Shader> presentVs =
-        std::make_shared<Shader>(m_device->Get(), Path::GetShaderPath("simplevs.vert.spv"));
-    std::shared_ptr<Shader> presentPs =
-        std::make_shared<Shader>(m_device->Get(), Path::GetShaderPath("present.frag.spv"));
+    std::shared_ptr<Shader> presentVs = std::make_shared<Shader>(m_device->Get(), ShaderSource{"simplevs.vert"});
+    std::shared_ptr<Shader> presentPs = std::make_shared<Shader>(m_device->Get(), ShaderSource{"present.frag"});
 
     GraphicsPipelineCreateInfo presentPipelineCreateInfo;
     presentPipelineCreateInfo.name = "present";
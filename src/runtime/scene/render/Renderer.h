@@ -7,6 +7,7 @@
 #include <runtime/function/rhi/vulkan/Descriptors.h>
 #include <runtime/function/rhi/vulkan/Device.h>
 #include <runtime/function/rhi/vulkan/Framebuffer.h>
+#include <runtime/function/rhi/vulkan/GpuTimer.h>
 #include <runtime/function/rhi/vulkan/Instance.h>
 #include <runtime/function/rhi/vulkan/Pipeline.h>
 #include <runtime/function/rhi/vulkan/Surface.h>
@@ -14,6 +15,7 @@
 #include <runtime/function/rhi/vulkan/UniformBuffer.h>
 #include <runtime/function/window/Window.h>
 #include <runtime/scene/render/Atmosphere.h>
+#include <runtime/scene/render/DynamicResolution.h>
 #include <runtime/scene/render/Geometry.h>
 #include <runtime/scene/render/LightPass.h>
 #include <runtime/scene/render/PostProcess.h>
@@ -39,6 +41,16 @@ class Renderer {
 
     std::shared_ptr<Camera> GetMainCamera() const noexcept;
 
+    // the swap chain is recreated before the next frame, unsupported modes fall back to fifo
+    void SetPresentMode(PresentMode present_mode) noexcept;
+    PresentMode GetPresentMode() const noexcept;
+
+    // the sky keeps the current luts until the new ones were computed over the next frames
+    void SetAtmosphere(const AtmosphereParameters &parameters, u32 multi_scattering_order = 3) noexcept;
+
+    // draw/bind counters of the geometry pass for the last recorded frame
+    const RenderQueueStats &GetRenderQueueStats() const noexcept;
+
   private:
     void DrawFrame() noexcept;
 
@@ -49,6 +61,15 @@ class Renderer {
 
     void CreatePresentPipeline() noexcept;
 
+    // recreates the swap chain and the screen sized render targets at the window's framebuffer size
+    void Resize() noexcept;
+
+    // feeds the gpu time of the last frame to the dynamic resolution controller
+    void UpdateRenderScale() noexcept;
+
+    // sizes the passes rendering at RenderContext::render_scale and the upscale of the post process pass
+    void ApplyRenderScale() noexcept;
+
     RenderContext m_render_context;
     std::shared_ptr<Window> m_window = nullptr;
     std::shared_ptr<Instance> m_instance = nullptr;
@@ -59,6 +80,8 @@ class Renderer {
     std::shared_ptr<CommandBuffer> m_command_buffer = nullptr;
     std::shared_ptr<Scene> m_scene = nullptr;
     std::shared_ptr<FullscreenTriangle> m_fullscreen_triangle = nullptr;
+    std::shared_ptr<GpuTimer> m_gpu_timer = nullptr;
+    std::shared_ptr<DynamicResolution> m_dynamic_resolution = nullptr;
     // sync primitives
 
     // semaphores
@@ -73,5 +96,11 @@ class Renderer {
     std::shared_ptr<PostProcess> m_post_process_pass;
     std::shared_ptr<Geometry> m_geometry_pass;
     std::shared_ptr<LightPass> m_light_pass;
+
+    bool m_swap_chain_dirty = false;
+
+    u32 m_last_reported_binds_saved = 0;
+    u64 m_last_reported_triangles = 0;
+    u64 m_last_reported_texture_size = 0;
 };
 } // namespace Horizon
\ No newline at end of file
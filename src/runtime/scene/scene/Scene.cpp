@@ -1,6 +1,7 @@
 #include "Scene.h"
 
 #include <runtime/core/log/Log.h>
+#include <runtime/function/rhi/vulkan/ResourceBarrier.h>
 #include <runtime/function/rhi/vulkan/UniformBuffer.h>
 
 namespace Horizon {
@@ -22,6 +23,8 @@ Scene::Scene(RenderContext &render_context, const std::shared_ptr<Device> &devic
 
     m_scene_descriptor_set = std::make_shared<DescriptorSet>(m_device, sceneDescriptorSetInfo);
 
+    m_render_queue.SetMultiDrawIndirect(m_device->SupportsMultiDrawIndirect());
+
     m_camera = std::make_shared<Camera>(Math::vec3(0.0f, 6370.0f, 10.0), Math::vec3(0.0f, 0.0f, 0.0f),
                                         Math::vec3(0.0f, 1.0f, 0.0f));
     m_camera->SetPerspectiveProjectionMatrix(
@@ -34,10 +37,22 @@ Scene::Scene(RenderContext &render_context, const std::shared_ptr<Device> &devic
     m_light_count_ub = std::make_shared<UniformBuffer>(device);
     m_light_ub = std::make_shared<UniformBuffer>(device);
     m_camera_ub = std::make_shared<UniformBuffer>(device);
+
+    m_transforms = std::make_shared<TransformHierarchy>();
+
+    m_texture_streamer = std::make_shared<TextureStreamer>(m_device, m_command_buffer, m_render_context.texture_budget);
+
+    if (m_render_context.bindless_materials && m_device->SupportsDescriptorIndexing()) {
+        m_material_table = std::make_shared<MaterialTable>(m_device);
+    } else if (m_render_context.bindless_materials) {
+        LOG_INFO("descriptor indexing is not supported, materials bind their own descriptor sets");
+    }
 }
 
-void Scene::LoadModel(const std::string &path, const std::string &name) noexcept {
-    m_models.insert({name, std::make_shared<Model>(path, m_device, m_command_buffer, m_scene_descriptor_set)});
+void Scene::LoadModel(const std::string &path, const std::string &name, ModelLoadOptions options) noexcept {
+    options.vertex_format = m_render_context.vertex_format;
+    m_models.insert({name, std::make_shared<Model>(path, m_device, m_command_buffer, m_scene_descriptor_set,
+                                                   m_transforms, m_texture_streamer, options)});
 }
 
 std::shared_ptr<Model> Scene::GetModel(const std::string &name) const noexcept { return m_models.at(name); }
@@ -117,29 +132,115 @@ void Scene::Prepare() noexcept {
 
     m_scene_descriptor_set->UpdateDescriptorSet(desc);
 
+    // one linear pass over the scene hierarchy, models then pick up the changed world matrices
+    m_transforms->Update();
+
+    // the last frame finished, so streamed textures can swap images before their descriptors are written
+    m_texture_streamer->Update();
+
     // update material&mesh descriptorset
     for (auto &model : m_models) {
         model.second->UpdateModelMatrix();
-        model.second->UpdateDescriptors();
+        model.second->UpdateDescriptors(m_material_table == nullptr);
     }
+    if (m_material_table) {
+        std::vector<std::shared_ptr<Material>> materials;
+        for (auto &model : m_models) {
+            const auto &model_materials = model.second->GetMaterials();
+            materials.insert(materials.end(), model_materials.begin(), model_materials.end());
+        }
+        m_material_table->Update(materials);
+    }
+
+    // descriptor sets were reallocated and the camera may have moved
+    m_render_queue_dirty = true;
 }
 
 void Scene::Draw(u32 _i, std::shared_ptr<CommandBuffer> _command_buffer, std::shared_ptr<Pipeline> _pipeline) noexcept {
 
+    if (m_render_queue_dirty) {
+        m_render_queue.Reset();
+        Math::mat4 view = m_camera->GetViewMatrix();
+        Math::vec2 near_far = m_camera->GetNearFarPlane();
+        // pixels covered by one unit of object space error at unit distance, at the resolution actually rendered
+        f32 render_height = static_cast<f32>(m_render_context.height) * m_render_context.render_scale;
+        f32 lod_scale = render_height / (2.0f * Math::tan(m_camera->GetFov() * 0.5f));
+        VkDescriptorSet material_table_set =
+            m_material_table ? m_material_table->GetDescriptorSet()->Get() : VK_NULL_HANDLE;
+        for (auto &model : m_models) {
+            model.second->Submit(m_render_queue, _pipeline.get(), view, near_far, lod_scale, m_meshlet_culling,
+                                 material_table_set);
+        }
+        m_render_queue.Sort();
+        m_render_queue_dirty = false;
+    }
+
     _command_buffer->beginRenderPass(_i, _pipeline);
+    m_render_queue.Record(_command_buffer->Get(_i), m_scene_descriptor_set->Get());
+    _command_buffer->endRenderPass(_i);
+}
+
+void Scene::CullMeshlets(u32 _i, std::shared_ptr<CommandBuffer> _command_buffer,
+                         std::shared_ptr<Pipeline> _cull_pipeline) noexcept {
+    if (m_meshlet_culling != (_cull_pipeline != nullptr)) {
+        m_meshlet_culling = _cull_pipeline != nullptr;
+        m_render_queue_dirty = true;
+    }
+    if (!_cull_pipeline) {
+        return;
+    }
+
+    // gribb-hartmann planes of the view projection, clip space depth is [0, w]
+    Math::mat4 view_projection = m_camera->GetProjectionMatrix() * m_camera->GetViewMatrix();
+    Math::vec4 rows[4];
+    for (u32 r = 0; r < 4; r++) {
+        rows[r] = Math::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r],
+                             view_projection[3][r]);
+    }
+    MeshletCullParams params;
+    params.frustum_planes[0] = rows[3] + rows[0];
+    params.frustum_planes[1] = rows[3] - rows[0];
+    params.frustum_planes[2] = rows[3] + rows[1];
+    params.frustum_planes[3] = rows[3] - rows[1];
+    params.frustum_planes[4] = rows[2];
+    params.frustum_planes[5] = rows[3] - rows[2];
+    for (Math::vec4 &plane : params.frustum_planes) {
+        plane /= Math::length(Math::vec3(plane));
+    }
+    params.camera_position = Math::vec4(m_camera->GetPosition(), 1.0f);
+
+    BarrierDesc barrier;
+    barrier.src_stage = PipelineStageFlags::PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    barrier.dst_stage = PipelineStageFlags::PIPELINE_STAGE_DRAW_INDIRECT_BIT;
     for (auto &model : m_models) {
-        model.second->Draw(_pipeline, _command_buffer->Get(_i));
+        std::shared_ptr<StorageBuffer> indirect_buffer = model.second->GetIndirectBuffer();
+        if (!indirect_buffer) {
+            continue;
+        }
+        model.second->RecordMeshletCulling(_command_buffer->Get(_i), _cull_pipeline.get(), params);
+
+        BufferMemoryBarrierDesc buffer_barrier;
+        buffer_barrier.src_access_mask = MemoryAccessFlags::ACCESS_SHADER_WRITE_BIT;
+        buffer_barrier.dst_access_mask = MemoryAccessFlags::ACCESS_INDIRECT_COMMAND_READ_BIT;
+        buffer_barrier.buffer = indirect_buffer->Get();
+        buffer_barrier.offset = 0;
+        buffer_barrier.size = static_cast<u32>(indirect_buffer->size());
+        barrier.buffer_memory_barriers.push_back(buffer_barrier);
+    }
+    if (!barrier.buffer_memory_barriers.empty()) {
+        InsertBarrier(_i, _command_buffer, barrier);
     }
-    _command_buffer->endRenderPass(_i);
 }
 
 std::shared_ptr<DescriptorSetLayouts> Scene::GetDescriptorLayouts() const noexcept {
     std::shared_ptr<DescriptorSetLayouts> layouts = std::make_shared<DescriptorSetLayouts>();
     VkDescriptorSetLayout materialSetLayout = nullptr;
+    VkDescriptorSetLayout instanceSetLayout = nullptr;
     for (const auto &model : m_models) {
         if (model.second->GetMaterialDescriptorSet()) {
             //meshSetLayout = model.second->getMeshDescriptorSet()->GetLayout();
             materialSetLayout = model.second->GetMaterialDescriptorSet()->GetLayout();
+            instanceSetLayout = model.second->GetInstanceDescriptorSet()->GetLayout();
         }
     }
     //if (!meshSetLayout) {
@@ -148,35 +249,60 @@ std::shared_ptr<DescriptorSetLayouts> Scene::GetDescriptorLayouts() const noexce
     if (materialSetLayout == nullptr) {
         LOG_ERROR("material descriptorset layout not found");
     }
-    layouts->layouts = {{m_scene_descriptor_set->GetLayout(), materialSetLayout}};
+    layouts->layouts = {{m_scene_descriptor_set->GetLayout(), materialSetLayout, instanceSetLayout}};
     return layouts;
 }
 
 std::shared_ptr<DescriptorSetLayouts> Scene::GetGeometryPassDescriptorLayouts() const noexcept {
     std::shared_ptr<DescriptorSetLayouts> layouts = std::make_shared<DescriptorSetLayouts>();
     VkDescriptorSetLayout materialSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSetLayout instanceSetLayout = VK_NULL_HANDLE;
     for (auto &model : m_models) {
         if (model.second->GetMaterialDescriptorSet()) {
             materialSetLayout = model.second->GetMaterialDescriptorSet()->GetLayout();
+            instanceSetLayout = model.second->GetInstanceDescriptorSet()->GetLayout();
         }
     }
+    if (m_material_table) {
+        materialSetLayout = m_material_table->GetDescriptorSet()->GetLayout();
+    }
     if (!materialSetLayout) {
         LOG_ERROR("material descriptorset layout not found");
     }
-    layouts->layouts = {{m_scene_descriptor_set->GetLayout(), materialSetLayout}};
+    layouts->layouts = {{m_scene_descriptor_set->GetLayout(), materialSetLayout, instanceSetLayout}};
     return layouts;
 }
 
+bool Scene::UsesBindlessMaterials() const noexcept { return m_material_table != nullptr; }
+
 std::shared_ptr<DescriptorSetLayouts> Scene::GetSceneDescriptorLayouts() const noexcept {
     std::shared_ptr<DescriptorSetLayouts> layouts = std::make_shared<DescriptorSetLayouts>();
     layouts->layouts.emplace_back(m_scene_descriptor_set->GetLayout());
     return layouts;
 }
 
+std::shared_ptr<DescriptorSetLayouts> Scene::GetMeshletCullDescriptorLayouts() const noexcept {
+    // every model creates the cull set from the same bindings, any of them provides the layout
+    for (auto &model : m_models) {
+        if (model.second->GetMeshletCullDescriptorSet()) {
+            std::shared_ptr<DescriptorSetLayouts> layouts = std::make_shared<DescriptorSetLayouts>();
+            layouts->layouts.emplace_back(model.second->GetMeshletCullDescriptorSet()->GetLayout());
+            return layouts;
+        }
+    }
+    return nullptr;
+}
+
 std::shared_ptr<Camera> Scene::GetMainCamera() const noexcept { return m_camera; }
 
 std::shared_ptr<UniformBuffer> Scene::getCameraUbo() const noexcept { return m_camera_ub; }
 
+const RenderQueueStats &Scene::GetRenderQueueStats() const noexcept { return m_render_queue.GetStats(); }
+
+void Scene::SetTextureBudget(u64 budget) noexcept { m_texture_streamer->SetBudget(budget); }
+
+TextureStreamingStats Scene::GetTextureStreamingStats() const noexcept { return m_texture_streamer->GetStats(); }
+
 FullscreenTriangle::FullscreenTriangle(std::shared_ptr<Device> device,
                                        std::shared_ptr<CommandBuffer> command_buffer) noexcept
     : m_device(device), m_command_buffer(command_buffer) {
@@ -207,6 +333,13 @@ void FullscreenTriangle::Draw(u32 _i, std::shared_ptr<CommandBuffer> _command_bu
                                 descriptor_sets.size(), descriptor_sets.data(), 0, 0);
     }
 
+    if (_pipeline->hasPushConstants()) {
+        for (auto &pc : _pipeline->m_push_constants->ranges) {
+            vkCmdPushConstants(command_buffer, _pipeline->GetLayout(), ToVkShaderStageFlags(pc.stages), pc.offset,
+                               pc.size, pc.value);
+        }
+    }
+
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline->Get());
     vkCmdDraw(command_buffer, 3, 1, 0, 0);
     _command_buffer->endRenderPass(_i);
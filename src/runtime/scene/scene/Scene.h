@@ -9,19 +9,25 @@
 #include <runtime/function/rhi/vulkan/Device.h>
 #include <runtime/scene/camera/Camera.h>
 #include <runtime/scene/light/Light.h>
+#include <runtime/scene/material/MaterialTable.h>
+#include <runtime/scene/material/TextureStreamer.h>
 #include <runtime/scene/model/Model.h>
+#include <runtime/scene/render/RenderQueue.h>
+#include <runtime/scene/scene/TransformHierarchy.h>
 
 namespace Horizon {
 
-#define MAX_LIGHT_COUNT 1024
-
 class Scene {
   public:
+    // size of the light uniform buffer, shading.frag is specialized to it
+    static constexpr u32 MAX_LIGHT_COUNT = 1024;
+
     Scene(RenderContext &render_context, const std::shared_ptr<Device> &device,
           const std::shared_ptr<CommandBuffer> &command_buffer) noexcept;
     ~Scene() noexcept = default;
 
-    void LoadModel(const std::string &path, const std::string &name) noexcept;
+    // the vertex format always follows the render context so it matches the geometry pipeline
+    void LoadModel(const std::string &path, const std::string &name, ModelLoadOptions options = {}) noexcept;
     std::shared_ptr<Model> GetModel(const std::string &name) const noexcept;
 
     // https://google.github.io/filament/Filament.html
@@ -32,11 +38,24 @@ class Scene {
 
     void Prepare() noexcept;
     void Draw(u32 i, std::shared_ptr<CommandBuffer> command_buffer, std::shared_ptr<Pipeline> pipeline) noexcept;
+    // cull meshlets of every model against the camera, recorded before the geometry pass. a null pipeline disables
+    // gpu culling and primitives are drawn whole
+    void CullMeshlets(u32 i, std::shared_ptr<CommandBuffer> command_buffer,
+                      std::shared_ptr<Pipeline> cull_pipeline) noexcept;
     std::shared_ptr<DescriptorSetLayouts> GetDescriptorLayouts() const noexcept;
+    // set 1 is the material table with bindless materials, the per material layout otherwise
     std::shared_ptr<DescriptorSetLayouts> GetGeometryPassDescriptorLayouts() const noexcept;
+    // RenderContext::bindless_materials on a device with descriptor indexing
+    bool UsesBindlessMaterials() const noexcept;
     std::shared_ptr<DescriptorSetLayouts> GetSceneDescriptorLayouts() const noexcept;
+    // null if no model has meshlets
+    std::shared_ptr<DescriptorSetLayouts> GetMeshletCullDescriptorLayouts() const noexcept;
     std::shared_ptr<Camera> GetMainCamera() const noexcept;
     std::shared_ptr<UniformBuffer> getCameraUbo() const noexcept;
+    const RenderQueueStats &GetRenderQueueStats() const noexcept;
+    // the budget starts out as RenderContext::texture_budget
+    void SetTextureBudget(u64 budget) noexcept;
+    TextureStreamingStats GetTextureStreamingStats() const noexcept;
 
     std::shared_ptr<UniformBuffer> m_light_count_ub;
     std::shared_ptr<UniformBuffer> m_light_ub;
@@ -48,6 +67,10 @@ class Scene {
     std::shared_ptr<Device> m_device;
     std::shared_ptr<CommandBuffer> m_command_buffer;
     std::shared_ptr<DescriptorSet> m_scene_descriptor_set = nullptr;
+    // shared by every model, requests come in while the render queue is built
+    std::shared_ptr<TextureStreamer> m_texture_streamer = nullptr;
+    // every material of every model, null when materials bind their own descriptor sets
+    std::shared_ptr<MaterialTable> m_material_table = nullptr;
 
     // uniform buffers
 
@@ -76,6 +99,14 @@ class Scene {
         f32 pad1;
     } m_camera_ubdata;
 
+    // transforms of every node in the scene
+    std::shared_ptr<TransformHierarchy> m_transforms = nullptr;
+
+    // opaque draws, rebuilt once per frame and recorded for every swap chain image
+    RenderQueue m_render_queue;
+    bool m_render_queue_dirty = true;
+    bool m_meshlet_culling = false;
+
     // models
     //std::vector<std::shared_ptr<Model>> m_models;
     std::unordered_map<std::string, std::shared_ptr<Model>> m_models;
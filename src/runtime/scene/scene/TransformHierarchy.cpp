@@ -0,0 +1,105 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+#include <runtime/core/log/Log.h>
+
+namespace Horizon {
+
+u32 TransformHierarchy::AddNode(i32 parent, const Math::vec3 &translation, const Math::quat &rotation,
+                                const Math::vec3 &scale, const Math::mat4 &matrix) noexcept {
+    u32 index = static_cast<u32>(m_parents.size());
+    if (parent >= static_cast<i32>(index)) {
+        LOG_ERROR("transform parent {} must be added before node {}", parent, index);
+        parent = INVALID_PARENT;
+    }
+
+    m_translations.push_back(translation);
+    m_rotations.push_back(rotation);
+    m_scales.push_back(scale);
+    m_matrices.push_back(matrix);
+    m_world_matrices.push_back(Math::mat4(1.0f));
+    m_parents.push_back(parent);
+    m_world_versions.push_back(0);
+    m_dirty.push_back(0);
+
+    MarkDirty(index);
+    return index;
+}
+
+void TransformHierarchy::SetTranslation(u32 index, const Math::vec3 &translation) noexcept {
+    m_translations[index] = translation;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::SetRotation(u32 index, const Math::quat &rotation) noexcept {
+    m_rotations[index] = rotation;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::SetScale(u32 index, const Math::vec3 &scale) noexcept {
+    m_scales[index] = scale;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocalMatrix(u32 index, const Math::mat4 &matrix) noexcept {
+    m_translations[index] = Math::vec3(0.0f);
+    m_rotations[index] = Math::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    m_scales[index] = Math::vec3(1.0f);
+    m_matrices[index] = matrix;
+    MarkDirty(index);
+}
+
+void TransformHierarchy::Update() noexcept {
+    if (!m_has_dirty) {
+        return;
+    }
+
+    // parents precede their children, so a node is stale iff it is dirty itself or its parent was rewritten in this
+    // pass. nodes before the first dirty one cannot be affected.
+    u64 version = m_version + 1;
+    u32 node_count = GetNodeCount();
+    for (u32 i = m_first_dirty; i < node_count; i++) {
+        i32 parent = m_parents[i];
+        bool parent_changed = parent != INVALID_PARENT && m_world_versions[parent] == version;
+        if (!m_dirty[i] && !parent_changed) {
+            continue;
+        }
+
+        Math::mat4 local = Math::translate(Math::mat4(1.0f), m_translations[i]) * Math::mat4_cast(m_rotations[i]) *
+                           Math::scale(Math::mat4(1.0f), m_scales[i]) * m_matrices[i];
+        m_world_matrices[i] = parent != INVALID_PARENT ? m_world_matrices[parent] * local : local;
+        m_world_versions[i] = version;
+        m_dirty[i] = 0;
+    }
+
+    m_version = version;
+    m_has_dirty = false;
+    m_first_dirty = node_count;
+}
+
+const Math::vec3 &TransformHierarchy::GetTranslation(u32 index) const noexcept { return m_translations[index]; }
+
+const Math::quat &TransformHierarchy::GetRotation(u32 index) const noexcept { return m_rotations[index]; }
+
+const Math::vec3 &TransformHierarchy::GetScale(u32 index) const noexcept { return m_scales[index]; }
+
+const Math::mat4 &TransformHierarchy::GetLocalMatrix(u32 index) const noexcept { return m_matrices[index]; }
+
+const Math::mat4 &TransformHierarchy::GetWorldMatrix(u32 index) const noexcept { return m_world_matrices[index]; }
+
+i32 TransformHierarchy::GetParent(u32 index) const noexcept { return m_parents[index]; }
+
+u32 TransformHierarchy::GetNodeCount() const noexcept { return static_cast<u32>(m_parents.size()); }
+
+u64 TransformHierarchy::GetVersion() const noexcept { return m_version; }
+
+u64 TransformHierarchy::GetWorldVersion(u32 index) const noexcept { return m_world_versions[index]; }
+
+void TransformHierarchy::MarkDirty(u32 index) noexcept {
+    m_dirty[index] = 1;
+    m_first_dirty = m_has_dirty ? std::min(m_first_dirty, index) : index;
+    m_has_dirty = true;
+}
+
+} // namespace Horizon
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <runtime/core/math/Math.h>
+
+namespace Horizon {
+
+// flattened transform hierarchy of a scene, stored as structure of arrays.
+// nodes are appended parent first, so a single linear pass over the arrays visits every parent before its children.
+class TransformHierarchy {
+  public:
+    static constexpr i32 INVALID_PARENT = -1;
+
+    TransformHierarchy() noexcept = default;
+    ~TransformHierarchy() noexcept = default;
+
+    // parent must be INVALID_PARENT or an index returned by a previous AddNode call
+    u32 AddNode(i32 parent, const Math::vec3 &translation = Math::vec3(0.0f),
+                const Math::quat &rotation = Math::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                const Math::vec3 &scale = Math::vec3(1.0f), const Math::mat4 &matrix = Math::mat4(1.0f)) noexcept;
+
+    void SetTranslation(u32 index, const Math::vec3 &translation) noexcept;
+    void SetRotation(u32 index, const Math::quat &rotation) noexcept;
+    void SetScale(u32 index, const Math::vec3 &scale) noexcept;
+    // replace the whole local transform with an arbitrary matrix, trs is reset to identity
+    void SetLocalMatrix(u32 index, const Math::mat4 &matrix) noexcept;
+
+    // recompute world matrices of dirty nodes and their descendants
+    void Update() noexcept;
+
+    const Math::vec3 &GetTranslation(u32 index) const noexcept;
+    const Math::quat &GetRotation(u32 index) const noexcept;
+    const Math::vec3 &GetScale(u32 index) const noexcept;
+    const Math::mat4 &GetLocalMatrix(u32 index) const noexcept;
+    const Math::mat4 &GetWorldMatrix(u32 index) const noexcept;
+    i32 GetParent(u32 index) const noexcept;
+    u32 GetNodeCount() const noexcept;
+
+    // bumped by every Update that changed at least one world matrix
+    u64 GetVersion() const noexcept;
+    // version of the last Update that changed this node's world matrix
+    u64 GetWorldVersion(u32 index) const noexcept;
+
+  private:
+    void MarkDirty(u32 index) noexcept;
+
+  private:
+    // local trs, the local matrix is T * R * S * matrix
+    std::vector<Math::vec3> m_translations;
+    std::vector<Math::quat> m_rotations;
+    std::vector<Math::vec3> m_scales;
+    std::vector<Math::mat4> m_matrices;
+
+    std::vector<Math::mat4> m_world_matrices;
+    std::vector<i32> m_parents;
+    std::vector<u64> m_world_versions;
+    std::vector<u8> m_dirty;
+
+    u32 m_first_dirty = 0;
+    bool m_has_dirty = false;
+    u64 m_version = 0;
+};
+
+} // namespace Horizon
@@ -0,0 +1,169 @@
+// writes the atmosphere lut cache for a list of presets in one run, so the renderer starts without precomputing.
+// usage: atmosphere_baker [--cpu | --compare] [preset...], every preset without preset arguments
+//   --cpu      computes the luts on the cpu, no vulkan device is created
+//   --compare  computes the luts on the gpu and the cpu and prints the difference per lut, and the error of the
+//              resident half float luts against the gpu ones. writes nothing
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include <runtime/function/rhi/vulkan/CommandBuffer.h>
+#include <runtime/function/rhi/vulkan/Device.h>
+#include <runtime/function/rhi/vulkan/Instance.h>
+#include <runtime/function/rhi/vulkan/Pipeline.h>
+#include <runtime/function/rhi/vulkan/Surface.h>
+#include <runtime/function/window/Window.h>
+#include <runtime/scene/render/Atmosphere.h>
+#include <runtime/scene/render/AtmosphereCpuPrecompute.h>
+
+using namespace Horizon;
+
+struct Preset {
+    const char *name;
+    AtmosphereParameters parameters;
+    u32 multi_scattering_order;
+    AtmosphereQuality quality = AtmosphereQuality::ATMOSPHERE_QUALITY_HIGH;
+};
+
+static std::vector<Preset> GetPresets() noexcept {
+    std::vector<Preset> presets;
+    // what the renderer uses
+    presets.push_back({"earth", AtmosphereParameters{}, 3});
+    presets.push_back({"earth_single_scattering", AtmosphereParameters{}, 0});
+    presets.push_back({"earth_high_order", AtmosphereParameters{}, 8});
+    presets.push_back({"earth_low", AtmosphereParameters{}, 3, AtmosphereQuality::ATMOSPHERE_QUALITY_LOW});
+
+    // four times the aerosols, spread higher up
+    AtmosphereParameters hazy;
+    hazy.mie_scattering = Math::vec3(0.015984f);
+    hazy.mie_extinction = Math::vec3(0.017760f);
+    hazy.mie_density.layers[1].exp_scale = -1.0f / 2.0f;
+    presets.push_back({"hazy", hazy, 3});
+    return presets;
+}
+
+static f64 GetMilliseconds(std::chrono::steady_clock::time_point start) noexcept {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void PrintLutError(const char *lut, const std::vector<f32> &cpu, const std::vector<f32> &gpu) noexcept {
+    AtmosphereCpuPrecompute::LutError error = AtmosphereCpuPrecompute::Compare(cpu, gpu);
+    std::printf("  %-13s max abs %.3e  mean abs %.3e  max rel %.3e", lut, error.max_abs, error.mean_abs,
+                error.max_rel);
+    if (error.non_finite > 0) {
+        std::printf("  %llu non finite", static_cast<unsigned long long>(error.non_finite));
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    bool cpu = false, compare = false;
+    std::vector<Preset> presets = GetPresets();
+    std::vector<Preset> selected;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--cpu") == 0) {
+            cpu = true;
+            continue;
+        }
+        if (std::strcmp(argv[i], "--compare") == 0) {
+            compare = true;
+            continue;
+        }
+        auto it = std::find_if(presets.begin(), presets.end(),
+                               [&](const Preset &preset) { return std::strcmp(preset.name, argv[i]) == 0; });
+        if (it == presets.end()) {
+            std::printf("unknown preset %s\n", argv[i]);
+            return 1;
+        }
+        selected.push_back(*it);
+    }
+    if (cpu && compare) {
+        std::printf("--cpu and --compare exclude each other\n");
+        return 1;
+    }
+    if (!selected.empty()) {
+        presets = selected;
+    }
+
+    // the device is created for a surface, the window is never shown long enough to matter
+    std::shared_ptr<Window> window;
+    std::shared_ptr<Instance> instance;
+    std::shared_ptr<Surface> surface;
+    std::shared_ptr<Device> device;
+    std::shared_ptr<CommandBuffer> command_buffer;
+    RenderContext render_context;
+    render_context.width = 64;
+    render_context.height = 64;
+    if (!cpu) {
+        window = std::make_shared<Window>("atmosphere baker", 64, 64);
+        instance = std::make_shared<Instance>();
+        surface = std::make_shared<Surface>(instance, window);
+        device = std::make_shared<Device>(instance, surface);
+        command_buffer = std::make_shared<CommandBuffer>(render_context, device);
+    }
+
+    u32 baked = 0;
+    for (const Preset &preset : presets) {
+        AtmosphereLutSize lut_size = GetAtmosphereLutSize(preset.quality);
+        std::string path = Atmosphere::GetCachePath(preset.parameters, preset.multi_scattering_order, lut_size);
+        std::error_code error;
+        if (!compare && std::filesystem::is_regular_file(path, error)) {
+            std::printf("%s: up to date, %s\n", preset.name, path.c_str());
+            continue;
+        }
+
+        AtmosphereLuts cpu_luts;
+        if (cpu || compare) {
+            auto start = std::chrono::steady_clock::now();
+            AtmosphereCpuPrecompute::Compute(preset.parameters, preset.multi_scattering_order, lut_size, cpu_luts);
+            std::printf("%s: cpu %.1f ms\n", preset.name, GetMilliseconds(start));
+        }
+        if (cpu) {
+            u64 key = Atmosphere::GetCacheKey(preset.parameters, preset.multi_scattering_order, lut_size);
+            if (!AtmosphereLutCache::Save(path, key, cpu_luts)) {
+                std::printf("%s: failed to write %s\n", preset.name, path.c_str());
+                return 1;
+            }
+            std::printf("%s: %s\n", preset.name, path.c_str());
+            baked++;
+            continue;
+        }
+
+        // pipelines are shared by name and point at the push constants of the atmosphere that created them
+        std::shared_ptr<PipelineManager> pipeline_manager = std::make_shared<PipelineManager>(device);
+        render_context.atmosphere_quality = preset.quality;
+        Atmosphere atmosphere(pipeline_manager, device, command_buffer, render_context, preset.parameters,
+                              preset.multi_scattering_order);
+        auto start = std::chrono::steady_clock::now();
+        AtmosphereLuts gpu_luts;
+        atmosphere.Precompute(!compare, compare ? &gpu_luts : nullptr);
+        if (compare) {
+            std::printf("%s: gpu %.1f ms\n", preset.name, GetMilliseconds(start));
+            PrintLutError("transmittance", cpu_luts.transmittance, gpu_luts.transmittance);
+            PrintLutError("irradiance", cpu_luts.irradiance, gpu_luts.irradiance);
+            PrintLutError("scattering", cpu_luts.scattering, gpu_luts.scattering);
+            // what narrowing the gpu luts to the resident format costs
+            AtmosphereLuts resident_luts = atmosphere.ReadLuts();
+            std::printf("%s: resident luts %llu KB\n", preset.name,
+                        static_cast<unsigned long long>(atmosphere.GetMemorySize() >> 10));
+            PrintLutError("transmittance", resident_luts.transmittance, gpu_luts.transmittance);
+            PrintLutError("irradiance", resident_luts.irradiance, gpu_luts.irradiance);
+            PrintLutError("scattering", resident_luts.scattering, gpu_luts.scattering);
+            continue;
+        }
+        std::printf("%s: %s\n", preset.name, path.c_str());
+        baked++;
+    }
+    if (device) {
+        vkDeviceWaitIdle(device->Get());
+    }
+    if (!compare) {
+        std::printf("baked %u of %zu presets\n", baked, presets.size());
+    }
+    return 0;
+}